@@ -2,30 +2,70 @@
 
 #include "CG_TP_2.h"
 
+#include "BatchRenderer.hpp"
+#include "Fleet.hpp"
+#include "FramePacer.hpp"
+#include "FrustumCuller.hpp"
+#include "GlCallCounter.hpp"
+#include "GlCalls.hpp"
+#include "GpuTimer.hpp"
+#include "HeadlessContext.hpp"
+#include "HotReloader.hpp"
+#include "InstanceBuffer.hpp"
+#include "JobSystem.hpp"
+#include "MeshBvh.hpp"
 #include "Model.hpp"
+#include "OcclusionCuller.hpp"
+#include "OffscreenTarget.hpp"
+#include "Profiler.hpp"
+#include "ProfilerOverlay.hpp"
+#include "ProgramBinaryCache.hpp"
+#include "SceneGraph.hpp"
 #include "ShaderProgram.hpp"
+#include "ShaderVariants.hpp"
+#include "StreamBuffer.hpp"
+#include "TextureService.hpp"
+#include "UniformBuffers.hpp"
 
 #include <GL/glew.h>
 #include <GLFW/glfw3.h>
 #include <glm/glm.hpp>
 #include <glm/gtc/matrix_transform.hpp>
+#include <glm/gtc/quaternion.hpp>
 #include <glm/gtc/type_ptr.hpp>
 
 #include <algorithm>
+#include <charconv>
+#include <chrono>
 #include <cmath>
+#include <cstdio>
 #include <cstdlib>
 #include <filesystem>
+#include <fstream>
 #include <iostream>
+#include <limits>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
 
 namespace {
 
 struct CameraController {
     float distance = 160.0f;
+    float maxDistance = 400.0f;
     float yaw = glm::radians(45.0f);
     float pitch = glm::radians(12.0f);
     bool dragging = false;
     double lastX = 0.0;
     double lastY = 0.0;
+    // A press and release without dragging selects what is under the cursor.
+    double pressX = 0.0;
+    double pressY = 0.0;
+    bool clickPending = false;
+    double clickX = 0.0;
+    double clickY = 0.0;
 };
 
 void ErrorCallback(int code, const char* description) {
@@ -58,6 +98,13 @@ bool InitGLEW() {
     GLenum glewError = glewInit();
     // GLEW can emit a benign error on init; clear it.
     glGetError();
+#ifdef GLEW_ERROR_NO_GLX_DISPLAY
+    // A GLX build of GLEW reports this under an EGL context, after it has
+    // loaded the GL entry points.
+    if (glewError == GLEW_ERROR_NO_GLX_DISPLAY) {
+        return true;
+    }
+#endif
     if (glewError != GLEW_OK) {
         std::cerr << "Failed to initialize GLEW: "
                   << reinterpret_cast<const char*>(glewGetErrorString(glewError)) << std::endl;
@@ -66,6 +113,41 @@ bool InitGLEW() {
     return true;
 }
 
+const char* PresentModeName(PresentMode mode) {
+    switch (mode) {
+    case PresentMode::Vsync:
+        return "vsync";
+    case PresentMode::Adaptive:
+        return "adaptive";
+    case PresentMode::Unlocked:
+        return "unlocked";
+    }
+    return "";
+}
+
+// Sets the swap interval of the current window's context. Adaptive vsync
+// (a negative interval) needs the swap_control_tear extension.
+void ApplyPresentMode(PresentMode& mode) {
+    if (mode == PresentMode::Adaptive && !glfwExtensionSupported("WGL_EXT_swap_control_tear") &&
+        !glfwExtensionSupported("GLX_EXT_swap_control_tear")) {
+        std::cout << "Adaptive vsync is not supported; using vsync.\n";
+        mode = PresentMode::Vsync;
+    }
+    glfwSwapInterval(mode == PresentMode::Vsync ? 1 : mode == PresentMode::Adaptive ? -1 : 0);
+}
+
+void PrintPacingStats(const FramePacer& pacer, PresentMode mode) {
+    const FramePacingStats stats = pacer.Stats();
+    std::cout << "Frame pacing (" << PresentModeName(mode) << ", " << pacer.Options().maxQueuedFrames << " queued";
+    if (pacer.Options().frameCap > 0.0) {
+        std::cout << ", capped at " << pacer.Options().frameCap << " fps";
+    }
+    std::cout << "): " << stats.frameMs << " ms/frame, jitter " << stats.jitterMs << " ms, p99 " << stats.frameP99Ms
+              << " ms; input to GPU done " << stats.latencyMs << " ms (p95 " << stats.latencyP95Ms << " ms)"
+              << (mode == PresentMode::Unlocked ? "" : " plus up to a refresh to scan-out") << "; " << stats.waitMs
+              << " ms/frame waiting\n";
+}
+
 CameraController* GetCamera(GLFWwindow* window) {
     return static_cast<CameraController*>(glfwGetWindowUserPointer(window));
 }
@@ -73,7 +155,7 @@ CameraController* GetCamera(GLFWwindow* window) {
 void ScrollCallback(GLFWwindow* window, double /*xoffset*/, double yoffset) {
     if (auto* camera = GetCamera(window)) {
         camera->distance -= static_cast<float>(yoffset) * 8.0f;
-        camera->distance = std::clamp(camera->distance, 20.0f, 400.0f);
+        camera->distance = std::clamp(camera->distance, 20.0f, camera->maxDistance);
     }
 }
 
@@ -89,8 +171,17 @@ void MouseButtonCallback(GLFWwindow* window, int button, int action, int /*mods*
     if (action == GLFW_PRESS) {
         camera->dragging = true;
         glfwGetCursorPos(window, &camera->lastX, &camera->lastY);
+        camera->pressX = camera->lastX;
+        camera->pressY = camera->lastY;
     } else if (action == GLFW_RELEASE) {
         camera->dragging = false;
+        double x, y;
+        glfwGetCursorPos(window, &x, &y);
+        if (std::abs(x - camera->pressX) < 4.0 && std::abs(y - camera->pressY) < 4.0) {
+            camera->clickPending = true;
+            camera->clickX = x;
+            camera->clickY = y;
+        }
     }
 }
 
@@ -110,6 +201,22 @@ void CursorPosCallback(GLFWwindow* window, double xpos, double ypos) {
     camera->pitch = std::clamp(camera->pitch, -1.2f, 1.2f);
 }
 
+// World-space ray through a cursor position given in window coordinates.
+Ray CursorRay(GLFWwindow* window, double x, double y, const glm::mat4& viewProjection) {
+    int width, height;
+    glfwGetWindowSize(window, &width, &height);
+    const float ndcX = width > 0 ? static_cast<float>(2.0 * x / width - 1.0) : 0.0f;
+    const float ndcY = height > 0 ? static_cast<float>(1.0 - 2.0 * y / height) : 0.0f;
+    const glm::mat4 inverseViewProjection = glm::inverse(viewProjection);
+    const glm::vec4 nearPoint = inverseViewProjection * glm::vec4(ndcX, ndcY, -1.0f, 1.0f);
+    const glm::vec4 farPoint = inverseViewProjection * glm::vec4(ndcX, ndcY, 1.0f, 1.0f);
+    Ray ray;
+    ray.origin = glm::vec3(nearPoint) / nearPoint.w;
+    ray.direction = glm::vec3(farPoint) / farPoint.w - ray.origin;
+    ray.tMax = 1.0f; // the far plane
+    return ray;
+}
+
 void UpdateCameraFromKeyboard(GLFWwindow* window, CameraController& camera, float deltaTime) {
     const float orbitSpeed = 1.5f;
     const float zoomSpeed = 120.0f;
@@ -134,42 +241,335 @@ void UpdateCameraFromKeyboard(GLFWwindow* window, CameraController& camera, floa
     }
 
     camera.pitch = std::clamp(camera.pitch, -1.2f, 1.2f);
-    camera.distance = std::clamp(camera.distance, 20.0f, 400.0f);
+    camera.distance = std::clamp(camera.distance, 20.0f, camera.maxDistance);
 }
 
-} // namespace
+struct ViewerOptions {
+    VertexFormat vertexFormat = VertexFormat::Float32;
+    // 0 draws the single UFO; otherwise a fleet drawn with instancing.
+    int instances = 0;
+    // Draw the fleet (of at least one UFO) through BatchRenderer instead.
+    bool batched = false;
+    // Skip fleet UFOs hidden behind the nearest ones.
+    bool occlusion = true;
+    // Threads preparing fleet frames, this one included; 0 uses every core.
+    int threads = 0;
+    // Render `frames` frames offscreen along a scripted camera path, at a
+    // fixed 60 Hz animation step, then exit. Needs no display.
+    bool headless = false;
+    int frames = 300;
+    // Rendered before timing starts, so shader JIT and first uploads stay out.
+    int warmupFrames = 10;
+    int width = 1280;
+    int height = 720;
+    int samples = 4;
+    std::filesystem::path timingsPath;   // per-frame CPU/GPU times as JSON
+    std::filesystem::path dumpDirectory; // frame_NNNNN.png every dumpEvery frames
+    int dumpEvery = 1;
+    std::filesystem::path tracePath; // Chrome trace of every profiler zone
+    // Vsync by default, unlocked for fleets so frame times mean something.
+    std::optional<PresentMode> presentMode;
+    FramePacingOptions pacing;
+};
 
-int main() {
-    if (!InitGLFW()) {
-        return EXIT_FAILURE;
+// Parses all of `value` as an integer of at least `minimum`.
+bool ParseInt(std::string_view value, int minimum, int& out) {
+    int parsed = 0;
+    auto [end, ec] = std::from_chars(value.data(), value.data() + value.size(), parsed);
+    if (ec != std::errc() || end != value.data() + value.size() || parsed < minimum) {
+        return false;
+    }
+    out = parsed;
+    return true;
+}
+
+bool ParseArguments(int argc, char** argv, ViewerOptions& options) {
+    constexpr std::string_view kInstancesPrefix = "--instances=";
+    constexpr std::string_view kFramesPrefix = "--frames=";
+    constexpr std::string_view kWarmupPrefix = "--warmup=";
+    constexpr std::string_view kSizePrefix = "--size=";
+    constexpr std::string_view kSamplesPrefix = "--samples=";
+    constexpr std::string_view kTimingsPrefix = "--timings=";
+    constexpr std::string_view kDumpFramesPrefix = "--dump-frames=";
+    constexpr std::string_view kDumpEveryPrefix = "--dump-every=";
+    constexpr std::string_view kTracePrefix = "--trace=";
+    constexpr std::string_view kFrameCapPrefix = "--fps-cap=";
+    constexpr std::string_view kMaxQueuedPrefix = "--max-queued=";
+    constexpr std::string_view kThreadsPrefix = "--threads=";
+    for (int i = 1; i < argc; ++i) {
+        std::string_view arg = argv[i];
+        if (arg == "--vertex-format=float") {
+            options.vertexFormat = VertexFormat::Float32;
+        } else if (arg == "--vertex-format=packed") {
+            options.vertexFormat = VertexFormat::Packed;
+        } else if (arg == "--batched") {
+            options.batched = true;
+        } else if (arg == "--no-occlusion") {
+            options.occlusion = false;
+        } else if (arg.starts_with(kInstancesPrefix)) {
+            std::string_view value = arg.substr(kInstancesPrefix.size());
+            if (!ParseInt(value, 0, options.instances)) {
+                std::cerr << "Invalid instance count: " << value << std::endl;
+                return false;
+            }
+        } else if (arg.starts_with(kThreadsPrefix)) {
+            std::string_view value = arg.substr(kThreadsPrefix.size());
+            if (!ParseInt(value, 0, options.threads)) {
+                std::cerr << "Invalid thread count: " << value << std::endl;
+                return false;
+            }
+        } else if (arg == "--headless") {
+            options.headless = true;
+        } else if (arg.starts_with(kFramesPrefix)) {
+            std::string_view value = arg.substr(kFramesPrefix.size());
+            if (!ParseInt(value, 1, options.frames)) {
+                std::cerr << "Invalid frame count: " << value << std::endl;
+                return false;
+            }
+        } else if (arg.starts_with(kWarmupPrefix)) {
+            std::string_view value = arg.substr(kWarmupPrefix.size());
+            if (!ParseInt(value, 0, options.warmupFrames)) {
+                std::cerr << "Invalid warm-up frame count: " << value << std::endl;
+                return false;
+            }
+        } else if (arg.starts_with(kSizePrefix)) {
+            std::string_view value = arg.substr(kSizePrefix.size());
+            const std::size_t separator = value.find('x');
+            if (separator == std::string_view::npos || !ParseInt(value.substr(0, separator), 1, options.width) ||
+                !ParseInt(value.substr(separator + 1), 1, options.height)) {
+                std::cerr << "Invalid size (expected WIDTHxHEIGHT): " << value << std::endl;
+                return false;
+            }
+        } else if (arg.starts_with(kSamplesPrefix)) {
+            std::string_view value = arg.substr(kSamplesPrefix.size());
+            if (!ParseInt(value, 1, options.samples)) {
+                std::cerr << "Invalid sample count: " << value << std::endl;
+                return false;
+            }
+        } else if (arg.starts_with(kTimingsPrefix)) {
+            options.timingsPath = arg.substr(kTimingsPrefix.size());
+        } else if (arg.starts_with(kDumpFramesPrefix)) {
+            options.dumpDirectory = arg.substr(kDumpFramesPrefix.size());
+        } else if (arg.starts_with(kDumpEveryPrefix)) {
+            std::string_view value = arg.substr(kDumpEveryPrefix.size());
+            if (!ParseInt(value, 1, options.dumpEvery)) {
+                std::cerr << "Invalid dump interval: " << value << std::endl;
+                return false;
+            }
+        } else if (arg.starts_with(kTracePrefix)) {
+            options.tracePath = arg.substr(kTracePrefix.size());
+        } else if (arg == "--present=vsync") {
+            options.presentMode = PresentMode::Vsync;
+        } else if (arg == "--present=adaptive") {
+            options.presentMode = PresentMode::Adaptive;
+        } else if (arg == "--present=unlocked") {
+            options.presentMode = PresentMode::Unlocked;
+        } else if (arg.starts_with(kFrameCapPrefix)) {
+            std::string_view value = arg.substr(kFrameCapPrefix.size());
+            int frameCap = 0;
+            if (!ParseInt(value, 0, frameCap)) {
+                std::cerr << "Invalid frame cap: " << value << std::endl;
+                return false;
+            }
+            options.pacing.frameCap = frameCap;
+        } else if (arg.starts_with(kMaxQueuedPrefix)) {
+            std::string_view value = arg.substr(kMaxQueuedPrefix.size());
+            if (!ParseInt(value, 1, options.pacing.maxQueuedFrames)) {
+                std::cerr << "Invalid queued frame count: " << value << std::endl;
+                return false;
+            }
+        } else {
+            std::cerr << "Unknown argument: " << arg << "\n"
+                      << "Usage: " << argv[0] << " [--vertex-format=float|packed] [--instances=N] [--batched] [--no-occlusion]\n"
+                      << "       [--threads=N]\n"
+                      << "       [--present=vsync|adaptive|unlocked] [--fps-cap=N] [--max-queued=N] [--trace=file.json]\n"
+                      << "       [--headless [--frames=N] [--warmup=N] [--size=WxH] [--samples=N] [--timings=file.json]\n"
+                      << "                   [--dump-frames=dir] [--dump-every=N]]" << std::endl;
+            return false;
+        }
     }
+    return true;
+}
+
+// Headless runs fly this path instead of reading input: an orbit that also
+// swings in and out, so culling and LOD selection see varied views.
+void FollowCameraPath(CameraController& camera, float time, float baseDistance) {
+    camera.yaw = glm::radians(45.0f) + time * 0.35f;
+    camera.pitch = glm::radians(12.0f) + 0.15f * std::sin(time * 0.6f);
+    camera.distance = std::clamp(baseDistance * (1.0f + 0.3f * std::sin(time * 0.45f)), 20.0f, camera.maxDistance);
+}
+
+struct HeadlessFrame {
+    float time = 0.0f;   // animation time
+    double cpuMs = 0.0;  // from the start of the frame until its commands are submitted
+    double gpuMs = -1.0; // negative when the timer query gave no result
+    std::size_t drawn = 0;
+};
+
+struct TimingSummary {
+    double mean = 0.0;
+    double median = 0.0;
+    double p95 = 0.0;
+    double max = 0.0;
+};
+
+// Ignores negative (missing) values.
+TimingSummary Summarize(const std::vector<HeadlessFrame>& frames, double HeadlessFrame::*field) {
+    std::vector<double> values;
+    for (const HeadlessFrame& frame : frames) {
+        if (frame.*field >= 0.0) {
+            values.push_back(frame.*field);
+        }
+    }
+    TimingSummary summary;
+    if (values.empty()) {
+        return summary;
+    }
+    std::sort(values.begin(), values.end());
+    for (double value : values) {
+        summary.mean += value;
+    }
+    summary.mean /= static_cast<double>(values.size());
+    summary.median = values[values.size() / 2];
+    summary.p95 = values[std::min(values.size() - 1, values.size() * 95 / 100)];
+    summary.max = values.back();
+    return summary;
+}
+
+std::string JsonString(std::string_view text) {
+    std::string quoted = "\"";
+    for (char c : text) {
+        if (c == '"' || c == '\\') {
+            quoted += '\\';
+        }
+        quoted += static_cast<unsigned char>(c) < 0x20 ? ' ' : c;
+    }
+    return quoted + "\"";
+}
+
+bool WriteHeadlessReport(const std::filesystem::path& path,
+                         const ViewerOptions& options,
+                         std::string_view renderer,
+                         const std::vector<HeadlessFrame>& frames,
+                         std::string* error) {
+    std::ofstream file(path);
+    if (!file) {
+        if (error) {
+            *error = "Unable to create " + path.string();
+        }
+        return false;
+    }
+    auto writeSummary = [&](const char* name, const TimingSummary& summary) {
+        file << "  " << JsonString(name) << ": {\"mean\": " << summary.mean << ", \"median\": " << summary.median
+             << ", \"p95\": " << summary.p95 << ", \"max\": " << summary.max << "},\n";
+    };
+    file << "{\n"
+         << "  \"renderer\": " << JsonString(renderer) << ",\n"
+         << "  \"width\": " << options.width << ",\n"
+         << "  \"height\": " << options.height << ",\n"
+         << "  \"samples\": " << options.samples << ",\n"
+         << "  \"warmupFrames\": " << options.warmupFrames << ",\n"
+         << "  \"instances\": " << options.instances << ",\n"
+         << "  \"batched\": " << (options.batched ? "true" : "false") << ",\n"
+         << "  \"occlusion\": " << (options.occlusion ? "true" : "false") << ",\n"
+         << "  \"vertexFormat\": " << JsonString(options.vertexFormat == VertexFormat::Packed ? "packed" : "float") << ",\n";
+    writeSummary("cpuMs", Summarize(frames, &HeadlessFrame::cpuMs));
+    writeSummary("gpuMs", Summarize(frames, &HeadlessFrame::gpuMs));
+    file << "  \"frames\": [\n";
+    for (std::size_t i = 0; i < frames.size(); ++i) {
+        const HeadlessFrame& frame = frames[i];
+        file << "    {\"frame\": " << i << ", \"time\": " << frame.time << ", \"cpuMs\": " << frame.cpuMs
+             << ", \"gpuMs\": ";
+        if (frame.gpuMs >= 0.0) {
+            file << frame.gpuMs;
+        } else {
+            file << "null";
+        }
+        file << ", \"drawn\": " << frame.drawn << "}" << (i + 1 < frames.size() ? ",\n" : "\n");
+    }
+    file << "  ]\n}\n";
+    if (!file) {
+        if (error) {
+            *error = "Failed to write " + path.string();
+        }
+        return false;
+    }
+    return true;
+}
+
+} // namespace
 
-    const int initialWidth = 1280;
-    const int initialHeight = 720;
-    GLFWwindow* window = glfwCreateWindow(initialWidth, initialHeight, "UFO Viewer", nullptr, nullptr);
-    if (!window) {
-        std::cerr << "Failed to create GLFW window." << std::endl;
-        glfwTerminate();
+int main(int argc, char** argv) {
+    ViewerOptions viewerOptions;
+    if (!ParseArguments(argc, argv, viewerOptions)) {
         return EXIT_FAILURE;
     }
 
-    glfwMakeContextCurrent(window);
-    glfwSetFramebufferSizeCallback(window, FrameBufferSizeCallback);
-    glfwSwapInterval(1);
+    const int fleetSize = viewerOptions.batched ? std::max(viewerOptions.instances, 1) : viewerOptions.instances;
+    GLFWwindow* window = nullptr;
+    HeadlessContext headlessContext;
+    if (viewerOptions.headless) {
+        std::string contextError;
+        if (!headlessContext.Create(4, 1, &contextError)) {
+            std::cerr << contextError << std::endl;
+            return EXIT_FAILURE;
+        }
+    } else {
+        if (!InitGLFW()) {
+            return EXIT_FAILURE;
+        }
+
+        const int initialWidth = 1280;
+        const int initialHeight = 720;
+        window = glfwCreateWindow(initialWidth, initialHeight, "UFO Viewer", nullptr, nullptr);
+        if (!window) {
+            std::cerr << "Failed to create GLFW window." << std::endl;
+            glfwTerminate();
+            return EXIT_FAILURE;
+        }
+
+        glfwMakeContextCurrent(window);
+        glfwSetFramebufferSizeCallback(window, FrameBufferSizeCallback);
+        if (!viewerOptions.presentMode) {
+            viewerOptions.presentMode = fleetSize > 0 ? PresentMode::Unlocked : PresentMode::Vsync;
+        }
+        ApplyPresentMode(*viewerOptions.presentMode);
+    }
+    auto closeContext = [&]() {
+        if (window) {
+            glfwDestroyWindow(window);
+            glfwTerminate();
+        } else {
+            headlessContext.Destroy();
+        }
+    };
 
     if (!InitGLEW()) {
-        glfwDestroyWindow(window);
-        glfwTerminate();
+        closeContext();
         return EXIT_FAILURE;
     }
 
     CameraController camera;
-    glfwSetWindowUserPointer(window, &camera);
-    glfwSetScrollCallback(window, ScrollCallback);
-    glfwSetMouseButtonCallback(window, MouseButtonCallback);
-    glfwSetCursorPosCallback(window, CursorPosCallback);
+    OffscreenTarget offscreen;
+    if (window) {
+        glfwSetWindowUserPointer(window, &camera);
+        glfwSetScrollCallback(window, ScrollCallback);
+        glfwSetMouseButtonCallback(window, MouseButtonCallback);
+        glfwSetCursorPosCallback(window, CursorPosCallback);
 
-    std::cout << "Controls: drag with LMB to orbit, scroll/Q/E to zoom, WASD/arrow keys to adjust view.\n";
+        std::cout << "Controls: drag with LMB to orbit, scroll/Q/E to zoom, WASD/arrow keys to adjust view, P to toggle the profiler.\n";
+    } else {
+        std::string targetError;
+        if (!offscreen.Create(viewerOptions.width, viewerOptions.height, viewerOptions.samples, &targetError)) {
+            std::cerr << targetError << std::endl;
+            closeContext();
+            return EXIT_FAILURE;
+        }
+        viewerOptions.samples = offscreen.Samples(); // as clamped by the driver
+        std::cout << "Rendering " << viewerOptions.frames << " frames headless at " << offscreen.Width() << "x"
+                  << offscreen.Height() << " (" << offscreen.Samples() << "x MSAA) on "
+                  << reinterpret_cast<const char*>(glGetString(GL_RENDERER)) << "\n";
+    }
 
     glEnable(GL_DEPTH_TEST);
     glEnable(GL_CULL_FACE);
@@ -177,46 +577,295 @@ int main() {
     glFrontFace(GL_CCW);
 
     const std::filesystem::path shaderRoot = std::filesystem::path(PROJECT_SOURCE_DIR) / "assets" / "shaders";
-    ShaderProgram shaderProgram;
+    ProgramBinaryCache programCache(std::filesystem::path(PROJECT_SOURCE_DIR) / ".cache" / "programs");
+    ShaderLoadOptions shaderOptions;
+    shaderOptions.binaryCache = &programCache;
+    if (viewerOptions.batched) {
+        shaderOptions.defines.push_back("BATCHED");
+    } else if (viewerOptions.instances > 0) {
+        shaderOptions.defines.push_back("INSTANCED");
+    }
+    ShaderVariants objectShaders;
     std::string shaderError;
-    if (!shaderProgram.LoadFromFiles(shaderRoot / "object.vert", shaderRoot / "object.frag", &shaderError)) {
+    if (!objectShaders.Load(shaderRoot / "object.vert", shaderRoot / "object.frag", shaderOptions, &shaderError)) {
         std::cerr << shaderError << std::endl;
-        glfwDestroyWindow(window);
-        glfwTerminate();
+        closeContext();
         return EXIT_FAILURE;
     }
+    const ShaderLoadStats& shaderStats = objectShaders.Generic().LoadStats();
+    std::cout << "Shaders loaded in " << shaderStats.totalMs << " ms [compile " << shaderStats.compileMs
+              << " ms, link " << shaderStats.linkMs << " ms, binary " << shaderStats.binaryMs << " ms]"
+              << (shaderStats.binaryCacheHit ? " (program cache hit)" : "") << "\n";
+    if (!shaderStats.cacheMessage.empty()) {
+        std::cout << shaderStats.cacheMessage << "\n";
+    }
 
     const std::filesystem::path ufoPath = std::filesystem::path(PROJECT_SOURCE_DIR) / "UFO" / "Low_poly_UFO.obj";
+    gfx::TextureService textureService;
     Model ufoModel;
     std::string modelError;
-    if (!ufoModel.LoadFromObj(ufoPath, &modelError)) {
+    ModelLoadOptions modelOptions;
+    modelOptions.obj.threadCount = 0;
+    modelOptions.optimizeMesh = true;
+    modelOptions.generateLods = true;
+    modelOptions.buildBvh = true;
+    modelOptions.vertexFormat = viewerOptions.vertexFormat;
+    modelOptions.textureService = &textureService;
+    if (!ufoModel.LoadFromObj(ufoPath, modelOptions, &modelError)) {
         std::cerr << modelError << std::endl;
-        glfwDestroyWindow(window);
-        glfwTerminate();
+        textureService.Destroy();
+        closeContext();
         return EXIT_FAILURE;
     }
 
+    const ModelLoadStats& loadStats = ufoModel.LoadStats();
+    std::cout << "Loaded " << ufoPath.filename().string() << " in " << loadStats.totalMs << " ms"
+              << (loadStats.meshCacheHit ? " (mesh cache hit)" : "") << " [parse " << loadStats.parseMs
+              << " ms, tangents " << loadStats.tangentMs << " ms, cache " << loadStats.cacheMs << " ms, BVH "
+              << loadStats.bvhMs << " ms, upload " << loadStats.uploadMs << " ms]\n";
+    if (!loadStats.meshCacheHit && !loadStats.cacheMessage.empty()) {
+        std::cout << loadStats.cacheMessage << "\n";
+    }
+    if (loadStats.optimized) {
+        const MeshOptimizeReport& report = loadStats.optimizeReport;
+        std::cout << "Mesh optimization (" << loadStats.optimizeMs << " ms): ACMR " << report.before.acmr << " -> "
+                  << report.after.acmr << ", ATVR " << report.before.atvr << " -> " << report.after.atvr << "\n";
+    }
+    if (loadStats.lodsGenerated) {
+        const MeshLodReport& lodReport = loadStats.lodReport;
+        std::cout << "LOD chain (" << loadStats.lodMs << " ms):";
+        for (std::size_t level = 0; level < lodReport.triangles.size(); ++level) {
+            std::cout << " [" << level << "] " << lodReport.triangles[level] << " tris, error "
+                      << lodReport.errors[level];
+        }
+        std::cout << "\n";
+    }
+    if (loadStats.quantized) {
+        const QuantizationError& quantError = loadStats.quantizationError;
+        std::cout << "Packed vertices: max position error " << quantError.maxPositionError << ", max normal error "
+                  << quantError.maxNormalErrorDegrees << " deg, max UV error " << quantError.maxTexCoordError << "\n";
+    }
+
     glm::vec3 lightDir = glm::normalize(glm::vec3(-0.4f, -1.0f, -0.3f));
     glm::vec3 lightColor(1.0f, 0.96f, 0.86f);
     glm::vec3 ambientColor(0.08f, 0.08f, 0.14f);
 
-    float previousTime = static_cast<float>(glfwGetTime());
+    FrameUniforms frameUniforms;
+    frameUniforms.lightDir = glm::vec4(lightDir, 0.0f);
+    frameUniforms.lightColor = glm::vec4(lightColor, 1.0f);
+    frameUniforms.ambientColor = glm::vec4(ambientColor, 1.0f);
+
+    // The lone UFO turns on the spot; only its rotation changes per frame.
+    SceneGraph sceneGraph;
+    const SceneNode ufoNode = sceneGraph.Add();
+    sceneGraph.SetScale(ufoNode, 1.4f);
+
+    const float fleetSpacing = ufoModel.Bounds().radius * 1.4f * 2.5f;
+    const std::vector<FleetSlot> fleet = LayoutFleet(fleetSize, fleetSpacing);
+    // Animation, culling, LOD selection and instance data run as jobs; this
+    // thread helps out and keeps the GL calls.
+    JobSystem frameJobs(static_cast<unsigned>(viewerOptions.threads));
+    FleetUpdater fleetUpdater;
+    fleetUpdater.SetFleet(fleet);
+    const std::vector<InstanceTransform>& fleetTransforms = fleetUpdater.Transforms();
+    const std::vector<uint32_t>& visibleInstances = fleetUpdater.Visible(); // inside the frustum
+    std::vector<InstanceTransform> visibleTransforms;
+    InstanceBuffer fleetBuffer;
+    std::vector<uint32_t> drawnInstances; // visible and not occluded
+    std::vector<BoundingSphere> visibleSpheres;
+    OcclusionCuller occlusionCuller;
+    constexpr std::size_t kMaxOccluders = 16;
+    std::vector<uint32_t> occlusionTested; // visibleInstances of the frame the pending pass tests
+    std::vector<uint8_t> occluded(fleet.size(), 0); // by the last finished pass
+    OcclusionStats occlusionStats; // of the last finished pass
+    BatchRenderer fleetBatch;
+    bool batchReported = false;
+    if (viewerOptions.batched) {
+        const uint32_t ufoMesh = fleetBatch.AddMesh(ufoModel);
+        for (std::size_t i = 0; i < fleet.size(); ++i) {
+            fleetBatch.AddObject(ufoMesh, glm::mat4(1.0f));
+        }
+    }
+    // Per-frame uniforms and instance transforms are written straight into a
+    // ring of mapped memory, three frames deep.
+    const GLsizeiptr uniformAlignment = UniformBufferOffsetAlignment();
+    GLsizeiptr streamBytes = uniformAlignment + static_cast<GLsizeiptr>(sizeof(FrameUniforms));
+    if (!fleet.empty() && !viewerOptions.batched) {
+        streamBytes += static_cast<GLsizeiptr>(fleet.size() * sizeof(InstanceTransform) + alignof(InstanceTransform));
+    }
+    StreamBuffer frameStream;
+    std::string streamError;
+    if (!frameStream.Create(streamBytes, 3, &streamError)) {
+        std::cerr << streamError << std::endl;
+        objectShaders.Destroy();
+        ufoModel.Destroy();
+        textureService.Destroy();
+        closeContext();
+        return EXIT_FAILURE;
+    }
+    std::cout << "Streaming per-frame data through " << (frameStream.Persistent() ? "a persistently" : "an explicitly flushed")
+              << " mapped ring of 3 x " << frameStream.BytesPerFrame() << " bytes\n";
+
+    float farPlane = 500.0f;
+    if (!fleet.empty()) {
+        const float fleetExtent = fleetSpacing * std::ceil(std::sqrt(static_cast<float>(fleet.size())));
+        camera.distance = std::max(camera.distance, fleetExtent * 0.9f);
+        camera.maxDistance = std::max(camera.maxDistance, fleetExtent * 2.0f);
+        farPlane = std::max(farPlane, camera.maxDistance + fleetExtent);
+        std::cout << "Drawing " << fleet.size() << (viewerOptions.batched ? " batched objects\n" : " instances\n");
+    }
+    double frameTimeSum = 0.0;
+    int frameTimeCount = 0;
+
+    // Draws use the generic program until their specialized variant is built.
+    ufoModel.RequestShaderVariants(objectShaders);
+
+    // Edits to the shaders, the OBJ/MTL or the textures are picked up live.
+    HotReloader hotReloader;
+    if (window) {
+        hotReloader.WatchShaders(objectShaders);
+        hotReloader.WatchTextures(textureService);
+        hotReloader.WatchModel(ufoModel, ufoPath, modelOptions, &objectShaders);
+    }
+
+    // Headless frames must not depend on how soon textures and shader
+    // variants arrive, so wait for all of them up front.
+    GpuTimer gpuTimer;
+    std::vector<HeadlessFrame> headlessFrames;
+    std::vector<GpuTiming> gpuTimings;
+    gfx::ImageRGBA8 frameImage;
+    const float pathDistance = camera.distance;
+    int warmupLeft = viewerOptions.warmupFrames;
+    if (viewerOptions.headless) {
+        textureService.Finish();
+        objectShaders.Finish();
+        gpuTimer.Create();
+        if (!viewerOptions.dumpDirectory.empty()) {
+            std::error_code directoryError;
+            std::filesystem::create_directories(viewerOptions.dumpDirectory, directoryError);
+        }
+    }
 
-    while (!glfwWindowShouldClose(window)) {
-        float currentTime = static_cast<float>(glfwGetTime());
+    // Headless runs time the GPU per frame themselves, and the overlay would
+    // end up in the dumped frames.
+    Profiler profiler;
+    ProfilerOverlay profilerOverlay;
+    bool showProfiler = false;
+    bool profilerKeyDown = false;
+    bool legendReported = false;
+    if (window) {
+        profiler.CreateGpuTimers(3, 2);
+        std::string overlayError;
+        if (profilerOverlay.Create(shaderRoot, &overlayError)) {
+            showProfiler = true;
+        } else {
+            std::cerr << "Profiler overlay disabled: " << overlayError << std::endl;
+        }
+    }
+    if (!viewerOptions.tracePath.empty()) {
+        profiler.StartTrace();
+    }
+
+    // Input is sampled after the pacer lets the frame start, right before
+    // it is recorded, instead of after the previous swap.
+    FramePacer framePacer;
+    framePacer.SetOptions(viewerOptions.pacing);
+    float pacingReportTime = 0.0f;
+
+    float previousTime = window ? static_cast<float>(glfwGetTime()) : 0.0f;
+    bool texturesReported = false;
+    bool shadersReported = false;
+    GlCallStats reportedCalls;
+
+    while (window ? !glfwWindowShouldClose(window) : headlessFrames.size() < static_cast<std::size_t>(viewerOptions.frames)) {
+        const auto frameStart = std::chrono::steady_clock::now();
+        profiler.BeginFrame();
+        ProfileZone streamingZone(profiler, "Streaming");
+        hotReloader.Pump();
+        for (const std::string& message : hotReloader.TakeMessages()) {
+            std::cout << message << "\n";
+        }
+        textureService.Pump();
+        if (!texturesReported && textureService.PendingCount() == 0) {
+            for (const gfx::TextureLoadTiming& timing : textureService.Timings()) {
+                std::cout << "Texture " << timing.path.filename().string();
+                if (timing.failed) {
+                    std::cout << " failed: " << timing.error << "\n";
+                    continue;
+                }
+                std::cout << " " << timing.width << "x" << timing.height << (timing.compressed ? " (BCn)" : "")
+                          << ": decode " << timing.decodeMs
+                          << " ms, upload " << timing.uploadMs << " ms, ready after " << timing.latencyMs << " ms\n";
+            }
+            texturesReported = true;
+        }
+        objectShaders.Pump();
+        if (!shadersReported && objectShaders.PendingCount() == 0) {
+            const ShaderVariantStats& variantStats = objectShaders.Stats();
+            const ProgramBinaryCacheStats& programCacheStats = programCache.Stats();
+            std::cout << "Shader variants: " << variantStats.ready << " ready"
+                      << (objectShaders.Parallel() ? " (parallel compile)" : " (deferred compile)") << " after "
+                      << variantStats.latencyMs << " ms, " << variantStats.threadMs << " ms on the GL thread";
+            if (programCache.Enabled()) {
+                std::cout << ", program cache " << programCacheStats.hits << "/"
+                          << programCacheStats.hits + programCacheStats.misses << " hits ("
+                          << programCacheStats.HitRate() * 100.0 << "%)";
+                if (programCacheStats.rejected > 0) {
+                    std::cout << ", " << programCacheStats.rejected << " rejected";
+                }
+            } else {
+                std::cout << ", program cache unsupported by the driver";
+            }
+            std::cout << "\n";
+            shadersReported = true;
+        }
+        streamingZone.End();
+
+        if (window) {
+            ProfileZone pacingZone(profiler, "Pacing");
+            framePacer.WaitForFrame();
+            glfwPollEvents();
+            framePacer.InputSampled();
+        }
+
+        ProfileZone cameraZone(profiler, "Camera");
+        float currentTime = window ? static_cast<float>(glfwGetTime()) : static_cast<float>(headlessFrames.size()) / 60.0f;
         float deltaTime = currentTime - previousTime;
         previousTime = currentTime;
+        if (!fleet.empty() && window) {
+            frameTimeSum += deltaTime;
+            ++frameTimeCount;
+            if (frameTimeSum >= 1.0) {
+                std::cout << fleet.size() << " instances: " << frameTimeSum * 1000.0 / frameTimeCount << " ms/frame ("
+                          << frameTimeCount / frameTimeSum << " fps), " << drawnInstances.size() << " drawn, "
+                          << fleetUpdater.Stats().Culled() << " outside the frustum (" << fleetUpdater.Stats().ms << " ms "
+                          << FrustumCuller::InstructionSet() << " on " << frameJobs.ThreadCount() << " threads)";
+                if (viewerOptions.occlusion) {
+                    std::cout << ", " << occlusionStats.Culled() << " occluded by " << occlusionStats.occluders << " ("
+                              << occlusionStats.triangles << " triangles, raster " << occlusionStats.rasterMs
+                              << " ms, test " << occlusionStats.testMs << " ms)";
+                }
+                std::cout << "\n";
+                frameTimeSum = 0.0;
+                frameTimeCount = 0;
+            }
+        }
 
-        UpdateCameraFromKeyboard(window, camera, deltaTime);
-
-        int width, height;
-        glfwGetFramebufferSize(window, &width, &height);
+        int width = offscreen.Width();
+        int height = offscreen.Height();
+        if (window) {
+            UpdateCameraFromKeyboard(window, camera, deltaTime);
+            glfwGetFramebufferSize(window, &width, &height);
+            const bool profilerKey = glfwGetKey(window, GLFW_KEY_P) == GLFW_PRESS;
+            if (profilerKey && !profilerKeyDown) {
+                showProfiler = !showProfiler;
+            }
+            profilerKeyDown = profilerKey;
+        } else {
+            FollowCameraPath(camera, currentTime, pathDistance);
+        }
         float aspect = width > 0 && height > 0 ? static_cast<float>(width) / static_cast<float>(height) : 1.0f;
 
-        glViewport(0, 0, width, height);
-        glClearColor(0.02f, 0.02f, 0.05f, 1.0f);
-        glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
-
         glm::vec3 target(0.0f, 15.0f, 0.0f);
         glm::vec3 cameraOffset;
         cameraOffset.x = camera.distance * std::cos(camera.pitch) * std::sin(camera.yaw);
@@ -225,32 +874,281 @@ int main() {
         glm::vec3 cameraPos = target + cameraOffset;
 
         glm::mat4 view = glm::lookAt(cameraPos, target, glm::vec3(0.0f, 1.0f, 0.0f));
-        glm::mat4 projection = glm::perspective(glm::radians(45.0f), aspect, 0.1f, 500.0f);
+        const float fovY = glm::radians(45.0f);
+        glm::mat4 projection = glm::perspective(fovY, aspect, 0.1f, farPlane);
+        const LodSelector lodSelector = LodSelector::ForPerspective(fovY, height);
+        const Frustum frustum = Frustum::FromViewProjection(projection * view);
+
+        sceneGraph.SetRotation(ufoNode, glm::angleAxis(currentTime * 0.15f, glm::vec3(0.0f, 1.0f, 0.0f)));
+        sceneGraph.Update();
+        const glm::mat4& model = sceneGraph.World(ufoNode);
+        cameraZone.End();
+
+        ProfileZone cullZone(profiler, "Cull");
+        if (!fleet.empty()) {
+            fleetUpdater.Update(frameJobs, currentTime, ufoModel.Bounds().radius * 0.2f, ufoModel.Box(), frustum);
+        }
+        // The UFOs covering the most screen occlude the rest. Each frame's
+        // pass runs on a worker through the rest of that frame, the swap
+        // and the wait for the next one, whose draws then use it: a UFO
+        // may show up one frame late. UFOs the pass did not test, such as
+        // those just entering the frustum, are drawn.
+        if (occlusionCuller.Pending()) {
+            std::fill(occluded.begin(), occluded.end(), 0);
+            for (uint32_t i : occlusionTested) {
+                occluded[i] = 1;
+            }
+            for (uint32_t k : occlusionCuller.Wait()) {
+                occluded[occlusionTested[k]] = 0;
+            }
+            occlusionStats = occlusionCuller.Stats();
+        }
+        drawnInstances.clear();
+        for (uint32_t i : visibleInstances) {
+            if (!occluded[i]) {
+                drawnInstances.push_back(i);
+            }
+        }
+        if (!fleet.empty() && viewerOptions.occlusion) {
+            occlusionTested = visibleInstances;
+            OcclusionScene scene;
+            scene.viewProjection = projection * view;
+            visibleSpheres.clear();
+            for (uint32_t i : visibleInstances) {
+                visibleSpheres.push_back(TransformSphere(ufoModel.Bounds(), fleetTransforms[i].model));
+                scene.boxes.push_back(TransformBox(ufoModel.Box(), fleetTransforms[i].model));
+            }
+            for (uint32_t k : SelectOccluders(visibleSpheres, cameraPos, kMaxOccluders)) {
+                scene.occluders.push_back(Occluder{ufoModel.OcclusionMesh(), fleetTransforms[visibleInstances[k]].model});
+            }
+            occlusionCuller.CullAsync(std::move(scene));
+        }
+        cullZone.End();
+
+        GpuProfileZone sceneGpuZone(profiler, "Scene");
+        if (window) {
+            gl::Viewport(0, 0, width, height);
+        } else {
+            if (warmupLeft == 0) {
+                gpuTimer.Begin(headlessFrames.size());
+            }
+            offscreen.Bind();
+        }
+        gl::ClearColor(0.02f, 0.02f, 0.05f, 1.0f);
+        gl::Clear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
 
-        glm::mat4 model = glm::mat4(1.0f);
-        model = glm::rotate(model, currentTime * 0.15f, glm::vec3(0.0f, 1.0f, 0.0f));
-        model = glm::scale(model, glm::vec3(1.4f));
-        glm::mat3 normalMatrix = glm::mat3(glm::transpose(glm::inverse(model)));
+        ProfileZone uniformZone(profiler, "Uniforms");
+        frameStream.BeginFrame();
+        frameUniforms.view = view;
+        frameUniforms.projection = projection;
+        frameUniforms.cameraPos = glm::vec4(cameraPos, 1.0f);
+        const StreamAllocation frameUniformData = frameStream.Allocate(sizeof(FrameUniforms), uniformAlignment);
+        if (frameUniformData) {
+            // Mapped memory may be write-combined: write once, never read.
+            *static_cast<FrameUniforms*>(frameUniformData.data) = frameUniforms;
+            frameStream.BindRange(GL_UNIFORM_BUFFER, static_cast<GLuint>(UniformBlock::Frame), frameUniformData);
+        }
+        uniformZone.End();
 
-        shaderProgram.Use();
-        shaderProgram.SetMat4("uModel", model);
-        shaderProgram.SetMat4("uView", view);
-        shaderProgram.SetMat4("uProjection", projection);
-        shaderProgram.SetMat3("uNormalMatrix", normalMatrix);
-        shaderProgram.SetVec3("uLightDir", lightDir);
-        shaderProgram.SetVec3("uLightColor", lightColor);
-        shaderProgram.SetVec3("uAmbientColor", ambientColor);
-        shaderProgram.SetVec3("uCameraPos", cameraPos);
-        shaderProgram.SetInt("uDiffuseMap", 0);
+        // Clicks pick the nearest triangle among the UFOs drawn this frame.
+        if (std::exchange(camera.clickPending, false) && ufoModel.Bvh()) {
+            const Ray worldRay = CursorRay(window, camera.clickX, camera.clickY, projection * view);
+            RayHit nearest;
+            std::size_t selected = 0;
+            auto pick = [&](std::size_t object, const glm::mat4& transform) {
+                Ray ray = TransformRay(worldRay, glm::inverse(transform));
+                ray.tMax = std::min(ray.tMax, nearest.t);
+                RayHit hit;
+                if (ufoModel.Bvh()->Intersect(ray, hit)) {
+                    nearest = hit;
+                    selected = object;
+                }
+            };
+            if (fleet.empty()) {
+                pick(0, model);
+            } else {
+                for (uint32_t i : drawnInstances) {
+                    pick(i, fleetTransforms[i].model);
+                }
+            }
+            if (nearest.Hit()) {
+                const glm::vec3 point = worldRay.origin + worldRay.direction * nearest.t;
+                std::cout << "Selected " << (fleet.empty() ? "the UFO" : "UFO #" + std::to_string(selected))
+                          << ", triangle " << nearest.triangle << " at (" << point.x << ", " << point.y << ", "
+                          << point.z << ")\n";
+            } else {
+                std::cout << "Nothing under the cursor\n";
+            }
+        }
 
-        ufoModel.Draw(shaderProgram);
+        ProfileZone drawZone(profiler, "Draw");
+        // Only drawn UFOs are uploaded, by the jobs straight into the mapped
+        // ring, before the frame's single commit. One LOD for all of them,
+        // fine enough for the nearest.
+        StreamAllocation instanceData;
+        float maxObjectError = 0.0f;
+        if (!fleet.empty() && !viewerOptions.batched) {
+            instanceData = frameStream.Allocate(static_cast<GLsizeiptr>(drawnInstances.size() * sizeof(InstanceTransform)),
+                                                alignof(InstanceTransform));
+            if (instanceData) {
+                maxObjectError = fleetUpdater.BuildInstances(frameJobs, drawnInstances, ufoModel.Bounds(), lodSelector, cameraPos,
+                                                             static_cast<InstanceTransform*>(instanceData.data));
+            } else {
+                visibleTransforms.resize(drawnInstances.size());
+                maxObjectError = fleetUpdater.BuildInstances(frameJobs, drawnInstances, ufoModel.Bounds(), lodSelector, cameraPos,
+                                                             visibleTransforms.data());
+            }
+        }
+        frameStream.Commit();
+        if (fleet.empty()) {
+            ufoModel.Draw(objectShaders, sceneGraph.Transform(ufoNode),
+                          lodSelector.MaxObjectError(model, ufoModel.Bounds(), cameraPos));
+        } else if (viewerOptions.batched) {
+            // drawnInstances is in increasing order.
+            std::size_t nextDrawn = 0;
+            for (uint32_t i = 0; i < fleetTransforms.size(); ++i) {
+                const bool drawn = nextDrawn < drawnInstances.size() && drawnInstances[nextDrawn] == i;
+                nextDrawn += drawn ? 1 : 0;
+                fleetBatch.SetTransform(i, fleetTransforms[i]);
+                fleetBatch.SetVisible(i, drawn);
+            }
+            // Culls the chunks of the drawn UFOs against the frustum again.
+            fleetBatch.Draw(objectShaders, lodSelector, cameraPos, &frustum);
+            if (!batchReported) {
+                const BatchStats& batchStats = fleetBatch.Stats();
+                std::cout << "Batched " << batchStats.objects << " objects into " << batchStats.commands << " commands, "
+                          << batchStats.batches << " batches in " << batchStats.buildMs << " ms"
+                          << (fleetBatch.MultiDrawIndirect() ? " (multi-draw indirect)" : " (one draw per command)") << "\n";
+                batchReported = true;
+            }
+        } else {
+            if (instanceData) {
+                fleetBuffer.Stream(frameStream, instanceData, static_cast<GLsizei>(drawnInstances.size()));
+            } else {
+                fleetBuffer.Update(visibleTransforms);
+            }
+            if (!drawnInstances.empty()) {
+                ufoModel.DrawInstanced(objectShaders, fleetBuffer, maxObjectError);
+            }
+        }
+        frameStream.EndFrame();
+        drawZone.End();
+        sceneGpuZone.End();
 
-        glfwSwapBuffers(window);
-        glfwPollEvents();
+        if (showProfiler) {
+            ProfileZone overlayZone(profiler, "Overlay");
+            GpuProfileZone overlayGpuZone(profiler, "Overlay");
+            profilerOverlay.Draw(profiler, width, height);
+        }
+
+        if (window) {
+            ProfileZone swapZone(profiler, "Swap");
+            glfwSwapBuffers(window);
+            framePacer.EndFrame();
+        } else if (warmupLeft > 0) {
+            --warmupLeft;
+        } else {
+            gpuTimer.End();
+            HeadlessFrame frame;
+            frame.time = currentTime;
+            frame.cpuMs = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - frameStart).count();
+            frame.drawn = fleet.empty() ? 1 : drawnInstances.size();
+            const std::size_t frameIndex = headlessFrames.size();
+            headlessFrames.push_back(frame);
+            if (!viewerOptions.dumpDirectory.empty() && frameIndex % static_cast<std::size_t>(viewerOptions.dumpEvery) == 0) {
+                char name[32];
+                std::snprintf(name, sizeof(name), "frame_%05zu.png", frameIndex);
+                offscreen.ReadPixels(frameImage);
+                std::string imageError;
+                if (!gfx::EncodePng(viewerOptions.dumpDirectory / name, frameImage, &imageError)) {
+                    std::cerr << imageError << std::endl;
+                }
+            }
+            gpuTimer.Collect(gpuTimings);
+        }
+
+        GlCallCounter::EndFrame();
+        const GlCallStats& calls = GlCallCounter::LastFrame();
+        if (calls.calls != reportedCalls.calls) {
+            std::cout << "GL calls/frame: " << calls.Total() << " (uniform " << calls.Of(GlCall::Uniform) << ", bind "
+                      << calls.Of(GlCall::Bind) << ", buffer " << calls.Of(GlCall::BufferUpdate) << ", draw "
+                      << calls.Of(GlCall::Draw) << ", other " << calls.Of(GlCall::Other) << ")\n";
+            reportedCalls = calls;
+        }
+
+        profiler.EndFrame();
+        if (showProfiler && !legendReported) {
+            std::cout << ProfilerOverlay::Legend(profiler) << "\n";
+            legendReported = true;
+        }
+        if (window && currentTime - pacingReportTime >= 5.0f) {
+            PrintPacingStats(framePacer, *viewerOptions.presentMode);
+            pacingReportTime = currentTime;
+        }
     }
 
+    int exitCode = EXIT_SUCCESS;
+    if (viewerOptions.headless) {
+        gpuTimer.Collect(gpuTimings, true);
+        for (const GpuTiming& timing : gpuTimings) {
+            headlessFrames[timing.tag].gpuMs = timing.ms;
+        }
+        const TimingSummary cpu = Summarize(headlessFrames, &HeadlessFrame::cpuMs);
+        const TimingSummary gpu = Summarize(headlessFrames, &HeadlessFrame::gpuMs);
+        std::cout << headlessFrames.size() << " frames: CPU " << cpu.mean << " ms mean, " << cpu.p95 << " ms p95; GPU "
+                  << gpu.mean << " ms mean, " << gpu.p95 << " ms p95\n";
+        if (!viewerOptions.timingsPath.empty()) {
+            std::string reportError;
+            const char* renderer = reinterpret_cast<const char*>(glGetString(GL_RENDERER));
+            if (WriteHeadlessReport(viewerOptions.timingsPath, viewerOptions, renderer ? renderer : "", headlessFrames,
+                                    &reportError)) {
+                std::cout << "Wrote " << viewerOptions.timingsPath.string() << "\n";
+            } else {
+                std::cerr << reportError << std::endl;
+                exitCode = EXIT_FAILURE;
+            }
+        }
+    }
+
+    for (std::size_t zone = 0; zone < profiler.ZoneCount(); ++zone) {
+        const ZoneStats stats = profiler.Stats(zone);
+        if (stats.samples == 0) {
+            continue;
+        }
+        std::cout << (profiler.IsGpuZone(zone) ? "GPU " : "CPU ") << profiler.ZoneName(zone) << ": " << stats.mean
+                  << " ms mean, " << stats.p50 << " p50, " << stats.p95 << " p95, " << stats.p99 << " p99 over the last "
+                  << stats.samples << " frames\n";
+    }
+    if (!viewerOptions.tracePath.empty()) {
+        std::string traceError;
+        if (profiler.WriteChromeTrace(viewerOptions.tracePath, &traceError)) {
+            std::cout << "Wrote " << viewerOptions.tracePath.string() << "\n";
+        } else {
+            std::cerr << traceError << std::endl;
+            exitCode = EXIT_FAILURE;
+        }
+    }
+
+    if (window) {
+        PrintPacingStats(framePacer, *viewerOptions.presentMode);
+    }
+
+    framePacer.Destroy();
+    profilerOverlay.Destroy();
+    profiler.DestroyGpuTimers();
+    gpuTimer.Destroy();
+    offscreen.Destroy();
+    fleetBatch.Destroy();
+    const StreamBufferStats& streamStats = frameStream.Stats();
+    std::cout << "Stream buffer: " << streamStats.peakFrameBytes << " of " << frameStream.BytesPerFrame()
+              << " bytes per frame at peak, " << streamStats.fenceWaits << " fence waits (" << streamStats.fenceWaitMs
+              << " ms), " << streamStats.orphans << " orphaned, " << streamStats.overflows << " overflows\n";
+
+    fleetBuffer.Destroy();
+    frameStream.Destroy();
+    objectShaders.Destroy();
     ufoModel.Destroy();
-    glfwDestroyWindow(window);
-    glfwTerminate();
-    return EXIT_SUCCESS;
+    textureService.Destroy();
+    closeContext();
+    return exitCode;
 }
@@ -4,44 +4,113 @@ in VS_OUT {
     vec3 normal;
     vec3 worldPos;
     vec2 uv;
+    vec4 tangent;
+#ifdef BATCHED
+    flat int materialIndex;
+#endif
 } fs_in;
 
+// Per-frame state shared with object.vert; std140 mirror of FrameUniforms.
+layout(std140) uniform FrameBlock {
+    mat4 uView;
+    mat4 uProjection;
+    vec4 uCameraPos;
+    vec4 uLightDir;
+    vec4 uLightColor;
+    vec4 uAmbientColor;
+};
+
+#ifdef BATCHED
+// BatchRenderer's materials: each MaterialUniforms as two texels, the flags
+// stored as 0.0/1.0. main() loads the draw's entry into uMaterial.
+uniform samplerBuffer uMaterials;
+
 struct Material {
     vec3 diffuseColor;
     float shininess;
     int hasDiffuseMap;
+    int hasNormalMap;
+    float normalScale;
 };
+Material uMaterial;
+
+Material FetchMaterial(int index) {
+    vec4 first = texelFetch(uMaterials, index * 2);
+    vec4 second = texelFetch(uMaterials, index * 2 + 1);
+    return Material(first.rgb, first.a, second.x > 0.5 ? 1 : 0, second.y > 0.5 ? 1 : 0, second.z);
+}
+#else
+// One range per draw call; std140 mirror of MaterialUniforms.
+layout(std140) uniform MaterialBlock {
+    vec3 diffuseColor;
+    float shininess;
+    int hasDiffuseMap;
+    int hasNormalMap;
+    float normalScale;
+} uMaterial;
+#endif
 
-uniform Material uMaterial;
-uniform vec3 uLightDir;
-uniform vec3 uLightColor;
-uniform vec3 uAmbientColor;
-uniform vec3 uCameraPos;
 uniform sampler2D uDiffuseMap;
+uniform sampler2D uNormalMap;
+
+// ShaderVariants builds this file once per material feature set with
+// MATERIAL_VARIANT defined, so the checks below are compile-time constants.
+// The generic build branches on the material flags instead.
+#ifdef MATERIAL_VARIANT
+#ifdef HAS_DIFFUSE_MAP
+#define USE_DIFFUSE_MAP true
+#else
+#define USE_DIFFUSE_MAP false
+#endif
+#ifdef HAS_NORMAL_MAP
+#define USE_NORMAL_MAP true
+#else
+#define USE_NORMAL_MAP false
+#endif
+#else
+#define USE_DIFFUSE_MAP (uMaterial.hasDiffuseMap == 1)
+#define USE_NORMAL_MAP (uMaterial.hasNormalMap == 1)
+#endif
 
 out vec4 FragColor;
 
+// Only the RG channels are read (BC5 normal maps carry no blue); z is
+// rebuilt and the slope scaled by the material's bump multiplier.
+vec3 PerturbNormal(vec3 N) {
+    vec3 T = normalize(fs_in.tangent.xyz - N * dot(N, fs_in.tangent.xyz));
+    vec3 B = cross(N, T) * fs_in.tangent.w;
+    vec2 xy = texture(uNormalMap, fs_in.uv).rg * 2.0 - 1.0;
+    float z = sqrt(max(1.0 - dot(xy, xy), 0.0));
+    return normalize(mat3(T, B, N) * vec3(xy * uMaterial.normalScale, z));
+}
+
 void main() {
+#ifdef BATCHED
+    uMaterial = FetchMaterial(fs_in.materialIndex);
+#endif
     vec3 N = normalize(fs_in.normal);
-    vec3 L = normalize(-uLightDir);
-    vec3 V = normalize(uCameraPos - fs_in.worldPos);
+    if (USE_NORMAL_MAP) {
+        N = PerturbNormal(N);
+    }
+    vec3 L = normalize(-uLightDir.xyz);
+    vec3 V = normalize(uCameraPos.xyz - fs_in.worldPos);
 
     vec3 albedo = uMaterial.diffuseColor;
-    if (uMaterial.hasDiffuseMap == 1) {
+    if (USE_DIFFUSE_MAP) {
         albedo *= texture(uDiffuseMap, fs_in.uv).rgb;
     }
 
     float diff = max(dot(N, L), 0.0);
-    vec3 diffuse = diff * albedo * uLightColor;
+    vec3 diffuse = diff * albedo * uLightColor.rgb;
 
     vec3 specular = vec3(0.0);
     if (diff > 0.0) {
         vec3 H = normalize(L + V);
         float spec = pow(max(dot(N, H), 0.0), uMaterial.shininess);
-        specular = spec * uLightColor * 0.35;
+        specular = spec * uLightColor.rgb * 0.35;
     }
 
-    vec3 ambient = albedo * uAmbientColor;
+    vec3 ambient = albedo * uAmbientColor.rgb;
     vec3 finalColor = ambient + diffuse + specular;
     FragColor = vec4(finalColor, 1.0);
 }
@@ -3,24 +3,87 @@
 layout(location = 0) in vec3 aPosition;
 layout(location = 1) in vec3 aNormal;
 layout(location = 2) in vec2 aTexCoord;
+// xyz tangent, w bitangent sign (float, or 2_10_10_10 for packed vertices).
+layout(location = 3) in vec4 aTangent;
 
+#ifdef BATCHED
+// BatchRenderer's per-draw record: x is the object, y the material. Each
+// indirect command's baseInstance selects its record, so this plays the
+// part of gl_DrawID on a 4.1 context.
+layout(location = 11) in uvec2 aDrawRecord;
+// Nine texels per object: model matrix, normal matrix columns, then the
+// packed-position offset and scale (see kBatchObjectTexels).
+uniform samplerBuffer uObjects;
+#elif defined(INSTANCED)
+// Per-instance InstanceTransform, see InstanceBuffer.hpp.
+layout(location = 4) in mat4 aInstanceModel;
+layout(location = 8) in mat3 aInstanceNormal;
+#define MODEL_MATRIX aInstanceModel
+#define NORMAL_MATRIX aInstanceNormal
+#else
 uniform mat4 uModel;
-uniform mat4 uView;
-uniform mat4 uProjection;
 uniform mat3 uNormalMatrix;
+#define MODEL_MATRIX uModel
+#define NORMAL_MATRIX uNormalMatrix
+#endif
+
+// Per-frame state shared with object.frag; std140 mirror of FrameUniforms.
+layout(std140) uniform FrameBlock {
+    mat4 uView;
+    mat4 uProjection;
+    vec4 uCameraPos;
+    vec4 uLightDir;
+    vec4 uLightColor;
+    vec4 uAmbientColor;
+};
+
+// Packed vertices store positions as unorm16 within the mesh bounds and
+// normals octahedral-encoded in two snorm16 components. For float vertices
+// the offset is 0, the scale is 1 and uOctahedralNormals is 0.
+#ifndef BATCHED
+uniform vec3 uPositionOffset;
+uniform vec3 uPositionScale;
+#endif
+uniform int uOctahedralNormals;
 
 out VS_OUT {
     vec3 normal;
     vec3 worldPos;
     vec2 uv;
+    vec4 tangent;
+#ifdef BATCHED
+    flat int materialIndex;
+#endif
 } vs_out;
 
+vec3 DecodeOctahedral(vec2 e) {
+    vec3 n = vec3(e, 1.0 - abs(e.x) - abs(e.y));
+    float t = max(-n.z, 0.0);
+    n.xy += vec2(n.x >= 0.0 ? -t : t, n.y >= 0.0 ? -t : t);
+    return normalize(n);
+}
+
 void main() {
-    vec4 worldPosition = uModel * vec4(aPosition, 1.0);
+#ifdef BATCHED
+    int object = int(aDrawRecord.x) * 9;
+    mat4 modelMatrix = mat4(texelFetch(uObjects, object), texelFetch(uObjects, object + 1),
+                            texelFetch(uObjects, object + 2), texelFetch(uObjects, object + 3));
+    mat3 normalMatrix = mat3(texelFetch(uObjects, object + 4).xyz, texelFetch(uObjects, object + 5).xyz,
+                             texelFetch(uObjects, object + 6).xyz);
+    vec3 position = texelFetch(uObjects, object + 7).xyz + aPosition * texelFetch(uObjects, object + 8).xyz;
+    vs_out.materialIndex = int(aDrawRecord.y);
+#else
+    mat4 modelMatrix = MODEL_MATRIX;
+    mat3 normalMatrix = NORMAL_MATRIX;
+    vec3 position = uPositionOffset + aPosition * uPositionScale;
+#endif
+    vec3 normal = uOctahedralNormals == 1 ? DecodeOctahedral(aNormal.xy) : aNormal;
+
+    vec4 worldPosition = modelMatrix * vec4(position, 1.0);
     vs_out.worldPos = worldPosition.xyz;
-    vs_out.normal = normalize(uNormalMatrix * aNormal);
+    vs_out.normal = normalize(normalMatrix * normal);
     vs_out.uv = aTexCoord;
+    vs_out.tangent = vec4(mat3(modelMatrix) * aTangent.xyz, aTangent.w < 0.0 ? -1.0 : 1.0);
 
     gl_Position = uProjection * uView * worldPosition;
 }
-
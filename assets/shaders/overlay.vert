@@ -0,0 +1,12 @@
+#version 410 core
+
+// ProfilerOverlay's vertices arrive in normalized device coordinates.
+layout(location = 0) in vec2 aPosition;
+layout(location = 1) in vec4 aColor;
+
+out vec4 vColor;
+
+void main() {
+    vColor = aColor;
+    gl_Position = vec4(aPosition, 0.0, 1.0);
+}
@@ -0,0 +1,202 @@
+// Builds a MeshBvh over an OBJ (or a procedural bumpy sphere) on one thread
+// and on all of them, then traces coherent camera rays and random rays both
+// one at a time and as packets. Packets must report exactly the hits of
+// single rays.
+//
+// Usage: BvhBench [file.obj] [raysPerSide]
+
+#include "MeshBvh.hpp"
+#include "ObjLoader.hpp"
+#include "ThreadPool.hpp"
+
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <random>
+#include <string>
+#include <vector>
+
+#include <glm/glm.hpp>
+
+namespace {
+
+using Clock = std::chrono::steady_clock;
+
+constexpr float kPi = 3.14159265358979f;
+
+double MillisecondsSince(Clock::time_point start) {
+    return std::chrono::duration<double, std::milli>(Clock::now() - start).count();
+}
+
+// A unit sphere with ridges, 2 * rings * segments triangles.
+void MakeBumpySphere(int rings, int segments, std::vector<glm::vec3>& positions, std::vector<uint32_t>& indices) {
+    for (int ring = 0; ring <= rings; ++ring) {
+        const float theta = kPi * static_cast<float>(ring) / static_cast<float>(rings);
+        for (int segment = 0; segment <= segments; ++segment) {
+            const float phi = 2.0f * kPi * static_cast<float>(segment) / static_cast<float>(segments);
+            const float radius = 1.0f + 0.05f * std::sin(theta * 23.0f) * std::cos(phi * 17.0f);
+            positions.emplace_back(radius * std::sin(theta) * std::cos(phi), radius * std::cos(theta),
+                                   radius * std::sin(theta) * std::sin(phi));
+        }
+    }
+    const uint32_t stride = static_cast<uint32_t>(segments + 1);
+    for (uint32_t ring = 0; ring < static_cast<uint32_t>(rings); ++ring) {
+        for (uint32_t segment = 0; segment < static_cast<uint32_t>(segments); ++segment) {
+            const uint32_t a = ring * stride + segment;
+            const uint32_t b = a + stride;
+            indices.insert(indices.end(), {a, b, a + 1, a + 1, b, b + 1});
+        }
+    }
+}
+
+// raysPerSide^2 rays through an image plane in front of the mesh, ordered
+// in 2x2 pixel quads so each packet covers neighbouring pixels.
+std::vector<Ray> CameraRays(const BoundingBox& box, int raysPerSide) {
+    const glm::vec3 center = box.Center();
+    const float size = glm::length(box.Extents());
+    const glm::vec3 eye = center + glm::vec3(0.3f, 0.4f, 2.5f) * size;
+    const glm::vec3 forward = glm::normalize(center - eye);
+    const glm::vec3 right = glm::normalize(glm::cross(forward, glm::vec3(0.0f, 1.0f, 0.0f)));
+    const glm::vec3 up = glm::cross(right, forward);
+    auto rayAt = [&](int x, int y) {
+        const float u = (static_cast<float>(x) + 0.5f) / static_cast<float>(raysPerSide) * 2.0f - 1.0f;
+        const float v = (static_cast<float>(y) + 0.5f) / static_cast<float>(raysPerSide) * 2.0f - 1.0f;
+        Ray ray;
+        ray.origin = eye;
+        ray.direction = forward + (right * u + up * v) * 0.45f;
+        return ray;
+    };
+    std::vector<Ray> rays;
+    for (int y = 0; y < raysPerSide; y += 2) {
+        for (int x = 0; x < raysPerSide; x += 2) {
+            rays.insert(rays.end(), {rayAt(x, y), rayAt(x + 1, y), rayAt(x, y + 1), rayAt(x + 1, y + 1)});
+        }
+    }
+    return rays;
+}
+
+// Rays from random points around the mesh towards random points inside it.
+std::vector<Ray> RandomRays(const BoundingBox& box, std::size_t count) {
+    std::mt19937 random(1234);
+    std::uniform_real_distribution<float> unit(-1.0f, 1.0f);
+    const glm::vec3 center = box.Center();
+    const glm::vec3 extents = box.Extents();
+    const float size = glm::length(extents);
+    std::vector<Ray> rays(count);
+    for (Ray& ray : rays) {
+        glm::vec3 direction(unit(random), unit(random), unit(random));
+        direction = glm::length(direction) > 1e-3f ? glm::normalize(direction) : glm::vec3(0.0f, 0.0f, 1.0f);
+        ray.origin = center + direction * size * 2.0f;
+        ray.direction = center + glm::vec3(unit(random), unit(random), unit(random)) * extents - ray.origin;
+    }
+    return rays;
+}
+
+struct TraceResult {
+    double singleMs = 0.0;
+    double packetMs = 0.0;
+    std::size_t hits = 0;
+    std::size_t mismatches = 0;
+};
+
+TraceResult Trace(const MeshBvh& bvh, const std::vector<Ray>& rays, int repetitions) {
+    TraceResult result;
+    std::vector<RayHit> single(rays.size());
+    std::vector<RayHit> packet(rays.size());
+    for (int r = 0; r < repetitions; ++r) {
+        auto start = Clock::now();
+        for (std::size_t i = 0; i < rays.size(); ++i) {
+            bvh.Intersect(rays[i], single[i]);
+        }
+        const double singleMs = MillisecondsSince(start);
+        start = Clock::now();
+        for (std::size_t i = 0; i + MeshBvh::kPacketSize <= rays.size(); i += MeshBvh::kPacketSize) {
+            bvh.IntersectPacket(std::span<const Ray, MeshBvh::kPacketSize>(rays.data() + i, MeshBvh::kPacketSize),
+                                std::span<RayHit, MeshBvh::kPacketSize>(packet.data() + i, MeshBvh::kPacketSize));
+        }
+        const double packetMs = MillisecondsSince(start);
+        if (r == 0 || singleMs < result.singleMs) {
+            result.singleMs = singleMs;
+        }
+        if (r == 0 || packetMs < result.packetMs) {
+            result.packetMs = packetMs;
+        }
+    }
+
+    const std::size_t packed = rays.size() / MeshBvh::kPacketSize * MeshBvh::kPacketSize;
+    for (std::size_t i = 0; i < packed; ++i) {
+        result.hits += single[i].Hit() ? 1 : 0;
+        // Ties between triangles sharing an edge may resolve differently,
+        // the distance may not.
+        if (single[i].Hit() != packet[i].Hit() || (single[i].Hit() && single[i].t != packet[i].t) ||
+            single[i].Hit() != bvh.Occluded(rays[i])) {
+            ++result.mismatches;
+        }
+    }
+    return result;
+}
+
+void Report(const char* name, std::size_t rayCount, const TraceResult& result) {
+    std::printf("%-8s %zu rays, %zu hit: single %.2f Mrays/s, packet %.2f Mrays/s (%.2fx)\n", name, rayCount,
+                result.hits, static_cast<double>(rayCount) / result.singleMs / 1000.0,
+                static_cast<double>(rayCount) / result.packetMs / 1000.0, result.singleMs / result.packetMs);
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+    std::vector<glm::vec3> positions;
+    std::vector<uint32_t> indices;
+    if (argc > 1) {
+        ObjMesh mesh;
+        std::string error;
+        ObjLoadOptions loadOptions;
+        loadOptions.threadCount = 0;
+        if (!LoadObjMesh(argv[1], mesh, loadOptions, &error)) {
+            std::fprintf(stderr, "%s\n", error.c_str());
+            return EXIT_FAILURE;
+        }
+        for (const VertexPNT& vertex : mesh.vertices) {
+            positions.push_back(vertex.position);
+        }
+        indices = std::move(mesh.indices);
+    } else {
+        MakeBumpySphere(384, 768, positions, indices);
+    }
+    const int raysPerSide = argc > 2 ? std::atoi(argv[2]) & ~1 : 512;
+    if (indices.empty() || raysPerSide <= 0) {
+        std::fprintf(stderr, "Usage: %s [file.obj] [raysPerSide]\n", argv[0]);
+        return EXIT_FAILURE;
+    }
+
+    MeshBvh bvh;
+    bvh.Build(positions, indices);
+    const BvhStats serial = bvh.Stats();
+    std::printf("%u triangles: %u nodes, %u leaves, depth %u, SAH cost %.2f\n", serial.triangles, serial.nodes,
+                serial.leaves, serial.maxDepth, serial.sahCost);
+    std::printf("build 1 thread  %.2f ms\n", serial.buildMs);
+    const unsigned threadCount = ThreadPool::DefaultThreadCount();
+    if (threadCount > 1) {
+        ThreadPool pool(threadCount - 1);
+        MeshBvh parallel;
+        parallel.Build(positions, indices, {}, &pool);
+        const BvhStats& stats = parallel.Stats();
+        std::printf("build %u threads %.2f ms (%.2fx), SAH cost %.2f\n", threadCount, stats.buildMs,
+                    serial.buildMs / stats.buildMs, stats.sahCost);
+    }
+
+    const std::vector<Ray> cameraRays = CameraRays(bvh.Bounds(), raysPerSide);
+    const std::vector<Ray> randomRays = RandomRays(bvh.Bounds(), cameraRays.size());
+    const TraceResult camera = Trace(bvh, cameraRays, 3);
+    const TraceResult random = Trace(bvh, randomRays, 3);
+    Report("coherent", cameraRays.size(), camera);
+    Report("random", randomRays.size(), random);
+    if (camera.mismatches + random.mismatches > 0) {
+        std::fprintf(stderr, "%zu packet or any-hit results disagree with single rays\n",
+                     camera.mismatches + random.mismatches);
+        return EXIT_FAILURE;
+    }
+    return EXIT_SUCCESS;
+}
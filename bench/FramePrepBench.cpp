@@ -0,0 +1,120 @@
+// Times the CPU side of a fleet frame (animation, frustum culling, LOD
+// selection and instance data, through FleetUpdater on a JobSystem) for
+// 1k, 10k and 100k UFOs against the thread count, and checks that every
+// thread count produces the same instance data as one thread.
+//
+// Usage: FramePrepBench [frames] [maxThreads]
+
+#include "Fleet.hpp"
+#include "JobSystem.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <thread>
+#include <vector>
+
+#include <glm/glm.hpp>
+#include <glm/gtc/matrix_transform.hpp>
+
+namespace {
+
+// Roughly the UFO's size, as the viewer's fleet layout expects.
+constexpr float kRadius = 12.0f;
+
+struct Run {
+    double meanMs = 0.0;
+    double bestMs = 0.0;
+    double stealsPerFrame = 0.0;
+    std::size_t drawn = 0;
+    std::vector<InstanceTransform> instances; // of the last frame
+};
+
+// The viewer's headless camera: an orbit swinging in and out, so the
+// visible share changes from frame to frame.
+Run Prepare(int count, unsigned threads, int frames) {
+    BoundingBox localBox;
+    localBox.min = glm::vec3(-kRadius, -kRadius * 0.3f, -kRadius);
+    localBox.max = glm::vec3(kRadius, kRadius * 0.3f, kRadius);
+    const BoundingSphere localSphere{glm::vec3(0.0f), kRadius};
+    const float spacing = kRadius * 1.4f * 2.5f;
+    const float extent = spacing * std::ceil(std::sqrt(static_cast<float>(count)));
+    const LodSelector lodSelector = LodSelector::ForPerspective(glm::radians(45.0f), 720);
+
+    JobSystem jobs(threads);
+    FleetUpdater fleet;
+    fleet.SetFleet(LayoutFleet(count, spacing));
+    Run run;
+    run.instances.resize(static_cast<std::size_t>(count));
+    constexpr int kWarmup = 5;
+    double totalMs = 0.0;
+    for (int frame = -kWarmup; frame < frames; ++frame) {
+        const float time = static_cast<float>(std::max(frame, 0)) / 60.0f;
+        const float yaw = glm::radians(45.0f) + time * 0.35f;
+        const float pitch = glm::radians(12.0f) + 0.15f * std::sin(time * 0.6f);
+        const float distance = extent * 0.9f * (1.0f + 0.3f * std::sin(time * 0.45f));
+        const glm::vec3 target(0.0f, 15.0f, 0.0f);
+        const glm::vec3 cameraPos = target + distance * glm::vec3(std::cos(pitch) * std::sin(yaw), std::sin(pitch),
+                                                                  std::cos(pitch) * std::cos(yaw));
+        const glm::mat4 view = glm::lookAt(cameraPos, target, glm::vec3(0.0f, 1.0f, 0.0f));
+        const glm::mat4 projection = glm::perspective(glm::radians(45.0f), 16.0f / 9.0f, 0.1f, extent * 4.0f);
+        const Frustum frustum = Frustum::FromViewProjection(projection * view);
+        if (frame == 0) {
+            jobs.ResetStats();
+        }
+
+        const auto start = std::chrono::steady_clock::now();
+        fleet.Update(jobs, time, kRadius * 0.2f, localBox, frustum);
+        fleet.BuildInstances(jobs, fleet.Visible(), localSphere, lodSelector, cameraPos, run.instances.data());
+        const double ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+        if (frame >= 0) {
+            totalMs += ms;
+            run.bestMs = frame == 0 ? ms : std::min(run.bestMs, ms);
+        }
+    }
+    run.meanMs = totalMs / frames;
+    run.stealsPerFrame = static_cast<double>(jobs.Stats().steals) / frames;
+    run.drawn = fleet.Visible().size();
+    run.instances.resize(run.drawn);
+    return run;
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+    const int frames = argc > 1 ? std::atoi(argv[1]) : 100;
+    const int maxThreads = argc > 2 ? std::atoi(argv[2]) : static_cast<int>(std::max(1u, std::thread::hardware_concurrency()));
+    if (frames <= 0 || maxThreads <= 0) {
+        std::fprintf(stderr, "Usage: %s [frames] [maxThreads]\n", argv[0]);
+        return EXIT_FAILURE;
+    }
+
+    // Powers of two, then the maximum itself.
+    std::vector<unsigned> threadCounts;
+    for (unsigned threads = 1; threads < static_cast<unsigned>(maxThreads); threads *= 2) {
+        threadCounts.push_back(threads);
+    }
+    threadCounts.push_back(static_cast<unsigned>(maxThreads));
+
+    for (int count : {1000, 10000, 100000}) {
+        Run serial;
+        for (unsigned threads : threadCounts) {
+            Run run = Prepare(count, threads, frames);
+            if (threads == 1) {
+                serial = run;
+            } else if (run.instances.size() != serial.instances.size() ||
+                       std::memcmp(run.instances.data(), serial.instances.data(),
+                                   run.instances.size() * sizeof(InstanceTransform)) != 0) {
+                std::fprintf(stderr, "%d UFOs on %u threads: instance data differs from one thread\n", count, threads);
+                return EXIT_FAILURE;
+            }
+            std::printf("%7d UFOs %3u threads %9.3f ms mean %9.3f ms best %6.2fx %8.1f steals/frame %7zu drawn\n", count,
+                        threads, run.meanMs, run.bestMs, serial.meanMs / run.meanMs, run.stealsPerFrame, run.drawn);
+        }
+    }
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,101 @@
+// Compares frustum culling one box at a time through Frustum::Intersects
+// against FrustumCuller's SIMD pass over the same boxes, and checks that
+// both keep the same set.
+//
+// Usage: FrustumCullBench [boxCount] [repetitions]
+
+#include "FrustumCuller.hpp"
+
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <random>
+#include <vector>
+
+#include <glm/glm.hpp>
+#include <glm/gtc/matrix_transform.hpp>
+
+namespace {
+
+// Unit-ish boxes scattered through a cube around the camera target, so
+// roughly a quarter of them end up inside the frustum.
+std::vector<BoundingBox> MakeBoxes(int count) {
+    std::mt19937 rng(1234);
+    std::uniform_real_distribution<float> position(-500.0f, 500.0f);
+    std::uniform_real_distribution<float> size(0.5f, 4.0f);
+    std::vector<BoundingBox> boxes(static_cast<std::size_t>(count));
+    for (BoundingBox& box : boxes) {
+        const glm::vec3 center(position(rng), position(rng), position(rng));
+        const glm::vec3 extents(size(rng), size(rng), size(rng));
+        box.min = center - extents;
+        box.max = center + extents;
+    }
+    return boxes;
+}
+
+template <typename CullFn>
+double BestOf(int repetitions, CullFn&& cull) {
+    double bestMs = 0.0;
+    for (int r = 0; r < repetitions; ++r) {
+        auto start = std::chrono::steady_clock::now();
+        cull();
+        double ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+        if (r == 0 || ms < bestMs) {
+            bestMs = ms;
+        }
+    }
+    return bestMs;
+}
+
+void Report(const char* name, std::size_t boxes, std::size_t visible, double ms) {
+    std::printf("%-16s %9zu boxes %9zu visible %9.3f ms %8.1f Mboxes/s\n", name, boxes, visible, ms,
+                static_cast<double>(boxes) / ms / 1000.0);
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+    int boxCount = argc > 1 ? std::atoi(argv[1]) : 1000000;
+    int repetitions = argc > 2 ? std::atoi(argv[2]) : 10;
+    if (boxCount <= 0 || repetitions <= 0) {
+        std::fprintf(stderr, "Usage: %s [boxCount] [repetitions]\n", argv[0]);
+        return EXIT_FAILURE;
+    }
+
+    const std::vector<BoundingBox> boxes = MakeBoxes(boxCount);
+    const glm::mat4 view = glm::lookAt(glm::vec3(0.0f, 0.0f, 0.0f), glm::vec3(1.0f, 0.2f, 0.5f), glm::vec3(0.0f, 1.0f, 0.0f));
+    const glm::mat4 projection = glm::perspective(glm::radians(70.0f), 16.0f / 9.0f, 0.1f, 800.0f);
+    const Frustum frustum = Frustum::FromViewProjection(projection * view);
+
+    std::vector<uint32_t> scalarVisible;
+    scalarVisible.reserve(boxes.size());
+    const double scalarMs = BestOf(repetitions, [&]() {
+        scalarVisible.clear();
+        for (uint32_t i = 0; i < boxes.size(); ++i) {
+            if (frustum.Intersects(boxes[i])) {
+                scalarVisible.push_back(i);
+            }
+        }
+    });
+    Report("scalar", boxes.size(), scalarVisible.size(), scalarMs);
+
+    FrustumCuller culler;
+    culler.Reserve(boxes.size());
+    for (const BoundingBox& box : boxes) {
+        culler.Add(box);
+    }
+    std::vector<uint32_t> simdVisible;
+    simdVisible.reserve(boxes.size());
+    const double simdMs = BestOf(repetitions, [&]() { culler.Cull(frustum, simdVisible); });
+    char name[32];
+    std::snprintf(name, sizeof(name), "SoA %s x%zu", FrustumCuller::InstructionSet(), FrustumCuller::kLanes);
+    Report(name, boxes.size(), simdVisible.size(), simdMs);
+
+    if (simdVisible != scalarVisible) {
+        std::fprintf(stderr, "Visible sets differ\n");
+        return EXIT_FAILURE;
+    }
+    std::printf("Speedup %.2fx\n", scalarMs / simdMs);
+    return EXIT_SUCCESS;
+}
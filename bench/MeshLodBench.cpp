@@ -0,0 +1,62 @@
+// Builds the LOD chain for an OBJ and prints triangles, error and the
+// simulated vertex cache behaviour of every level.
+//
+// Usage: MeshLodBench <file.obj> [maxRelativeError]
+
+#include "MeshOptimizer.hpp"
+#include "MeshSimplifier.hpp"
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <span>
+#include <string>
+
+int main(int argc, char** argv) {
+    if (argc < 2) {
+        std::fprintf(stderr, "Usage: %s <file.obj> [maxRelativeError]\n", argv[0]);
+        return EXIT_FAILURE;
+    }
+
+    ObjMesh mesh;
+    std::string error;
+    ObjLoadOptions loadOptions;
+    loadOptions.threadCount = 0;
+    if (!LoadObjMesh(argv[1], mesh, loadOptions, &error)) {
+        std::fprintf(stderr, "%s\n", error.c_str());
+        return EXIT_FAILURE;
+    }
+    OptimizeMesh(mesh);
+
+    MeshLodOptions lodOptions;
+    if (argc > 2) {
+        lodOptions.maxRelativeError = static_cast<float>(std::atof(argv[2]));
+    }
+
+    const std::size_t sourceIndexCount = mesh.indices.size();
+    auto start = std::chrono::steady_clock::now();
+    MeshLodReport report;
+    GenerateMeshLods(mesh, lodOptions, &report);
+    double ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+
+    const BoundingSphere bounds = ComputeBoundingSphere(mesh.vertices);
+    std::printf("%zu chunks, %zu vertices, radius %.3f, LOD build %.2f ms, index memory %zu -> %zu\n",
+                mesh.chunks.size(), mesh.vertices.size(), bounds.radius, ms, sourceIndexCount, mesh.indices.size());
+    for (std::size_t level = 0; level < report.triangles.size(); ++level) {
+        std::printf("LOD %zu  tris %9zu  max error %.5f (%.3f%% of radius)\n", level, report.triangles[level],
+                    report.errors[level], bounds.radius > 0.0f ? 100.0f * report.errors[level] / bounds.radius : 0.0f);
+    }
+
+    // Vertex cache stats of the deepest level for every chunk.
+    for (const MeshChunk& chunk : mesh.chunks) {
+        if (chunk.lods.empty()) {
+            continue;
+        }
+        const MeshLod& lod = chunk.lods.back();
+        VertexCacheStats stats = AnalyzeVertexCache(
+            std::span<const uint32_t>(mesh.indices.data() + lod.startIndex, lod.indexCount), mesh.vertices.size());
+        std::printf("chunk %-16s LOD %zu  tris %7zu  ACMR %.3f\n", chunk.material.name.c_str(), chunk.lods.size(),
+                    stats.triangles, stats.acmr);
+    }
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,136 @@
+// Runs OcclusionCuller headlessly on a synthetic city: a few large blocks
+// in front of the camera hide part of a grid of small boxes behind them.
+// Prints the timings and a hash of the visible set, which must not change
+// between runs, builds or the synchronous and asynchronous paths; the depth
+// buffer can be written as a PGM image to look at.
+//
+// Usage: OcclusionCullBench [gridSize] [repetitions] [depth.pgm]
+
+#include "OcclusionCuller.hpp"
+
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <memory>
+#include <vector>
+
+#include <glm/glm.hpp>
+#include <glm/gtc/matrix_transform.hpp>
+
+namespace {
+
+// Unit cube centred on the origin.
+std::shared_ptr<const OccluderMesh> MakeCube() {
+    auto cube = std::make_shared<OccluderMesh>();
+    for (int corner = 0; corner < 8; ++corner) {
+        cube->positions.emplace_back((corner & 1) ? 0.5f : -0.5f, (corner & 2) ? 0.5f : -0.5f, (corner & 4) ? 0.5f : -0.5f);
+    }
+    cube->indices = {0, 2, 1, 1, 2, 3, 4, 5, 6, 5, 7, 6, 0, 1, 4, 1, 5, 4,
+                     2, 6, 3, 3, 6, 7, 0, 4, 2, 2, 4, 6, 1, 3, 5, 3, 7, 5};
+    return cube;
+}
+
+OcclusionScene MakeScene(int gridSize) {
+    OcclusionScene scene;
+    const glm::mat4 view = glm::lookAt(glm::vec3(0.0f, 6.0f, 0.0f), glm::vec3(0.0f, 4.0f, -100.0f), glm::vec3(0.0f, 1.0f, 0.0f));
+    const glm::mat4 projection = glm::perspective(glm::radians(60.0f), 16.0f / 9.0f, 0.1f, 1000.0f);
+    scene.viewProjection = projection * view;
+
+    const std::shared_ptr<const OccluderMesh> cube = MakeCube();
+    for (int i = -2; i <= 2; ++i) {
+        glm::mat4 transform = glm::translate(glm::mat4(1.0f), glm::vec3(static_cast<float>(i) * 14.0f, 10.0f, -30.0f));
+        scene.occluders.push_back(Occluder{cube, glm::scale(transform, glm::vec3(10.0f, 20.0f, 4.0f))});
+    }
+
+    for (int z = 0; z < gridSize; ++z) {
+        for (int x = 0; x < gridSize; ++x) {
+            const glm::vec3 center(static_cast<float>(x - gridSize / 2) * 4.0f, 1.0f, -40.0f - static_cast<float>(z) * 4.0f);
+            BoundingBox box;
+            box.min = center - glm::vec3(1.0f);
+            box.max = center + glm::vec3(1.0f);
+            scene.boxes.push_back(box);
+        }
+    }
+    return scene;
+}
+
+uint64_t HashVisible(const std::vector<uint32_t>& visible) {
+    uint64_t hash = 1469598103934665603ull; // FNV-1a
+    for (uint32_t index : visible) {
+        hash = (hash ^ index) * 1099511628211ull;
+    }
+    return hash;
+}
+
+bool WritePgm(const char* path, const OcclusionCuller& culler) {
+    std::ofstream file(path, std::ios::binary);
+    file << "P5\n" << culler.Width() << " " << culler.Height() << "\n255\n";
+    const std::vector<float>& depth = culler.Depth();
+    // Top row first, and stretched: perspective depth crowds towards 1.
+    for (int y = culler.Height() - 1; y >= 0; --y) {
+        for (int x = 0; x < culler.Width(); ++x) {
+            const float value = depth[static_cast<std::size_t>(y) * culler.Width() + x];
+            file.put(static_cast<char>(static_cast<uint8_t>(glm::clamp((1.0f - value) * 20.0f, 0.0f, 1.0f) * 255.0f)));
+        }
+    }
+    return static_cast<bool>(file);
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+    int gridSize = argc > 1 ? std::atoi(argv[1]) : 64;
+    int repetitions = argc > 2 ? std::atoi(argv[2]) : 20;
+    if (gridSize <= 0 || repetitions <= 0) {
+        std::fprintf(stderr, "Usage: %s [gridSize] [repetitions] [depth.pgm]\n", argv[0]);
+        return EXIT_FAILURE;
+    }
+
+    const OcclusionScene scene = MakeScene(gridSize);
+    OcclusionCuller culler;
+    std::vector<uint32_t> visible;
+    double bestRasterMs = 0.0;
+    double bestTestMs = 0.0;
+    uint64_t hash = 0;
+    for (int r = 0; r < repetitions; ++r) {
+        culler.Cull(scene, visible);
+        const uint64_t runHash = HashVisible(visible);
+        if (r > 0 && runHash != hash) {
+            std::fprintf(stderr, "Visible set changed between runs\n");
+            return EXIT_FAILURE;
+        }
+        hash = runHash;
+        const OcclusionStats& stats = culler.Stats();
+        if (r == 0 || stats.rasterMs < bestRasterMs) {
+            bestRasterMs = stats.rasterMs;
+        }
+        if (r == 0 || stats.testMs < bestTestMs) {
+            bestTestMs = stats.testMs;
+        }
+    }
+
+    const OcclusionStats& stats = culler.Stats();
+    std::printf("%dx%d buffer, %u occluders (%u triangles), %u boxes: %u visible, %u occluded, hash %016llx\n",
+                culler.Width(), culler.Height(), stats.occluders, stats.triangles, stats.tested, stats.visible,
+                stats.Culled(), static_cast<unsigned long long>(hash));
+    std::printf("raster + pyramid %.3f ms, test %.3f ms (%.1f Mboxes/s)\n", bestRasterMs, bestTestMs,
+                static_cast<double>(stats.tested) / bestTestMs / 1000.0);
+
+    auto start = std::chrono::steady_clock::now();
+    culler.CullAsync(scene);
+    const std::vector<uint32_t>& asyncVisible = culler.Wait();
+    const double asyncMs = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+    if (HashVisible(asyncVisible) != hash) {
+        std::fprintf(stderr, "Asynchronous pass disagrees\n");
+        return EXIT_FAILURE;
+    }
+    std::printf("asynchronous pass %.3f ms including hand-off\n", asyncMs);
+
+    if (argc > 3 && !WritePgm(argv[3], culler)) {
+        std::fprintf(stderr, "Failed to write %s\n", argv[3]);
+        return EXIT_FAILURE;
+    }
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,194 @@
+// Animates a fleet of parented UFOs through SceneGraph: each has a hull,
+// a spinning ring under it carrying three lights, and a stretched antenna
+// (the one non-uniform scale). Times three ways of getting every world and
+// normal matrix per frame:
+//
+//   rebuild:  the old way, glm::rotate/glm::scale down each chain and a full
+//             inverse for every normal matrix;
+//   full:     every hull moves, so SceneGraph recomputes everything;
+//   partial:  hulls hold still and only the rings spin, so the hull
+//             matrices stay as they are.
+//
+// and checks SceneGraph's matrices against the rebuilt ones.
+//
+// Usage: SceneGraphBench [ufoCount] [frames]
+
+#include "SceneGraph.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <vector>
+
+#include <glm/glm.hpp>
+#include <glm/gtc/matrix_transform.hpp>
+#include <glm/gtc/quaternion.hpp>
+
+namespace {
+
+constexpr int kLights = 3;
+const glm::vec3 kUp(0.0f, 1.0f, 0.0f);
+const glm::vec3 kAntennaScale(0.2f, 3.0f, 0.2f);
+
+struct Ufo {
+    glm::vec3 position{0.0f};
+    float phase = 0.0f;
+    SceneNode hull = 0;
+    SceneNode ring = 0;
+    SceneNode lights[kLights] = {};
+    SceneNode antenna = 0;
+};
+
+float HullAngle(const Ufo& ufo, float time) {
+    return time * 0.15f + ufo.phase;
+}
+
+float RingAngle(const Ufo& ufo, float time) {
+    return time * 2.0f + ufo.phase;
+}
+
+glm::vec3 LightOffset(int light) {
+    const float angle = static_cast<float>(light) * 2.0943951f;
+    return glm::vec3(4.0f * std::cos(angle), 0.0f, 4.0f * std::sin(angle));
+}
+
+std::vector<Ufo> BuildFleet(int count, SceneGraph& graph) {
+    std::vector<Ufo> fleet(static_cast<std::size_t>(count));
+    const int side = static_cast<int>(std::ceil(std::sqrt(static_cast<float>(count))));
+    graph.Reserve(fleet.size() * (3 + kLights));
+    for (int i = 0; i < count; ++i) {
+        Ufo& ufo = fleet[static_cast<std::size_t>(i)];
+        ufo.position = glm::vec3(static_cast<float>(i % side) * 40.0f, 0.0f, static_cast<float>(i / side) * 40.0f);
+        ufo.phase = static_cast<float>(i) * 2.39996f;
+        ufo.hull = graph.Add();
+        graph.SetTranslation(ufo.hull, ufo.position);
+        graph.SetScale(ufo.hull, 1.4f);
+        ufo.ring = graph.Add(ufo.hull);
+        graph.SetTranslation(ufo.ring, glm::vec3(0.0f, -1.0f, 0.0f));
+        for (int light = 0; light < kLights; ++light) {
+            ufo.lights[light] = graph.Add(ufo.ring);
+            graph.SetTranslation(ufo.lights[light], LightOffset(light));
+            graph.SetScale(ufo.lights[light], 0.5f);
+        }
+        ufo.antenna = graph.Add(ufo.hull);
+        graph.SetTranslation(ufo.antenna, glm::vec3(0.0f, 2.0f, 0.0f));
+        graph.SetScale(ufo.antenna, kAntennaScale);
+    }
+    return fleet;
+}
+
+void Animate(const std::vector<Ufo>& fleet, float time, bool moveHulls, SceneGraph& graph) {
+    for (const Ufo& ufo : fleet) {
+        if (moveHulls) {
+            graph.SetRotation(ufo.hull, glm::angleAxis(HullAngle(ufo, time), kUp));
+        }
+        graph.SetRotation(ufo.ring, glm::angleAxis(RingAngle(ufo, time), kUp));
+    }
+}
+
+struct Rebuilt {
+    std::vector<glm::mat4> world;
+    std::vector<glm::mat3> normal;
+};
+
+void Push(Rebuilt& out, const glm::mat4& world) {
+    out.world.push_back(world);
+    out.normal.push_back(glm::transpose(glm::inverse(glm::mat3(world))));
+}
+
+// Same node order as BuildFleet().
+void Rebuild(const std::vector<Ufo>& fleet, float hullTime, float ringTime, Rebuilt& out) {
+    out.world.clear();
+    out.normal.clear();
+    for (const Ufo& ufo : fleet) {
+        glm::mat4 hull = glm::translate(glm::mat4(1.0f), ufo.position);
+        hull = glm::rotate(hull, HullAngle(ufo, hullTime), kUp);
+        hull = glm::scale(hull, glm::vec3(1.4f));
+        Push(out, hull);
+        glm::mat4 ring = glm::translate(hull, glm::vec3(0.0f, -1.0f, 0.0f));
+        ring = glm::rotate(ring, RingAngle(ufo, ringTime), kUp);
+        Push(out, ring);
+        for (int light = 0; light < kLights; ++light) {
+            Push(out, glm::scale(glm::translate(ring, LightOffset(light)), glm::vec3(0.5f)));
+        }
+        Push(out, glm::scale(glm::translate(hull, glm::vec3(0.0f, 2.0f, 0.0f)), kAntennaScale));
+    }
+}
+
+template <typename FrameFn>
+double MeanMs(int frames, FrameFn&& frame) {
+    const auto start = std::chrono::steady_clock::now();
+    for (int f = 0; f < frames; ++f) {
+        frame(static_cast<float>(f + 1) / 60.0f);
+    }
+    return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count() / frames;
+}
+
+// Largest difference relative to the matrix's largest entry.
+float MaxError(const SceneGraph& graph, const Rebuilt& rebuilt) {
+    float worst = 0.0f;
+    for (SceneNode node = 0; node < graph.Size(); ++node) {
+        for (int c = 0; c < 4; ++c) {
+            for (int r = 0; r < 4; ++r) {
+                const float expected = rebuilt.world[node][c][r];
+                worst = std::max(worst, std::abs(graph.World(node)[c][r] - expected) / std::max(1.0f, std::abs(expected)));
+            }
+        }
+        for (int c = 0; c < 3; ++c) {
+            for (int r = 0; r < 3; ++r) {
+                const float expected = rebuilt.normal[node][c][r];
+                worst = std::max(worst, std::abs(graph.Normal(node)[c][r] - expected) / std::max(1.0f, std::abs(expected)));
+            }
+        }
+    }
+    return worst;
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+    const int ufoCount = argc > 1 ? std::atoi(argv[1]) : 10000;
+    const int frames = argc > 2 ? std::atoi(argv[2]) : 100;
+    if (ufoCount <= 0 || frames <= 0) {
+        std::fprintf(stderr, "Usage: %s [ufoCount] [frames]\n", argv[0]);
+        return EXIT_FAILURE;
+    }
+
+    SceneGraph graph;
+    const std::vector<Ufo> fleet = BuildFleet(ufoCount, graph);
+    graph.Update();
+    Rebuilt rebuilt;
+    rebuilt.world.reserve(graph.Size());
+    rebuilt.normal.reserve(graph.Size());
+
+    const double rebuildMs = MeanMs(frames, [&](float time) { Rebuild(fleet, time, time, rebuilt); });
+    const double fullMs = MeanMs(frames, [&](float time) {
+        Animate(fleet, time, true, graph);
+        graph.Update();
+    });
+    const SceneGraphStats full = graph.Stats();
+    Rebuild(fleet, static_cast<float>(frames) / 60.0f, static_cast<float>(frames) / 60.0f, rebuilt);
+    const float fullError = MaxError(graph, rebuilt);
+
+    const double partialMs = MeanMs(frames, [&](float time) {
+        Animate(fleet, time, false, graph);
+        graph.Update();
+    });
+    const SceneGraphStats partial = graph.Stats();
+    Rebuild(fleet, static_cast<float>(frames) / 60.0f, static_cast<float>(frames) / 60.0f, rebuilt);
+    const float partialError = MaxError(graph, rebuilt);
+
+    std::printf("%d UFOs, %u nodes\n", ufoCount, full.nodes);
+    std::printf("rebuild  %9.3f ms/frame\n", rebuildMs);
+    std::printf("full     %9.3f ms/frame %6.2fx  %u updated, %u inverse normals, max error %.2g\n", fullMs,
+                rebuildMs / fullMs, full.updated, full.inverseNormals, fullError);
+    std::printf("partial  %9.3f ms/frame %6.2fx  %u updated, %u inverse normals, max error %.2g\n", partialMs,
+                rebuildMs / partialMs, partial.updated, partial.inverseNormals, partialError);
+    if (fullError > 1e-4f || partialError > 1e-4f) {
+        std::fprintf(stderr, "SceneGraph matrices differ from the rebuilt ones\n");
+        return EXIT_FAILURE;
+    }
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,156 @@
+// Compares OBJ vertex deduplication through the old node-based
+// std::unordered_map against VertexDedupTable. Each variant runs in its own
+// process on POSIX so the reported peak RSS is not shared between them.
+//
+// Usage: VertexDedupBench [gridSize] [repetitions]
+
+#include "VertexDedupTable.hpp"
+
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#ifdef _WIN32
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#include <windows.h>
+#include <psapi.h>
+#else
+#include <sys/resource.h>
+#include <sys/wait.h>
+#include <unistd.h>
+#endif
+
+namespace {
+
+// The hasher LoadObjMesh used before the flat table.
+struct LegacyVertexKeyHasher {
+    std::size_t operator()(const VertexKey& key) const {
+        std::size_t seed = static_cast<std::size_t>(key.position);
+        seed ^= static_cast<std::size_t>(key.texCoord) + 0x9e3779b9 + (seed << 6) + (seed >> 2);
+        seed ^= static_cast<std::size_t>(key.normal) + 0x9e3779b9 + (seed << 6) + (seed >> 2);
+        return seed;
+    }
+};
+
+// Face corners of a gridSize x gridSize quad grid split into triangles, with
+// a UV seam every 16 columns, in the order an exporter would write them.
+std::vector<VertexKey> MakeGridCorners(int gridSize) {
+    std::vector<VertexKey> corners;
+    corners.reserve(static_cast<std::size_t>(gridSize) * gridSize * 6);
+    auto corner = [&](int x, int y, int seamSide) {
+        int position = y * (gridSize + 1) + x;
+        int texCoord = (x % 16 == 0 && seamSide) ? position + (gridSize + 1) * (gridSize + 1) : position;
+        corners.push_back({position, texCoord, position});
+    };
+    for (int y = 0; y < gridSize; ++y) {
+        for (int x = 0; x < gridSize; ++x) {
+            corner(x, y, 1);
+            corner(x + 1, y, 0);
+            corner(x + 1, y + 1, 0);
+            corner(x, y, 1);
+            corner(x + 1, y + 1, 0);
+            corner(x, y + 1, 1);
+        }
+    }
+    return corners;
+}
+
+double PeakRssMiB() {
+#ifdef _WIN32
+    PROCESS_MEMORY_COUNTERS counters{};
+    GetProcessMemoryInfo(GetCurrentProcess(), &counters, sizeof(counters));
+    return static_cast<double>(counters.PeakWorkingSetSize) / (1024.0 * 1024.0);
+#else
+    rusage usage{};
+    getrusage(RUSAGE_SELF, &usage);
+#ifdef __APPLE__
+    return static_cast<double>(usage.ru_maxrss) / (1024.0 * 1024.0);
+#else
+    return static_cast<double>(usage.ru_maxrss) / 1024.0;
+#endif
+#endif
+}
+
+template <typename DedupFn>
+void RunVariant(const char* name, int gridSize, int repetitions, DedupFn&& dedup) {
+    std::vector<VertexKey> corners = MakeGridCorners(gridSize);
+    double rssBefore = PeakRssMiB();
+
+    double bestMs = 0.0;
+    std::size_t unique = 0;
+    for (int r = 0; r < repetitions; ++r) {
+        auto start = std::chrono::steady_clock::now();
+        unique = dedup(corners);
+        double ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+        if (r == 0 || ms < bestMs) {
+            bestMs = ms;
+        }
+    }
+
+    double rssAfter = PeakRssMiB();
+    std::printf("%-14s %10zu corners %9zu unique %9.2f ms %8.1f Mcorners/s  peak RSS %8.1f MiB (+%.1f MiB)\n",
+                name, corners.size(), unique, bestMs, static_cast<double>(corners.size()) / bestMs / 1000.0,
+                rssAfter, rssAfter - rssBefore);
+    std::fflush(stdout);
+}
+
+std::size_t DedupWithUnorderedMap(const std::vector<VertexKey>& corners) {
+    std::unordered_map<VertexKey, uint32_t, LegacyVertexKeyHasher> cache;
+    uint32_t next = 0;
+    for (const auto& key : corners) {
+        auto it = cache.find(key);
+        if (it == cache.end()) {
+            cache.emplace(key, next++);
+        }
+    }
+    return cache.size();
+}
+
+std::size_t DedupWithFlatTable(const std::vector<VertexKey>& corners) {
+    VertexDedupTable table;
+    // Same estimate LoadObjMesh derives from its record pre-pass.
+    table.Reserve(corners.size() / 6 + corners.size() / 24);
+    uint32_t next = 0;
+    for (const auto& key : corners) {
+        if (table.FindOrInsert(key, next) == next) {
+            ++next;
+        }
+    }
+    return table.Size();
+}
+
+template <typename Fn>
+void RunIsolated(Fn&& fn) {
+#ifdef _WIN32
+    fn();
+#else
+    pid_t child = fork();
+    if (child == 0) {
+        fn();
+        std::_Exit(0);
+    }
+    int status = 0;
+    waitpid(child, &status, 0);
+#endif
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+    int gridSize = argc > 1 ? std::atoi(argv[1]) : 1024;
+    int repetitions = argc > 2 ? std::atoi(argv[2]) : 5;
+    if (gridSize <= 0 || repetitions <= 0) {
+        std::fprintf(stderr, "Usage: %s [gridSize] [repetitions]\n", argv[0]);
+        return EXIT_FAILURE;
+    }
+
+    RunIsolated([&]() { RunVariant("unordered_map", gridSize, repetitions, DedupWithUnorderedMap); });
+    RunIsolated([&]() { RunVariant("flat table", gridSize, repetitions, DedupWithFlatTable); });
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,503 @@
+#include "BatchRenderer.hpp"
+
+#include "GlCalls.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <cstring>
+#include <limits>
+#include <numeric>
+#include <tuple>
+
+namespace {
+
+// A MaterialUniforms as the two RGBA32F texels object.frag fetches, with the
+// flags as 0.0/1.0: int bits read back from a float texture are denormals,
+// which the GPU may flush to zero.
+struct BatchMaterial {
+    glm::vec3 diffuseColor{0.8f};
+    float shininess = 32.0f;
+    float hasDiffuseMap = 0.0f;
+    float hasNormalMap = 0.0f;
+    float normalScale = 1.0f;
+    float padding = 0.0f;
+};
+static_assert(sizeof(BatchMaterial) == 2 * sizeof(glm::vec4), "BatchMaterial is two texels");
+
+BatchMaterial MakeBatchMaterial(const MeshDrawCall& draw) {
+    const MaterialUniforms uniforms = MakeMaterialUniforms(draw);
+    BatchMaterial material;
+    material.diffuseColor = uniforms.diffuseColor;
+    material.shininess = uniforms.shininess;
+    material.hasDiffuseMap = static_cast<float>(uniforms.hasDiffuseMap);
+    material.hasNormalMap = static_cast<float>(uniforms.hasNormalMap);
+    material.normalScale = uniforms.normalScale;
+    return material;
+}
+
+GLuint CreateBuffer(GLenum target, GLsizeiptr size, const void* data, GLenum usage) {
+    GLuint buffer = 0;
+    glGenBuffers(1, &buffer);
+    glBindBuffer(target, buffer);
+    glBufferData(target, size, data, usage);
+    return buffer;
+}
+
+void CopyBuffer(GLuint source, GLuint destination, GLintptr destinationOffset, GLsizeiptr size) {
+    glBindBuffer(GL_COPY_READ_BUFFER, source);
+    glBindBuffer(GL_COPY_WRITE_BUFFER, destination);
+    glCopyBufferSubData(GL_COPY_READ_BUFFER, GL_COPY_WRITE_BUFFER, 0, destinationOffset, size);
+}
+
+GLuint CreateBufferTexture(GLuint buffer) {
+    GLuint texture = 0;
+    glGenTextures(1, &texture);
+    glBindTexture(GL_TEXTURE_BUFFER, texture);
+    glTexBuffer(GL_TEXTURE_BUFFER, GL_RGBA32F, buffer);
+    glBindTexture(GL_TEXTURE_BUFFER, 0);
+    return texture;
+}
+
+void DeleteBuffer(GLuint& buffer) {
+    if (buffer != 0) {
+        glDeleteBuffers(1, &buffer);
+        buffer = 0;
+    }
+}
+
+void DeleteTexture(GLuint& texture) {
+    if (texture != 0) {
+        glDeleteTextures(1, &texture);
+        texture = 0;
+    }
+}
+
+} // namespace
+
+BatchRenderer::~BatchRenderer() {
+    Destroy();
+}
+
+uint32_t BatchRenderer::AddMesh(const Model& model) {
+    Mesh mesh;
+    mesh.model = &model;
+    meshes_.push_back(mesh);
+    needsBuild_ = true;
+    return static_cast<uint32_t>(meshes_.size() - 1);
+}
+
+uint32_t BatchRenderer::AddObject(uint32_t mesh, const glm::mat4& transform) {
+    objects_.push_back(Object{mesh, MakeInstanceTransform(transform), true});
+    needsBuild_ = true;
+    return static_cast<uint32_t>(objects_.size() - 1);
+}
+
+void BatchRenderer::SetTransform(uint32_t object, const glm::mat4& transform) {
+    if (objects_[object].transform.model != transform) {
+        SetTransform(object, MakeInstanceTransform(transform));
+    }
+}
+
+void BatchRenderer::SetTransform(uint32_t object, const InstanceTransform& transform) {
+    InstanceTransform& current = objects_[object].transform;
+    if (current.model == transform.model && current.normal == transform.normal) {
+        return;
+    }
+    current = transform;
+    dirtyBegin_ = dirtyBegin_ < dirtyEnd_ ? std::min(dirtyBegin_, object) : object;
+    dirtyEnd_ = std::max(dirtyEnd_, object + 1);
+}
+
+void BatchRenderer::SetVisible(uint32_t object, bool visible) {
+    // Visibility is applied to the commands, so the object data stays.
+    objects_[object].visible = visible;
+}
+
+bool BatchRenderer::Build(std::string* errorMessage) {
+    const auto start = std::chrono::steady_clock::now();
+    DestroyBuffers();
+    built_ = false;
+    needsBuild_ = false;
+    stats_ = BatchStats{};
+    multiDrawIndirect_ = GLEW_VERSION_4_3 || (GLEW_ARB_multi_draw_indirect && GLEW_ARB_base_instance);
+
+    // Lay the meshes out back to back in the arenas.
+    std::size_t vertexCount = 0;
+    std::size_t indexCount = 0;
+    uint32_t materialCount = 0;
+    for (std::size_t i = 0; i < meshes_.size(); ++i) {
+        Mesh& mesh = meshes_[i];
+        const ModelGeometry geometry = mesh.model->Geometry();
+        mesh.revision = mesh.model->Revision();
+        if (geometry.vertexBuffer == 0) {
+            if (errorMessage) {
+                *errorMessage = "Batched mesh " + std::to_string(i) + " is not loaded.";
+            }
+            return false;
+        }
+        if (i == 0) {
+            vertexFormat_ = geometry.vertexFormat;
+        } else if (geometry.vertexFormat != vertexFormat_) {
+            if (errorMessage) {
+                *errorMessage = "Batched models must share one vertex format.";
+            }
+            return false;
+        }
+        if (vertexCount + geometry.vertexCount > static_cast<std::size_t>(std::numeric_limits<int32_t>::max()) ||
+            indexCount + geometry.indexCount > std::numeric_limits<uint32_t>::max()) {
+            if (errorMessage) {
+                *errorMessage = "Batched geometry exceeds 32-bit offsets.";
+            }
+            return false;
+        }
+        mesh.baseVertex = static_cast<int32_t>(vertexCount);
+        mesh.firstIndex = static_cast<uint32_t>(indexCount);
+        mesh.firstMaterial = materialCount;
+        mesh.quantization = geometry.quantization;
+        mesh.bounds = mesh.model->Bounds();
+        vertexCount += geometry.vertexCount;
+        indexCount += geometry.indexCount;
+        materialCount += static_cast<uint32_t>(mesh.model->DrawCalls().size());
+    }
+
+    // Copy the geometry GPU to GPU; the models keep their own buffers.
+    const GLsizeiptr vertexStride = Model::VertexStride(vertexFormat_);
+    const GLsizeiptr tangentStride = Model::TangentStride(vertexFormat_);
+    vertexArena_ = CreateBuffer(GL_COPY_WRITE_BUFFER, static_cast<GLsizeiptr>(vertexCount) * vertexStride, nullptr, GL_STATIC_DRAW);
+    tangentArena_ = CreateBuffer(GL_COPY_WRITE_BUFFER, static_cast<GLsizeiptr>(vertexCount) * tangentStride, nullptr, GL_STATIC_DRAW);
+    indexArena_ = CreateBuffer(GL_COPY_WRITE_BUFFER, static_cast<GLsizeiptr>(indexCount * sizeof(uint32_t)), nullptr, GL_STATIC_DRAW);
+    std::vector<uint8_t> zeroTangents;
+    for (const Mesh& mesh : meshes_) {
+        const ModelGeometry geometry = mesh.model->Geometry();
+        const GLsizeiptr vertices = static_cast<GLsizeiptr>(geometry.vertexCount);
+        CopyBuffer(geometry.vertexBuffer, vertexArena_, mesh.baseVertex * vertexStride, vertices * vertexStride);
+        CopyBuffer(geometry.indexBuffer, indexArena_, static_cast<GLintptr>(mesh.firstIndex * sizeof(uint32_t)),
+                   static_cast<GLsizeiptr>(geometry.indexCount * sizeof(uint32_t)));
+        if (geometry.tangentBuffer != 0) {
+            CopyBuffer(geometry.tangentBuffer, tangentArena_, mesh.baseVertex * tangentStride, vertices * tangentStride);
+        } else {
+            // Such meshes have no normal-mapped chunks, so the tangent is never read.
+            zeroTangents.assign(static_cast<std::size_t>(vertices * tangentStride), 0);
+            glBindBuffer(GL_COPY_WRITE_BUFFER, tangentArena_);
+            glBufferSubData(GL_COPY_WRITE_BUFFER, mesh.baseVertex * tangentStride, vertices * tangentStride, zeroTangents.data());
+        }
+    }
+    glBindBuffer(GL_COPY_READ_BUFFER, 0);
+    glBindBuffer(GL_COPY_WRITE_BUFFER, 0);
+
+    std::vector<BatchMaterial> materials;
+    materials.reserve(materialCount);
+    for (const Mesh& mesh : meshes_) {
+        for (const MeshDrawCall& draw : mesh.model->DrawCalls()) {
+            materials.push_back(MakeBatchMaterial(draw));
+        }
+    }
+
+    // One item per object chunk, ordered so that each run of equal program
+    // and textures becomes one batch.
+    for (uint32_t object = 0; object < objects_.size(); ++object) {
+        const Mesh& mesh = meshes_[objects_[object].mesh];
+        const std::vector<MeshDrawCall>& draws = mesh.model->DrawCalls();
+        for (uint32_t chunk = 0; chunk < draws.size(); ++chunk) {
+            const MeshDrawCall& draw = draws[chunk];
+            DrawItem item;
+            item.object = object;
+            item.chunk = chunk;
+            item.material = mesh.firstMaterial + chunk;
+            item.features = draw.features;
+            item.diffuseTexture = draw.hasDiffuse ? draw.diffuseTexture : 0;
+            item.normalTexture = draw.hasNormalMap ? draw.normalTexture : 0;
+            items_.push_back(item);
+        }
+    }
+    std::sort(items_.begin(), items_.end(), [](const DrawItem& a, const DrawItem& b) {
+        return std::make_tuple(a.features.Bits(), a.diffuseTexture, a.normalTexture, a.material, a.object) <
+               std::make_tuple(b.features.Bits(), b.diffuseTexture, b.normalTexture, b.material, b.object);
+    });
+
+    std::vector<uint32_t> records;
+    records.reserve(items_.size() * 2);
+    commands_.resize(items_.size());
+    for (uint32_t i = 0; i < items_.size(); ++i) {
+        const DrawItem& item = items_[i];
+        if (batches_.empty() || batches_.back().features != item.features ||
+            batches_.back().diffuseTexture != item.diffuseTexture || batches_.back().normalTexture != item.normalTexture) {
+            Batch batch;
+            batch.features = item.features;
+            batch.diffuseTexture = item.diffuseTexture;
+            batch.normalTexture = item.normalTexture;
+            batch.firstCommand = i;
+            batches_.push_back(batch);
+        }
+        ++batches_.back().commandCount;
+        items_[i].batch = static_cast<uint32_t>(batches_.size() - 1);
+        records.push_back(item.object);
+        records.push_back(item.material);
+        // count and firstIndex follow the LOD and are filled in every frame.
+        commands_[i].baseVertex = meshes_[objects_[item.object].mesh].baseVertex;
+        commands_[i].baseInstance = i;
+    }
+    uploadedCommands_.clear();
+
+    glGenVertexArrays(1, &vao_);
+    glBindVertexArray(vao_);
+    glBindBuffer(GL_ARRAY_BUFFER, vertexArena_);
+    Model::BindVertexAttributes(vertexFormat_);
+    glBindBuffer(GL_ARRAY_BUFFER, tangentArena_);
+    Model::BindTangentAttribute(vertexFormat_);
+    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, indexArena_);
+    if (multiDrawIndirect_) {
+        // Each command's baseInstance picks its record; instanceCount is 1.
+        recordBuffer_ = CreateBuffer(GL_ARRAY_BUFFER, static_cast<GLsizeiptr>(records.size() * sizeof(uint32_t)),
+                                     records.data(), GL_STATIC_DRAW);
+        glEnableVertexAttribArray(kDrawRecordAttribute);
+        glVertexAttribIPointer(kDrawRecordAttribute, 2, GL_UNSIGNED_INT, 2 * sizeof(uint32_t), nullptr);
+        glVertexAttribDivisor(kDrawRecordAttribute, 1);
+        commandBuffer_ = CreateBuffer(GL_DRAW_INDIRECT_BUFFER,
+                                      static_cast<GLsizeiptr>(commands_.size() * sizeof(DrawElementsIndirectCommand)),
+                                      nullptr, GL_DYNAMIC_DRAW);
+        glBindBuffer(GL_DRAW_INDIRECT_BUFFER, 0);
+    }
+    glBindVertexArray(0);
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
+
+    materialBuffer_ = CreateBuffer(GL_TEXTURE_BUFFER, static_cast<GLsizeiptr>(materials.size() * sizeof(BatchMaterial)),
+                                   materials.data(), GL_STATIC_DRAW);
+    materialTexture_ = CreateBufferTexture(materialBuffer_);
+    objectBuffer_ = CreateBuffer(GL_TEXTURE_BUFFER, static_cast<GLsizeiptr>(objects_.size() * kBatchObjectTexels * sizeof(glm::vec4)),
+                                 nullptr, GL_DYNAMIC_DRAW);
+    objectTexture_ = CreateBufferTexture(objectBuffer_);
+    glBindBuffer(GL_TEXTURE_BUFFER, 0);
+    dirtyBegin_ = 0;
+    dirtyEnd_ = static_cast<uint32_t>(objects_.size());
+
+    stats_.objects = static_cast<uint32_t>(objects_.size());
+    stats_.commands = static_cast<uint32_t>(commands_.size());
+    stats_.batches = static_cast<uint32_t>(batches_.size());
+    stats_.buildMs = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+    built_ = true;
+    return true;
+}
+
+void BatchRenderer::UploadObjects() {
+    objectTexels_.resize(objects_.size() * kBatchObjectTexels);
+    for (uint32_t i = dirtyBegin_; i < dirtyEnd_; ++i) {
+        const Object& object = objects_[i];
+        const QuantizationParams& quantization = meshes_[object.mesh].quantization;
+        glm::vec4* texels = objectTexels_.data() + std::size_t{i} * kBatchObjectTexels;
+        for (int column = 0; column < 4; ++column) {
+            texels[column] = object.transform.model[column];
+        }
+        for (int column = 0; column < 3; ++column) {
+            texels[4 + column] = glm::vec4(object.transform.normal[column], 0.0f);
+        }
+        texels[7] = glm::vec4(quantization.positionOffset, 0.0f);
+        texels[8] = glm::vec4(quantization.positionScale, 0.0f);
+    }
+    constexpr GLsizeiptr kObjectBytes = kBatchObjectTexels * sizeof(glm::vec4);
+    gl::BindBuffer(GL_TEXTURE_BUFFER, objectBuffer_);
+    gl::BufferSubData(GL_TEXTURE_BUFFER, static_cast<GLintptr>(dirtyBegin_) * kObjectBytes,
+                      static_cast<GLsizeiptr>(dirtyEnd_ - dirtyBegin_) * kObjectBytes,
+                      objectTexels_.data() + std::size_t{dirtyBegin_} * kBatchObjectTexels);
+    gl::BindBuffer(GL_TEXTURE_BUFFER, 0);
+}
+
+void BatchRenderer::UpdateBounds() {
+    // Build() empties the culler; after that only moved objects' chunks change.
+    if (culler_.Size() != items_.size()) {
+        culler_.Clear();
+        culler_.Reserve(items_.size());
+        for (const DrawItem& item : items_) {
+            const Object& object = objects_[item.object];
+            culler_.Add(meshes_[object.mesh].model->DrawCalls()[item.chunk].box, object.transform.model);
+        }
+        return;
+    }
+    for (uint32_t i = 0; i < items_.size(); ++i) {
+        const DrawItem& item = items_[i];
+        if (item.object >= dirtyBegin_ && item.object < dirtyEnd_) {
+            const Object& object = objects_[item.object];
+            culler_.Set(i, TransformBox(meshes_[object.mesh].model->DrawCalls()[item.chunk].box, object.transform.model));
+        }
+    }
+}
+
+void BatchRenderer::UpdateCommands(const LodSelector& lodSelector, const glm::vec3& cameraPos) {
+    // Only objects with a visible chunk pay for LOD selection.
+    objectErrors_.assign(objects_.size(), -1.0f);
+    visibleCommands_.resize(visibleItems_.size());
+    for (Batch& batch : batches_) {
+        batch.visibleCount = 0;
+    }
+    for (uint32_t v = 0; v < visibleItems_.size(); ++v) {
+        const uint32_t i = visibleItems_[v];
+        const DrawItem& item = items_[i];
+        const Object& object = objects_[item.object];
+        const Mesh& mesh = meshes_[object.mesh];
+        const MeshDrawCall& draw = mesh.model->DrawCalls()[item.chunk];
+        float& objectError = objectErrors_[item.object];
+        if (objectError < 0.0f) {
+            objectError = lodSelector.MaxObjectError(object.transform.model, mesh.bounds, cameraPos);
+        }
+        uint32_t startIndex = draw.startIndex;
+        uint32_t indexCount = draw.indexCount;
+        if (std::size_t level = SelectLod(draw.lods, objectError); level > 0) {
+            startIndex = draw.lods[level - 1].startIndex;
+            indexCount = draw.lods[level - 1].indexCount;
+        }
+        // Visible items are in increasing order, so each batch stays contiguous.
+        Batch& batch = batches_[item.batch];
+        if (batch.visibleCount++ == 0) {
+            batch.firstVisible = v;
+        }
+        DrawElementsIndirectCommand& command = visibleCommands_[v];
+        command = commands_[i];
+        command.count = indexCount;
+        command.firstIndex = mesh.firstIndex + startIndex;
+    }
+}
+
+void BatchRenderer::Draw(const ShaderVariants& shaders,
+                         const LodSelector& lodSelector,
+                         const glm::vec3& cameraPos,
+                         const Frustum* frustum) {
+    stats_.submissions = 0;
+    const bool stale = std::any_of(meshes_.begin(), meshes_.end(), [](const Mesh& mesh) {
+        return mesh.revision != mesh.model->Revision();
+    });
+    // A failed build is retried once something changes again.
+    if ((needsBuild_ || stale) && !Build()) {
+        return;
+    }
+    if (!built_ || items_.empty()) {
+        return;
+    }
+    if (dirtyBegin_ < dirtyEnd_) {
+        UploadObjects();
+        UpdateBounds();
+        dirtyBegin_ = 0;
+        dirtyEnd_ = 0;
+    }
+    if (frustum) {
+        culler_.Cull(*frustum, visibleItems_);
+        stats_.cullMs = culler_.Stats().ms;
+    } else {
+        visibleItems_.resize(items_.size());
+        std::iota(visibleItems_.begin(), visibleItems_.end(), 0u);
+        stats_.cullMs = 0.0;
+    }
+    std::erase_if(visibleItems_, [&](uint32_t i) { return !objects_[items_[i].object].visible; });
+    stats_.visible = static_cast<uint32_t>(visibleItems_.size());
+    UpdateCommands(lodSelector, cameraPos);
+    if (visibleItems_.empty()) {
+        return;
+    }
+
+    gl::BindVertexArray(vao_);
+    gl::ActiveTexture(GL_TEXTURE0 + static_cast<GLuint>(TextureUnit::Objects));
+    gl::BindTexture(GL_TEXTURE_BUFFER, objectTexture_);
+    gl::ActiveTexture(GL_TEXTURE0 + static_cast<GLuint>(TextureUnit::Materials));
+    gl::BindTexture(GL_TEXTURE_BUFFER, materialTexture_);
+    GLuint activeUnit = static_cast<GLuint>(TextureUnit::Materials);
+
+    if (multiDrawIndirect_) {
+        gl::BindBuffer(GL_DRAW_INDIRECT_BUFFER, commandBuffer_);
+        // Commands only change when an object switches LOD or visibility.
+        if (visibleCommands_ != uploadedCommands_) {
+            gl::BufferSubData(GL_DRAW_INDIRECT_BUFFER, 0,
+                              static_cast<GLsizeiptr>(visibleCommands_.size() * sizeof(DrawElementsIndirectCommand)),
+                              visibleCommands_.data());
+            uploadedCommands_ = visibleCommands_;
+        }
+    }
+
+    GLuint boundTextures[2] = {0, 0};
+    auto bindTexture = [&](TextureUnit textureUnit, GLuint texture) {
+        const GLuint unit = static_cast<GLuint>(textureUnit);
+        if (boundTextures[unit] == texture) {
+            return;
+        }
+        if (activeUnit != unit) {
+            gl::ActiveTexture(GL_TEXTURE0 + unit);
+            activeUnit = unit;
+        }
+        gl::BindTexture(GL_TEXTURE_2D, texture);
+        boundTextures[unit] = texture;
+    };
+
+    const ShaderProgram* boundShader = nullptr;
+    for (const Batch& batch : batches_) {
+        if (batch.visibleCount == 0) {
+            continue;
+        }
+        const ShaderProgram& shader = shaders.Get(batch.features);
+        if (&shader != boundShader) {
+            shader.Use();
+            shader.SetInt("uOctahedralNormals", vertexFormat_ == VertexFormat::Packed ? 1 : 0);
+            boundShader = &shader;
+        }
+        if (batch.diffuseTexture != 0) {
+            bindTexture(TextureUnit::Diffuse, batch.diffuseTexture);
+        }
+        if (batch.normalTexture != 0) {
+            bindTexture(TextureUnit::Normal, batch.normalTexture);
+        }
+
+        if (multiDrawIndirect_) {
+            const void* offset = reinterpret_cast<const void*>(
+                static_cast<uintptr_t>(batch.firstVisible) * sizeof(DrawElementsIndirectCommand));
+            gl::MultiDrawElementsIndirect(GL_TRIANGLES, GL_UNSIGNED_INT, offset, static_cast<GLsizei>(batch.visibleCount),
+                                          sizeof(DrawElementsIndirectCommand));
+            ++stats_.submissions;
+            continue;
+        }
+        // No base instance: the record becomes a constant attribute per draw.
+        for (uint32_t v = batch.firstVisible; v < batch.firstVisible + batch.visibleCount; ++v) {
+            const DrawElementsIndirectCommand& command = visibleCommands_[v];
+            const DrawItem& item = items_[visibleItems_[v]];
+            gl::VertexAttribI2ui(kDrawRecordAttribute, item.object, item.material);
+            gl::DrawElementsBaseVertex(GL_TRIANGLES, static_cast<GLsizei>(command.count), GL_UNSIGNED_INT,
+                                       reinterpret_cast<const void*>(static_cast<uintptr_t>(command.firstIndex) * sizeof(uint32_t)),
+                                       command.baseVertex);
+            ++stats_.submissions;
+        }
+    }
+
+    if (multiDrawIndirect_) {
+        gl::BindBuffer(GL_DRAW_INDIRECT_BUFFER, 0);
+    }
+    gl::ActiveTexture(GL_TEXTURE0);
+    gl::BindVertexArray(0);
+}
+
+void BatchRenderer::DestroyBuffers() {
+    if (vao_ != 0) {
+        glDeleteVertexArrays(1, &vao_);
+        vao_ = 0;
+    }
+    DeleteBuffer(vertexArena_);
+    DeleteBuffer(tangentArena_);
+    DeleteBuffer(indexArena_);
+    DeleteBuffer(recordBuffer_);
+    DeleteBuffer(commandBuffer_);
+    DeleteTexture(objectTexture_);
+    DeleteBuffer(objectBuffer_);
+    DeleteTexture(materialTexture_);
+    DeleteBuffer(materialBuffer_);
+    items_.clear();
+    batches_.clear();
+    commands_.clear();
+    culler_.Clear();
+    visibleItems_.clear();
+    visibleCommands_.clear();
+    uploadedCommands_.clear();
+}
+
+void BatchRenderer::Destroy() {
+    DestroyBuffers();
+    meshes_.clear();
+    objects_.clear();
+    built_ = false;
+    needsBuild_ = true;
+    stats_ = BatchStats{};
+}
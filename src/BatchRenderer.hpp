@@ -0,0 +1,164 @@
+#pragma once
+
+#include "FrustumCuller.hpp"
+#include "InstanceTransform.hpp"
+#include "MeshSimplifier.hpp"
+#include "Model.hpp"
+#include "ShaderVariants.hpp"
+
+#include <GL/glew.h>
+#include <glm/glm.hpp>
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+// Texels of BatchRenderer's object buffer per object, as object.vert reads
+// them: model matrix columns, normal matrix columns, position offset and
+// position scale.
+constexpr int kBatchObjectTexels = 9;
+
+// Per-draw (object, material) record of object.vert built with BATCHED.
+constexpr GLuint kDrawRecordAttribute = 11;
+
+// Layout glMultiDrawElementsIndirect reads.
+struct DrawElementsIndirectCommand {
+    uint32_t count = 0;
+    uint32_t instanceCount = 1;
+    uint32_t firstIndex = 0;
+    int32_t baseVertex = 0;
+    uint32_t baseInstance = 0;
+
+    friend bool operator==(const DrawElementsIndirectCommand&, const DrawElementsIndirectCommand&) = default;
+};
+
+struct BatchStats {
+    uint32_t objects = 0;
+    uint32_t commands = 0;    // one per object and chunk
+    uint32_t batches = 0;     // runs sharing a program and textures
+    uint32_t visible = 0;     // commands left after culling in the last Draw()
+    uint32_t submissions = 0; // draw calls issued by the last Draw()
+    double buildMs = 0.0;
+    double cullMs = 0.0;
+
+    uint32_t Culled() const { return commands - visible; }
+};
+
+// Draws many objects of many models with a fixed number of GL calls per
+// state change instead of per chunk. Build() copies every model's vertices
+// and indices into shared arenas on the GPU, sorts the object chunks by
+// shader variant, textures and material, and groups them into batches;
+// Draw() submits each batch with one glMultiDrawElementsIndirect. Per-draw
+// transforms and materials live in buffer textures that object.vert/.frag
+// (built with BATCHED) index through a per-draw attribute. Without
+// GL_ARB_multi_draw_indirect the same commands are issued one by one.
+// Given a frustum, Draw() first culls every chunk's world-space box and
+// submits only the commands that survive.
+class BatchRenderer {
+public:
+    BatchRenderer() = default;
+    ~BatchRenderer();
+
+    BatchRenderer(const BatchRenderer&) = delete;
+    BatchRenderer& operator=(const BatchRenderer&) = delete;
+
+    // The model must outlive the renderer. All models need the same vertex
+    // format. When one reloads, the next Draw() rebuilds the arenas.
+    uint32_t AddMesh(const Model& model);
+    uint32_t AddObject(uint32_t mesh, const glm::mat4& transform);
+    void SetTransform(uint32_t object, const glm::mat4& transform);
+    // With the normal matrix already at hand, e.g. from FleetUpdater or
+    // SceneGraph. Only objects whose transform changed are uploaded again.
+    void SetTransform(uint32_t object, const InstanceTransform& transform);
+    // Hidden objects are skipped by Draw(), e.g. when OcclusionCuller found
+    // them occluded.
+    void SetVisible(uint32_t object, bool visible);
+
+    bool Build(std::string* errorMessage = nullptr);
+    // Each chunk draws at the coarsest LOD its object's distance allows.
+    // The caller provides FrameBlock; `shaders` must be built with BATCHED.
+    void Draw(const ShaderVariants& shaders,
+              const LodSelector& lodSelector,
+              const glm::vec3& cameraPos,
+              const Frustum* frustum = nullptr);
+    void Destroy();
+
+    bool MultiDrawIndirect() const { return multiDrawIndirect_; }
+    const BatchStats& Stats() const { return stats_; }
+
+private:
+    struct Mesh {
+        const Model* model = nullptr;
+        uint32_t revision = 0;
+        int32_t baseVertex = 0;
+        uint32_t firstIndex = 0;
+        uint32_t firstMaterial = 0;
+        QuantizationParams quantization;
+        BoundingSphere bounds;
+    };
+
+    struct Object {
+        uint32_t mesh = 0;
+        InstanceTransform transform;
+        bool visible = true;
+    };
+
+    // Sorted alongside the commands; identifies the chunk behind each one.
+    struct DrawItem {
+        uint32_t object = 0;
+        uint32_t chunk = 0; // index into the mesh's DrawCalls()
+        uint32_t material = 0;
+        uint32_t batch = 0;
+        ShaderFeatures features;
+        GLuint diffuseTexture = 0;
+        GLuint normalTexture = 0;
+    };
+
+    struct Batch {
+        ShaderFeatures features;
+        GLuint diffuseTexture = 0;
+        GLuint normalTexture = 0;
+        uint32_t firstCommand = 0;
+        uint32_t commandCount = 0;
+        // Range of visibleCommands_, refreshed every Draw().
+        uint32_t firstVisible = 0;
+        uint32_t visibleCount = 0;
+    };
+
+    std::vector<Mesh> meshes_;
+    std::vector<Object> objects_;
+    // Objects whose transform changed since the last upload.
+    uint32_t dirtyBegin_ = 0;
+    uint32_t dirtyEnd_ = 0;
+    bool needsBuild_ = true; // meshes or objects were added since Build()
+    bool built_ = false;
+    bool multiDrawIndirect_ = false;
+    VertexFormat vertexFormat_ = VertexFormat::Float32;
+
+    std::vector<DrawItem> items_;
+    std::vector<Batch> batches_;
+    std::vector<DrawElementsIndirectCommand> commands_; // per item
+    FrustumCuller culler_;               // per item, world space
+    std::vector<uint32_t> visibleItems_; // refreshed every Draw()
+    std::vector<DrawElementsIndirectCommand> visibleCommands_;
+    std::vector<DrawElementsIndirectCommand> uploadedCommands_;
+    std::vector<glm::vec4> objectTexels_;
+    std::vector<float> objectErrors_; // per object, negative until needed
+    BatchStats stats_;
+
+    GLuint vao_ = 0;
+    GLuint vertexArena_ = 0;
+    GLuint tangentArena_ = 0;
+    GLuint indexArena_ = 0;
+    GLuint recordBuffer_ = 0;
+    GLuint commandBuffer_ = 0;
+    GLuint objectBuffer_ = 0;
+    GLuint objectTexture_ = 0;
+    GLuint materialBuffer_ = 0;
+    GLuint materialTexture_ = 0;
+
+    void UploadObjects();
+    void UpdateBounds();
+    void UpdateCommands(const LodSelector& lodSelector, const glm::vec3& cameraPos);
+    void DestroyBuffers();
+};
@@ -0,0 +1,525 @@
+#include "BlockCompression.hpp"
+
+#include "ThreadPool.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <limits>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define GFX_BLOCK_COMPRESSION_SSE2 1
+#include <emmintrin.h>
+#endif
+
+namespace gfx {
+namespace {
+
+// Texels of a block in structure-of-arrays form, four channels x 16 texels.
+struct BlockTexels {
+    alignas(16) float c[4][16];
+};
+
+void LoadTexels(const uint8_t block[64], BlockTexels& texels) {
+    for (int i = 0; i < 16; ++i) {
+        for (int ch = 0; ch < 4; ++ch) {
+            texels.c[ch][i] = static_cast<float>(block[i * 4 + ch]);
+        }
+    }
+}
+
+// Picks the nearest palette entry for every texel (squared distance over the
+// first `channels` channels) and returns the summed error. Ties keep the
+// lower index; the scalar path mirrors the SIMD arithmetic exactly.
+float SelectIndices(const BlockTexels& texels,
+                    const float (*palette)[4],
+                    int paletteSize,
+                    int channels,
+                    uint8_t indices[16]) {
+#if GFX_BLOCK_COMPRESSION_SSE2
+    __m128 errorSum = _mm_setzero_ps();
+    for (int group = 0; group < 16; group += 4) {
+        __m128 t[4];
+        for (int ch = 0; ch < channels; ++ch) {
+            t[ch] = _mm_load_ps(&texels.c[ch][group]);
+        }
+        __m128 best = _mm_set1_ps(std::numeric_limits<float>::max());
+        __m128i bestIndex = _mm_setzero_si128();
+        for (int p = 0; p < paletteSize; ++p) {
+            __m128 d = _mm_sub_ps(t[0], _mm_set1_ps(palette[p][0]));
+            __m128 dist = _mm_mul_ps(d, d);
+            for (int ch = 1; ch < channels; ++ch) {
+                d = _mm_sub_ps(t[ch], _mm_set1_ps(palette[p][ch]));
+                dist = _mm_add_ps(dist, _mm_mul_ps(d, d));
+            }
+            __m128i closer = _mm_castps_si128(_mm_cmplt_ps(dist, best));
+            best = _mm_min_ps(dist, best);
+            bestIndex = _mm_or_si128(_mm_and_si128(closer, _mm_set1_epi32(p)), _mm_andnot_si128(closer, bestIndex));
+        }
+        errorSum = _mm_add_ps(errorSum, best);
+        alignas(16) int32_t lanes[4];
+        _mm_store_si128(reinterpret_cast<__m128i*>(lanes), bestIndex);
+        for (int i = 0; i < 4; ++i) {
+            indices[group + i] = static_cast<uint8_t>(lanes[i]);
+        }
+    }
+    alignas(16) float sums[4];
+    _mm_store_ps(sums, errorSum);
+    return (sums[0] + sums[1]) + (sums[2] + sums[3]);
+#else
+    float sums[4] = {0.0f, 0.0f, 0.0f, 0.0f};
+    for (int group = 0; group < 16; group += 4) {
+        for (int lane = 0; lane < 4; ++lane) {
+            const int i = group + lane;
+            float best = std::numeric_limits<float>::max();
+            int bestIndex = 0;
+            for (int p = 0; p < paletteSize; ++p) {
+                float d = texels.c[0][i] - palette[p][0];
+                float dist = d * d;
+                for (int ch = 1; ch < channels; ++ch) {
+                    d = texels.c[ch][i] - palette[p][ch];
+                    dist = dist + d * d;
+                }
+                if (dist < best) {
+                    best = dist;
+                    bestIndex = p;
+                }
+            }
+            sums[lane] += best;
+            indices[i] = static_cast<uint8_t>(bestIndex);
+        }
+    }
+    return (sums[0] + sums[1]) + (sums[2] + sums[3]);
+#endif
+}
+
+// Mean and principal axis (power iteration on the covariance matrix).
+void PrincipalAxis(const BlockTexels& texels, int channels, float mean[4], float axis[4]) {
+    for (int ch = 0; ch < 4; ++ch) {
+        float sum = 0.0f;
+        for (int i = 0; i < 16; ++i) {
+            sum += texels.c[ch][i];
+        }
+        mean[ch] = ch < channels ? sum / 16.0f : 0.0f;
+        axis[ch] = 0.0f;
+    }
+
+    float covariance[4][4] = {};
+    for (int i = 0; i < 16; ++i) {
+        float d[4];
+        for (int ch = 0; ch < channels; ++ch) {
+            d[ch] = texels.c[ch][i] - mean[ch];
+        }
+        for (int a = 0; a < channels; ++a) {
+            for (int b = a; b < channels; ++b) {
+                covariance[a][b] += d[a] * d[b];
+            }
+        }
+    }
+    for (int a = 0; a < channels; ++a) {
+        for (int b = 0; b < a; ++b) {
+            covariance[a][b] = covariance[b][a];
+        }
+    }
+
+    float v[4] = {1.0f, 1.0f, 1.0f, 1.0f};
+    for (int iteration = 0; iteration < 8; ++iteration) {
+        float next[4] = {};
+        float length = 0.0f;
+        for (int a = 0; a < channels; ++a) {
+            for (int b = 0; b < channels; ++b) {
+                next[a] += covariance[a][b] * v[b];
+            }
+            length += next[a] * next[a];
+        }
+        if (length <= 1e-12f) {
+            break;
+        }
+        length = std::sqrt(length);
+        for (int a = 0; a < channels; ++a) {
+            v[a] = next[a] / length;
+        }
+    }
+
+    float length = 0.0f;
+    for (int ch = 0; ch < channels; ++ch) {
+        length += v[ch] * v[ch];
+    }
+    length = std::sqrt(length);
+    for (int ch = 0; ch < channels; ++ch) {
+        axis[ch] = length > 0.0f ? v[ch] / length : 0.0f;
+    }
+}
+
+// Endpoints at the extremes of the texel projections onto the principal axis.
+void AxisEndpoints(const BlockTexels& texels, int channels, float low[4], float high[4]) {
+    float mean[4];
+    float axis[4];
+    PrincipalAxis(texels, channels, mean, axis);
+
+    float minT = 0.0f;
+    float maxT = 0.0f;
+    for (int i = 0; i < 16; ++i) {
+        float t = 0.0f;
+        for (int ch = 0; ch < channels; ++ch) {
+            t += (texels.c[ch][i] - mean[ch]) * axis[ch];
+        }
+        minT = std::min(minT, t);
+        maxT = std::max(maxT, t);
+    }
+    for (int ch = 0; ch < 4; ++ch) {
+        low[ch] = std::clamp(mean[ch] + axis[ch] * minT, 0.0f, 255.0f);
+        high[ch] = std::clamp(mean[ch] + axis[ch] * maxT, 0.0f, 255.0f);
+    }
+}
+
+// Least-squares endpoints for fixed per-texel weights (texel = (1 - w) * e0 + w * e1).
+bool FitEndpoints(const BlockTexels& texels, int channels, const float weights[16], float e0[4], float e1[4]) {
+    float aa = 0.0f, ab = 0.0f, bb = 0.0f;
+    float ax[4] = {}, bx[4] = {};
+    for (int i = 0; i < 16; ++i) {
+        const float b = weights[i];
+        const float a = 1.0f - b;
+        aa += a * a;
+        ab += a * b;
+        bb += b * b;
+        for (int ch = 0; ch < channels; ++ch) {
+            ax[ch] += a * texels.c[ch][i];
+            bx[ch] += b * texels.c[ch][i];
+        }
+    }
+    const float det = aa * bb - ab * ab;
+    if (std::abs(det) < 1e-6f) {
+        return false;
+    }
+    for (int ch = 0; ch < channels; ++ch) {
+        e0[ch] = std::clamp((ax[ch] * bb - bx[ch] * ab) / det, 0.0f, 255.0f);
+        e1[ch] = std::clamp((bx[ch] * aa - ax[ch] * ab) / det, 0.0f, 255.0f);
+    }
+    return true;
+}
+
+void StoreLE(uint8_t* out, uint64_t value, int bytes) {
+    for (int i = 0; i < bytes; ++i) {
+        out[i] = static_cast<uint8_t>(value >> (8 * i));
+    }
+}
+
+// --- BC1 colour block -------------------------------------------------------
+
+uint16_t To565(const float c[4]) {
+    auto quantize = [](float v, float maxValue) {
+        return static_cast<uint16_t>(std::clamp(std::lround(v * maxValue / 255.0f), 0L, static_cast<long>(maxValue)));
+    };
+    return static_cast<uint16_t>((quantize(c[0], 31.0f) << 11) | (quantize(c[1], 63.0f) << 5) | quantize(c[2], 31.0f));
+}
+
+void From565(uint16_t value, float out[4]) {
+    const int r = (value >> 11) & 31;
+    const int g = (value >> 5) & 63;
+    const int b = value & 31;
+    out[0] = static_cast<float>((r << 3) | (r >> 2));
+    out[1] = static_cast<float>((g << 2) | (g >> 4));
+    out[2] = static_cast<float>((b << 3) | (b >> 2));
+    out[3] = 0.0f;
+}
+
+// Four-colour mode palette in index order: c0, c1, 2/3 c0 + 1/3 c1, 1/3 c0 + 2/3 c1.
+float EvaluateBC1(const BlockTexels& texels, uint16_t c0, uint16_t c1, uint8_t indices[16]) {
+    float palette[4][4];
+    From565(c0, palette[0]);
+    From565(c1, palette[1]);
+    for (int ch = 0; ch < 4; ++ch) {
+        palette[2][ch] = (2.0f * palette[0][ch] + palette[1][ch]) / 3.0f;
+        palette[3][ch] = (palette[0][ch] + 2.0f * palette[1][ch]) / 3.0f;
+    }
+    return SelectIndices(texels, palette, 4, 3, indices);
+}
+
+void EncodeColorBlock(const BlockTexels& texels, uint8_t out[8]) {
+    constexpr float kIndexWeights[4] = {0.0f, 1.0f, 1.0f / 3.0f, 2.0f / 3.0f};
+
+    float low[4];
+    float high[4];
+    AxisEndpoints(texels, 3, low, high);
+
+    uint16_t c0 = To565(high);
+    uint16_t c1 = To565(low);
+    uint8_t indices[16];
+    float error = EvaluateBC1(texels, c0, c1, indices);
+
+    for (int iteration = 0; iteration < 2 && error > 0.0f; ++iteration) {
+        float weights[16];
+        for (int i = 0; i < 16; ++i) {
+            weights[i] = kIndexWeights[indices[i]];
+        }
+        float e0[4] = {};
+        float e1[4] = {};
+        if (!FitEndpoints(texels, 3, weights, e0, e1)) {
+            break;
+        }
+        uint16_t r0 = To565(e0);
+        uint16_t r1 = To565(e1);
+        uint8_t refinedIndices[16];
+        float refinedError = EvaluateBC1(texels, r0, r1, refinedIndices);
+        if (refinedError >= error) {
+            break;
+        }
+        c0 = r0;
+        c1 = r1;
+        error = refinedError;
+        std::memcpy(indices, refinedIndices, sizeof(indices));
+    }
+
+    // Four-colour mode needs c0 > c1; swapping exchanges 0<->1 and 2<->3.
+    if (c0 < c1) {
+        std::swap(c0, c1);
+        for (uint8_t& index : indices) {
+            index ^= 1;
+        }
+    }
+    if (c0 == c1) {
+        std::fill(std::begin(indices), std::end(indices), uint8_t{0});
+    }
+
+    uint32_t bits = 0;
+    for (int i = 0; i < 16; ++i) {
+        bits |= static_cast<uint32_t>(indices[i]) << (2 * i);
+    }
+    StoreLE(out, c0, 2);
+    StoreLE(out + 2, c1, 2);
+    StoreLE(out + 4, bits, 4);
+}
+
+// --- BC4 single channel block -----------------------------------------------
+
+void EncodeBC4(const uint8_t block[64], int channel, uint8_t out[8]) {
+    uint8_t minValue = 255;
+    uint8_t maxValue = 0;
+    for (int i = 0; i < 16; ++i) {
+        minValue = std::min(minValue, block[i * 4 + channel]);
+        maxValue = std::max(maxValue, block[i * 4 + channel]);
+    }
+
+    // a0 > a1 selects the eight-value ramp: index 0 = a0, 1 = a1 and 2..7
+    // step from a0 towards a1.
+    uint64_t bits = 0;
+    if (maxValue > minValue) {
+        const int range = maxValue - minValue;
+        for (int i = 0; i < 16; ++i) {
+            const int step = ((block[i * 4 + channel] - minValue) * 14 + range) / (2 * range);
+            const uint64_t index = step == 7 ? 0 : step == 0 ? 1 : static_cast<uint64_t>(8 - step);
+            bits |= index << (3 * i);
+        }
+    }
+    out[0] = maxValue;
+    out[1] = minValue;
+    StoreLE(out + 2, bits, 6);
+}
+
+// --- BC7 mode 6 ---------------------------------------------------------------
+
+constexpr int kBC7Weights[16] = {0, 4, 9, 13, 17, 21, 26, 30, 34, 38, 43, 47, 51, 55, 60, 64};
+
+struct BC7Mode6 {
+    uint8_t endpoint[2][4] = {}; // 7-bit values
+    uint8_t pbit[2] = {};
+    uint8_t indices[16] = {};
+    float error = std::numeric_limits<float>::max();
+};
+
+// Tries all four p-bit combinations for the given float endpoints.
+void TryBC7Mode6(const BlockTexels& texels, const float e0[4], const float e1[4], BC7Mode6& best) {
+    for (int p0 = 0; p0 < 2; ++p0) {
+        for (int p1 = 0; p1 < 2; ++p1) {
+            BC7Mode6 candidate;
+            candidate.pbit[0] = static_cast<uint8_t>(p0);
+            candidate.pbit[1] = static_cast<uint8_t>(p1);
+            int expanded[2][4];
+            for (int ch = 0; ch < 4; ++ch) {
+                const float sources[2] = {e0[ch], e1[ch]};
+                for (int e = 0; e < 2; ++e) {
+                    const int p = candidate.pbit[e];
+                    const long q = std::clamp(std::lround((sources[e] - static_cast<float>(p)) * 0.5f), 0L, 127L);
+                    candidate.endpoint[e][ch] = static_cast<uint8_t>(q);
+                    expanded[e][ch] = static_cast<int>((q << 1) | p);
+                }
+            }
+
+            float palette[16][4];
+            for (int i = 0; i < 16; ++i) {
+                const int w = kBC7Weights[i];
+                for (int ch = 0; ch < 4; ++ch) {
+                    palette[i][ch] = static_cast<float>(((64 - w) * expanded[0][ch] + w * expanded[1][ch] + 32) >> 6);
+                }
+            }
+            candidate.error = SelectIndices(texels, palette, 16, 4, candidate.indices);
+            if (candidate.error < best.error) {
+                best = candidate;
+            }
+        }
+    }
+}
+
+class BitWriter {
+public:
+    void Put(uint64_t value, int bits) {
+        if (position_ < 64) {
+            low_ |= value << position_;
+            if (position_ + bits > 64) {
+                high_ |= value >> (64 - position_);
+            }
+        } else {
+            high_ |= value << (position_ - 64);
+        }
+        position_ += bits;
+    }
+
+    void Store(uint8_t out[16]) const {
+        StoreLE(out, low_, 8);
+        StoreLE(out + 8, high_, 8);
+    }
+
+private:
+    uint64_t low_ = 0;
+    uint64_t high_ = 0;
+    int position_ = 0;
+};
+
+void GatherBlock(const uint8_t* rgba, uint32_t width, uint32_t height, uint32_t bx, uint32_t by, uint8_t block[64]) {
+    for (uint32_t y = 0; y < 4; ++y) {
+        const uint32_t sy = std::min(by * 4 + y, height - 1);
+        for (uint32_t x = 0; x < 4; ++x) {
+            const uint32_t sx = std::min(bx * 4 + x, width - 1);
+            std::memcpy(block + (y * 4 + x) * 4, rgba + (static_cast<std::size_t>(sy) * width + sx) * 4, 4);
+        }
+    }
+}
+
+} // namespace
+
+std::size_t BlockBytes(BlockFormat format) {
+    return format == BlockFormat::BC1 ? 8 : 16;
+}
+
+std::size_t CompressedSize(BlockFormat format, uint32_t width, uint32_t height) {
+    const std::size_t blocksX = (static_cast<std::size_t>(width) + 3) / 4;
+    const std::size_t blocksY = (static_cast<std::size_t>(height) + 3) / 4;
+    return blocksX * blocksY * BlockBytes(format);
+}
+
+void EncodeBC1Block(const uint8_t block[64], uint8_t out[8]) {
+    BlockTexels texels;
+    LoadTexels(block, texels);
+    EncodeColorBlock(texels, out);
+}
+
+void EncodeBC3Block(const uint8_t block[64], uint8_t out[16]) {
+    EncodeBC4(block, 3, out);
+    BlockTexels texels;
+    LoadTexels(block, texels);
+    EncodeColorBlock(texels, out + 8);
+}
+
+void EncodeBC5Block(const uint8_t block[64], uint8_t out[16]) {
+    EncodeBC4(block, 0, out);
+    EncodeBC4(block, 1, out + 8);
+}
+
+void EncodeBC7Block(const uint8_t block[64], uint8_t out[16]) {
+    BlockTexels texels;
+    LoadTexels(block, texels);
+
+    float low[4];
+    float high[4];
+    AxisEndpoints(texels, 4, low, high);
+
+    BC7Mode6 best;
+    TryBC7Mode6(texels, low, high, best);
+
+    for (int iteration = 0; iteration < 2 && best.error > 0.0f; ++iteration) {
+        float weights[16];
+        for (int i = 0; i < 16; ++i) {
+            weights[i] = static_cast<float>(kBC7Weights[best.indices[i]]) / 64.0f;
+        }
+        float e0[4] = {};
+        float e1[4] = {};
+        if (!FitEndpoints(texels, 4, weights, e0, e1)) {
+            break;
+        }
+        const float previousError = best.error;
+        TryBC7Mode6(texels, e0, e1, best);
+        if (best.error >= previousError) {
+            break;
+        }
+    }
+
+    // The anchor (texel 0) index is stored with an implicit zero top bit.
+    if (best.indices[0] & 8) {
+        std::swap(best.endpoint[0], best.endpoint[1]);
+        std::swap(best.pbit[0], best.pbit[1]);
+        for (uint8_t& index : best.indices) {
+            index = static_cast<uint8_t>(15 - index);
+        }
+    }
+
+    BitWriter writer;
+    writer.Put(1u << 6, 7); // mode 6
+    for (int ch = 0; ch < 4; ++ch) {
+        writer.Put(best.endpoint[0][ch], 7);
+        writer.Put(best.endpoint[1][ch], 7);
+    }
+    writer.Put(best.pbit[0], 1);
+    writer.Put(best.pbit[1], 1);
+    writer.Put(best.indices[0], 3);
+    for (int i = 1; i < 16; ++i) {
+        writer.Put(best.indices[i], 4);
+    }
+    writer.Store(out);
+}
+
+void CompressBlocks(BlockFormat format,
+                    const uint8_t* rgba,
+                    uint32_t width,
+                    uint32_t height,
+                    uint8_t* out,
+                    ThreadPool* pool) {
+    if (width == 0 || height == 0) {
+        return;
+    }
+    const uint32_t blocksX = (width + 3) / 4;
+    const uint32_t blocksY = (height + 3) / 4;
+    const std::size_t blockBytes = BlockBytes(format);
+
+    auto encodeRow = [&](std::size_t by) {
+        uint8_t block[64];
+        uint8_t* dst = out + by * blocksX * blockBytes;
+        for (uint32_t bx = 0; bx < blocksX; ++bx, dst += blockBytes) {
+            GatherBlock(rgba, width, height, bx, static_cast<uint32_t>(by), block);
+            switch (format) {
+            case BlockFormat::BC1:
+                EncodeBC1Block(block, dst);
+                break;
+            case BlockFormat::BC3:
+                EncodeBC3Block(block, dst);
+                break;
+            case BlockFormat::BC5:
+                EncodeBC5Block(block, dst);
+                break;
+            case BlockFormat::BC7:
+                EncodeBC7Block(block, dst);
+                break;
+            }
+        }
+    };
+
+    if (pool) {
+        pool->ParallelFor(blocksY, encodeRow);
+    } else {
+        for (uint32_t by = 0; by < blocksY; ++by) {
+            encodeRow(by);
+        }
+    }
+}
+
+} // namespace gfx
@@ -0,0 +1,39 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+class ThreadPool;
+
+namespace gfx {
+
+enum class BlockFormat : uint32_t {
+    BC1 = 1, // RGB, 4 bpp
+    BC3 = 3, // RGBA (BC1 colour + BC4 alpha), 8 bpp
+    BC5 = 5, // RG (two BC4 channels), 8 bpp; for normal maps
+    BC7 = 7, // RGBA, 8 bpp; encoded with mode 6 only
+};
+
+std::size_t BlockBytes(BlockFormat format);
+
+// Bytes needed for a width x height image in `format` (4x4 blocks, partial
+// blocks at the edges included).
+std::size_t CompressedSize(BlockFormat format, uint32_t width, uint32_t height);
+
+// Encodes tightly packed RGBA8 pixels row by row into blocks. Edge blocks
+// replicate the last row/column. Block rows are spread across `pool` when
+// one is given.
+void CompressBlocks(BlockFormat format,
+                    const uint8_t* rgba,
+                    uint32_t width,
+                    uint32_t height,
+                    uint8_t* out,
+                    ThreadPool* pool = nullptr);
+
+// Single 4x4 block encoders; `block` is 16 RGBA8 texels in row order.
+void EncodeBC1Block(const uint8_t block[64], uint8_t out[8]);
+void EncodeBC3Block(const uint8_t block[64], uint8_t out[16]);
+void EncodeBC5Block(const uint8_t block[64], uint8_t out[16]);
+void EncodeBC7Block(const uint8_t block[64], uint8_t out[16]);
+
+} // namespace gfx
@@ -0,0 +1,49 @@
+#pragma once
+
+#include <limits>
+
+#include <glm/glm.hpp>
+
+struct BoundingSphere {
+    glm::vec3 center{0.0f};
+    float radius = 0.0f;
+};
+
+// Axis-aligned box; empty (min > max) until a point is added.
+struct BoundingBox {
+    glm::vec3 min{std::numeric_limits<float>::max()};
+    glm::vec3 max{std::numeric_limits<float>::lowest()};
+
+    void Expand(const glm::vec3& point) {
+        min = glm::min(min, point);
+        max = glm::max(max, point);
+    }
+    void Expand(const BoundingBox& box) {
+        min = glm::min(min, box.min);
+        max = glm::max(max, box.max);
+    }
+    bool Empty() const { return min.x > max.x || min.y > max.y || min.z > max.z; }
+    glm::vec3 Center() const { return (min + max) * 0.5f; }
+    glm::vec3 Extents() const { return (max - min) * 0.5f; }
+};
+
+// Encloses `sphere` after an affine transform, scaling the radius by the
+// largest axis scale.
+inline BoundingSphere TransformSphere(const BoundingSphere& sphere, const glm::mat4& transform) {
+    const float scale = glm::max(glm::max(glm::length(glm::vec3(transform[0])), glm::length(glm::vec3(transform[1]))),
+                                 glm::length(glm::vec3(transform[2])));
+    return BoundingSphere{glm::vec3(transform * glm::vec4(sphere.center, 1.0f)), sphere.radius * scale};
+}
+
+// Axis-aligned bounds of `box` after an affine transform: the centre is
+// transformed and the extents are projected onto the new axes (Arvo).
+inline BoundingBox TransformBox(const BoundingBox& box, const glm::mat4& transform) {
+    const glm::vec3 center = glm::vec3(transform * glm::vec4(box.Center(), 1.0f));
+    const glm::mat3 axes(transform);
+    const glm::vec3 extents = box.Extents();
+    const glm::vec3 projected = glm::abs(axes[0]) * extents.x + glm::abs(axes[1]) * extents.y + glm::abs(axes[2]) * extents.z;
+    BoundingBox result;
+    result.min = center - projected;
+    result.max = center + projected;
+    return result;
+}
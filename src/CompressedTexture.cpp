@@ -0,0 +1,311 @@
+#include "CompressedTexture.hpp"
+
+#include "MappedFile.hpp"
+#include "SourceStamp.hpp"
+#include "ThreadPool.hpp"
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+#include <fstream>
+#include <system_error>
+
+namespace gfx {
+namespace {
+
+constexpr char kMagic[8] = {'U', 'F', 'O', 'T', 'E', 'X', '\0', '\0'};
+constexpr uint32_t kFlagSrgb = 1u << 0;
+constexpr std::size_t kDataAlignment = 16;
+
+struct TextureHeader {
+    char magic[8];
+    uint32_t version;
+    uint32_t format;
+    uint32_t flags;
+    uint32_t mipCount;
+    uint64_t sourceSize;
+    int64_t sourceMtime;
+    uint64_t sourceHash;
+    uint64_t dataOffset;
+    uint64_t dataSize;
+};
+
+struct MipRecord {
+    uint32_t width;
+    uint32_t height;
+    uint64_t offset;
+    uint64_t size;
+};
+
+bool Fail(std::string* error, const std::string& message) {
+    if (error) {
+        *error = message;
+    }
+    return false;
+}
+
+bool IsKnownFormat(uint32_t format) {
+    return format == static_cast<uint32_t>(BlockFormat::BC1) || format == static_cast<uint32_t>(BlockFormat::BC3) ||
+           format == static_cast<uint32_t>(BlockFormat::BC5) || format == static_cast<uint32_t>(BlockFormat::BC7);
+}
+
+const std::array<float, 256>& SrgbToLinearTable() {
+    static const std::array<float, 256> table = [] {
+        std::array<float, 256> values{};
+        for (int i = 0; i < 256; ++i) {
+            float c = static_cast<float>(i) / 255.0f;
+            values[i] = c <= 0.04045f ? c / 12.92f : std::pow((c + 0.055f) / 1.055f, 2.4f);
+        }
+        return values;
+    }();
+    return table;
+}
+
+uint8_t LinearToSrgb(float linear) {
+    float c = linear <= 0.0031308f ? linear * 12.92f : 1.055f * std::pow(linear, 1.0f / 2.4f) - 0.055f;
+    return static_cast<uint8_t>(std::clamp(std::lround(c * 255.0f), 0L, 255L));
+}
+
+// 2x2 box filter; odd edges reuse the last row/column.
+void Downsample(const ImageRGBA8& source, bool srgb, ImageRGBA8& out, ThreadPool* pool) {
+    out.width = std::max(1u, source.width / 2);
+    out.height = std::max(1u, source.height / 2);
+    out.pixels.resize(static_cast<std::size_t>(out.width) * out.height * 4);
+    const auto& toLinear = SrgbToLinearTable();
+
+    auto filterRow = [&](std::size_t y) {
+        const uint32_t y0 = std::min(static_cast<uint32_t>(y) * 2, source.height - 1);
+        const uint32_t y1 = std::min(y0 + 1, source.height - 1);
+        for (uint32_t x = 0; x < out.width; ++x) {
+            const uint32_t x0 = std::min(x * 2, source.width - 1);
+            const uint32_t x1 = std::min(x0 + 1, source.width - 1);
+            const uint8_t* taps[4] = {
+                &source.pixels[(static_cast<std::size_t>(y0) * source.width + x0) * 4],
+                &source.pixels[(static_cast<std::size_t>(y0) * source.width + x1) * 4],
+                &source.pixels[(static_cast<std::size_t>(y1) * source.width + x0) * 4],
+                &source.pixels[(static_cast<std::size_t>(y1) * source.width + x1) * 4],
+            };
+            uint8_t* dst = &out.pixels[(y * out.width + x) * 4];
+            for (int ch = 0; ch < 4; ++ch) {
+                if (srgb && ch < 3) {
+                    float sum = toLinear[taps[0][ch]] + toLinear[taps[1][ch]] + toLinear[taps[2][ch]] +
+                                toLinear[taps[3][ch]];
+                    dst[ch] = LinearToSrgb(sum * 0.25f);
+                } else {
+                    dst[ch] = static_cast<uint8_t>((taps[0][ch] + taps[1][ch] + taps[2][ch] + taps[3][ch] + 2) / 4);
+                }
+            }
+        }
+    };
+
+    if (pool) {
+        pool->ParallelFor(out.height, filterRow);
+    } else {
+        for (uint32_t y = 0; y < out.height; ++y) {
+            filterRow(y);
+        }
+    }
+}
+
+} // namespace
+
+void CompressTexture(const ImageRGBA8& image, BlockFormat format, bool srgb, CompressedTexture& out, ThreadPool* pool) {
+    out.format = format;
+    out.srgb = srgb;
+    out.mips.clear();
+    out.data.clear();
+    if (image.width == 0 || image.height == 0) {
+        return;
+    }
+
+    ImageRGBA8 level = image;
+    ImageRGBA8 next;
+    while (true) {
+        CompressedMip mip;
+        mip.width = level.width;
+        mip.height = level.height;
+        mip.offset = out.data.size();
+        mip.size = CompressedSize(format, level.width, level.height);
+        out.data.resize(out.data.size() + mip.size);
+        CompressBlocks(format, level.pixels.data(), level.width, level.height, out.data.data() + mip.offset, pool);
+        out.mips.push_back(mip);
+
+        if (level.width == 1 && level.height == 1) {
+            break;
+        }
+        Downsample(level, srgb, next, pool);
+        std::swap(level, next);
+    }
+}
+
+std::filesystem::path CompressedTextureFile::PathFor(const std::filesystem::path& sourcePath) {
+    std::filesystem::path path = sourcePath;
+    path += ".ctex";
+    return path;
+}
+
+bool CompressedTextureFile::Read(const std::filesystem::path& sourcePath,
+                                 CompressedTexture& out,
+                                 std::string* error) {
+    const std::filesystem::path path = PathFor(sourcePath);
+    MappedFile file;
+    if (!file.Open(path, error)) {
+        return false;
+    }
+
+    TextureHeader header{};
+    if (file.Size() < sizeof(header)) {
+        return Fail(error, "Compressed texture is truncated: " + path.string());
+    }
+    std::memcpy(&header, file.Data(), sizeof(header));
+    if (std::memcmp(header.magic, kMagic, sizeof(kMagic)) != 0 || header.version != kVersion ||
+        !IsKnownFormat(header.format) || header.mipCount == 0) {
+        return Fail(error, "Compressed texture has an incompatible format: " + path.string());
+    }
+
+    const uint64_t fileSize = file.Size();
+    const uint64_t tableSize = static_cast<uint64_t>(header.mipCount) * sizeof(MipRecord);
+    if (tableSize > fileSize - sizeof(header) || header.dataOffset > fileSize ||
+        header.dataSize > fileSize - header.dataOffset) {
+        return Fail(error, "Compressed texture is truncated: " + path.string());
+    }
+
+    SourceStamp source;
+    source.size = header.sourceSize;
+    source.mtime = header.sourceMtime;
+    source.contentHash = header.sourceHash;
+    if (!SourceUnchanged(sourcePath, source)) {
+        return Fail(error, "Compressed texture is stale: " + sourcePath.string() + " changed.");
+    }
+
+    out.format = static_cast<BlockFormat>(header.format);
+    out.srgb = (header.flags & kFlagSrgb) != 0;
+    out.mips.resize(header.mipCount);
+    for (uint32_t i = 0; i < header.mipCount; ++i) {
+        MipRecord record{};
+        std::memcpy(&record, file.Data() + sizeof(header) + i * sizeof(MipRecord), sizeof(record));
+        if (record.offset > header.dataSize || record.size > header.dataSize - record.offset ||
+            record.size != CompressedSize(out.format, record.width, record.height)) {
+            return Fail(error, "Compressed texture is corrupt: " + path.string());
+        }
+        out.mips[i] = {record.width, record.height, record.offset, record.size};
+    }
+
+    const auto* data = reinterpret_cast<const uint8_t*>(file.Data() + header.dataOffset);
+    out.data.assign(data, data + header.dataSize);
+    return true;
+}
+
+bool CompressedTextureFile::Write(const std::filesystem::path& sourcePath,
+                                  const CompressedTexture& texture,
+                                  std::string* error) {
+    const std::filesystem::path path = PathFor(sourcePath);
+
+    SourceStamp source;
+    if (!StampSource(sourcePath, source)) {
+        return Fail(error, "Unable to read texture source: " + sourcePath.string());
+    }
+
+    TextureHeader header{};
+    std::memcpy(header.magic, kMagic, sizeof(kMagic));
+    header.version = kVersion;
+    header.format = static_cast<uint32_t>(texture.format);
+    header.flags = texture.srgb ? kFlagSrgb : 0u;
+    header.mipCount = static_cast<uint32_t>(texture.mips.size());
+    header.sourceSize = source.size;
+    header.sourceMtime = source.mtime;
+    header.sourceHash = source.contentHash;
+    const uint64_t tableEnd = sizeof(header) + texture.mips.size() * sizeof(MipRecord);
+    header.dataOffset = (tableEnd + kDataAlignment - 1) / kDataAlignment * kDataAlignment;
+    header.dataSize = texture.data.size();
+
+    // Write to a temporary file and rename so readers never see a partial file.
+    std::filesystem::path tempPath = path;
+    tempPath += ".tmp";
+    {
+        std::ofstream out(tempPath, std::ios::binary | std::ios::trunc);
+        if (!out) {
+            return Fail(error, "Unable to create compressed texture: " + tempPath.string());
+        }
+        out.write(reinterpret_cast<const char*>(&header), sizeof(header));
+        for (const CompressedMip& mip : texture.mips) {
+            MipRecord record{mip.width, mip.height, mip.offset, mip.size};
+            out.write(reinterpret_cast<const char*>(&record), sizeof(record));
+        }
+        const char padding[kDataAlignment] = {};
+        out.write(padding, static_cast<std::streamsize>(header.dataOffset - tableEnd));
+        out.write(reinterpret_cast<const char*>(texture.data.data()), static_cast<std::streamsize>(texture.data.size()));
+        if (!out) {
+            out.close();
+            std::filesystem::remove(tempPath);
+            return Fail(error, "Unable to write compressed texture: " + tempPath.string());
+        }
+    }
+
+    std::error_code ec;
+    std::filesystem::rename(tempPath, path, ec);
+    if (ec) {
+        std::filesystem::remove(tempPath, ec);
+        return Fail(error, "Unable to replace compressed texture: " + path.string());
+    }
+    return true;
+}
+
+GLenum CompressedInternalFormat(BlockFormat format, bool srgb) {
+    switch (format) {
+    case BlockFormat::BC1:
+        return srgb ? GL_COMPRESSED_SRGB_S3TC_DXT1_EXT : GL_COMPRESSED_RGB_S3TC_DXT1_EXT;
+    case BlockFormat::BC3:
+        return srgb ? GL_COMPRESSED_SRGB_ALPHA_S3TC_DXT5_EXT : GL_COMPRESSED_RGBA_S3TC_DXT5_EXT;
+    case BlockFormat::BC5:
+        return GL_COMPRESSED_RG_RGTC2;
+    case BlockFormat::BC7:
+        return srgb ? GL_COMPRESSED_SRGB_ALPHA_BPTC_UNORM : GL_COMPRESSED_RGBA_BPTC_UNORM;
+    }
+    return 0;
+}
+
+CompressedFormatSupport CompressedFormatSupport::Query() {
+    CompressedFormatSupport support;
+    support.s3tc = GLEW_EXT_texture_compression_s3tc;
+    support.s3tcSrgb = support.s3tc && GLEW_EXT_texture_sRGB;
+    support.bptc = GLEW_VERSION_4_2 || GLEW_ARB_texture_compression_bptc;
+    support.rgtc = true; // core since OpenGL 3.0
+    return support;
+}
+
+bool CompressedFormatSupport::Supports(BlockFormat format, bool srgb) const {
+    switch (format) {
+    case BlockFormat::BC1:
+    case BlockFormat::BC3:
+        return srgb ? s3tcSrgb : s3tc;
+    case BlockFormat::BC5:
+        return rgtc && !srgb;
+    case BlockFormat::BC7:
+        return bptc;
+    }
+    return false;
+}
+
+void UploadCompressedTexture2D(GLuint texture, const CompressedTexture& compressed, const uint8_t* data) {
+    const GLenum internalFormat = CompressedInternalFormat(compressed.format, compressed.srgb);
+    glBindTexture(GL_TEXTURE_2D, texture);
+    for (std::size_t level = 0; level < compressed.mips.size(); ++level) {
+        const CompressedMip& mip = compressed.mips[level];
+        glCompressedTexImage2D(GL_TEXTURE_2D, static_cast<GLint>(level), internalFormat,
+                               static_cast<GLsizei>(mip.width), static_cast<GLsizei>(mip.height), 0,
+                               static_cast<GLsizei>(mip.size),
+                               reinterpret_cast<const void*>(reinterpret_cast<uintptr_t>(data) + mip.offset));
+    }
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_BASE_LEVEL, 0);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAX_LEVEL, static_cast<GLint>(compressed.mips.size()) - 1);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_LINEAR);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_REPEAT);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_REPEAT);
+    glBindTexture(GL_TEXTURE_2D, 0);
+}
+
+} // namespace gfx
@@ -0,0 +1,75 @@
+#pragma once
+
+#include "BlockCompression.hpp"
+#include "TextureLoader.hpp"
+
+#include <GL/glew.h>
+#include <cstdint>
+#include <filesystem>
+#include <string>
+#include <vector>
+
+class ThreadPool;
+
+namespace gfx {
+
+struct CompressedMip {
+    uint32_t width = 0;
+    uint32_t height = 0;
+    uint64_t offset = 0; // into CompressedTexture::data
+    uint64_t size = 0;
+};
+
+// Block-compressed image with its full mip chain, level 0 first.
+struct CompressedTexture {
+    BlockFormat format = BlockFormat::BC7;
+    bool srgb = true;
+    std::vector<CompressedMip> mips;
+    std::vector<uint8_t> data;
+};
+
+// Builds the mip chain with a box filter (in linear light for sRGB images)
+// and block-compresses every level, spreading blocks across `pool`.
+void CompressTexture(const ImageRGBA8& image,
+                     BlockFormat format,
+                     bool srgb,
+                     CompressedTexture& out,
+                     ThreadPool* pool = nullptr);
+
+// Compressed copy of a source image stored next to it ("hull.png" ->
+// "hull.png.ctex"), valid while the source size/mtime (or hash) matches.
+// Reading touches no GL state.
+class CompressedTextureFile {
+public:
+    static constexpr uint32_t kVersion = 1;
+
+    static std::filesystem::path PathFor(const std::filesystem::path& sourcePath);
+
+    static bool Read(const std::filesystem::path& sourcePath,
+                     CompressedTexture& out,
+                     std::string* error = nullptr);
+
+    static bool Write(const std::filesystem::path& sourcePath,
+                      const CompressedTexture& texture,
+                      std::string* error = nullptr);
+};
+
+GLenum CompressedInternalFormat(BlockFormat format, bool srgb);
+
+// Which block formats the current context can sample. Query on the GL thread.
+struct CompressedFormatSupport {
+    bool s3tc = false;     // BC1/BC3
+    bool s3tcSrgb = false; // sRGB BC1/BC3
+    bool bptc = false;     // BC7
+    bool rgtc = false;     // BC5
+
+    static CompressedFormatSupport Query();
+    bool Supports(BlockFormat format, bool srgb) const;
+};
+
+// (Re)defines `texture` from every stored mip level. `data` is normally
+// compressed.data.data(); with a pixel unpack buffer bound pass nullptr and
+// the mip offsets address the buffer instead.
+void UploadCompressedTexture2D(GLuint texture, const CompressedTexture& compressed, const uint8_t* data);
+
+} // namespace gfx
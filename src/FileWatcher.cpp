@@ -0,0 +1,117 @@
+#include "FileWatcher.hpp"
+
+#include <set>
+
+#ifdef __linux__
+#include <sys/inotify.h>
+#include <unistd.h>
+
+#include <cstring>
+#endif
+
+namespace {
+
+constexpr auto kScanInterval = std::chrono::milliseconds(500);
+
+} // namespace
+
+FileWatcher::FileWatcher() {
+#ifdef __linux__
+    inotify_ = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+#endif
+}
+
+FileWatcher::~FileWatcher() {
+#ifdef __linux__
+    if (inotify_ >= 0) {
+        close(inotify_);
+    }
+#endif
+}
+
+bool FileWatcher::Watch(const std::filesystem::path& path) {
+    const std::filesystem::path canonical = std::filesystem::absolute(path).lexically_normal();
+    if (files_.count(canonical) != 0) {
+        return true;
+    }
+    SourceStamp stamp;
+    if (!StampSource(canonical, stamp)) {
+        return false;
+    }
+    files_.emplace(canonical, stamp);
+
+#ifdef __linux__
+    if (inotify_ >= 0) {
+        // Adding a directory twice returns the existing descriptor.
+        const std::filesystem::path directory = canonical.parent_path();
+        const int wd = inotify_add_watch(inotify_, directory.c_str(), IN_CLOSE_WRITE | IN_MOVED_TO);
+        if (wd >= 0) {
+            directories_[wd] = directory;
+        }
+    }
+#endif
+    return true;
+}
+
+std::vector<std::filesystem::path> FileWatcher::Poll() {
+    std::set<std::filesystem::path> candidates;
+
+#ifdef __linux__
+    if (inotify_ >= 0) {
+        alignas(inotify_event) char buffer[4096];
+        for (;;) {
+            const ssize_t length = read(inotify_, buffer, sizeof(buffer));
+            if (length <= 0) {
+                break;
+            }
+            for (ssize_t offset = 0; offset < length;) {
+                inotify_event event;
+                std::memcpy(&event, buffer + offset, sizeof(event));
+                if (event.mask & IN_Q_OVERFLOW) {
+                    // Events were dropped; look at everything.
+                    for (const auto& [path, stamp] : files_) {
+                        candidates.insert(path);
+                    }
+                } else if (event.len > 0) {
+                    auto directory = directories_.find(event.wd);
+                    if (directory != directories_.end()) {
+                        const std::filesystem::path path = directory->second / (buffer + offset + sizeof(inotify_event));
+                        if (files_.count(path) != 0) {
+                            candidates.insert(path);
+                        }
+                    }
+                }
+                offset += static_cast<ssize_t>(sizeof(inotify_event) + event.len);
+            }
+        }
+    }
+#endif
+
+    if (inotify_ < 0 && Clock::now() - lastScan_ >= kScanInterval) {
+        lastScan_ = Clock::now();
+        for (const auto& [path, stamp] : files_) {
+            SourceStamp current;
+            if (StatSource(path, current) && (current.size != stamp.size || current.mtime != stamp.mtime)) {
+                candidates.insert(path);
+            }
+        }
+    }
+
+    std::vector<std::filesystem::path> changed;
+    for (const std::filesystem::path& path : candidates) {
+        if (Refresh(path, files_[path])) {
+            changed.push_back(path);
+        }
+    }
+    return changed;
+}
+
+bool FileWatcher::Refresh(const std::filesystem::path& path, SourceStamp& stamp) {
+    SourceStamp current;
+    if (!StampSource(path, current)) {
+        return false; // mid-save; the rename or close that completes it follows
+    }
+    const bool changed = current.size != stamp.size || current.contentHash != stamp.contentHash;
+    stamp = current;
+    return changed;
+}
@@ -0,0 +1,42 @@
+#pragma once
+
+#include "SourceStamp.hpp"
+
+#include <chrono>
+#include <filesystem>
+#include <map>
+#include <unordered_map>
+#include <vector>
+
+// Reports files whose contents changed. On Linux an inotify watch on each
+// file's directory sees in-place writes as well as editors that save by
+// renaming a temporary file; elsewhere size and mtime are polled twice a
+// second. Changes are confirmed by content hash, so saving identical bytes
+// reports nothing.
+class FileWatcher {
+public:
+    FileWatcher();
+    ~FileWatcher();
+
+    FileWatcher(const FileWatcher&) = delete;
+    FileWatcher& operator=(const FileWatcher&) = delete;
+
+    // Watching the same file twice is harmless. False when it cannot be read.
+    bool Watch(const std::filesystem::path& path);
+
+    // Files changed since the last call. Never blocks.
+    std::vector<std::filesystem::path> Poll();
+
+    bool UsesInotify() const { return inotify_ >= 0; }
+
+private:
+    using Clock = std::chrono::steady_clock;
+
+    std::map<std::filesystem::path, SourceStamp> files_;
+    int inotify_ = -1;
+    std::unordered_map<int, std::filesystem::path> directories_; // by watch descriptor
+    Clock::time_point lastScan_;
+
+    // Re-stamps `path`; true when its contents differ from the stored stamp.
+    bool Refresh(const std::filesystem::path& path, SourceStamp& stamp);
+};
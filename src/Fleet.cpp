@@ -0,0 +1,96 @@
+#include "Fleet.hpp"
+
+#include "JobSystem.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <limits>
+
+#include <glm/gtc/matrix_transform.hpp>
+
+std::vector<FleetSlot> LayoutFleet(int count, float spacing) {
+    const int side = static_cast<int>(std::ceil(std::sqrt(static_cast<float>(count))));
+    const float origin = -0.5f * spacing * static_cast<float>(side - 1);
+    std::vector<FleetSlot> slots(static_cast<std::size_t>(std::max(count, 0)));
+    for (int i = 0; i < count; ++i) {
+        FleetSlot& slot = slots[static_cast<std::size_t>(i)];
+        slot.position = glm::vec3(origin + spacing * static_cast<float>(i % side), 0.0f,
+                                  origin + spacing * static_cast<float>(i / side));
+        slot.phase = static_cast<float>(i) * 2.39996f; // golden angle, so neighbours never move in step
+    }
+    return slots;
+}
+
+InstanceTransform AnimateFleetSlot(const FleetSlot& slot, float time, float bobHeight) {
+    glm::mat4 model = glm::translate(glm::mat4(1.0f),
+                                     slot.position + glm::vec3(0.0f, bobHeight * std::sin(time * 1.3f + slot.phase), 0.0f));
+    model = glm::rotate(model, time * 0.15f + slot.phase, glm::vec3(0.0f, 1.0f, 0.0f));
+    model = glm::scale(model, glm::vec3(1.4f));
+    return MakeInstanceTransform(model, true);
+}
+
+void FleetUpdater::SetFleet(std::vector<FleetSlot> slots) {
+    slots_ = std::move(slots);
+    transforms_.resize(slots_.size());
+    culler_.Clear();
+    culler_.Resize(slots_.size());
+    visible_.clear();
+    jobVisible_.resize((slots_.size() + kGrain - 1) / kGrain);
+    for (std::vector<uint32_t>& visible : jobVisible_) {
+        visible.reserve(kGrain);
+    }
+    visible_.reserve(slots_.size());
+}
+
+void FleetUpdater::Update(JobSystem& jobs, float time, float bobHeight, const BoundingBox& localBox, const Frustum& frustum) {
+    const auto start = std::chrono::steady_clock::now();
+    JobCounter culled;
+    jobs.ParallelFor(slots_.size(), kGrain, [&](std::size_t begin, std::size_t end) {
+        for (std::size_t i = begin; i < end; ++i) {
+            transforms_[i] = AnimateFleetSlot(slots_[i], time, bobHeight);
+            culler_.Set(static_cast<uint32_t>(i), TransformBox(localBox, transforms_[i].model));
+        }
+        std::vector<uint32_t>& visible = jobVisible_[begin / kGrain];
+        visible.clear();
+        culler_.CullRange(frustum, begin, end, visible);
+    }, culled);
+    JobCounter gathered;
+    jobs.RunAfter(culled, [this]() {
+        visible_.clear();
+        for (const std::vector<uint32_t>& visible : jobVisible_) {
+            visible_.insert(visible_.end(), visible.begin(), visible.end());
+        }
+    }, &gathered);
+    // `culled` is done with before the gather job can run.
+    jobs.Wait(gathered);
+
+    stats_.tested = static_cast<uint32_t>(slots_.size());
+    stats_.visible = static_cast<uint32_t>(visible_.size());
+    stats_.ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+}
+
+float FleetUpdater::BuildInstances(JobSystem& jobs,
+                                   std::span<const uint32_t> drawn,
+                                   const BoundingSphere& localSphere,
+                                   const LodSelector& lodSelector,
+                                   const glm::vec3& cameraPos,
+                                   InstanceTransform* out) {
+    jobError_.assign((drawn.size() + kGrain - 1) / kGrain, std::numeric_limits<float>::max());
+    JobCounter built;
+    jobs.ParallelFor(drawn.size(), kGrain, [&](std::size_t begin, std::size_t end) {
+        float maxObjectError = std::numeric_limits<float>::max();
+        for (std::size_t k = begin; k < end; ++k) {
+            const InstanceTransform& instance = transforms_[drawn[k]];
+            maxObjectError = std::min(maxObjectError, lodSelector.MaxObjectError(instance.model, localSphere, cameraPos));
+            out[k] = instance;
+        }
+        jobError_[begin / kGrain] = maxObjectError;
+    }, built);
+    jobs.Wait(built);
+    float maxObjectError = std::numeric_limits<float>::max();
+    for (float error : jobError_) {
+        maxObjectError = std::min(maxObjectError, error);
+    }
+    return maxObjectError;
+}
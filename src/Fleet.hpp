@@ -0,0 +1,74 @@
+#pragma once
+
+#include "Bounds.hpp"
+#include "FrustumCuller.hpp"
+#include "InstanceTransform.hpp"
+#include "MeshSimplifier.hpp"
+
+#include <cstddef>
+#include <cstdint>
+#include <span>
+#include <vector>
+
+#include <glm/glm.hpp>
+
+class JobSystem;
+
+struct FleetSlot {
+    glm::vec3 position{0.0f};
+    float phase = 0.0f;
+};
+
+// A square grid centred on the origin, `spacing` apart.
+std::vector<FleetSlot> LayoutFleet(int count, float spacing);
+
+// Every UFO spins and bobs, each out of phase with its neighbours.
+InstanceTransform AnimateFleetSlot(const FleetSlot& slot, float time, float bobHeight);
+
+// The per-frame CPU side of drawing a fleet, spread over a JobSystem: the
+// calling thread only waits, helping with the jobs, and keeps the GL calls.
+//
+//   Update(): animate and frustum cull, one job per kGrain UFOs, then one
+//             job after those gathering the visible indices in order.
+//   BuildInstances(): LOD error and instance data for the UFOs to draw,
+//             written straight to the caller's (mapped) memory.
+//
+// Results do not depend on the thread count.
+class FleetUpdater {
+public:
+    // UFOs per job: a few tens of microseconds of work.
+    static constexpr std::size_t kGrain = 256;
+
+    void SetFleet(std::vector<FleetSlot> slots);
+
+    // `localBox` bounds the model every UFO draws; taken per call, since it
+    // may be reloaded.
+    void Update(JobSystem& jobs, float time, float bobHeight, const BoundingBox& localBox, const Frustum& frustum);
+
+    // Writes the transforms of `drawn` (indices into Transforms()) to `out`
+    // in order and returns the finest LOD error any of them needs.
+    float BuildInstances(JobSystem& jobs,
+                         std::span<const uint32_t> drawn,
+                         const BoundingSphere& localSphere,
+                         const LodSelector& lodSelector,
+                         const glm::vec3& cameraPos,
+                         InstanceTransform* out);
+
+    std::size_t Size() const { return slots_.size(); }
+    const std::vector<InstanceTransform>& Transforms() const { return transforms_; }
+    // Indices of the UFOs inside the frustum, in increasing order.
+    const std::vector<uint32_t>& Visible() const { return visible_; }
+    // Of the last Update(), `ms` being its wall time.
+    const CullStats& Stats() const { return stats_; }
+
+private:
+    std::vector<FleetSlot> slots_;
+    std::vector<InstanceTransform> transforms_;
+    FrustumCuller culler_;
+    std::vector<uint32_t> visible_;
+    CullStats stats_;
+
+    // Per job, merged once all are done.
+    std::vector<std::vector<uint32_t>> jobVisible_;
+    std::vector<float> jobError_;
+};
@@ -0,0 +1,146 @@
+#include "FramePacer.hpp"
+
+#include "GlCalls.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <thread>
+
+namespace {
+
+constexpr std::size_t kHistory = 240;
+// Sleeping overshoots by up to a scheduler tick; the rest is spun.
+constexpr auto kSpinMargin = std::chrono::microseconds(1500);
+
+double Mean(const std::vector<float>& values) {
+    double sum = 0.0;
+    for (float value : values) {
+        sum += value;
+    }
+    return values.empty() ? 0.0 : sum / static_cast<double>(values.size());
+}
+
+double Percentile(std::vector<float> values, double fraction) {
+    if (values.empty()) {
+        return 0.0;
+    }
+    const std::size_t rank = static_cast<std::size_t>(std::ceil(fraction * static_cast<double>(values.size())));
+    const std::size_t index = std::clamp<std::size_t>(rank, 1, values.size()) - 1;
+    std::nth_element(values.begin(), values.begin() + static_cast<std::ptrdiff_t>(index), values.end());
+    return values[index];
+}
+
+} // namespace
+
+FramePacer::~FramePacer() {
+    Destroy();
+}
+
+void FramePacer::SetOptions(const FramePacingOptions& options) {
+    options_ = options;
+    options_.maxQueuedFrames = std::max(options_.maxQueuedFrames, 1);
+    options_.frameCap = std::max(options_.frameCap, 0.0);
+    nextDeadline_ = Clock::now();
+}
+
+void FramePacer::WaitForFrame() {
+    const Clock::time_point start = Clock::now();
+    Retire(static_cast<int>(queued_.size()) >= options_.maxQueuedFrames);
+    WaitForCap();
+
+    const Clock::time_point frameStart = Clock::now();
+    Push(waitMs_, frames_, std::chrono::duration<float, std::milli>(frameStart - start).count());
+    if (frames_ > 0) {
+        // The first interval ends on the second frame, so it is sample 0.
+        Push(frameMs_, frames_ - 1, std::chrono::duration<float, std::milli>(frameStart - lastFrameStart_).count());
+    }
+    lastFrameStart_ = frameStart;
+    ++frames_;
+}
+
+void FramePacer::InputSampled() {
+    inputTime_ = Clock::now();
+}
+
+void FramePacer::EndFrame() {
+    QueuedFrame frame;
+    frame.fence = gl::FenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+    frame.inputTime = inputTime_;
+    queued_.push_back(frame);
+}
+
+void FramePacer::Destroy() {
+    for (QueuedFrame& frame : queued_) {
+        glDeleteSync(frame.fence);
+    }
+    queued_.clear();
+}
+
+FramePacingStats FramePacer::Stats() const {
+    FramePacingStats stats;
+    stats.frames = frameMs_.size();
+    stats.frameMs = Mean(frameMs_);
+    double variance = 0.0;
+    for (float value : frameMs_) {
+        variance += (value - stats.frameMs) * (value - stats.frameMs);
+    }
+    stats.jitterMs = frameMs_.empty() ? 0.0 : std::sqrt(variance / static_cast<double>(frameMs_.size()));
+    stats.frameP99Ms = Percentile(frameMs_, 0.99);
+    stats.latencyMs = Mean(latencyMs_);
+    stats.latencyP95Ms = Percentile(latencyMs_, 0.95);
+    stats.waitMs = Mean(waitMs_);
+    return stats;
+}
+
+void FramePacer::Retire(bool waitOldest) {
+    while (!queued_.empty()) {
+        QueuedFrame& oldest = queued_.front();
+        GLenum status = gl::ClientWaitSync(oldest.fence, 0, 0);
+        if (status == GL_TIMEOUT_EXPIRED && waitOldest) {
+            // Flush so the fence is sure to reach the GPU, then block.
+            GLbitfield flags = GL_SYNC_FLUSH_COMMANDS_BIT;
+            do {
+                status = gl::ClientWaitSync(oldest.fence, flags, 1'000'000'000);
+                flags = 0;
+            } while (status == GL_TIMEOUT_EXPIRED);
+        }
+        if (status == GL_TIMEOUT_EXPIRED) {
+            return;
+        }
+        if (status != GL_WAIT_FAILED) {
+            Push(latencyMs_, retired_++,
+                 std::chrono::duration<float, std::milli>(Clock::now() - oldest.inputTime).count());
+        }
+        gl::DeleteSync(oldest.fence);
+        queued_.pop_front();
+        waitOldest = false;
+    }
+}
+
+void FramePacer::WaitForCap() {
+    if (options_.frameCap <= 0.0) {
+        return;
+    }
+    const auto period = std::chrono::duration_cast<Clock::duration>(std::chrono::duration<double>(1.0 / options_.frameCap));
+    Clock::time_point now = Clock::now();
+    // A frame that ran long moves the schedule rather than bursting to
+    // catch up.
+    if (now - nextDeadline_ > period) {
+        nextDeadline_ = now;
+    }
+    if (nextDeadline_ - now > kSpinMargin) {
+        std::this_thread::sleep_for(nextDeadline_ - now - kSpinMargin);
+    }
+    while (Clock::now() < nextDeadline_) {
+        std::this_thread::yield();
+    }
+    nextDeadline_ += period;
+}
+
+void FramePacer::Push(std::vector<float>& window, std::size_t count, float value) {
+    if (window.size() < kHistory) {
+        window.push_back(value);
+    } else {
+        window[count % kHistory] = value;
+    }
+}
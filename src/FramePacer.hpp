@@ -0,0 +1,90 @@
+#pragma once
+
+#include <GL/glew.h>
+
+#include <chrono>
+#include <cstddef>
+#include <deque>
+#include <vector>
+
+enum class PresentMode {
+    Vsync,    // swap interval 1
+    Adaptive, // late swaps tear instead of waiting a whole refresh
+    Unlocked, // swap interval 0, optionally capped by FramePacingOptions
+};
+
+struct FramePacingOptions {
+    // Frames the CPU may queue ahead of the GPU. 1 waits for the previous
+    // frame before sampling input: the lowest latency, but no CPU/GPU overlap.
+    int maxQueuedFrames = 2;
+    // Frames per second; 0 leaves the rate to the swap interval.
+    double frameCap = 0.0;
+};
+
+// Over the frames a FramePacer still remembers.
+struct FramePacingStats {
+    std::size_t frames = 0;
+    double frameMs = 0.0;    // mean frame-start interval
+    double jitterMs = 0.0;   // its standard deviation
+    double frameP99Ms = 0.0;
+    // From sampling input to the GPU finishing the frame; the display adds
+    // up to a refresh with vsync. Measured when the pacer notices the fence,
+    // so an upper bound.
+    double latencyMs = 0.0;
+    double latencyP95Ms = 0.0;
+    double waitMs = 0.0; // mean time blocked on fences and the cap
+};
+
+// Keeps the CPU at most a few frames ahead of the GPU with fences, caps the
+// frame rate and measures pacing. Per frame: WaitForFrame(), sample input,
+// InputSampled(), render and swap, EndFrame(). GL thread only.
+class FramePacer {
+public:
+    FramePacer() = default;
+    ~FramePacer();
+
+    FramePacer(const FramePacer&) = delete;
+    FramePacer& operator=(const FramePacer&) = delete;
+
+    void SetOptions(const FramePacingOptions& options);
+    const FramePacingOptions& Options() const { return options_; }
+
+    // Blocks until fewer than maxQueuedFrames frames are in flight and the
+    // cap allows another.
+    void WaitForFrame();
+    void InputSampled();
+    // Fences the frame just submitted; call after the swap.
+    void EndFrame();
+    // Deletes the fences without waiting.
+    void Destroy();
+
+    FramePacingStats Stats() const;
+
+private:
+    using Clock = std::chrono::steady_clock;
+
+    struct QueuedFrame {
+        GLsync fence = nullptr;
+        Clock::time_point inputTime;
+    };
+
+    FramePacingOptions options_;
+    std::deque<QueuedFrame> queued_;
+    Clock::time_point inputTime_;
+    Clock::time_point lastFrameStart_;
+    Clock::time_point nextDeadline_;
+    std::size_t frames_ = 0;
+    std::size_t retired_ = 0;
+
+    // Rolling windows for Stats(), kHistory long.
+    std::vector<float> frameMs_;
+    std::vector<float> latencyMs_;
+    std::vector<float> waitMs_;
+
+    // Retires queued frames whose fence has signalled; with wait, blocks on
+    // the oldest first.
+    void Retire(bool waitOldest);
+    void WaitForCap();
+    // Adds the count-th value, replacing the oldest once the window is full.
+    static void Push(std::vector<float>& window, std::size_t count, float value);
+};
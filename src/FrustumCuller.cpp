@@ -0,0 +1,210 @@
+#include "FrustumCuller.hpp"
+
+#include <algorithm>
+#include <bit>
+#include <chrono>
+#include <cmath>
+
+#if defined(__AVX__)
+#define FRUSTUM_CULLER_AVX 1
+#include <immintrin.h>
+#elif defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define FRUSTUM_CULLER_SSE2 1
+#include <emmintrin.h>
+#endif
+
+namespace {
+
+// Appends base + i for every set bit i of a lane mask.
+void AppendVisible(uint32_t mask, std::size_t base, std::vector<uint32_t>& visible) {
+    while (mask != 0) {
+        visible.push_back(static_cast<uint32_t>(base) + static_cast<uint32_t>(std::countr_zero(mask)));
+        mask &= mask - 1;
+    }
+}
+
+} // namespace
+
+Frustum Frustum::FromViewProjection(const glm::mat4& viewProjection) {
+    auto row = [&](int i) {
+        return glm::vec4(viewProjection[0][i], viewProjection[1][i], viewProjection[2][i], viewProjection[3][i]);
+    };
+    Frustum frustum;
+    frustum.planes = {row(3) + row(0), row(3) - row(0), row(3) + row(1),
+                      row(3) - row(1), row(3) + row(2), row(3) - row(2)};
+    for (glm::vec4& plane : frustum.planes) {
+        plane /= glm::length(glm::vec3(plane));
+    }
+    return frustum;
+}
+
+bool Frustum::Intersects(const BoundingBox& box) const {
+    const glm::vec3 center = box.Center();
+    const glm::vec3 extents = box.Extents();
+    for (const glm::vec4& plane : planes) {
+        const float distance = center.x * plane.x + center.y * plane.y + center.z * plane.z + plane.w;
+        const float reach = extents.x * std::abs(plane.x) + extents.y * std::abs(plane.y) + extents.z * std::abs(plane.z);
+        if (distance + reach < 0.0f) {
+            return false;
+        }
+    }
+    return true;
+}
+
+const char* FrustumCuller::InstructionSet() {
+#if FRUSTUM_CULLER_AVX
+    return "AVX";
+#elif FRUSTUM_CULLER_SSE2
+    return "SSE2";
+#else
+    return "scalar";
+#endif
+}
+
+void FrustumCuller::Clear() {
+    centerX_.clear();
+    centerY_.clear();
+    centerZ_.clear();
+    extentX_.clear();
+    extentY_.clear();
+    extentZ_.clear();
+}
+
+void FrustumCuller::Reserve(std::size_t count) {
+    centerX_.reserve(count);
+    centerY_.reserve(count);
+    centerZ_.reserve(count);
+    extentX_.reserve(count);
+    extentY_.reserve(count);
+    extentZ_.reserve(count);
+}
+
+void FrustumCuller::Resize(std::size_t count) {
+    centerX_.resize(count);
+    centerY_.resize(count);
+    centerZ_.resize(count);
+    extentX_.resize(count);
+    extentY_.resize(count);
+    extentZ_.resize(count);
+}
+
+uint32_t FrustumCuller::Add(const BoundingBox& worldBox) {
+    const glm::vec3 center = worldBox.Center();
+    const glm::vec3 extents = worldBox.Extents();
+    centerX_.push_back(center.x);
+    centerY_.push_back(center.y);
+    centerZ_.push_back(center.z);
+    extentX_.push_back(extents.x);
+    extentY_.push_back(extents.y);
+    extentZ_.push_back(extents.z);
+    return static_cast<uint32_t>(centerX_.size() - 1);
+}
+
+uint32_t FrustumCuller::Add(const BoundingBox& localBox, const glm::mat4& transform) {
+    return Add(TransformBox(localBox, transform));
+}
+
+void FrustumCuller::Set(uint32_t index, const BoundingBox& worldBox) {
+    const glm::vec3 center = worldBox.Center();
+    const glm::vec3 extents = worldBox.Extents();
+    centerX_[index] = center.x;
+    centerY_[index] = center.y;
+    centerZ_[index] = center.z;
+    extentX_[index] = extents.x;
+    extentY_[index] = extents.y;
+    extentZ_[index] = extents.z;
+}
+
+void FrustumCuller::Cull(const Frustum& frustum, std::vector<uint32_t>& visible) {
+    const auto start = std::chrono::steady_clock::now();
+    visible.clear();
+    CullRange(frustum, 0, centerX_.size(), visible);
+    stats_.tested = static_cast<uint32_t>(centerX_.size());
+    stats_.visible = static_cast<uint32_t>(visible.size());
+    stats_.ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+}
+
+void FrustumCuller::CullRange(const Frustum& frustum, std::size_t begin, std::size_t end,
+                              std::vector<uint32_t>& visible) const {
+    const std::size_t count = std::min(end, centerX_.size());
+    std::array<glm::vec3, 6> absNormals;
+    for (std::size_t p = 0; p < 6; ++p) {
+        absNormals[p] = glm::abs(glm::vec3(frustum.planes[p]));
+    }
+
+    // A box survives a plane when centre distance + projected extent >= 0.
+    // Every path evaluates that sum in the same order, so they agree exactly
+    // wherever a range starts.
+    std::size_t i = begin;
+#if FRUSTUM_CULLER_AVX
+    __m256 px[6], py[6], pz[6], pw[6], ax[6], ay[6], az[6];
+    for (std::size_t p = 0; p < 6; ++p) {
+        px[p] = _mm256_set1_ps(frustum.planes[p].x);
+        py[p] = _mm256_set1_ps(frustum.planes[p].y);
+        pz[p] = _mm256_set1_ps(frustum.planes[p].z);
+        pw[p] = _mm256_set1_ps(frustum.planes[p].w);
+        ax[p] = _mm256_set1_ps(absNormals[p].x);
+        ay[p] = _mm256_set1_ps(absNormals[p].y);
+        az[p] = _mm256_set1_ps(absNormals[p].z);
+    }
+    const __m256 zero = _mm256_setzero_ps();
+    for (; i + 8 <= count; i += 8) {
+        const __m256 cx = _mm256_loadu_ps(centerX_.data() + i);
+        const __m256 cy = _mm256_loadu_ps(centerY_.data() + i);
+        const __m256 cz = _mm256_loadu_ps(centerZ_.data() + i);
+        const __m256 ex = _mm256_loadu_ps(extentX_.data() + i);
+        const __m256 ey = _mm256_loadu_ps(extentY_.data() + i);
+        const __m256 ez = _mm256_loadu_ps(extentZ_.data() + i);
+        __m256 inside = _mm256_castsi256_ps(_mm256_set1_epi32(-1));
+        for (std::size_t p = 0; p < 6; ++p) {
+            const __m256 distance = _mm256_add_ps(
+                _mm256_add_ps(_mm256_add_ps(_mm256_mul_ps(cx, px[p]), _mm256_mul_ps(cy, py[p])), _mm256_mul_ps(cz, pz[p])),
+                pw[p]);
+            const __m256 reach =
+                _mm256_add_ps(_mm256_add_ps(_mm256_mul_ps(ex, ax[p]), _mm256_mul_ps(ey, ay[p])), _mm256_mul_ps(ez, az[p]));
+            inside = _mm256_and_ps(inside, _mm256_cmp_ps(_mm256_add_ps(distance, reach), zero, _CMP_GE_OQ));
+        }
+        AppendVisible(static_cast<uint32_t>(_mm256_movemask_ps(inside)), i, visible);
+    }
+#elif FRUSTUM_CULLER_SSE2
+    __m128 px[6], py[6], pz[6], pw[6], ax[6], ay[6], az[6];
+    for (std::size_t p = 0; p < 6; ++p) {
+        px[p] = _mm_set1_ps(frustum.planes[p].x);
+        py[p] = _mm_set1_ps(frustum.planes[p].y);
+        pz[p] = _mm_set1_ps(frustum.planes[p].z);
+        pw[p] = _mm_set1_ps(frustum.planes[p].w);
+        ax[p] = _mm_set1_ps(absNormals[p].x);
+        ay[p] = _mm_set1_ps(absNormals[p].y);
+        az[p] = _mm_set1_ps(absNormals[p].z);
+    }
+    const __m128 zero = _mm_setzero_ps();
+    for (; i + 4 <= count; i += 4) {
+        const __m128 cx = _mm_loadu_ps(centerX_.data() + i);
+        const __m128 cy = _mm_loadu_ps(centerY_.data() + i);
+        const __m128 cz = _mm_loadu_ps(centerZ_.data() + i);
+        const __m128 ex = _mm_loadu_ps(extentX_.data() + i);
+        const __m128 ey = _mm_loadu_ps(extentY_.data() + i);
+        const __m128 ez = _mm_loadu_ps(extentZ_.data() + i);
+        __m128 inside = _mm_castsi128_ps(_mm_set1_epi32(-1));
+        for (std::size_t p = 0; p < 6; ++p) {
+            const __m128 distance =
+                _mm_add_ps(_mm_add_ps(_mm_add_ps(_mm_mul_ps(cx, px[p]), _mm_mul_ps(cy, py[p])), _mm_mul_ps(cz, pz[p])), pw[p]);
+            const __m128 reach = _mm_add_ps(_mm_add_ps(_mm_mul_ps(ex, ax[p]), _mm_mul_ps(ey, ay[p])), _mm_mul_ps(ez, az[p]));
+            inside = _mm_and_ps(inside, _mm_cmpge_ps(_mm_add_ps(distance, reach), zero));
+        }
+        AppendVisible(static_cast<uint32_t>(_mm_movemask_ps(inside)), i, visible);
+    }
+#endif
+    for (; i < count; ++i) {
+        bool inside = true;
+        for (std::size_t p = 0; p < 6; ++p) {
+            const glm::vec4& plane = frustum.planes[p];
+            const float distance = centerX_[i] * plane.x + centerY_[i] * plane.y + centerZ_[i] * plane.z + plane.w;
+            const float reach = extentX_[i] * absNormals[p].x + extentY_[i] * absNormals[p].y + extentZ_[i] * absNormals[p].z;
+            inside = inside && distance + reach >= 0.0f;
+        }
+        if (inside) {
+            visible.push_back(static_cast<uint32_t>(i));
+        }
+    }
+}
@@ -0,0 +1,78 @@
+#pragma once
+
+#include "Bounds.hpp"
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include <glm/glm.hpp>
+
+// Six planes (xyz normal pointing inwards, w distance), normalized.
+struct Frustum {
+    std::array<glm::vec4, 6> planes{};
+
+    // Gribb/Hartmann extraction from projection * view (OpenGL clip space).
+    static Frustum FromViewProjection(const glm::mat4& viewProjection);
+
+    // Scalar reference for FrustumCuller; true unless the box lies entirely
+    // behind one plane.
+    bool Intersects(const BoundingBox& box) const;
+};
+
+struct CullStats {
+    uint32_t tested = 0;
+    uint32_t visible = 0;
+    double ms = 0.0;
+
+    uint32_t Culled() const { return tested - visible; }
+};
+
+// World-space boxes stored as separate centre/extent arrays so the frustum
+// test runs on a register of boxes at once: 8 with AVX, 4 with SSE2,
+// chosen at compile time; other targets test one box at a time. Fill it
+// every frame, then Cull(). Resize(), Set() and CullRange() let several
+// threads fill and cull disjoint ranges at once.
+class FrustumCuller {
+public:
+    static constexpr std::size_t kLanes =
+#if defined(__AVX__)
+        8;
+#elif defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+        4;
+#else
+        1;
+#endif
+
+    // "AVX", "SSE2" or "scalar".
+    static const char* InstructionSet();
+
+    void Clear();
+    void Reserve(std::size_t count);
+    void Resize(std::size_t count);
+    // Returns the box's index.
+    uint32_t Add(const BoundingBox& worldBox);
+    // Adds `localBox` moved into world space by `transform`.
+    uint32_t Add(const BoundingBox& localBox, const glm::mat4& transform);
+    void Set(uint32_t index, const BoundingBox& worldBox);
+
+    // Replaces `visible` with the indices of the boxes that intersect the
+    // frustum, in increasing order.
+    void Cull(const Frustum& frustum, std::vector<uint32_t>& visible);
+    // Appends the visible boxes of [begin, end) to `visible`, in increasing
+    // order, without updating Stats(). Same results as Cull().
+    void CullRange(const Frustum& frustum, std::size_t begin, std::size_t end, std::vector<uint32_t>& visible) const;
+
+    std::size_t Size() const { return centerX_.size(); }
+    const CullStats& Stats() const { return stats_; }
+
+private:
+    std::vector<float> centerX_;
+    std::vector<float> centerY_;
+    std::vector<float> centerZ_;
+    std::vector<float> extentX_;
+    std::vector<float> extentY_;
+    std::vector<float> extentZ_;
+    CullStats stats_;
+};
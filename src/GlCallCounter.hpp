@@ -0,0 +1,48 @@
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+
+// CPU-side tally of the GL calls the renderer issues per frame, so changes
+// to state traffic can be measured without a GPU profiler. Render code
+// issues its per-frame calls through the wrappers in GlCalls.hpp, which
+// record themselves; the counter is only touched on the GL thread.
+enum class GlCall : uint8_t {
+    Uniform,      // glUniform*
+    Bind,         // program, VAO, texture and buffer binds
+    BufferUpdate, // glBufferSubData and friends
+    Draw,
+    Other,        // clears, viewport, fences, timer queries, ...
+    Count,
+};
+
+struct GlCallStats {
+    std::array<uint32_t, static_cast<std::size_t>(GlCall::Count)> calls{};
+
+    uint32_t Of(GlCall kind) const { return calls[static_cast<std::size_t>(kind)]; }
+    uint32_t Total() const {
+        uint32_t total = 0;
+        for (uint32_t count : calls) {
+            total += count;
+        }
+        return total;
+    }
+};
+
+class GlCallCounter {
+public:
+    static void Record(GlCall kind, uint32_t count = 1) { current_.calls[static_cast<std::size_t>(kind)] += count; }
+
+    // Publishes the calls recorded since the last EndFrame() and restarts.
+    static void EndFrame() {
+        lastFrame_ = current_;
+        current_ = GlCallStats{};
+    }
+
+    static const GlCallStats& LastFrame() { return lastFrame_; }
+
+private:
+    static inline GlCallStats current_{};
+    static inline GlCallStats lastFrame_{};
+};
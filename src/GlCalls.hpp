@@ -0,0 +1,223 @@
+#pragma once
+
+#include "GlCallCounter.hpp"
+
+#include <GL/glew.h>
+
+// The GL calls render code issues per frame, each recording itself in
+// GlCallCounter, so the tally cannot drift from the calls actually made.
+// Setup, asset uploads, frame dumps and teardown call GL directly and are
+// not counted.
+namespace gl {
+
+// GlCall::Bind
+inline void UseProgram(GLuint program) {
+    glUseProgram(program);
+    GlCallCounter::Record(GlCall::Bind);
+}
+
+inline void BindVertexArray(GLuint vao) {
+    glBindVertexArray(vao);
+    GlCallCounter::Record(GlCall::Bind);
+}
+
+inline void ActiveTexture(GLenum unit) {
+    glActiveTexture(unit);
+    GlCallCounter::Record(GlCall::Bind);
+}
+
+inline void BindTexture(GLenum target, GLuint texture) {
+    glBindTexture(target, texture);
+    GlCallCounter::Record(GlCall::Bind);
+}
+
+inline void BindBuffer(GLenum target, GLuint buffer) {
+    glBindBuffer(target, buffer);
+    GlCallCounter::Record(GlCall::Bind);
+}
+
+inline void BindBufferBase(GLenum target, GLuint index, GLuint buffer) {
+    glBindBufferBase(target, index, buffer);
+    GlCallCounter::Record(GlCall::Bind);
+}
+
+inline void BindBufferRange(GLenum target, GLuint index, GLuint buffer, GLintptr offset, GLsizeiptr size) {
+    glBindBufferRange(target, index, buffer, offset, size);
+    GlCallCounter::Record(GlCall::Bind);
+}
+
+inline void BindFramebuffer(GLenum target, GLuint framebuffer) {
+    glBindFramebuffer(target, framebuffer);
+    GlCallCounter::Record(GlCall::Bind);
+}
+
+// GlCall::Uniform
+inline void UniformMatrix4fv(GLint location, GLsizei count, GLboolean transpose, const GLfloat* value) {
+    glUniformMatrix4fv(location, count, transpose, value);
+    GlCallCounter::Record(GlCall::Uniform);
+}
+
+inline void UniformMatrix3fv(GLint location, GLsizei count, GLboolean transpose, const GLfloat* value) {
+    glUniformMatrix3fv(location, count, transpose, value);
+    GlCallCounter::Record(GlCall::Uniform);
+}
+
+inline void Uniform3fv(GLint location, GLsizei count, const GLfloat* value) {
+    glUniform3fv(location, count, value);
+    GlCallCounter::Record(GlCall::Uniform);
+}
+
+inline void Uniform1f(GLint location, GLfloat value) {
+    glUniform1f(location, value);
+    GlCallCounter::Record(GlCall::Uniform);
+}
+
+inline void Uniform1i(GLint location, GLint value) {
+    glUniform1i(location, value);
+    GlCallCounter::Record(GlCall::Uniform);
+}
+
+// GlCall::BufferUpdate
+inline void BufferData(GLenum target, GLsizeiptr size, const void* data, GLenum usage) {
+    glBufferData(target, size, data, usage);
+    GlCallCounter::Record(GlCall::BufferUpdate);
+}
+
+inline void BufferSubData(GLenum target, GLintptr offset, GLsizeiptr size, const void* data) {
+    glBufferSubData(target, offset, size, data);
+    GlCallCounter::Record(GlCall::BufferUpdate);
+}
+
+inline void* MapBufferRange(GLenum target, GLintptr offset, GLsizeiptr length, GLbitfield access) {
+    void* data = glMapBufferRange(target, offset, length, access);
+    GlCallCounter::Record(GlCall::BufferUpdate);
+    return data;
+}
+
+inline void FlushMappedBufferRange(GLenum target, GLintptr offset, GLsizeiptr length) {
+    glFlushMappedBufferRange(target, offset, length);
+    GlCallCounter::Record(GlCall::BufferUpdate);
+}
+
+inline GLboolean UnmapBuffer(GLenum target) {
+    const GLboolean intact = glUnmapBuffer(target);
+    GlCallCounter::Record(GlCall::BufferUpdate);
+    return intact;
+}
+
+// GlCall::Draw
+inline void DrawArrays(GLenum mode, GLint first, GLsizei count) {
+    glDrawArrays(mode, first, count);
+    GlCallCounter::Record(GlCall::Draw);
+}
+
+inline void DrawElements(GLenum mode, GLsizei count, GLenum type, const void* indices) {
+    glDrawElements(mode, count, type, indices);
+    GlCallCounter::Record(GlCall::Draw);
+}
+
+inline void DrawElementsInstanced(GLenum mode, GLsizei count, GLenum type, const void* indices, GLsizei instances) {
+    glDrawElementsInstanced(mode, count, type, indices, instances);
+    GlCallCounter::Record(GlCall::Draw);
+}
+
+inline void DrawElementsBaseVertex(GLenum mode, GLsizei count, GLenum type, const void* indices, GLint baseVertex) {
+    glDrawElementsBaseVertex(mode, count, type, indices, baseVertex);
+    GlCallCounter::Record(GlCall::Draw);
+}
+
+inline void MultiDrawElementsIndirect(GLenum mode, GLenum type, const void* indirect, GLsizei drawCount, GLsizei stride) {
+    glMultiDrawElementsIndirect(mode, type, indirect, drawCount, stride);
+    GlCallCounter::Record(GlCall::Draw);
+}
+
+// GlCall::Other
+inline void ClearColor(GLfloat red, GLfloat green, GLfloat blue, GLfloat alpha) {
+    glClearColor(red, green, blue, alpha);
+    GlCallCounter::Record(GlCall::Other);
+}
+
+inline void Clear(GLbitfield mask) {
+    glClear(mask);
+    GlCallCounter::Record(GlCall::Other);
+}
+
+inline void Viewport(GLint x, GLint y, GLsizei width, GLsizei height) {
+    glViewport(x, y, width, height);
+    GlCallCounter::Record(GlCall::Other);
+}
+
+inline void Enable(GLenum capability) {
+    glEnable(capability);
+    GlCallCounter::Record(GlCall::Other);
+}
+
+inline void Disable(GLenum capability) {
+    glDisable(capability);
+    GlCallCounter::Record(GlCall::Other);
+}
+
+inline void BlendFuncSeparate(GLenum srcRgb, GLenum dstRgb, GLenum srcAlpha, GLenum dstAlpha) {
+    glBlendFuncSeparate(srcRgb, dstRgb, srcAlpha, dstAlpha);
+    GlCallCounter::Record(GlCall::Other);
+}
+
+inline void EnableVertexAttribArray(GLuint index) {
+    glEnableVertexAttribArray(index);
+    GlCallCounter::Record(GlCall::Other);
+}
+
+inline void VertexAttribPointer(GLuint index, GLint size, GLenum type, GLboolean normalized, GLsizei stride,
+                                const void* pointer) {
+    glVertexAttribPointer(index, size, type, normalized, stride, pointer);
+    GlCallCounter::Record(GlCall::Other);
+}
+
+inline void VertexAttribDivisor(GLuint index, GLuint divisor) {
+    glVertexAttribDivisor(index, divisor);
+    GlCallCounter::Record(GlCall::Other);
+}
+
+inline void VertexAttribI2ui(GLuint index, GLuint x, GLuint y) {
+    glVertexAttribI2ui(index, x, y);
+    GlCallCounter::Record(GlCall::Other);
+}
+
+inline GLsync FenceSync(GLenum condition, GLbitfield flags) {
+    GLsync fence = glFenceSync(condition, flags);
+    GlCallCounter::Record(GlCall::Other);
+    return fence;
+}
+
+inline GLenum ClientWaitSync(GLsync fence, GLbitfield flags, GLuint64 timeout) {
+    const GLenum status = glClientWaitSync(fence, flags, timeout);
+    GlCallCounter::Record(GlCall::Other);
+    return status;
+}
+
+inline void DeleteSync(GLsync fence) {
+    glDeleteSync(fence);
+    GlCallCounter::Record(GlCall::Other);
+}
+
+inline void BeginQuery(GLenum target, GLuint query) {
+    glBeginQuery(target, query);
+    GlCallCounter::Record(GlCall::Other);
+}
+
+inline void EndQuery(GLenum target) {
+    glEndQuery(target);
+    GlCallCounter::Record(GlCall::Other);
+}
+
+inline void GetQueryObjectiv(GLuint query, GLenum name, GLint* value) {
+    glGetQueryObjectiv(query, name, value);
+    GlCallCounter::Record(GlCall::Other);
+}
+
+inline void GetQueryObjectui64v(GLuint query, GLenum name, GLuint64* value) {
+    glGetQueryObjectui64v(query, name, value);
+    GlCallCounter::Record(GlCall::Other);
+}
+
+} // namespace gl
@@ -0,0 +1,82 @@
+#include "GpuTimer.hpp"
+
+#include "GlCalls.hpp"
+
+#include <algorithm>
+
+GpuTimer::~GpuTimer() {
+    Destroy();
+}
+
+void GpuTimer::Create(std::size_t queryCount) {
+    Destroy();
+    queries_.resize(std::max<std::size_t>(queryCount, 1));
+    for (Query& query : queries_) {
+        glGenQueries(1, &query.id);
+    }
+}
+
+bool GpuTimer::Begin(uint64_t tag, bool wait) {
+    if (queries_.empty() || open_) {
+        return false;
+    }
+    Query& query = queries_[next_];
+    if (query.pending && !Read(query, wait)) {
+        return false;
+    }
+    query.tag = tag;
+    gl::BeginQuery(GL_TIME_ELAPSED, query.id);
+    open_ = true;
+    return true;
+}
+
+void GpuTimer::End() {
+    if (!open_) {
+        return;
+    }
+    gl::EndQuery(GL_TIME_ELAPSED);
+    queries_[next_].pending = true;
+    next_ = (next_ + 1) % queries_.size();
+    open_ = false;
+}
+
+void GpuTimer::Collect(std::vector<GpuTiming>& out, bool wait) {
+    // The GPU finishes queries in submission order, so stop at the first
+    // one still running.
+    for (std::size_t i = 0; i < queries_.size(); ++i) {
+        Query& query = queries_[(next_ + i) % queries_.size()];
+        if (query.pending && !Read(query, wait)) {
+            break;
+        }
+    }
+    out.insert(out.end(), finished_.begin(), finished_.end());
+    finished_.clear();
+}
+
+void GpuTimer::Destroy() {
+    if (open_) {
+        glEndQuery(GL_TIME_ELAPSED);
+        open_ = false;
+    }
+    for (Query& query : queries_) {
+        glDeleteQueries(1, &query.id);
+    }
+    queries_.clear();
+    finished_.clear();
+    next_ = 0;
+}
+
+bool GpuTimer::Read(Query& query, bool wait) {
+    if (!wait) {
+        GLint available = GL_FALSE;
+        gl::GetQueryObjectiv(query.id, GL_QUERY_RESULT_AVAILABLE, &available);
+        if (!available) {
+            return false;
+        }
+    }
+    GLuint64 nanoseconds = 0;
+    gl::GetQueryObjectui64v(query.id, GL_QUERY_RESULT, &nanoseconds);
+    finished_.push_back(GpuTiming{query.tag, static_cast<double>(nanoseconds) / 1.0e6});
+    query.pending = false;
+    return true;
+}
@@ -0,0 +1,48 @@
+#pragma once
+
+#include <GL/glew.h>
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+struct GpuTiming {
+    uint64_t tag = 0; // as given to Begin()
+    double ms = 0.0;
+};
+
+// GPU time of spans of commands, measured with GL_TIME_ELAPSED queries.
+// Results are read back a few spans later so the CPU does not wait for
+// the GPU. Timer queries do not nest: only one span may be open at a time.
+class GpuTimer {
+public:
+    GpuTimer() = default;
+    ~GpuTimer();
+
+    GpuTimer(const GpuTimer&) = delete;
+    GpuTimer& operator=(const GpuTimer&) = delete;
+
+    // Up to queryCount spans may be in flight. Beyond that, Begin() waits
+    // for the oldest or, without wait, skips the span and returns false.
+    void Create(std::size_t queryCount = 4);
+    bool Begin(uint64_t tag, bool wait = true);
+    void End();
+    // Appends the spans the GPU has finished, oldest first; with wait, every
+    // ended span.
+    void Collect(std::vector<GpuTiming>& out, bool wait = false);
+    void Destroy();
+
+private:
+    struct Query {
+        GLuint id = 0;
+        uint64_t tag = 0;
+        bool pending = false;
+    };
+
+    std::vector<Query> queries_;
+    std::size_t next_ = 0; // also the oldest once the ring is full
+    bool open_ = false;
+    std::vector<GpuTiming> finished_;
+
+    bool Read(Query& query, bool wait);
+};
@@ -0,0 +1,116 @@
+#include "HeadlessContext.hpp"
+
+#if CG_TP_2_HAVE_EGL
+#include <EGL/egl.h>
+#include <EGL/eglext.h>
+#endif
+
+#include <utility>
+
+namespace {
+
+bool Fail(std::string* error, std::string message) {
+    if (error) {
+        *error = std::move(message);
+    }
+    return false;
+}
+
+} // namespace
+
+HeadlessContext::~HeadlessContext() {
+    Destroy();
+}
+
+#if CG_TP_2_HAVE_EGL
+
+namespace {
+
+EGLDisplay OpenDisplay() {
+    // Surfaceless needs neither X11/Wayland nor a DRM device.
+    const char* extensions = eglQueryString(EGL_NO_DISPLAY, EGL_EXTENSIONS);
+    const std::string clientExtensions = extensions ? extensions : "";
+    auto getPlatformDisplay =
+        reinterpret_cast<PFNEGLGETPLATFORMDISPLAYEXTPROC>(eglGetProcAddress("eglGetPlatformDisplayEXT"));
+    if (getPlatformDisplay && clientExtensions.find("EGL_MESA_platform_surfaceless") != std::string::npos) {
+        EGLDisplay display = getPlatformDisplay(EGL_PLATFORM_SURFACELESS_MESA, EGL_DEFAULT_DISPLAY, nullptr);
+        if (display != EGL_NO_DISPLAY && eglInitialize(display, nullptr, nullptr)) {
+            return display;
+        }
+    }
+    EGLDisplay display = eglGetDisplay(EGL_DEFAULT_DISPLAY);
+    if (display != EGL_NO_DISPLAY && eglInitialize(display, nullptr, nullptr)) {
+        return display;
+    }
+    return EGL_NO_DISPLAY;
+}
+
+} // namespace
+
+bool HeadlessContext::Create(int majorVersion, int minorVersion, std::string* error) {
+    Destroy();
+    EGLDisplay display = OpenDisplay();
+    if (display == EGL_NO_DISPLAY) {
+        return Fail(error, "Unable to initialize an EGL display.");
+    }
+    display_ = display;
+
+    const char* extensions = eglQueryString(display, EGL_EXTENSIONS);
+    if (!extensions || std::string(extensions).find("EGL_KHR_surfaceless_context") == std::string::npos) {
+        Destroy();
+        return Fail(error, "The EGL display does not support surfaceless contexts.");
+    }
+    if (!eglBindAPI(EGL_OPENGL_API)) {
+        Destroy();
+        return Fail(error, "The EGL display does not support desktop OpenGL.");
+    }
+
+    const EGLint configAttributes[] = {EGL_RENDERABLE_TYPE, EGL_OPENGL_BIT, EGL_NONE};
+    EGLConfig config = nullptr;
+    EGLint configCount = 0;
+    // Without EGL_KHR_no_config_context a config is still needed, though
+    // nothing is ever drawn to its surfaces.
+    eglChooseConfig(display, configAttributes, &config, 1, &configCount);
+
+    const EGLint contextAttributes[] = {
+        EGL_CONTEXT_MAJOR_VERSION, majorVersion,
+        EGL_CONTEXT_MINOR_VERSION, minorVersion,
+        EGL_CONTEXT_OPENGL_PROFILE_MASK, EGL_CONTEXT_OPENGL_CORE_PROFILE_BIT,
+        EGL_NONE,
+    };
+    EGLContext context = eglCreateContext(display, configCount > 0 ? config : nullptr, EGL_NO_CONTEXT, contextAttributes);
+    if (context == EGL_NO_CONTEXT) {
+        Destroy();
+        return Fail(error, "Unable to create an OpenGL " + std::to_string(majorVersion) + "." +
+                               std::to_string(minorVersion) + " core context through EGL.");
+    }
+    context_ = context;
+    if (!eglMakeCurrent(display, EGL_NO_SURFACE, EGL_NO_SURFACE, context)) {
+        Destroy();
+        return Fail(error, "Unable to make the EGL context current.");
+    }
+    return true;
+}
+
+void HeadlessContext::Destroy() {
+    if (display_) {
+        eglMakeCurrent(display_, EGL_NO_SURFACE, EGL_NO_SURFACE, EGL_NO_CONTEXT);
+        if (context_) {
+            eglDestroyContext(display_, context_);
+        }
+        eglTerminate(display_);
+    }
+    display_ = nullptr;
+    context_ = nullptr;
+}
+
+#else
+
+bool HeadlessContext::Create(int, int, std::string* error) {
+    return Fail(error, "Headless rendering needs EGL, which this build was configured without.");
+}
+
+void HeadlessContext::Destroy() {
+}
+
+#endif
@@ -0,0 +1,27 @@
+#pragma once
+
+#include <string>
+
+// A desktop OpenGL core context without a window or display server, made
+// current on the calling thread. Uses EGL on Mesa's surfaceless platform
+// (llvmpipe works without a GPU) or, failing that, the default EGL display.
+// There is no default framebuffer, so draws go to an OffscreenTarget.
+class HeadlessContext {
+public:
+    HeadlessContext() = default;
+    ~HeadlessContext();
+
+    HeadlessContext(const HeadlessContext&) = delete;
+    HeadlessContext& operator=(const HeadlessContext&) = delete;
+
+    // False when the build has no EGL (CG_TP_2_HAVE_EGL) or no driver
+    // offers the requested version.
+    bool Create(int majorVersion, int minorVersion, std::string* error = nullptr);
+    void Destroy();
+
+    bool Valid() const { return context_ != nullptr; }
+
+private:
+    void* display_ = nullptr; // EGLDisplay
+    void* context_ = nullptr; // EGLContext
+};
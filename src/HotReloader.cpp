@@ -0,0 +1,185 @@
+#include "HotReloader.hpp"
+
+#include <algorithm>
+#include <sstream>
+#include <utility>
+
+namespace {
+
+double MillisecondsSince(std::chrono::steady_clock::time_point start) {
+    return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+}
+
+std::filesystem::path Normalized(const std::filesystem::path& path) {
+    return std::filesystem::absolute(path).lexically_normal();
+}
+
+} // namespace
+
+HotReloader::HotReloader() : pool_(1) {
+}
+
+HotReloader::~HotReloader() {
+    for (const auto& watched : models_) {
+        if (watched->pending.valid()) {
+            watched->pending.wait();
+        }
+    }
+}
+
+void HotReloader::WatchShaders(ShaderVariants& shaders) {
+    watcher_.Watch(shaders.VertexPath());
+    watcher_.Watch(shaders.FragmentPath());
+    WatchedShaders watched;
+    watched.shaders = &shaders;
+    watched.errorsSeen = shaders.Errors().size();
+    shaders_.push_back(watched);
+}
+
+void HotReloader::WatchTextures(gfx::TextureService& textures) {
+    textures_ = &textures;
+    texturesSeen_ = textures.Timings().size();
+    WatchTextureSources();
+}
+
+void HotReloader::WatchModel(Model& model,
+                             const std::filesystem::path& objPath,
+                             const ModelLoadOptions& options,
+                             ShaderVariants* shaders) {
+    auto watched = std::make_unique<WatchedModel>();
+    watched->model = &model;
+    watched->objPath = objPath;
+    watched->options = options;
+    watched->shaders = shaders;
+    for (const std::filesystem::path& source : model.Sources()) {
+        watcher_.Watch(source);
+    }
+    models_.push_back(std::move(watched));
+}
+
+void HotReloader::WatchTextureSources() {
+    if (textures_) {
+        for (const std::filesystem::path& source : textures_->Sources()) {
+            watcher_.Watch(source);
+        }
+    }
+}
+
+void HotReloader::Pump() {
+    for (const std::filesystem::path& changed : watcher_.Poll()) {
+        for (WatchedShaders& watched : shaders_) {
+            if (Normalized(watched.shaders->VertexPath()) == changed ||
+                Normalized(watched.shaders->FragmentPath()) == changed) {
+                watched.shaders->Reload();
+                watched.reloading = true;
+                watched.failed = false;
+                watched.started = Clock::now();
+                messages_.push_back("Reloading shaders after " + changed.filename().string() + " changed");
+            }
+        }
+        if (textures_) {
+            for (const std::filesystem::path& source : textures_->Sources()) {
+                if (Normalized(source) == changed && textures_->Reload(source) > 0) {
+                    reloadingTextures_.insert(changed);
+                }
+            }
+        }
+        for (const auto& watched : models_) {
+            const auto& sources = watched->model->Sources();
+            const bool affected = std::any_of(sources.begin(), sources.end(), [&](const std::filesystem::path& source) {
+                return Normalized(source) == changed;
+            });
+            if (!affected) {
+                continue;
+            }
+            if (watched->pending.valid()) {
+                watched->dirty = true;
+            } else {
+                StartModelReload(*watched);
+            }
+        }
+    }
+
+    for (WatchedShaders& watched : shaders_) {
+        const std::vector<std::string>& errors = watched.shaders->Errors();
+        for (; watched.errorsSeen < errors.size(); ++watched.errorsSeen) {
+            messages_.push_back(errors[watched.errorsSeen]);
+            watched.failed = watched.failed || watched.reloading;
+        }
+        if (watched.reloading && watched.shaders->ReloadPendingCount() == 0 && watched.shaders->PendingCount() == 0) {
+            watched.reloading = false;
+            std::ostringstream message;
+            message << (watched.failed ? "Shader reload failed, keeping the previous programs" : "Shaders reloaded")
+                    << " (" << MillisecondsSince(watched.started) << " ms)";
+            messages_.push_back(message.str());
+        }
+    }
+
+    if (textures_) {
+        const std::vector<gfx::TextureLoadTiming>& timings = textures_->Timings();
+        for (; texturesSeen_ < timings.size(); ++texturesSeen_) {
+            const gfx::TextureLoadTiming& timing = timings[texturesSeen_];
+            if (reloadingTextures_.erase(Normalized(timing.path)) == 0) {
+                continue;
+            }
+            std::ostringstream message;
+            if (timing.failed) {
+                message << "Reloading " << timing.path.filename().string() << " failed: " << timing.error;
+            } else {
+                message << "Reloaded " << timing.path.filename().string() << ": decode " << timing.decodeMs
+                        << " ms, upload " << timing.uploadMs << " ms";
+            }
+            messages_.push_back(message.str());
+        }
+    }
+
+    for (const auto& watched : models_) {
+        if (watched->pending.valid() &&
+            watched->pending.wait_for(std::chrono::seconds(0)) == std::future_status::ready) {
+            FinishModelReload(*watched);
+        }
+    }
+}
+
+void HotReloader::StartModelReload(WatchedModel& watched) {
+    watched.started = Clock::now();
+    watched.dirty = false;
+    watched.pending = pool_.Submit([objPath = watched.objPath, options = watched.options]() {
+        PreparedResult result;
+        const auto start = std::chrono::steady_clock::now();
+        result.ok = Model::PrepareMesh(objPath, options, result.mesh, &result.error);
+        result.prepareMs = MillisecondsSince(start);
+        return result;
+    });
+}
+
+void HotReloader::FinishModelReload(WatchedModel& watched) {
+    PreparedResult result = watched.pending.get();
+    const std::string name = watched.objPath.filename().string();
+    std::string error = std::move(result.error);
+    if (result.ok && watched.model->LoadPrepared(result.mesh, watched.options, &error)) {
+        if (watched.shaders) {
+            watched.model->RequestShaderVariants(*watched.shaders);
+        }
+        // The edit may have added an MTL file or a texture.
+        for (const std::filesystem::path& source : watched.model->Sources()) {
+            watcher_.Watch(source);
+        }
+        WatchTextureSources();
+
+        std::ostringstream message;
+        message << "Reloaded " << name << " in " << MillisecondsSince(watched.started) << " ms [prepare "
+                << result.prepareMs << " ms on a worker, upload " << watched.model->LoadStats().uploadMs << " ms]";
+        messages_.push_back(message.str());
+    } else {
+        messages_.push_back("Reloading " + name + " failed, keeping the previous mesh: " + error);
+    }
+
+    if (watched.dirty) {
+        StartModelReload(watched);
+    }
+}
+
+std::vector<std::string> HotReloader::TakeMessages() {
+    return std::exchange(messages_, {});
+}
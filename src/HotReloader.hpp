@@ -0,0 +1,89 @@
+#pragma once
+
+#include "FileWatcher.hpp"
+#include "Model.hpp"
+#include "ShaderVariants.hpp"
+#include "TextureService.hpp"
+#include "ThreadPool.hpp"
+
+#include <chrono>
+#include <filesystem>
+#include <future>
+#include <memory>
+#include <set>
+#include <string>
+#include <vector>
+
+// Watches the files behind shaders, textures and models and rebuilds only
+// what changed, off the GL thread where it can: models are parsed on a
+// worker, textures decode in their TextureService and shaders compile on
+// driver threads when GL_KHR_parallel_shader_compile is available. Pump()
+// swaps finished results in between frames; until then the old resources
+// keep drawing. Everything registered must outlive the reloader.
+class HotReloader {
+public:
+    HotReloader();
+    ~HotReloader();
+
+    HotReloader(const HotReloader&) = delete;
+    HotReloader& operator=(const HotReloader&) = delete;
+
+    void WatchShaders(ShaderVariants& shaders);
+    // Watches every texture the service has loaded, including ones
+    // requested by later model reloads.
+    void WatchTextures(gfx::TextureService& textures);
+    // `shaders`, when given, receives the variants a reloaded model needs.
+    void WatchModel(Model& model,
+                    const std::filesystem::path& objPath,
+                    const ModelLoadOptions& options,
+                    ShaderVariants* shaders = nullptr);
+
+    // Call once per frame on the GL thread, before drawing.
+    void Pump();
+
+    // Log lines produced since the last call, including shader build errors.
+    std::vector<std::string> TakeMessages();
+
+    bool UsesInotify() const { return watcher_.UsesInotify(); }
+
+private:
+    using Clock = std::chrono::steady_clock;
+
+    struct PreparedResult {
+        PreparedMesh mesh;
+        bool ok = false;
+        std::string error;
+        double prepareMs = 0.0;
+    };
+
+    struct WatchedShaders {
+        ShaderVariants* shaders = nullptr;
+        bool reloading = false;
+        bool failed = false;
+        std::size_t errorsSeen = 0;
+        Clock::time_point started;
+    };
+
+    struct WatchedModel {
+        Model* model = nullptr;
+        std::filesystem::path objPath;
+        ModelLoadOptions options;
+        ShaderVariants* shaders = nullptr;
+        std::future<PreparedResult> pending;
+        bool dirty = false; // changed again while a reload was running
+        Clock::time_point started;
+    };
+
+    FileWatcher watcher_;
+    ThreadPool pool_;
+    std::vector<WatchedShaders> shaders_;
+    gfx::TextureService* textures_ = nullptr;
+    std::size_t texturesSeen_ = 0; // TextureService::Timings() already looked at
+    std::set<std::filesystem::path> reloadingTextures_;
+    std::vector<std::unique_ptr<WatchedModel>> models_;
+    std::vector<std::string> messages_;
+
+    void WatchTextureSources();
+    void StartModelReload(WatchedModel& watched);
+    void FinishModelReload(WatchedModel& watched);
+};
@@ -0,0 +1,67 @@
+#include "InstanceBuffer.hpp"
+
+#include "GlCalls.hpp"
+
+#include <algorithm>
+#include <cstddef>
+
+InstanceBuffer::~InstanceBuffer() {
+    Destroy();
+}
+
+void InstanceBuffer::Update(std::span<const InstanceTransform> instances) {
+    if (buffer_ == 0) {
+        glGenBuffers(1, &buffer_);
+    }
+    const GLsizeiptr size = static_cast<GLsizeiptr>(instances.size_bytes());
+    gl::BindBuffer(GL_ARRAY_BUFFER, buffer_);
+    if (size > capacity_) {
+        capacity_ = std::max(size, capacity_ * 2);
+    }
+    gl::BufferData(GL_ARRAY_BUFFER, capacity_, nullptr, GL_STREAM_DRAW);
+    if (size > 0) {
+        gl::BufferSubData(GL_ARRAY_BUFFER, 0, size, instances.data());
+    }
+    gl::BindBuffer(GL_ARRAY_BUFFER, 0);
+    source_ = buffer_;
+    offset_ = 0;
+    count_ = static_cast<GLsizei>(instances.size());
+}
+
+void InstanceBuffer::Stream(const StreamBuffer& stream, const StreamAllocation& allocation, GLsizei count) {
+    source_ = stream.Handle();
+    offset_ = allocation.offset;
+    count_ = count;
+}
+
+void InstanceBuffer::BindAttributes() const {
+    constexpr GLsizei stride = sizeof(InstanceTransform);
+    gl::BindBuffer(GL_ARRAY_BUFFER, source_);
+    // Matrices take one attribute location per column.
+    for (GLuint column = 0; column < 4; ++column) {
+        const GLuint location = kInstanceModelAttribute + column;
+        const std::size_t offset = offset_ + offsetof(InstanceTransform, model) + column * sizeof(glm::vec4);
+        gl::EnableVertexAttribArray(location);
+        gl::VertexAttribPointer(location, 4, GL_FLOAT, GL_FALSE, stride, reinterpret_cast<const void*>(offset));
+        gl::VertexAttribDivisor(location, 1);
+    }
+    for (GLuint column = 0; column < 3; ++column) {
+        const GLuint location = kInstanceNormalAttribute + column;
+        const std::size_t offset = offset_ + offsetof(InstanceTransform, normal) + column * sizeof(glm::vec3);
+        gl::EnableVertexAttribArray(location);
+        gl::VertexAttribPointer(location, 3, GL_FLOAT, GL_FALSE, stride, reinterpret_cast<const void*>(offset));
+        gl::VertexAttribDivisor(location, 1);
+    }
+    gl::BindBuffer(GL_ARRAY_BUFFER, 0);
+}
+
+void InstanceBuffer::Destroy() {
+    if (buffer_ != 0) {
+        glDeleteBuffers(1, &buffer_);
+        buffer_ = 0;
+        capacity_ = 0;
+    }
+    source_ = 0;
+    offset_ = 0;
+    count_ = 0;
+}
@@ -0,0 +1,44 @@
+#pragma once
+
+#include "InstanceTransform.hpp"
+#include "StreamBuffer.hpp"
+
+#include <GL/glew.h>
+
+#include <span>
+
+constexpr GLuint kInstanceModelAttribute = 4;
+constexpr GLuint kInstanceNormalAttribute = 8;
+
+// The vertex buffer Model::DrawInstanced() reads per-instance transforms
+// from: its own, rewritten every frame, or a StreamBuffer allocation.
+class InstanceBuffer {
+public:
+    InstanceBuffer() = default;
+    ~InstanceBuffer();
+
+    InstanceBuffer(const InstanceBuffer&) = delete;
+    InstanceBuffer& operator=(const InstanceBuffer&) = delete;
+
+    // Replaces the contents. The storage is orphaned first so the driver
+    // never stalls on a frame that still reads the old transforms, and
+    // grows by doubling.
+    void Update(std::span<const InstanceTransform> instances);
+    // Reads `count` transforms written into `allocation` instead; the own
+    // buffer is kept for the next Update().
+    void Stream(const StreamBuffer& stream, const StreamAllocation& allocation, GLsizei count);
+    // Points the instance attributes of the bound vertex array at this buffer.
+    void BindAttributes() const;
+    void Destroy();
+
+    GLuint Handle() const { return source_; }
+    GLintptr Offset() const { return offset_; }
+    GLsizei Count() const { return count_; }
+
+private:
+    GLuint buffer_ = 0;
+    GLsizeiptr capacity_ = 0; // bytes
+    GLuint source_ = 0;       // buffer_ or the stream's
+    GLintptr offset_ = 0;
+    GLsizei count_ = 0;
+};
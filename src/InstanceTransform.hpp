@@ -0,0 +1,30 @@
+#pragma once
+
+#include <glm/glm.hpp>
+
+// Per-instance attributes of object.vert built with INSTANCED: the model
+// matrix in locations 4-7 and the normal matrix in 8-10.
+struct InstanceTransform {
+    glm::mat4 model{1.0f};
+    glm::mat3 normal{1.0f};
+};
+static_assert(sizeof(InstanceTransform) == 100, "InstanceTransform is read as tightly packed vertex attributes");
+
+// The inverse-transpose of the upper 3x3. A rotation times a uniform scale
+// s needs no inverse: the result is the matrix itself over s squared.
+inline glm::mat3 NormalMatrix(const glm::mat4& model, bool uniformScale = false) {
+    const glm::mat3 linear(model);
+    if (uniformScale) {
+        return linear * (1.0f / glm::dot(linear[0], linear[0]));
+    }
+    return glm::transpose(glm::inverse(linear));
+}
+
+// The model matrix with its normal matrix; pass uniformScale when the model
+// matrix is known to have no non-uniform scale.
+inline InstanceTransform MakeInstanceTransform(const glm::mat4& model, bool uniformScale = false) {
+    InstanceTransform instance;
+    instance.model = model;
+    instance.normal = NormalMatrix(model, uniformScale);
+    return instance;
+}
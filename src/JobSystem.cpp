@@ -0,0 +1,187 @@
+#include "JobSystem.hpp"
+
+#include <algorithm>
+
+namespace {
+
+// The deque of the current thread, when it is a worker.
+thread_local const JobSystem* currentSystem = nullptr;
+thread_local std::size_t currentQueue = 0;
+
+} // namespace
+
+JobSystem::JobSystem(unsigned threadCount) {
+    if (threadCount == 0) {
+        threadCount = std::max(1u, std::thread::hardware_concurrency());
+    }
+    queues_.reserve(threadCount);
+    for (unsigned i = 0; i < threadCount; ++i) {
+        queues_.push_back(std::make_unique<Queue>());
+    }
+    workers_.reserve(threadCount - 1);
+    for (std::size_t i = 1; i < threadCount; ++i) {
+        workers_.emplace_back([this, i]() { WorkerLoop(i); });
+    }
+}
+
+JobSystem::~JobSystem() {
+    {
+        std::lock_guard<std::mutex> lock(sleepMutex_);
+        stopping_ = true;
+    }
+    wake_.notify_all();
+    for (std::thread& worker : workers_) {
+        worker.join();
+    }
+}
+
+void JobSystem::Run(std::function<void()> fn, JobCounter* signal) {
+    if (signal) {
+        signal->pending_.fetch_add(1, std::memory_order_relaxed);
+    }
+    Push(Job{std::move(fn), signal});
+}
+
+void JobSystem::RunAfter(JobCounter& dependency, std::function<void()> fn, JobCounter* signal) {
+    if (signal) {
+        signal->pending_.fetch_add(1, std::memory_order_relaxed);
+    }
+    Job job{std::move(fn), signal};
+    {
+        // Finish() drops the count and takes the waiting list under this
+        // lock, so a job is either parked before that or sees zero here.
+        std::lock_guard<std::mutex> lock(dependency.mutex_);
+        if (!dependency.Done()) {
+            dependency.waiting_.push_back(std::move(job));
+            return;
+        }
+    }
+    Push(std::move(job));
+}
+
+void JobSystem::ParallelFor(std::size_t count, std::size_t grain, std::function<void(std::size_t, std::size_t)> body,
+                            JobCounter& signal) {
+    grain = std::max<std::size_t>(grain, 1);
+    auto shared = std::make_shared<std::function<void(std::size_t, std::size_t)>>(std::move(body));
+    for (std::size_t begin = 0; begin < count; begin += grain) {
+        const std::size_t end = std::min(begin + grain, count);
+        Run([shared, begin, end]() { (*shared)(begin, end); }, &signal);
+    }
+}
+
+void JobSystem::Wait(JobCounter& counter) {
+    const std::size_t self = CurrentQueue();
+    Job job;
+    while (!counter.Done()) {
+        if (TryTake(self, job)) {
+            Execute(job);
+        } else {
+            // The rest is running elsewhere.
+            std::this_thread::yield();
+        }
+    }
+    // Lets the job that finished the counter let go of it.
+    std::lock_guard<std::mutex> lock(counter.mutex_);
+}
+
+JobSystemStats JobSystem::Stats() const {
+    JobSystemStats stats;
+    stats.jobs = jobsRun_.load(std::memory_order_relaxed);
+    stats.steals = steals_.load(std::memory_order_relaxed);
+    return stats;
+}
+
+void JobSystem::ResetStats() {
+    jobsRun_.store(0, std::memory_order_relaxed);
+    steals_.store(0, std::memory_order_relaxed);
+}
+
+std::size_t JobSystem::CurrentQueue() const {
+    return currentSystem == this ? currentQueue : 0;
+}
+
+void JobSystem::Push(Job job) {
+    Queue& queue = *queues_[CurrentQueue()];
+    {
+        std::lock_guard<std::mutex> lock(queue.mutex);
+        queue.jobs.push_back(std::move(job));
+    }
+    // Pairs with the sleeping_ increment in WorkerLoop(): either a worker
+    // sees the job before it sleeps or this sees the worker asleep.
+    queued_.fetch_add(1);
+    if (sleeping_.load() > 0) {
+        std::lock_guard<std::mutex> lock(sleepMutex_);
+        wake_.notify_one();
+    }
+}
+
+bool JobSystem::TryTake(std::size_t self, Job& job) {
+    if (queued_.load(std::memory_order_relaxed) == 0) {
+        return false;
+    }
+    {
+        Queue& own = *queues_[self];
+        std::lock_guard<std::mutex> lock(own.mutex);
+        if (!own.jobs.empty()) {
+            job = std::move(own.jobs.back());
+            own.jobs.pop_back();
+            queued_.fetch_sub(1);
+            return true;
+        }
+    }
+    for (std::size_t k = 1; k < queues_.size(); ++k) {
+        Queue& victim = *queues_[(self + k) % queues_.size()];
+        std::lock_guard<std::mutex> lock(victim.mutex);
+        if (!victim.jobs.empty()) {
+            job = std::move(victim.jobs.front());
+            victim.jobs.pop_front();
+            queued_.fetch_sub(1);
+            steals_.fetch_add(1, std::memory_order_relaxed);
+            return true;
+        }
+    }
+    return false;
+}
+
+void JobSystem::Execute(Job& job) {
+    job.fn();
+    jobsRun_.fetch_add(1, std::memory_order_relaxed);
+    if (job.signal) {
+        Finish(*job.signal);
+    }
+    job = Job{};
+}
+
+void JobSystem::Finish(JobCounter& counter) {
+    // Under the lock, so that a Wait() returning on zero, and the owner
+    // freeing the counter, cannot come before this is done with it.
+    std::vector<Job> ready;
+    {
+        std::lock_guard<std::mutex> lock(counter.mutex_);
+        if (counter.pending_.fetch_sub(1, std::memory_order_acq_rel) == 1) {
+            ready.swap(counter.waiting_);
+        }
+    }
+    for (Job& job : ready) {
+        Push(std::move(job));
+    }
+}
+
+void JobSystem::WorkerLoop(std::size_t index) {
+    currentSystem = this;
+    currentQueue = index;
+    Job job;
+    for (;;) {
+        if (TryTake(index, job)) {
+            Execute(job);
+            continue;
+        }
+        std::unique_lock<std::mutex> lock(sleepMutex_);
+        sleeping_.fetch_add(1);
+        wake_.wait(lock, [this]() { return stopping_ || queued_.load() > 0; });
+        sleeping_.fetch_sub(1);
+        if (stopping_ && queued_.load() == 0) {
+            return;
+        }
+    }
+}
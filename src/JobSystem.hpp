@@ -0,0 +1,103 @@
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+class JobCounter;
+
+struct Job {
+    std::function<void()> fn;
+    JobCounter* signal = nullptr; // held up until fn returns
+};
+
+// Counts unfinished jobs. A job started with a counter holds it up until it
+// finishes; a job started after a counter only runs once it reaches zero.
+// Wait() on it before it goes away; reusable after that.
+class JobCounter {
+public:
+    JobCounter() = default;
+
+    JobCounter(const JobCounter&) = delete;
+    JobCounter& operator=(const JobCounter&) = delete;
+
+    bool Done() const { return pending_.load(std::memory_order_acquire) == 0; }
+
+private:
+    friend class JobSystem;
+
+    std::atomic<uint32_t> pending_{0};
+    std::mutex mutex_;
+    std::vector<Job> waiting_; // started after this counter
+};
+
+struct JobSystemStats {
+    std::size_t jobs = 0;   // run since the last ResetStats()
+    std::size_t steals = 0; // of those, taken from another thread's deque
+};
+
+// Work-stealing scheduler for short CPU jobs. Every thread owns a deque:
+// it pushes and pops its own jobs at the back, newest first while they are
+// still in cache, and idle threads steal the oldest from the front of the
+// others. The thread that created the system takes part from deque 0
+// whenever it Wait()s, so threadCount includes it; other threads may start
+// jobs too, into the same deque.
+//
+// Jobs must not block on anything but Wait().
+class JobSystem {
+public:
+    // threadCount == 0 uses std::thread::hardware_concurrency().
+    explicit JobSystem(unsigned threadCount = 0);
+    ~JobSystem();
+
+    JobSystem(const JobSystem&) = delete;
+    JobSystem& operator=(const JobSystem&) = delete;
+
+    void Run(std::function<void()> fn, JobCounter* signal = nullptr);
+    // Queues fn once `dependency` reaches zero, at once if it already has.
+    void RunAfter(JobCounter& dependency, std::function<void()> fn, JobCounter* signal = nullptr);
+    // Runs body(begin, end) over [0, count) in ranges of at most `grain`,
+    // one job each, all holding up `signal`.
+    void ParallelFor(std::size_t count, std::size_t grain, std::function<void(std::size_t, std::size_t)> body,
+                     JobCounter& signal);
+    // Runs queued jobs, stealing if need be, until `counter` reaches zero.
+    void Wait(JobCounter& counter);
+
+    unsigned ThreadCount() const { return static_cast<unsigned>(queues_.size()); }
+
+    JobSystemStats Stats() const;
+    void ResetStats();
+
+private:
+    struct alignas(64) Queue {
+        std::mutex mutex;
+        std::deque<Job> jobs;
+    };
+
+    std::vector<std::unique_ptr<Queue>> queues_; // [0] is the creating thread's
+    std::vector<std::thread> workers_;
+    std::atomic<std::size_t> queued_{0};
+    std::atomic<std::size_t> jobsRun_{0};
+    std::atomic<std::size_t> steals_{0};
+
+    // Idle workers sleep here until a job is pushed.
+    std::mutex sleepMutex_;
+    std::condition_variable wake_;
+    std::atomic<unsigned> sleeping_{0};
+    bool stopping_ = false;
+
+    std::size_t CurrentQueue() const;
+    void Push(Job job);
+    // Pops from the back of deque `self`, else steals from another's front.
+    bool TryTake(std::size_t self, Job& job);
+    void Execute(Job& job);
+    void Finish(JobCounter& counter);
+    void WorkerLoop(std::size_t index);
+};
@@ -0,0 +1,172 @@
+#include "MappedFile.hpp"
+
+#ifdef _WIN32
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+MappedFile::~MappedFile() {
+    Close();
+}
+
+MappedFile::MappedFile(MappedFile&& other) noexcept {
+    MoveFrom(other);
+}
+
+MappedFile& MappedFile::operator=(MappedFile&& other) noexcept {
+    if (this != &other) {
+        Close();
+        MoveFrom(other);
+    }
+    return *this;
+}
+
+void MappedFile::MoveFrom(MappedFile& other) noexcept {
+    data_ = other.data_;
+    size_ = other.size_;
+    isEmptyFile_ = other.isEmptyFile_;
+    other.data_ = nullptr;
+    other.size_ = 0;
+    other.isEmptyFile_ = false;
+#ifdef _WIN32
+    fileHandle_ = other.fileHandle_;
+    mappingHandle_ = other.mappingHandle_;
+    other.fileHandle_ = nullptr;
+    other.mappingHandle_ = nullptr;
+#endif
+}
+
+#ifdef _WIN32
+
+bool MappedFile::Open(const std::filesystem::path& path, std::string* error) {
+    Close();
+
+    HANDLE file = CreateFileW(path.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING,
+                              FILE_ATTRIBUTE_NORMAL | FILE_FLAG_SEQUENTIAL_SCAN, nullptr);
+    if (file == INVALID_HANDLE_VALUE) {
+        if (error) {
+            *error = "Unable to open file: " + path.string();
+        }
+        return false;
+    }
+
+    LARGE_INTEGER fileSize{};
+    if (!GetFileSizeEx(file, &fileSize)) {
+        CloseHandle(file);
+        if (error) {
+            *error = "Unable to query file size: " + path.string();
+        }
+        return false;
+    }
+
+    if (fileSize.QuadPart == 0) {
+        CloseHandle(file);
+        isEmptyFile_ = true;
+        return true;
+    }
+
+    HANDLE mapping = CreateFileMappingW(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+    if (!mapping) {
+        CloseHandle(file);
+        if (error) {
+            *error = "Unable to map file: " + path.string();
+        }
+        return false;
+    }
+
+    void* view = MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0);
+    if (!view) {
+        CloseHandle(mapping);
+        CloseHandle(file);
+        if (error) {
+            *error = "Unable to map file view: " + path.string();
+        }
+        return false;
+    }
+
+    fileHandle_ = file;
+    mappingHandle_ = mapping;
+    data_ = static_cast<const char*>(view);
+    size_ = static_cast<std::size_t>(fileSize.QuadPart);
+    return true;
+}
+
+void MappedFile::Close() {
+    if (data_) {
+        UnmapViewOfFile(data_);
+    }
+    if (mappingHandle_) {
+        CloseHandle(mappingHandle_);
+    }
+    if (fileHandle_) {
+        CloseHandle(fileHandle_);
+    }
+    data_ = nullptr;
+    size_ = 0;
+    isEmptyFile_ = false;
+    fileHandle_ = nullptr;
+    mappingHandle_ = nullptr;
+}
+
+#else
+
+bool MappedFile::Open(const std::filesystem::path& path, std::string* error) {
+    Close();
+
+    int fd = ::open(path.c_str(), O_RDONLY);
+    if (fd < 0) {
+        if (error) {
+            *error = "Unable to open file: " + path.string();
+        }
+        return false;
+    }
+
+    struct stat info {};
+    if (::fstat(fd, &info) != 0) {
+        ::close(fd);
+        if (error) {
+            *error = "Unable to query file size: " + path.string();
+        }
+        return false;
+    }
+
+    if (info.st_size == 0) {
+        ::close(fd);
+        isEmptyFile_ = true;
+        return true;
+    }
+
+    std::size_t length = static_cast<std::size_t>(info.st_size);
+    void* mapping = ::mmap(nullptr, length, PROT_READ, MAP_PRIVATE, fd, 0);
+    // The mapping keeps its own reference to the file.
+    ::close(fd);
+    if (mapping == MAP_FAILED) {
+        if (error) {
+            *error = "Unable to map file: " + path.string();
+        }
+        return false;
+    }
+    ::madvise(mapping, length, MADV_SEQUENTIAL);
+
+    data_ = static_cast<const char*>(mapping);
+    size_ = length;
+    return true;
+}
+
+void MappedFile::Close() {
+    if (data_) {
+        ::munmap(const_cast<char*>(data_), size_);
+    }
+    data_ = nullptr;
+    size_ = 0;
+    isEmptyFile_ = false;
+}
+
+#endif
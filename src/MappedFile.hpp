@@ -0,0 +1,38 @@
+#pragma once
+
+#include <cstddef>
+#include <filesystem>
+#include <string>
+#include <string_view>
+
+// Read-only memory mapping of a whole file.
+class MappedFile {
+public:
+    MappedFile() = default;
+    ~MappedFile();
+
+    MappedFile(const MappedFile&) = delete;
+    MappedFile& operator=(const MappedFile&) = delete;
+
+    MappedFile(MappedFile&& other) noexcept;
+    MappedFile& operator=(MappedFile&& other) noexcept;
+
+    bool Open(const std::filesystem::path& path, std::string* error = nullptr);
+    void Close();
+
+    const char* Data() const { return data_; }
+    std::size_t Size() const { return size_; }
+    std::string_view View() const { return {data_, size_}; }
+    bool IsOpen() const { return data_ != nullptr || isEmptyFile_; }
+
+private:
+    const char* data_ = nullptr;
+    std::size_t size_ = 0;
+    bool isEmptyFile_ = false;
+#ifdef _WIN32
+    void* fileHandle_ = nullptr;
+    void* mappingHandle_ = nullptr;
+#endif
+
+    void MoveFrom(MappedFile& other) noexcept;
+};
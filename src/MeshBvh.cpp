@@ -0,0 +1,643 @@
+#include "MeshBvh.hpp"
+
+#include "ThreadPool.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <functional>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define MESH_BVH_SSE2 1
+#include <emmintrin.h>
+#endif
+
+namespace {
+
+// Deep enough for a median split of 2^32 triangles below the SAH levels.
+constexpr uint32_t kSahMaxDepth = 64;
+constexpr int kStackSize = 128;
+
+// One float per ray of a packet. The scalar build performs the same IEEE
+// operations, so both report the same hits.
+#if MESH_BVH_SSE2
+struct Mask4 {
+    __m128 v;
+
+    friend Mask4 operator&(Mask4 a, Mask4 b) { return {_mm_and_ps(a.v, b.v)}; }
+    unsigned Bits() const { return static_cast<unsigned>(_mm_movemask_ps(v)); }
+};
+
+struct Float4 {
+    __m128 v;
+
+    static Float4 Splat(float a) { return {_mm_set1_ps(a)}; }
+    static Float4 Set(float a, float b, float c, float d) { return {_mm_setr_ps(a, b, c, d)}; }
+    float Lane(int i) const {
+        alignas(16) float lanes[4];
+        _mm_store_ps(lanes, v);
+        return lanes[i];
+    }
+
+    friend Float4 operator+(Float4 a, Float4 b) { return {_mm_add_ps(a.v, b.v)}; }
+    friend Float4 operator-(Float4 a, Float4 b) { return {_mm_sub_ps(a.v, b.v)}; }
+    friend Float4 operator*(Float4 a, Float4 b) { return {_mm_mul_ps(a.v, b.v)}; }
+    friend Float4 operator/(Float4 a, Float4 b) { return {_mm_div_ps(a.v, b.v)}; }
+    friend Float4 Max(Float4 a, Float4 b) { return {_mm_max_ps(a.v, b.v)}; }
+    friend Float4 Min(Float4 a, Float4 b) { return {_mm_min_ps(a.v, b.v)}; }
+    friend Mask4 operator<=(Float4 a, Float4 b) { return {_mm_cmple_ps(a.v, b.v)}; }
+    friend Float4 Select(Mask4 mask, Float4 a, Float4 b) {
+        return {_mm_or_ps(_mm_and_ps(mask.v, a.v), _mm_andnot_ps(mask.v, b.v))};
+    }
+};
+#else
+struct Mask4 {
+    bool v[4];
+
+    friend Mask4 operator&(Mask4 a, Mask4 b) {
+        return {{a.v[0] && b.v[0], a.v[1] && b.v[1], a.v[2] && b.v[2], a.v[3] && b.v[3]}};
+    }
+    unsigned Bits() const {
+        return (v[0] ? 1u : 0u) | (v[1] ? 2u : 0u) | (v[2] ? 4u : 0u) | (v[3] ? 8u : 0u);
+    }
+};
+
+struct Float4 {
+    float v[4];
+
+    static Float4 Splat(float a) { return {{a, a, a, a}}; }
+    static Float4 Set(float a, float b, float c, float d) { return {{a, b, c, d}}; }
+    float Lane(int i) const { return v[i]; }
+
+    template <typename Op>
+    static Float4 Map(Float4 a, Float4 b, Op op) {
+        return {{op(a.v[0], b.v[0]), op(a.v[1], b.v[1]), op(a.v[2], b.v[2]), op(a.v[3], b.v[3])}};
+    }
+
+    friend Float4 operator+(Float4 a, Float4 b) { return Map(a, b, [](float x, float y) { return x + y; }); }
+    friend Float4 operator-(Float4 a, Float4 b) { return Map(a, b, [](float x, float y) { return x - y; }); }
+    friend Float4 operator*(Float4 a, Float4 b) { return Map(a, b, [](float x, float y) { return x * y; }); }
+    friend Float4 operator/(Float4 a, Float4 b) { return Map(a, b, [](float x, float y) { return x / y; }); }
+    // Same operand order as maxps/minps: the second operand wins ties and NaNs.
+    friend Float4 Max(Float4 a, Float4 b) { return Map(a, b, [](float x, float y) { return x > y ? x : y; }); }
+    friend Float4 Min(Float4 a, Float4 b) { return Map(a, b, [](float x, float y) { return x < y ? x : y; }); }
+    friend Mask4 operator<=(Float4 a, Float4 b) {
+        return {{a.v[0] <= b.v[0], a.v[1] <= b.v[1], a.v[2] <= b.v[2], a.v[3] <= b.v[3]}};
+    }
+    friend Float4 Select(Mask4 mask, Float4 a, Float4 b) {
+        return {{mask.v[0] ? a.v[0] : b.v[0], mask.v[1] ? a.v[1] : b.v[1], mask.v[2] ? a.v[2] : b.v[2],
+                 mask.v[3] ? a.v[3] : b.v[3]}};
+    }
+};
+#endif
+
+// 1/d, with zero components replaced by a huge finite slope so slab tests
+// never compute 0 * inf.
+glm::vec3 SafeInverse(const glm::vec3& d) {
+    auto inverse = [](float x) { return std::abs(x) > 1e-30f ? 1.0f / x : std::copysign(1e30f, x); };
+    return glm::vec3(inverse(d.x), inverse(d.y), inverse(d.z));
+}
+
+float SurfaceArea(const BoundingBox& box) {
+    if (box.Empty()) {
+        return 0.0f;
+    }
+    const glm::vec3 size = box.max - box.min;
+    return 2.0f * (size.x * size.y + size.y * size.z + size.z * size.x);
+}
+
+// Whether the ray enters the box within [tMin, tMax], and where.
+bool SlabTest(const glm::vec3& min,
+              const glm::vec3& max,
+              const glm::vec3& origin,
+              const glm::vec3& inverseDirection,
+              float tMin,
+              float tMax,
+              float& tEntry) {
+    const float t1x = (min.x - origin.x) * inverseDirection.x;
+    const float t2x = (max.x - origin.x) * inverseDirection.x;
+    const float t1y = (min.y - origin.y) * inverseDirection.y;
+    const float t2y = (max.y - origin.y) * inverseDirection.y;
+    const float t1z = (min.z - origin.z) * inverseDirection.z;
+    const float t2z = (max.z - origin.z) * inverseDirection.z;
+    tEntry = std::max(std::max(std::min(t1x, t2x), std::min(t1y, t2y)), std::max(std::min(t1z, t2z), tMin));
+    const float tExit = std::min(std::min(std::max(t1x, t2x), std::max(t1y, t2y)), std::min(std::max(t1z, t2z), tMax));
+    return tEntry <= tExit;
+}
+
+// A triangle during the build; partitioned in place, so each node's
+// triangles stay contiguous.
+struct BuildReference {
+    BoundingBox box;
+    glm::vec3 centroid;
+    uint32_t triangle = 0;
+};
+
+struct Bin {
+    BoundingBox box;
+    BoundingBox centroids;
+    uint32_t count = 0;
+
+    void Add(const BuildReference& reference) {
+        box.Expand(reference.box);
+        centroids.Expand(reference.centroid);
+        ++count;
+    }
+    void Add(const Bin& bin) {
+        box.Expand(bin.box);
+        centroids.Expand(bin.centroids);
+        count += bin.count;
+    }
+};
+
+} // namespace
+
+Ray TransformRay(const Ray& ray, const glm::mat4& transform) {
+    Ray result = ray;
+    result.origin = glm::vec3(transform * glm::vec4(ray.origin, 1.0f));
+    result.direction = glm::mat3(transform) * ray.direction;
+    return result;
+}
+
+struct MeshBvh::BuildState {
+    BuildState(const BvhBuildOptions& options, ThreadPool* pool) : options(options), pool(pool) {}
+
+    const BvhBuildOptions& options;
+    ThreadPool* pool = nullptr;
+    std::vector<BuildReference> references;
+    std::atomic<uint32_t> nodeCount{1};
+    std::atomic<uint32_t> leafCount{0};
+    std::atomic<uint32_t> maxDepth{0};
+
+    std::size_t SliceCount(uint32_t count) const {
+        if (!pool || count < options.parallelThreshold) {
+            return 1;
+        }
+        return std::min<std::size_t>(pool->ThreadCount() + 1, count / (options.parallelThreshold / 4 + 1));
+    }
+
+    // Runs body(slice, begin, end) over SliceCount(count) slices of
+    // [first, first + count), on the pool when there are several.
+    void ForSlices(uint32_t first, uint32_t count, const std::function<void(std::size_t, uint32_t, uint32_t)>& body) const {
+        const std::size_t sliceCount = SliceCount(count);
+        auto slice = [&](std::size_t s) {
+            body(s, first + static_cast<uint32_t>(uint64_t{count} * s / sliceCount),
+                 first + static_cast<uint32_t>(uint64_t{count} * (s + 1) / sliceCount));
+        };
+        if (sliceCount > 1) {
+            pool->ParallelFor(sliceCount, slice);
+        } else {
+            slice(0);
+        }
+    }
+
+    Bin RangeBounds(uint32_t first, uint32_t count) const {
+        std::vector<Bin> slices(SliceCount(count));
+        ForSlices(first, count, [&](std::size_t s, uint32_t begin, uint32_t end) {
+            for (uint32_t i = begin; i < end; ++i) {
+                slices[s].Add(references[i]);
+            }
+        });
+        for (std::size_t s = 1; s < slices.size(); ++s) {
+            slices[0].Add(slices[s]);
+        }
+        return slices[0];
+    }
+};
+
+void MeshBvh::Build(std::span<const glm::vec3> positions,
+                    std::span<const uint32_t> indices,
+                    const BvhBuildOptions& options,
+                    ThreadPool* pool) {
+    const auto start = std::chrono::steady_clock::now();
+    nodes_.clear();
+    triangles_.clear();
+    stats_ = BvhStats{};
+
+    BuildState state(options, pool);
+    for (std::size_t i = 0; i + 2 < indices.size(); i += 3) {
+        if (indices[i] < positions.size() && indices[i + 1] < positions.size() && indices[i + 2] < positions.size()) {
+            BuildReference reference;
+            reference.triangle = static_cast<uint32_t>(i / 3);
+            state.references.push_back(reference);
+        }
+    }
+    const uint32_t triangleCount = static_cast<uint32_t>(state.references.size());
+    if (triangleCount == 0) {
+        return;
+    }
+    state.ForSlices(0, triangleCount, [&](std::size_t, uint32_t begin, uint32_t end) {
+        for (uint32_t i = begin; i < end; ++i) {
+            BuildReference& reference = state.references[i];
+            for (int corner = 0; corner < 3; ++corner) {
+                reference.box.Expand(positions[indices[reference.triangle * 3 + corner]]);
+            }
+            reference.centroid = reference.box.Center();
+        }
+    });
+
+    nodes_.resize(static_cast<std::size_t>(triangleCount) * 2 - 1);
+    const Bin root = state.RangeBounds(0, triangleCount);
+    BuildNode(state, 0, 0, triangleCount, root.box, root.centroids, 0);
+    nodes_.resize(state.nodeCount.load());
+
+    triangles_.resize(triangleCount);
+    for (uint32_t i = 0; i < triangleCount; ++i) {
+        const uint32_t triangle = state.references[i].triangle;
+        const glm::vec3 v0 = positions[indices[triangle * 3]];
+        triangles_[i] = Triangle{v0, positions[indices[triangle * 3 + 1]] - v0, positions[indices[triangle * 3 + 2]] - v0,
+                                 triangle};
+    }
+
+    const float rootArea = std::max(SurfaceArea(Bounds()), 1e-30f);
+    for (const Node& node : nodes_) {
+        const float area = SurfaceArea(BoundingBox{node.min, node.max}) / rootArea;
+        stats_.sahCost += node.count > 0 ? area * static_cast<float>(node.count) : area * options.traversalCost;
+    }
+    stats_.triangles = triangleCount;
+    stats_.nodes = static_cast<uint32_t>(nodes_.size());
+    stats_.leaves = state.leafCount.load();
+    stats_.maxDepth = state.maxDepth.load();
+    stats_.buildMs = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+}
+
+void MeshBvh::BuildNode(BuildState& state,
+                        uint32_t nodeIndex,
+                        uint32_t first,
+                        uint32_t count,
+                        const BoundingBox& box,
+                        const BoundingBox& centroidBox,
+                        uint32_t depth) {
+    const BvhBuildOptions& options = state.options;
+    Node& node = nodes_[nodeIndex];
+    node.min = box.min;
+    node.max = box.max;
+    uint32_t seenDepth = state.maxDepth.load();
+    while (depth > seenDepth && !state.maxDepth.compare_exchange_weak(seenDepth, depth)) {
+    }
+
+    auto makeLeaf = [&]() {
+        node.leftOrFirst = first;
+        node.count = count;
+        state.leafCount.fetch_add(1);
+    };
+    if (count <= options.maxLeafTriangles) {
+        makeLeaf();
+        return;
+    }
+
+    // Bin the centroids along every axis and sweep each for the cheapest
+    // split; costs are relative to one triangle test.
+    const unsigned binCount = std::max(options.binCount, 2u);
+    const glm::vec3 extent = centroidBox.max - centroidBox.min;
+    glm::vec3 binScale(0.0f);
+    for (int axis = 0; axis < 3; ++axis) {
+        if (extent[axis] > 0.0f) {
+            binScale[axis] = static_cast<float>(binCount) / extent[axis];
+        }
+    }
+    auto binOf = [&](const BuildReference& reference, int axis) {
+        const float offset = (reference.centroid[axis] - centroidBox.min[axis]) * binScale[axis];
+        return std::min(static_cast<unsigned>(offset), binCount - 1);
+    };
+
+    std::vector<std::vector<Bin>> sliceBins(state.SliceCount(count), std::vector<Bin>(3 * binCount));
+    state.ForSlices(first, count, [&](std::size_t s, uint32_t begin, uint32_t end) {
+        std::vector<Bin>& bins = sliceBins[s];
+        for (uint32_t i = begin; i < end; ++i) {
+            const BuildReference& reference = state.references[i];
+            for (int axis = 0; axis < 3; ++axis) {
+                bins[axis * binCount + binOf(reference, axis)].Add(reference);
+            }
+        }
+    });
+    std::vector<Bin>& bins = sliceBins[0];
+    for (std::size_t s = 1; s < sliceBins.size(); ++s) {
+        for (std::size_t b = 0; b < bins.size(); ++b) {
+            bins[b].Add(sliceBins[s][b]);
+        }
+    }
+
+    const float nodeArea = std::max(SurfaceArea(box), 1e-30f);
+    float bestCost = std::numeric_limits<float>::max();
+    int bestAxis = -1;
+    unsigned bestSplit = 0; // bins [0, bestSplit] go left
+    std::vector<float> rightCost(binCount);
+    for (int axis = 0; axis < 3; ++axis) {
+        if (binScale[axis] == 0.0f) {
+            continue;
+        }
+        const Bin* axisBins = bins.data() + axis * binCount;
+        BoundingBox right;
+        uint32_t rightCount = 0;
+        for (unsigned b = binCount - 1; b > 0; --b) {
+            right.Expand(axisBins[b].box);
+            rightCount += axisBins[b].count;
+            rightCost[b] = SurfaceArea(right) * static_cast<float>(rightCount);
+        }
+        BoundingBox left;
+        uint32_t leftCount = 0;
+        for (unsigned b = 0; b + 1 < binCount; ++b) {
+            left.Expand(axisBins[b].box);
+            leftCount += axisBins[b].count;
+            if (leftCount == 0 || leftCount == count) {
+                continue;
+            }
+            const float cost =
+                options.traversalCost + (SurfaceArea(left) * static_cast<float>(leftCount) + rightCost[b + 1]) / nodeArea;
+            if (cost < bestCost) {
+                bestCost = cost;
+                bestAxis = axis;
+                bestSplit = b;
+            }
+        }
+    }
+
+    // The children's bounds come from the bins on either side of the split.
+    Bin leftBin;
+    Bin rightBin;
+    auto begin = state.references.begin() + first;
+    if (bestAxis >= 0 && depth < kSahMaxDepth) {
+        if (bestCost >= static_cast<float>(count) && count <= options.leafTriangles) {
+            makeLeaf();
+            return;
+        }
+        for (unsigned b = 0; b < binCount; ++b) {
+            (b <= bestSplit ? leftBin : rightBin).Add(bins[bestAxis * binCount + b]);
+        }
+        std::partition(begin, begin + count,
+                       [&](const BuildReference& reference) { return binOf(reference, bestAxis) <= bestSplit; });
+    } else if (count <= options.leafTriangles) {
+        makeLeaf();
+        return;
+    } else {
+        // Coincident centroids (or a runaway depth): halve the range along
+        // the longest axis.
+        const int axis = extent.x >= extent.y && extent.x >= extent.z ? 0 : (extent.y >= extent.z ? 1 : 2);
+        std::nth_element(begin, begin + count / 2, begin + count, [&](const BuildReference& a, const BuildReference& b) {
+            return a.centroid[axis] < b.centroid[axis];
+        });
+        leftBin = state.RangeBounds(first, count / 2);
+        rightBin = state.RangeBounds(first + count / 2, count - count / 2);
+    }
+
+    const uint32_t left = state.nodeCount.fetch_add(2);
+    node.leftOrFirst = left;
+    node.count = 0;
+    auto buildChild = [&](std::size_t child) {
+        if (child == 0) {
+            BuildNode(state, left, first, leftBin.count, leftBin.box, leftBin.centroids, depth + 1);
+        } else {
+            BuildNode(state, left + 1, first + leftBin.count, rightBin.count, rightBin.box, rightBin.centroids, depth + 1);
+        }
+    };
+    if (state.pool && count >= options.parallelThreshold) {
+        state.pool->ParallelFor(2, buildChild);
+    } else {
+        buildChild(0);
+        buildChild(1);
+    }
+}
+
+BoundingBox MeshBvh::Bounds() const {
+    return nodes_.empty() ? BoundingBox{} : BoundingBox{nodes_[0].min, nodes_[0].max};
+}
+
+bool MeshBvh::Intersect(const Ray& ray, RayHit& hit) const {
+    hit = RayHit{};
+    return Traverse(ray, &hit);
+}
+
+bool MeshBvh::Occluded(const Ray& ray) const {
+    return Traverse(ray, nullptr);
+}
+
+bool MeshBvh::Traverse(const Ray& ray, RayHit* hit) const {
+    if (nodes_.empty()) {
+        return false;
+    }
+    const glm::vec3 o = ray.origin;
+    const glm::vec3 d = ray.direction;
+    const glm::vec3 inverseDirection = SafeInverse(d);
+    float tMax = ray.tMax;
+    bool found = false;
+
+    uint32_t stack[kStackSize];
+    int stackSize = 0;
+    float tEntry = 0.0f;
+    if (!SlabTest(nodes_[0].min, nodes_[0].max, o, inverseDirection, ray.tMin, tMax, tEntry)) {
+        return false;
+    }
+    stack[stackSize++] = 0;
+    while (stackSize > 0) {
+        const Node& node = nodes_[stack[--stackSize]];
+        if (node.count > 0) {
+            for (uint32_t i = node.leftOrFirst; i < node.leftOrFirst + node.count; ++i) {
+                // Möller-Trumbore, spelled out to match the packet version.
+                const Triangle& triangle = triangles_[i];
+                const glm::vec3& e1 = triangle.edge1;
+                const glm::vec3& e2 = triangle.edge2;
+                const float px = d.y * e2.z - d.z * e2.y;
+                const float py = d.z * e2.x - d.x * e2.z;
+                const float pz = d.x * e2.y - d.y * e2.x;
+                const float inverseDet = 1.0f / (e1.x * px + e1.y * py + e1.z * pz);
+                const float sx = o.x - triangle.v0.x;
+                const float sy = o.y - triangle.v0.y;
+                const float sz = o.z - triangle.v0.z;
+                const float u = (sx * px + sy * py + sz * pz) * inverseDet;
+                const float qx = sy * e1.z - sz * e1.y;
+                const float qy = sz * e1.x - sx * e1.z;
+                const float qz = sx * e1.y - sy * e1.x;
+                const float v = (d.x * qx + d.y * qy + d.z * qz) * inverseDet;
+                const float t = (e2.x * qx + e2.y * qy + e2.z * qz) * inverseDet;
+                if (!(0.0f <= u && 0.0f <= v && u + v <= 1.0f && ray.tMin <= t && t <= tMax)) {
+                    continue;
+                }
+                if (!hit) {
+                    return true;
+                }
+                found = true;
+                tMax = t;
+                hit->t = t;
+                hit->triangle = triangle.index;
+                hit->barycentric = glm::vec2(u, v);
+            }
+            continue;
+        }
+
+        // Visit the nearer child first so its hits prune the other.
+        const uint32_t left = node.leftOrFirst;
+        float leftEntry = 0.0f;
+        float rightEntry = 0.0f;
+        const bool hitLeft = SlabTest(nodes_[left].min, nodes_[left].max, o, inverseDirection, ray.tMin, tMax, leftEntry);
+        const bool hitRight =
+            SlabTest(nodes_[left + 1].min, nodes_[left + 1].max, o, inverseDirection, ray.tMin, tMax, rightEntry);
+        if (hitLeft && hitRight) {
+            const bool leftFirst = leftEntry <= rightEntry;
+            stack[stackSize++] = leftFirst ? left + 1 : left;
+            stack[stackSize++] = leftFirst ? left : left + 1;
+        } else if (hitLeft) {
+            stack[stackSize++] = left;
+        } else if (hitRight) {
+            stack[stackSize++] = left + 1;
+        }
+    }
+    return found;
+}
+
+void MeshBvh::IntersectPacket(std::span<const Ray, kPacketSize> rays, std::span<RayHit, kPacketSize> hits) const {
+    for (RayHit& hit : hits) {
+        hit = RayHit{};
+    }
+    if (nodes_.empty()) {
+        return;
+    }
+
+    auto gather = [&](auto component) {
+        return Float4::Set(component(rays[0]), component(rays[1]), component(rays[2]), component(rays[3]));
+    };
+    const Float4 ox = gather([](const Ray& r) { return r.origin.x; });
+    const Float4 oy = gather([](const Ray& r) { return r.origin.y; });
+    const Float4 oz = gather([](const Ray& r) { return r.origin.z; });
+    const Float4 dx = gather([](const Ray& r) { return r.direction.x; });
+    const Float4 dy = gather([](const Ray& r) { return r.direction.y; });
+    const Float4 dz = gather([](const Ray& r) { return r.direction.z; });
+    const Float4 ix = gather([](const Ray& r) { return SafeInverse(r.direction).x; });
+    const Float4 iy = gather([](const Ray& r) { return SafeInverse(r.direction).y; });
+    const Float4 iz = gather([](const Ray& r) { return SafeInverse(r.direction).z; });
+    const Float4 tMin = gather([](const Ray& r) { return r.tMin; });
+    Float4 tMax = gather([](const Ray& r) { return r.tMax; });
+    Float4 hitU = Float4::Splat(0.0f);
+    Float4 hitV = Float4::Splat(0.0f);
+    unsigned hitLanes = 0;
+
+    // Entry distances of the packet into a node; `mask` gets the rays that
+    // enter it before their current hit.
+    auto slabTest = [&](const Node& node, unsigned& mask) {
+        const Float4 t1x = (Float4::Splat(node.min.x) - ox) * ix;
+        const Float4 t2x = (Float4::Splat(node.max.x) - ox) * ix;
+        const Float4 t1y = (Float4::Splat(node.min.y) - oy) * iy;
+        const Float4 t2y = (Float4::Splat(node.max.y) - oy) * iy;
+        const Float4 t1z = (Float4::Splat(node.min.z) - oz) * iz;
+        const Float4 t2z = (Float4::Splat(node.max.z) - oz) * iz;
+        const Float4 tEntry = Max(Max(Min(t1x, t2x), Min(t1y, t2y)), Max(Min(t1z, t2z), tMin));
+        const Float4 tExit = Min(Min(Max(t1x, t2x), Max(t1y, t2y)), Min(Max(t1z, t2z), tMax));
+        mask = (tEntry <= tExit).Bits();
+        return tEntry;
+    };
+    // Smallest entry distance over the rays in `mask`.
+    auto nearest = [](Float4 tEntry, unsigned mask) {
+        float best = std::numeric_limits<float>::max();
+        for (int lane = 0; lane < 4; ++lane) {
+            if (mask & (1u << lane)) {
+                best = std::min(best, tEntry.Lane(lane));
+            }
+        }
+        return best;
+    };
+
+    uint32_t stack[kStackSize];
+    int stackSize = 0;
+    unsigned rootMask = 0;
+    slabTest(nodes_[0], rootMask);
+    if (rootMask != 0) {
+        stack[stackSize++] = 0;
+    }
+    while (stackSize > 0) {
+        const Node& node = nodes_[stack[--stackSize]];
+        if (node.count > 0) {
+            for (uint32_t i = node.leftOrFirst; i < node.leftOrFirst + node.count; ++i) {
+                const Triangle& triangle = triangles_[i];
+                const Float4 e1x = Float4::Splat(triangle.edge1.x);
+                const Float4 e1y = Float4::Splat(triangle.edge1.y);
+                const Float4 e1z = Float4::Splat(triangle.edge1.z);
+                const Float4 e2x = Float4::Splat(triangle.edge2.x);
+                const Float4 e2y = Float4::Splat(triangle.edge2.y);
+                const Float4 e2z = Float4::Splat(triangle.edge2.z);
+                const Float4 px = dy * e2z - dz * e2y;
+                const Float4 py = dz * e2x - dx * e2z;
+                const Float4 pz = dx * e2y - dy * e2x;
+                const Float4 inverseDet = Float4::Splat(1.0f) / (e1x * px + e1y * py + e1z * pz);
+                const Float4 sx = ox - Float4::Splat(triangle.v0.x);
+                const Float4 sy = oy - Float4::Splat(triangle.v0.y);
+                const Float4 sz = oz - Float4::Splat(triangle.v0.z);
+                const Float4 u = (sx * px + sy * py + sz * pz) * inverseDet;
+                const Float4 qx = sy * e1z - sz * e1y;
+                const Float4 qy = sz * e1x - sx * e1z;
+                const Float4 qz = sx * e1y - sy * e1x;
+                const Float4 v = (dx * qx + dy * qy + dz * qz) * inverseDet;
+                const Float4 t = (e2x * qx + e2y * qy + e2z * qz) * inverseDet;
+                const Float4 zero = Float4::Splat(0.0f);
+                const Mask4 inside = (zero <= u) & (zero <= v) & (u + v <= Float4::Splat(1.0f)) & (tMin <= t) & (t <= tMax);
+                const unsigned mask = inside.Bits();
+                if (mask == 0) {
+                    continue;
+                }
+                tMax = Select(inside, t, tMax);
+                hitU = Select(inside, u, hitU);
+                hitV = Select(inside, v, hitV);
+                hitLanes |= mask;
+                for (int lane = 0; lane < 4; ++lane) {
+                    if (mask & (1u << lane)) {
+                        hits[lane].triangle = triangle.index;
+                    }
+                }
+            }
+            continue;
+        }
+
+        const uint32_t left = node.leftOrFirst;
+        unsigned leftMask = 0;
+        unsigned rightMask = 0;
+        const Float4 leftEntry = slabTest(nodes_[left], leftMask);
+        const Float4 rightEntry = slabTest(nodes_[left + 1], rightMask);
+        if (leftMask != 0 && rightMask != 0) {
+            const bool leftFirst = nearest(leftEntry, leftMask) <= nearest(rightEntry, rightMask);
+            stack[stackSize++] = leftFirst ? left + 1 : left;
+            stack[stackSize++] = leftFirst ? left : left + 1;
+        } else if (leftMask != 0) {
+            stack[stackSize++] = left;
+        } else if (rightMask != 0) {
+            stack[stackSize++] = left + 1;
+        }
+    }
+
+    for (int lane = 0; lane < 4; ++lane) {
+        if (hitLanes & (1u << lane)) {
+            hits[lane].t = tMax.Lane(lane);
+            hits[lane].barycentric = glm::vec2(hitU.Lane(lane), hitV.Lane(lane));
+        }
+    }
+}
+
+void MeshBvh::QueryBox(const BoundingBox& box, std::vector<uint32_t>& triangles) const {
+    if (nodes_.empty()) {
+        return;
+    }
+    auto overlaps = [&](const glm::vec3& min, const glm::vec3& max) {
+        return glm::all(glm::lessThanEqual(min, box.max)) && glm::all(glm::lessThanEqual(box.min, max));
+    };
+    uint32_t stack[kStackSize];
+    int stackSize = 0;
+    stack[stackSize++] = 0;
+    while (stackSize > 0) {
+        const Node& node = nodes_[stack[--stackSize]];
+        if (!overlaps(node.min, node.max)) {
+            continue;
+        }
+        if (node.count == 0) {
+            stack[stackSize++] = node.leftOrFirst;
+            stack[stackSize++] = node.leftOrFirst + 1;
+            continue;
+        }
+        for (uint32_t i = node.leftOrFirst; i < node.leftOrFirst + node.count; ++i) {
+            const Triangle& triangle = triangles_[i];
+            const glm::vec3 v1 = triangle.v0 + triangle.edge1;
+            const glm::vec3 v2 = triangle.v0 + triangle.edge2;
+            if (overlaps(glm::min(triangle.v0, glm::min(v1, v2)), glm::max(triangle.v0, glm::max(v1, v2)))) {
+                triangles.push_back(triangle.index);
+            }
+        }
+    }
+}
@@ -0,0 +1,115 @@
+#pragma once
+
+#include "Bounds.hpp"
+
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <span>
+#include <vector>
+
+#include <glm/glm.hpp>
+
+class ThreadPool;
+
+struct Ray {
+    glm::vec3 origin{0.0f};
+    glm::vec3 direction{0.0f, 0.0f, -1.0f}; // need not be normalized; t is in its units
+    float tMin = 0.0f;
+    float tMax = std::numeric_limits<float>::max();
+};
+
+struct RayHit {
+    static constexpr uint32_t kNoHit = std::numeric_limits<uint32_t>::max();
+
+    float t = std::numeric_limits<float>::max();
+    uint32_t triangle = kNoHit; // index into the indices given to Build(), divided by 3
+    glm::vec2 barycentric{0.0f}; // weights of the triangle's second and third vertex
+
+    bool Hit() const { return triangle != kNoHit; }
+};
+
+// `ray` in the space `transform` maps to, keeping t comparable: a hit at t
+// is the same point in both spaces.
+Ray TransformRay(const Ray& ray, const glm::mat4& transform);
+
+struct BvhBuildOptions {
+    unsigned binCount = 16;         // SAH candidates per axis
+    unsigned maxLeafTriangles = 4;  // a leaf always splits above this...
+    unsigned leafTriangles = 16;    // ...and never stays a leaf above this, even if SAH prefers it
+    float traversalCost = 1.0f;     // relative to one ray-triangle test
+    // Subtrees and binning passes below this many triangles run serially.
+    std::size_t parallelThreshold = 8192;
+};
+
+struct BvhStats {
+    uint32_t triangles = 0;
+    uint32_t nodes = 0;
+    uint32_t leaves = 0;
+    uint32_t maxDepth = 0;
+    float sahCost = 0.0f; // expected cost of a ray through the root
+    double buildMs = 0.0;
+};
+
+// Bounding volume hierarchy over a triangle list, built with the binned
+// surface area heuristic: every node tries binCount split planes per axis
+// and keeps the one with the lowest expected ray cost. Given a pool, the two
+// halves of large nodes are built in parallel and their binning passes are
+// split across workers. Keeps its own reordered copy of the triangles, so
+// the source arrays may be freed after Build().
+class MeshBvh {
+public:
+    static constexpr std::size_t kPacketSize = 4;
+
+    void Build(std::span<const glm::vec3> positions,
+               std::span<const uint32_t> indices,
+               const BvhBuildOptions& options = {},
+               ThreadPool* pool = nullptr);
+
+    // Nearest hit within [tMin, tMax]; both windings count.
+    bool Intersect(const Ray& ray, RayHit& hit) const;
+    // Whether anything lies within [tMin, tMax]; stops at the first hit.
+    bool Occluded(const Ray& ray) const;
+    // Intersect() for kPacketSize rays traversed together, testing the
+    // packet against each node and triangle at once (SSE2 when available).
+    // Fastest for coherent rays such as neighbouring pixels.
+    void IntersectPacket(std::span<const Ray, kPacketSize> rays, std::span<RayHit, kPacketSize> hits) const;
+    // Appends the triangles whose bounds overlap `box`.
+    void QueryBox(const BoundingBox& box, std::vector<uint32_t>& triangles) const;
+
+    bool Empty() const { return nodes_.empty(); }
+    BoundingBox Bounds() const;
+    const BvhStats& Stats() const { return stats_; }
+
+private:
+    struct Node {
+        glm::vec3 min;
+        uint32_t leftOrFirst = 0; // left child (right is next) or first triangle
+        glm::vec3 max;
+        uint32_t count = 0; // triangles of a leaf, 0 for inner nodes
+    };
+
+    // Möller-Trumbore form, in BVH order.
+    struct Triangle {
+        glm::vec3 v0;
+        glm::vec3 edge1;
+        glm::vec3 edge2;
+        uint32_t index = 0;
+    };
+
+    std::vector<Node> nodes_;
+    std::vector<Triangle> triangles_;
+    BvhStats stats_;
+
+    struct BuildState;
+
+    // centroidBox bounds the centres of the node's triangles.
+    void BuildNode(BuildState& state,
+                   uint32_t nodeIndex,
+                   uint32_t first,
+                   uint32_t count,
+                   const BoundingBox& box,
+                   const BoundingBox& centroidBox,
+                   uint32_t depth);
+    bool Traverse(const Ray& ray, RayHit* hit) const;
+};
@@ -0,0 +1,349 @@
+#include "MeshCache.hpp"
+
+#include "SourceStamp.hpp"
+
+#include <cstring>
+#include <fstream>
+#include <system_error>
+
+namespace {
+
+constexpr char kMagic[8] = {'U', 'F', 'O', 'M', 'E', 'S', 'H', '\0'};
+constexpr std::size_t kDataAlignment = 64;
+
+struct CacheHeader {
+    char magic[8];
+    uint32_t version;
+    uint32_t vertexStride;
+    uint32_t chunkCount;
+    uint32_t dependencyCount;
+    uint64_t contentKey;
+    uint64_t vertexCount;
+    uint64_t vertexOffset;
+    uint64_t indexCount;
+    uint64_t indexOffset;
+    uint64_t tangentOffset; // 0 when the cache holds no tangents
+    uint64_t metadataOffset;
+    uint64_t metadataSize;
+};
+
+class ByteWriter {
+public:
+    template <typename T>
+    void Put(const T& value) {
+        const auto* bytes = reinterpret_cast<const char*>(&value);
+        data_.insert(data_.end(), bytes, bytes + sizeof(T));
+    }
+
+    void PutString(const std::string& text) {
+        Put(static_cast<uint32_t>(text.size()));
+        data_.insert(data_.end(), text.begin(), text.end());
+    }
+
+    const std::vector<char>& Data() const { return data_; }
+
+private:
+    std::vector<char> data_;
+};
+
+class ByteReader {
+public:
+    ByteReader(const char* data, std::size_t size) : cursor_(data), end_(data + size) {}
+
+    template <typename T>
+    bool Get(T& value) {
+        if (static_cast<std::size_t>(end_ - cursor_) < sizeof(T)) {
+            return false;
+        }
+        std::memcpy(&value, cursor_, sizeof(T));
+        cursor_ += sizeof(T);
+        return true;
+    }
+
+    bool GetString(std::string& text) {
+        uint32_t length = 0;
+        if (!Get(length) || static_cast<std::size_t>(end_ - cursor_) < length) {
+            return false;
+        }
+        text.assign(cursor_, length);
+        cursor_ += length;
+        return true;
+    }
+
+    std::size_t Offset(const char* begin) const { return static_cast<std::size_t>(cursor_ - begin); }
+
+private:
+    const char* cursor_;
+    const char* end_;
+};
+
+uint64_t AlignUp(uint64_t value, uint64_t alignment) {
+    return (value + alignment - 1) / alignment * alignment;
+}
+
+std::string RelativeTo(const std::filesystem::path& path, const std::filesystem::path& base) {
+    if (path.empty()) {
+        return {};
+    }
+    return path.lexically_relative(base).generic_string();
+}
+
+bool Fail(std::string* error, const std::string& message) {
+    if (error) {
+        *error = message;
+    }
+    return false;
+}
+
+struct StampRefresh {
+    uint64_t offset; // of the stamp's mtime in the cache file
+    int64_t mtime;
+};
+
+// Stores the mtimes of sources that only matched by content hash. Best
+// effort: if this fails, the next load simply hashes them again.
+void RefreshStamps(const std::filesystem::path& cachePath, const std::vector<StampRefresh>& refreshes) {
+    std::fstream file(cachePath, std::ios::binary | std::ios::in | std::ios::out);
+    for (const StampRefresh& refresh : refreshes) {
+        if (!file) {
+            return;
+        }
+        file.seekp(static_cast<std::streamoff>(refresh.offset));
+        file.write(reinterpret_cast<const char*>(&refresh.mtime), sizeof(refresh.mtime));
+    }
+}
+
+} // namespace
+
+std::filesystem::path MeshCacheFile::PathFor(const std::filesystem::path& objPath) {
+    std::filesystem::path cachePath = objPath;
+    cachePath += ".meshcache";
+    return cachePath;
+}
+
+bool MeshCacheFile::Open(const std::filesystem::path& objPath, uint64_t contentKey, std::string* error) {
+    const std::filesystem::path cachePath = PathFor(objPath);
+    const std::filesystem::path baseDir = objPath.parent_path();
+
+    if (!file_.Open(cachePath, error)) {
+        return false;
+    }
+
+    CacheHeader header{};
+    if (file_.Size() < sizeof(header)) {
+        return Fail(error, "Mesh cache is truncated: " + cachePath.string());
+    }
+    std::memcpy(&header, file_.Data(), sizeof(header));
+    if (std::memcmp(header.magic, kMagic, sizeof(kMagic)) != 0 || header.version != kVersion ||
+        header.vertexStride != sizeof(VertexPNT)) {
+        return Fail(error, "Mesh cache has an incompatible format: " + cachePath.string());
+    }
+    if (header.contentKey != contentKey) {
+        return Fail(error, "Mesh cache was built with different options: " + cachePath.string());
+    }
+
+    const uint64_t fileSize = file_.Size();
+    auto inBounds = [fileSize](uint64_t offset, uint64_t size) {
+        return offset <= fileSize && size <= fileSize - offset;
+    };
+    if (!inBounds(header.vertexOffset, header.vertexCount * sizeof(VertexPNT)) ||
+        !inBounds(header.indexOffset, header.indexCount * sizeof(uint32_t)) ||
+        (header.tangentOffset != 0 && !inBounds(header.tangentOffset, header.vertexCount * sizeof(glm::vec4))) ||
+        !inBounds(header.metadataOffset, header.metadataSize)) {
+        return Fail(error, "Mesh cache is truncated: " + cachePath.string());
+    }
+
+    const char* metadata = file_.Data() + header.metadataOffset;
+    ByteReader reader(metadata, header.metadataSize);
+
+    sources_.clear();
+    std::vector<StampRefresh> refreshes;
+    for (uint32_t i = 0; i < header.dependencyCount; ++i) {
+        std::string relativePath;
+        SourceStamp cached;
+        if (!reader.GetString(relativePath) || !reader.Get(cached.size)) {
+            return Fail(error, "Mesh cache metadata is corrupt: " + cachePath.string());
+        }
+        const uint64_t mtimeOffset = header.metadataOffset + reader.Offset(metadata);
+        if (!reader.Get(cached.mtime) || !reader.Get(cached.contentHash)) {
+            return Fail(error, "Mesh cache metadata is corrupt: " + cachePath.string());
+        }
+
+        const std::filesystem::path sourcePath = (baseDir / relativePath).lexically_normal();
+        if (i == 0 && sourcePath != objPath.lexically_normal()) {
+            return Fail(error, "Mesh cache belongs to a different OBJ: " + cachePath.string());
+        }
+
+        SourceStamp current;
+        if (!SourceUnchanged(sourcePath, cached, &current)) {
+            return Fail(error, "Mesh cache is stale: " + sourcePath.string() + " changed.");
+        }
+        if (current.mtime != cached.mtime) {
+            refreshes.push_back({mtimeOffset, current.mtime});
+        }
+        sources_.push_back(sourcePath);
+    }
+
+    chunks_.clear();
+    chunks_.reserve(header.chunkCount);
+    for (uint32_t i = 0; i < header.chunkCount; ++i) {
+        MeshChunk chunk;
+        std::string texture;
+        std::string normalTexture;
+        if (!reader.Get(chunk.startIndex) || !reader.Get(chunk.indexCount) ||
+            !reader.Get(chunk.material.diffuseColor) || !reader.Get(chunk.material.shininess) ||
+            !reader.GetString(chunk.material.name) || !reader.GetString(texture) ||
+            !reader.GetString(normalTexture) || !reader.Get(chunk.material.normalScale) ||
+            !reader.Get(chunk.box.min) || !reader.Get(chunk.box.max) || !reader.Get(chunk.sphere.center) ||
+            !reader.Get(chunk.sphere.radius)) {
+            return Fail(error, "Mesh cache metadata is corrupt: " + cachePath.string());
+        }
+        if (static_cast<uint64_t>(chunk.startIndex) + chunk.indexCount > header.indexCount) {
+            return Fail(error, "Mesh cache metadata is corrupt: " + cachePath.string());
+        }
+        if (!texture.empty()) {
+            chunk.material.diffuseTexture = (baseDir / texture).lexically_normal();
+        }
+        if (!normalTexture.empty()) {
+            chunk.material.normalTexture = (baseDir / normalTexture).lexically_normal();
+        }
+        uint32_t lodCount = 0;
+        if (!reader.Get(lodCount)) {
+            return Fail(error, "Mesh cache metadata is corrupt: " + cachePath.string());
+        }
+        for (uint32_t l = 0; l < lodCount; ++l) {
+            MeshLod lod;
+            if (!reader.Get(lod.startIndex) || !reader.Get(lod.indexCount) || !reader.Get(lod.error) ||
+                static_cast<uint64_t>(lod.startIndex) + lod.indexCount > header.indexCount) {
+                return Fail(error, "Mesh cache metadata is corrupt: " + cachePath.string());
+            }
+            chunk.lods.push_back(lod);
+        }
+        chunks_.push_back(std::move(chunk));
+    }
+
+    vertices_ = reinterpret_cast<const VertexPNT*>(file_.Data() + header.vertexOffset);
+    tangents_ = header.tangentOffset != 0
+                    ? reinterpret_cast<const glm::vec4*>(file_.Data() + header.tangentOffset)
+                    : nullptr;
+    vertexCount_ = static_cast<std::size_t>(header.vertexCount);
+    indices_ = reinterpret_cast<const uint32_t*>(file_.Data() + header.indexOffset);
+    indexCount_ = static_cast<std::size_t>(header.indexCount);
+    if (!refreshes.empty()) {
+        RefreshStamps(cachePath, refreshes);
+    }
+    return true;
+}
+
+bool MeshCacheFile::Write(const std::filesystem::path& objPath,
+                          const ObjMesh& mesh,
+                          uint64_t contentKey,
+                          std::string* error) {
+    const std::filesystem::path cachePath = PathFor(objPath);
+    const std::filesystem::path baseDir = objPath.parent_path();
+
+    std::vector<std::filesystem::path> sources;
+    sources.push_back(objPath);
+    sources.insert(sources.end(), mesh.materialLibraries.begin(), mesh.materialLibraries.end());
+
+    ByteWriter metadata;
+    uint32_t dependencyCount = 0;
+    for (const auto& source : sources) {
+        SourceStamp stamp;
+        if (!StatSource(source, stamp)) {
+            // The loader skipped a missing MTL; the cache is stale once it appears.
+            stamp.mtime = kMissingSourceMtime;
+        } else if (!HashSource(source, stamp.contentHash)) {
+            return Fail(error, "Unable to read mesh cache source: " + source.string());
+        }
+        metadata.PutString(RelativeTo(source, baseDir));
+        metadata.Put(stamp.size);
+        metadata.Put(stamp.mtime);
+        metadata.Put(stamp.contentHash);
+        ++dependencyCount;
+    }
+
+    for (const auto& chunk : mesh.chunks) {
+        metadata.Put(chunk.startIndex);
+        metadata.Put(chunk.indexCount);
+        metadata.Put(chunk.material.diffuseColor);
+        metadata.Put(chunk.material.shininess);
+        metadata.PutString(chunk.material.name);
+        metadata.PutString(RelativeTo(chunk.material.diffuseTexture, baseDir));
+        metadata.PutString(RelativeTo(chunk.material.normalTexture, baseDir));
+        metadata.Put(chunk.material.normalScale);
+        metadata.Put(chunk.box.min);
+        metadata.Put(chunk.box.max);
+        metadata.Put(chunk.sphere.center);
+        metadata.Put(chunk.sphere.radius);
+        metadata.Put(static_cast<uint32_t>(chunk.lods.size()));
+        for (const auto& lod : chunk.lods) {
+            metadata.Put(lod.startIndex);
+            metadata.Put(lod.indexCount);
+            metadata.Put(lod.error);
+        }
+    }
+
+    CacheHeader header{};
+    std::memcpy(header.magic, kMagic, sizeof(kMagic));
+    header.version = kVersion;
+    header.vertexStride = sizeof(VertexPNT);
+    header.contentKey = contentKey;
+    header.chunkCount = static_cast<uint32_t>(mesh.chunks.size());
+    header.dependencyCount = dependencyCount;
+    header.vertexCount = mesh.vertices.size();
+    header.vertexOffset = AlignUp(sizeof(CacheHeader), kDataAlignment);
+    header.indexCount = mesh.indices.size();
+    header.indexOffset = AlignUp(header.vertexOffset + header.vertexCount * sizeof(VertexPNT), kDataAlignment);
+    uint64_t indexEnd = header.indexOffset + header.indexCount * sizeof(uint32_t);
+    const bool hasTangents = !mesh.tangents.empty() && mesh.tangents.size() == mesh.vertices.size();
+    if (hasTangents) {
+        header.tangentOffset = AlignUp(indexEnd, kDataAlignment);
+        indexEnd = header.tangentOffset + header.vertexCount * sizeof(glm::vec4);
+    }
+    header.metadataOffset = indexEnd;
+    header.metadataSize = metadata.Data().size();
+
+    // Write to a temporary file and rename so readers never see a partial cache.
+    std::filesystem::path tempPath = cachePath;
+    tempPath += ".tmp";
+    {
+        std::ofstream out(tempPath, std::ios::binary | std::ios::trunc);
+        if (!out) {
+            return Fail(error, "Unable to create mesh cache: " + tempPath.string());
+        }
+
+        const char padding[kDataAlignment] = {};
+        auto padTo = [&](uint64_t offset) {
+            uint64_t position = static_cast<uint64_t>(out.tellp());
+            out.write(padding, static_cast<std::streamsize>(offset - position));
+        };
+
+        out.write(reinterpret_cast<const char*>(&header), sizeof(header));
+        padTo(header.vertexOffset);
+        out.write(reinterpret_cast<const char*>(mesh.vertices.data()),
+                  static_cast<std::streamsize>(mesh.vertices.size() * sizeof(VertexPNT)));
+        padTo(header.indexOffset);
+        out.write(reinterpret_cast<const char*>(mesh.indices.data()),
+                  static_cast<std::streamsize>(mesh.indices.size() * sizeof(uint32_t)));
+        if (hasTangents) {
+            padTo(header.tangentOffset);
+            out.write(reinterpret_cast<const char*>(mesh.tangents.data()),
+                      static_cast<std::streamsize>(mesh.tangents.size() * sizeof(glm::vec4)));
+        }
+        out.write(metadata.Data().data(), static_cast<std::streamsize>(metadata.Data().size()));
+        if (!out) {
+            out.close();
+            std::filesystem::remove(tempPath);
+            return Fail(error, "Unable to write mesh cache: " + tempPath.string());
+        }
+    }
+
+    std::error_code ec;
+    std::filesystem::rename(tempPath, cachePath, ec);
+    if (ec) {
+        std::filesystem::remove(tempPath, ec);
+        return Fail(error, "Unable to replace mesh cache: " + cachePath.string());
+    }
+    return true;
+}
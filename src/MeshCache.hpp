@@ -0,0 +1,53 @@
+#pragma once
+
+#include "MappedFile.hpp"
+#include "ObjLoader.hpp"
+
+#include <cstdint>
+#include <filesystem>
+#include <string>
+#include <vector>
+
+// Binary copy of an ObjMesh stored next to the source OBJ. Vertex and index
+// arrays are kept in their in-memory layout so a mapped cache can be handed
+// directly to glBufferData.
+class MeshCacheFile {
+public:
+    static constexpr uint32_t kVersion = 6;
+
+    // Cache location used for a given OBJ ("model.obj" -> "model.obj.meshcache").
+    static std::filesystem::path PathFor(const std::filesystem::path& objPath);
+
+    // Maps the cache and checks it against the OBJ and every MTL it was built
+    // from. Sources are compared by size and mtime first and by content hash
+    // when the mtime changed (e.g. after a fresh checkout), in which case the
+    // new mtime is written back. An MTL that was missing at build time makes
+    // the cache stale once it exists. contentKey identifies the options the
+    // mesh was processed with and must match the one it was written with.
+    bool Open(const std::filesystem::path& objPath, uint64_t contentKey, std::string* error = nullptr);
+
+    static bool Write(const std::filesystem::path& objPath,
+                      const ObjMesh& mesh,
+                      uint64_t contentKey,
+                      std::string* error = nullptr);
+
+    const VertexPNT* Vertices() const { return vertices_; }
+    // One per vertex, or nullptr when the mesh was cached without tangents.
+    const glm::vec4* Tangents() const { return tangents_; }
+    std::size_t VertexCount() const { return vertexCount_; }
+    const uint32_t* Indices() const { return indices_; }
+    std::size_t IndexCount() const { return indexCount_; }
+    const std::vector<MeshChunk>& Chunks() const { return chunks_; }
+    // The OBJ followed by the MTL files the cache was built from.
+    const std::vector<std::filesystem::path>& Sources() const { return sources_; }
+
+private:
+    MappedFile file_;
+    const VertexPNT* vertices_ = nullptr;
+    const glm::vec4* tangents_ = nullptr;
+    std::size_t vertexCount_ = 0;
+    const uint32_t* indices_ = nullptr;
+    std::size_t indexCount_ = 0;
+    std::vector<MeshChunk> chunks_;
+    std::vector<std::filesystem::path> sources_;
+};
@@ -0,0 +1,406 @@
+#include "MeshOptimizer.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <numeric>
+#include <vector>
+
+#include <glm/geometric.hpp>
+
+namespace {
+
+constexpr uint32_t kUnused = 0xFFFFFFFFu;
+
+// Forsyth, "Linear-Speed Vertex Cache Optimisation". The scores are tuned
+// for an LRU cache of this size, which also does well on FIFO hardware.
+constexpr int kForsythCacheSize = 32;
+constexpr int kForsythMaxValence = 32;
+
+struct ForsythTables {
+    float cache[kForsythCacheSize + 1] = {};
+    float valence[kForsythMaxValence + 1] = {};
+
+    ForsythTables() {
+        for (int i = 0; i < kForsythCacheSize; ++i) {
+            if (i < 3) {
+                // The vertices of the last triangle are penalised slightly so
+                // strips do not keep turning back on themselves.
+                cache[i] = 0.75f;
+            } else {
+                float scaler = 1.0f / static_cast<float>(kForsythCacheSize - 3);
+                cache[i] = std::pow(1.0f - static_cast<float>(i - 3) * scaler, 1.5f);
+            }
+        }
+        cache[kForsythCacheSize] = 0.0f; // not in cache
+        valence[0] = 0.0f;
+        for (int i = 1; i <= kForsythMaxValence; ++i) {
+            valence[i] = 2.0f / std::sqrt(static_cast<float>(i));
+        }
+    }
+
+    float Score(int cachePosition, uint32_t liveTriangles) const {
+        if (liveTriangles == 0) {
+            return -1.0f;
+        }
+        float valenceScore = liveTriangles <= static_cast<uint32_t>(kForsythMaxValence)
+                                 ? valence[liveTriangles]
+                                 : 2.0f / std::sqrt(static_cast<float>(liveTriangles));
+        return cache[cachePosition] + valenceScore;
+    }
+};
+
+const ForsythTables& GetForsythTables() {
+    static const ForsythTables tables;
+    return tables;
+}
+
+// Scratch buffers reused across chunks. localIds maps a global vertex to its
+// index within the current chunk and is reset only where it was written.
+struct ChunkScratch {
+    std::vector<uint32_t> localIds;
+    std::vector<uint32_t> globalIds;
+    std::vector<uint32_t> localIndices;
+};
+
+void BuildLocalIndices(std::span<const uint32_t> indices, ChunkScratch& scratch) {
+    scratch.globalIds.clear();
+    scratch.localIndices.resize(indices.size());
+    for (std::size_t i = 0; i < indices.size(); ++i) {
+        uint32_t global = indices[i];
+        uint32_t& local = scratch.localIds[global];
+        if (local == kUnused) {
+            local = static_cast<uint32_t>(scratch.globalIds.size());
+            scratch.globalIds.push_back(global);
+        }
+        scratch.localIndices[i] = local;
+    }
+}
+
+void ResetLocalIds(ChunkScratch& scratch) {
+    for (uint32_t global : scratch.globalIds) {
+        scratch.localIds[global] = kUnused;
+    }
+}
+
+// Reorders the triangles of `indices` (local vertex ids < vertexCount) in place.
+void OptimizeVertexCacheForsyth(std::vector<uint32_t>& indices, std::size_t vertexCount) {
+    const ForsythTables& tables = GetForsythTables();
+    const std::size_t triangleCount = indices.size() / 3;
+    if (triangleCount < 2) {
+        return;
+    }
+
+    // Vertex -> triangle adjacency in CSR form. liveTriangles[v] is the number
+    // of not-yet-emitted triangles at the front of v's adjacency range.
+    std::vector<uint32_t> liveTriangles(vertexCount, 0);
+    for (uint32_t index : indices) {
+        ++liveTriangles[index];
+    }
+    std::vector<uint32_t> adjacencyOffset(vertexCount + 1, 0);
+    for (std::size_t v = 0; v < vertexCount; ++v) {
+        adjacencyOffset[v + 1] = adjacencyOffset[v] + liveTriangles[v];
+    }
+    std::vector<uint32_t> adjacency(indices.size());
+    {
+        std::vector<uint32_t> fill(adjacencyOffset.begin(), adjacencyOffset.end() - 1);
+        for (std::size_t t = 0; t < triangleCount; ++t) {
+            for (int k = 0; k < 3; ++k) {
+                adjacency[fill[indices[t * 3 + k]]++] = static_cast<uint32_t>(t);
+            }
+        }
+    }
+
+    std::vector<int> cachePosition(vertexCount, kForsythCacheSize);
+    std::vector<float> vertexScore(vertexCount);
+    for (std::size_t v = 0; v < vertexCount; ++v) {
+        vertexScore[v] = tables.Score(kForsythCacheSize, liveTriangles[v]);
+    }
+
+    std::vector<float> triangleScore(triangleCount);
+    for (std::size_t t = 0; t < triangleCount; ++t) {
+        triangleScore[t] = vertexScore[indices[t * 3]] + vertexScore[indices[t * 3 + 1]] +
+                           vertexScore[indices[t * 3 + 2]];
+    }
+
+    std::vector<char> emitted(triangleCount, 0);
+    std::vector<uint32_t> output;
+    output.reserve(indices.size());
+
+    uint32_t cache[kForsythCacheSize + 3];
+    int cacheCount = 0;
+    uint32_t newCache[kForsythCacheSize + 3];
+
+    std::size_t bestTriangle = static_cast<std::size_t>(
+        std::max_element(triangleScore.begin(), triangleScore.end()) - triangleScore.begin());
+    std::size_t scanCursor = 0;
+
+    for (std::size_t emittedCount = 0; emittedCount < triangleCount; ++emittedCount) {
+        if (bestTriangle == static_cast<std::size_t>(-1)) {
+            // Nothing in the cache touches a live triangle: restart from the
+            // next unemitted triangle in input order.
+            while (emitted[scanCursor]) {
+                ++scanCursor;
+            }
+            bestTriangle = scanCursor;
+        }
+
+        const uint32_t* tri = &indices[bestTriangle * 3];
+        emitted[bestTriangle] = 1;
+        output.insert(output.end(), tri, tri + 3);
+
+        // Drop the triangle from its vertices' live adjacency.
+        for (int k = 0; k < 3; ++k) {
+            uint32_t v = tri[k];
+            uint32_t* begin = &adjacency[adjacencyOffset[v]];
+            uint32_t* end = begin + liveTriangles[v];
+            uint32_t* it = std::find(begin, end, static_cast<uint32_t>(bestTriangle));
+            std::swap(*it, *(end - 1));
+            --liveTriangles[v];
+        }
+
+        // New LRU order: the emitted triangle's vertices first.
+        int newCount = 0;
+        for (int k = 0; k < 3; ++k) {
+            newCache[newCount++] = tri[k];
+        }
+        for (int i = 0; i < cacheCount; ++i) {
+            uint32_t v = cache[i];
+            if (v != tri[0] && v != tri[1] && v != tri[2]) {
+                newCache[newCount++] = v;
+            }
+        }
+
+        // Vertices pushed past the cache end lose their cache score.
+        for (int i = kForsythCacheSize; i < newCount; ++i) {
+            uint32_t v = newCache[i];
+            cachePosition[v] = kForsythCacheSize;
+            float score = tables.Score(kForsythCacheSize, liveTriangles[v]);
+            float delta = score - vertexScore[v];
+            vertexScore[v] = score;
+            for (uint32_t a = 0; a < liveTriangles[v]; ++a) {
+                triangleScore[adjacency[adjacencyOffset[v] + a]] += delta;
+            }
+        }
+        cacheCount = std::min(newCount, kForsythCacheSize);
+        std::copy(newCache, newCache + cacheCount, cache);
+
+        // Rescore cached vertices and pick the best triangle touching them.
+        bestTriangle = static_cast<std::size_t>(-1);
+        float bestScore = -1.0f;
+        for (int i = 0; i < cacheCount; ++i) {
+            uint32_t v = cache[i];
+            cachePosition[v] = i;
+            float score = tables.Score(i, liveTriangles[v]);
+            float delta = score - vertexScore[v];
+            vertexScore[v] = score;
+            for (uint32_t a = 0; a < liveTriangles[v]; ++a) {
+                uint32_t t = adjacency[adjacencyOffset[v] + a];
+                triangleScore[t] += delta;
+            }
+        }
+        for (int i = 0; i < cacheCount; ++i) {
+            uint32_t v = cache[i];
+            for (uint32_t a = 0; a < liveTriangles[v]; ++a) {
+                uint32_t t = adjacency[adjacencyOffset[v] + a];
+                if (triangleScore[t] > bestScore) {
+                    bestScore = triangleScore[t];
+                    bestTriangle = t;
+                }
+            }
+        }
+    }
+
+    indices.swap(output);
+}
+
+// Sander, Nehab, Barczak, "Fast Triangle Reordering for Vertex Locality and
+// Reduced Overdraw". Splits the cache-optimised sequence into clusters at
+// hard cache boundaries and draws outward-facing clusters first.
+void OptimizeOverdraw(std::vector<uint32_t>& indices,
+                      const std::vector<uint32_t>& globalIds,
+                      const std::vector<VertexPNT>& vertices,
+                      unsigned cacheSize) {
+    const std::size_t triangleCount = indices.size() / 3;
+    if (triangleCount < 2) {
+        return;
+    }
+
+    std::vector<uint32_t> clusterStarts;
+    {
+        std::vector<uint32_t> timestamps(globalIds.size(), 0);
+        uint32_t time = cacheSize + 1;
+        for (std::size_t t = 0; t < triangleCount; ++t) {
+            int misses = 0;
+            for (int k = 0; k < 3; ++k) {
+                uint32_t v = indices[t * 3 + k];
+                if (time - timestamps[v] > cacheSize) {
+                    timestamps[v] = time++;
+                    ++misses;
+                }
+            }
+            if (t == 0 || misses == 3) {
+                clusterStarts.push_back(static_cast<uint32_t>(t));
+            }
+        }
+    }
+    if (clusterStarts.size() < 2) {
+        return;
+    }
+    clusterStarts.push_back(static_cast<uint32_t>(triangleCount));
+
+    const std::size_t clusterCount = clusterStarts.size() - 1;
+    std::vector<glm::vec3> centroids(clusterCount, glm::vec3(0.0f));
+    std::vector<glm::vec3> normals(clusterCount, glm::vec3(0.0f));
+    glm::vec3 meshCentroid(0.0f);
+    float meshArea = 0.0f;
+
+    for (std::size_t c = 0; c < clusterCount; ++c) {
+        float clusterArea = 0.0f;
+        for (uint32_t t = clusterStarts[c]; t < clusterStarts[c + 1]; ++t) {
+            const glm::vec3& a = vertices[globalIds[indices[t * 3]]].position;
+            const glm::vec3& b = vertices[globalIds[indices[t * 3 + 1]]].position;
+            const glm::vec3& d = vertices[globalIds[indices[t * 3 + 2]]].position;
+            glm::vec3 n = glm::cross(b - a, d - a);
+            float area = glm::length(n);
+            centroids[c] += (a + b + d) * (area / 3.0f);
+            normals[c] += n;
+            clusterArea += area;
+        }
+        meshCentroid += centroids[c];
+        meshArea += clusterArea;
+        centroids[c] = clusterArea > 0.0f ? centroids[c] / clusterArea : glm::vec3(0.0f);
+    }
+    if (meshArea > 0.0f) {
+        meshCentroid /= meshArea;
+    }
+
+    std::vector<float> sortKey(clusterCount);
+    for (std::size_t c = 0; c < clusterCount; ++c) {
+        float normalLength = glm::length(normals[c]);
+        glm::vec3 n = normalLength > 0.0f ? normals[c] / normalLength : glm::vec3(0.0f);
+        sortKey[c] = glm::dot(centroids[c] - meshCentroid, n);
+    }
+
+    std::vector<uint32_t> order(clusterCount);
+    std::iota(order.begin(), order.end(), 0u);
+    std::stable_sort(order.begin(), order.end(), [&](uint32_t a, uint32_t b) { return sortKey[a] > sortKey[b]; });
+
+    std::vector<uint32_t> output;
+    output.reserve(indices.size());
+    for (uint32_t c : order) {
+        output.insert(output.end(), indices.begin() + clusterStarts[c] * 3, indices.begin() + clusterStarts[c + 1] * 3);
+    }
+    indices.swap(output);
+}
+
+void OptimizeVertexFetch(ObjMesh& mesh) {
+    std::vector<uint32_t> remap(mesh.vertices.size(), kUnused);
+    std::vector<VertexPNT> reordered;
+    reordered.reserve(mesh.vertices.size());
+    std::vector<glm::vec4> reorderedTangents;
+    const bool hasTangents = !mesh.tangents.empty();
+    reorderedTangents.reserve(mesh.tangents.size());
+    for (uint32_t& index : mesh.indices) {
+        if (remap[index] == kUnused) {
+            remap[index] = static_cast<uint32_t>(reordered.size());
+            reordered.push_back(mesh.vertices[index]);
+            if (hasTangents) {
+                reorderedTangents.push_back(mesh.tangents[index]);
+            }
+        }
+        index = remap[index];
+    }
+    mesh.vertices.swap(reordered);
+    mesh.tangents.swap(reorderedTangents);
+}
+
+} // namespace
+
+VertexCacheStats AnalyzeVertexCache(std::span<const uint32_t> indices,
+                                    std::size_t vertexCount,
+                                    unsigned cacheSize) {
+    VertexCacheStats stats;
+    stats.triangles = indices.size() / 3;
+
+    // FIFO emulation: a vertex is resident while fewer than cacheSize misses
+    // happened since it was last loaded.
+    std::vector<uint32_t> timestamps(vertexCount, 0);
+    std::vector<char> seen(vertexCount, 0);
+    uint32_t time = cacheSize + 1;
+    for (uint32_t index : indices) {
+        if (time - timestamps[index] > cacheSize) {
+            timestamps[index] = time++;
+            ++stats.transformedVertices;
+        }
+        if (!seen[index]) {
+            seen[index] = 1;
+            ++stats.uniqueVertices;
+        }
+    }
+
+    if (stats.triangles > 0) {
+        stats.acmr = static_cast<float>(stats.transformedVertices) / static_cast<float>(stats.triangles);
+    }
+    if (stats.uniqueVertices > 0) {
+        stats.atvr = static_cast<float>(stats.transformedVertices) / static_cast<float>(stats.uniqueVertices);
+    }
+    return stats;
+}
+
+void OptimizeVertexCache(std::span<uint32_t> indices, std::size_t vertexCount) {
+    ChunkScratch scratch;
+    scratch.localIds.assign(vertexCount, kUnused);
+    std::span<uint32_t> range = indices.first(indices.size() - indices.size() % 3);
+    BuildLocalIndices(range, scratch);
+    OptimizeVertexCacheForsyth(scratch.localIndices, scratch.globalIds.size());
+    for (std::size_t i = 0; i < range.size(); ++i) {
+        range[i] = scratch.globalIds[scratch.localIndices[i]];
+    }
+}
+
+void OptimizeMesh(ObjMesh& mesh, const MeshOptimizeOptions& options, MeshOptimizeReport* report) {
+    constexpr unsigned kAnalysisCacheSize = 16;
+
+    if (report) {
+        report->before = AnalyzeVertexCache(mesh.indices, mesh.vertices.size(), kAnalysisCacheSize);
+        report->verticesBefore = mesh.vertices.size();
+    }
+
+    if (options.vertexCache || options.overdraw) {
+        std::vector<std::pair<uint32_t, uint32_t>> ranges;
+        for (const auto& chunk : mesh.chunks) {
+            ranges.emplace_back(chunk.startIndex, chunk.indexCount);
+        }
+        if (ranges.empty()) {
+            ranges.emplace_back(0u, static_cast<uint32_t>(mesh.indices.size()));
+        }
+
+        ChunkScratch scratch;
+        scratch.localIds.assign(mesh.vertices.size(), kUnused);
+        for (const auto& [start, count] : ranges) {
+            std::span<uint32_t> range(mesh.indices.data() + start, count - count % 3);
+            BuildLocalIndices(range, scratch);
+
+            if (options.vertexCache) {
+                OptimizeVertexCacheForsyth(scratch.localIndices, scratch.globalIds.size());
+            }
+            if (options.overdraw) {
+                OptimizeOverdraw(scratch.localIndices, scratch.globalIds, mesh.vertices, kAnalysisCacheSize);
+            }
+
+            for (std::size_t i = 0; i < range.size(); ++i) {
+                range[i] = scratch.globalIds[scratch.localIndices[i]];
+            }
+            ResetLocalIds(scratch);
+        }
+    }
+
+    if (options.vertexFetch) {
+        OptimizeVertexFetch(mesh);
+    }
+
+    if (report) {
+        report->after = AnalyzeVertexCache(mesh.indices, mesh.vertices.size(), kAnalysisCacheSize);
+        report->verticesAfter = mesh.vertices.size();
+    }
+}
@@ -0,0 +1,43 @@
+#pragma once
+
+#include "ObjLoader.hpp"
+
+#include <cstddef>
+#include <cstdint>
+#include <span>
+
+// Post-transform vertex cache behaviour of an index buffer, simulated with a
+// FIFO cache so it can be tracked without a GPU.
+struct VertexCacheStats {
+    std::size_t triangles = 0;
+    std::size_t uniqueVertices = 0;
+    std::size_t transformedVertices = 0;
+    float acmr = 0.0f; // transformed vertices per triangle (0.5 is ideal for regular grids, 3 is worst)
+    float atvr = 0.0f; // transformed vertices per unique vertex (1 is ideal)
+};
+
+VertexCacheStats AnalyzeVertexCache(std::span<const uint32_t> indices,
+                                    std::size_t vertexCount,
+                                    unsigned cacheSize = 16);
+
+struct MeshOptimizeOptions {
+    bool vertexCache = true; // Forsyth triangle reordering per chunk
+    bool overdraw = true;    // sort cache-friendly clusters front-to-back-ish per chunk
+    bool vertexFetch = true; // renumber vertices in first-use order, dropping unused ones
+};
+
+struct MeshOptimizeReport {
+    VertexCacheStats before;
+    VertexCacheStats after;
+    std::size_t verticesBefore = 0;
+    std::size_t verticesAfter = 0;
+};
+
+// Forsyth reordering of an arbitrary triangle list (e.g. a LOD range).
+void OptimizeVertexCache(std::span<uint32_t> indices, std::size_t vertexCount);
+
+// Reorders triangles inside each MeshChunk (chunk ranges and materials are
+// preserved) and remaps the vertex array for fetch locality.
+void OptimizeMesh(ObjMesh& mesh,
+                  const MeshOptimizeOptions& options = {},
+                  MeshOptimizeReport* report = nullptr);
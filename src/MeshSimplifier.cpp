@@ -0,0 +1,727 @@
+#include "MeshSimplifier.hpp"
+
+#include "MeshOptimizer.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <utility>
+
+namespace {
+
+constexpr uint32_t kUnused = 0xFFFFFFFFu;
+
+// Border planes are weighted well above surface planes so open edges and
+// attribute seams keep their outline.
+constexpr double kBorderWeight = 10.0;
+constexpr double kSeamWeight = 1.0;
+
+enum class VertexKind : uint8_t {
+    Manifold, // single vertex, closed fan: may collapse towards any neighbour
+    Border,   // on an open edge: only slides along the border
+    Seam,     // several vertices share the position: only slides along the seam
+    Locked,   // non-manifold or locked by the caller
+};
+
+struct Quadric {
+    double a2 = 0.0, b2 = 0.0, c2 = 0.0;
+    double ab = 0.0, ac = 0.0, bc = 0.0;
+    double ad = 0.0, bd = 0.0, cd = 0.0;
+    double d2 = 0.0;
+    double weight = 0.0;
+
+    // Plane a*x + b*y + c*z + d = 0 with unit normal (a, b, c).
+    void AddPlane(double a, double b, double c, double d, double w) {
+        a2 += w * a * a;
+        b2 += w * b * b;
+        c2 += w * c * c;
+        ab += w * a * b;
+        ac += w * a * c;
+        bc += w * b * c;
+        ad += w * a * d;
+        bd += w * b * d;
+        cd += w * c * d;
+        d2 += w * d * d;
+        weight += w;
+    }
+
+    void Add(const Quadric& other) {
+        a2 += other.a2;
+        b2 += other.b2;
+        c2 += other.c2;
+        ab += other.ab;
+        ac += other.ac;
+        bc += other.bc;
+        ad += other.ad;
+        bd += other.bd;
+        cd += other.cd;
+        d2 += other.d2;
+        weight += other.weight;
+    }
+
+    // Weighted mean squared distance to the accumulated planes.
+    double Evaluate(const glm::vec3& p) const {
+        if (weight <= 0.0) {
+            return 0.0;
+        }
+        double x = p.x, y = p.y, z = p.z;
+        double error = a2 * x * x + b2 * y * y + c2 * z * z + 2.0 * (ab * x * y + ac * x * z + bc * y * z) +
+                       2.0 * (ad * x + bd * y + cd * z) + d2;
+        return std::max(error, 0.0) / weight;
+    }
+};
+
+void AddPlaneQuadric(Quadric& quadric, const glm::vec3& normal, const glm::vec3& point, double weight) {
+    quadric.AddPlane(normal.x, normal.y, normal.z, -static_cast<double>(glm::dot(normal, point)), weight);
+}
+
+uint64_t EdgeKey(uint32_t a, uint32_t b) {
+    if (a > b) {
+        std::swap(a, b);
+    }
+    return (static_cast<uint64_t>(a) << 32) | b;
+}
+
+bool PositionLess(const glm::vec3& a, const glm::vec3& b) {
+    if (a.x != b.x) {
+        return a.x < b.x;
+    }
+    if (a.y != b.y) {
+        return a.y < b.y;
+    }
+    return a.z < b.z;
+}
+
+class Simplifier {
+public:
+    Simplifier(std::span<const VertexPNT> vertices, std::span<const uint32_t> indices, const SimplifyOptions& options)
+        : vertices_(vertices), options_(options) {
+        BuildLocalMesh(indices);
+        BuildQuadrics();
+    }
+
+    float Run(std::vector<uint32_t>& outIndices) {
+        const double maxErrorSq = static_cast<double>(options_.maxError) * options_.maxError;
+        double resultErrorSq = 0.0;
+
+        while (liveTriangles_ * 3 > options_.targetIndexCount) {
+            BuildTopology();
+            CollectCandidates();
+
+            std::size_t collapses = 0;
+            std::fill(touched_.begin(), touched_.end(), 0);
+            for (const Candidate& candidate : candidates_) {
+                if (liveTriangles_ * 3 <= options_.targetIndexCount || candidate.cost > maxErrorSq) {
+                    break;
+                }
+                if (touched_[candidate.from] || touched_[candidate.to]) {
+                    continue;
+                }
+                if (!PassesLinkCondition(candidate.from, candidate.to) || Flips(candidate.from, candidate.to) ||
+                    !BuildWedgeMap(candidate.from, candidate.to)) {
+                    continue;
+                }
+                Collapse(candidate.from, candidate.to);
+                resultErrorSq = std::max(resultErrorSq, candidate.cost);
+                ++collapses;
+            }
+            if (collapses == 0) {
+                break;
+            }
+        }
+
+        outIndices.clear();
+        outIndices.reserve(liveTriangles_ * 3);
+        for (std::size_t t = 0; t < alive_.size(); ++t) {
+            if (!alive_[t]) {
+                continue;
+            }
+            for (int k = 0; k < 3; ++k) {
+                outIndices.push_back(globalIds_[corners_[t * 3 + k]]);
+            }
+        }
+        return static_cast<float>(std::sqrt(resultErrorSq));
+    }
+
+private:
+    struct Candidate {
+        double cost;
+        uint32_t from;
+        uint32_t to;
+    };
+
+    std::span<const VertexPNT> vertices_;
+    const SimplifyOptions& options_;
+
+    // Vertices are renumbered 0..n-1 within the range; positions are welded
+    // so each local vertex has a representative `rep_` shared by its seam
+    // siblings. Topology, quadrics and collapses work on representatives.
+    std::vector<uint32_t> globalIds_;
+    std::vector<glm::vec3> positions_;
+    std::vector<uint32_t> rep_;
+    std::vector<uint8_t> lockedRep_;
+    std::vector<uint32_t> corners_;
+    std::vector<uint8_t> alive_;
+    std::size_t liveTriangles_ = 0;
+    std::vector<Quadric> quadrics_;
+
+    // Rebuilt every pass.
+    std::vector<uint64_t> edgeKeys_;
+    std::vector<uint32_t> edgeCounts_;
+    std::vector<VertexKind> kinds_;
+    std::vector<uint32_t> adjacencyOffsets_;
+    std::vector<uint32_t> adjacency_;
+    std::vector<Candidate> candidates_;
+    std::vector<uint8_t> touched_;
+
+    std::vector<uint32_t> linkStamp_;
+    uint32_t linkTime_ = 0;
+    std::vector<std::pair<uint32_t, uint32_t>> wedgeMap_;
+
+    uint32_t RepOf(uint32_t t, int k) const { return rep_[corners_[t * 3 + k]]; }
+
+    void BuildLocalMesh(std::span<const uint32_t> indices) {
+        const std::size_t indexCount = indices.size() - indices.size() % 3;
+        globalIds_.assign(indices.begin(), indices.begin() + static_cast<std::ptrdiff_t>(indexCount));
+        std::sort(globalIds_.begin(), globalIds_.end());
+        globalIds_.erase(std::unique(globalIds_.begin(), globalIds_.end()), globalIds_.end());
+
+        const std::size_t n = globalIds_.size();
+        positions_.resize(n);
+        for (std::size_t i = 0; i < n; ++i) {
+            positions_[i] = vertices_[globalIds_[i]].position;
+        }
+
+        corners_.resize(indexCount);
+        for (std::size_t i = 0; i < indexCount; ++i) {
+            auto it = std::lower_bound(globalIds_.begin(), globalIds_.end(), indices[i]);
+            corners_[i] = static_cast<uint32_t>(it - globalIds_.begin());
+        }
+
+        std::vector<uint32_t> order(n);
+        for (uint32_t i = 0; i < n; ++i) {
+            order[i] = i;
+        }
+        std::sort(order.begin(), order.end(), [&](uint32_t a, uint32_t b) {
+            return PositionLess(positions_[a], positions_[b]);
+        });
+        rep_.resize(n);
+        lockedRep_.assign(n, 0);
+        for (std::size_t i = 0; i < n;) {
+            std::size_t end = i + 1;
+            while (end < n && positions_[order[end]] == positions_[order[i]]) {
+                ++end;
+            }
+            uint32_t rep = *std::min_element(order.begin() + static_cast<std::ptrdiff_t>(i),
+                                             order.begin() + static_cast<std::ptrdiff_t>(end));
+            for (std::size_t j = i; j < end; ++j) {
+                rep_[order[j]] = rep;
+                if (!options_.lockedVertices.empty() && options_.lockedVertices[globalIds_[order[j]]]) {
+                    lockedRep_[rep] = 1;
+                }
+            }
+            i = end;
+        }
+
+        const std::size_t triangleCount = indexCount / 3;
+        alive_.assign(triangleCount, 1);
+        liveTriangles_ = triangleCount;
+        for (std::size_t t = 0; t < triangleCount; ++t) {
+            uint32_t a = RepOf(static_cast<uint32_t>(t), 0);
+            uint32_t b = RepOf(static_cast<uint32_t>(t), 1);
+            uint32_t c = RepOf(static_cast<uint32_t>(t), 2);
+            if (a == b || b == c || a == c) {
+                alive_[t] = 0;
+                --liveTriangles_;
+            }
+        }
+
+        touched_.resize(n);
+        linkStamp_.assign(n, 0);
+        kinds_.resize(n);
+    }
+
+    void BuildQuadrics() {
+        quadrics_.assign(positions_.size(), Quadric{});
+        BuildTopology();
+
+        for (std::size_t t = 0; t < alive_.size(); ++t) {
+            if (!alive_[t]) {
+                continue;
+            }
+            const uint32_t r[3] = {RepOf(static_cast<uint32_t>(t), 0), RepOf(static_cast<uint32_t>(t), 1),
+                                   RepOf(static_cast<uint32_t>(t), 2)};
+            const glm::vec3& p0 = positions_[r[0]];
+            glm::vec3 normal = glm::cross(positions_[r[1]] - p0, positions_[r[2]] - p0);
+            float length = glm::length(normal);
+            if (length <= 0.0f) {
+                continue;
+            }
+            normal /= length;
+            const double area = 0.5 * length;
+            for (uint32_t v : r) {
+                AddPlaneQuadric(quadrics_[v], normal, p0, area);
+            }
+
+            // Keep open borders and seams in place with planes through the
+            // edge, perpendicular to the triangle.
+            for (int k = 0; k < 3; ++k) {
+                uint32_t a = r[k];
+                uint32_t b = r[(k + 1) % 3];
+                double weight = 0.0;
+                if (EdgeCount(a, b) == 1) {
+                    weight = kBorderWeight;
+                } else if (IsSeamEdge(static_cast<uint32_t>(t), k)) {
+                    weight = kSeamWeight;
+                }
+                if (weight == 0.0) {
+                    continue;
+                }
+                glm::vec3 edge = positions_[b] - positions_[a];
+                glm::vec3 edgeNormal = glm::cross(edge, normal);
+                float edgeNormalLength = glm::length(edgeNormal);
+                if (edgeNormalLength <= 0.0f) {
+                    continue;
+                }
+                edgeNormal /= edgeNormalLength;
+                const double edgeWeight = weight * glm::dot(edge, edge);
+                AddPlaneQuadric(quadrics_[a], edgeNormal, positions_[a], edgeWeight);
+                AddPlaneQuadric(quadrics_[b], edgeNormal, positions_[a], edgeWeight);
+            }
+        }
+    }
+
+    void BuildTopology() {
+        const std::size_t n = positions_.size();
+
+        edgeKeys_.clear();
+        for (std::size_t t = 0; t < alive_.size(); ++t) {
+            if (!alive_[t]) {
+                continue;
+            }
+            for (int k = 0; k < 3; ++k) {
+                edgeKeys_.push_back(EdgeKey(RepOf(static_cast<uint32_t>(t), k), RepOf(static_cast<uint32_t>(t), (k + 1) % 3)));
+            }
+        }
+        std::sort(edgeKeys_.begin(), edgeKeys_.end());
+        edgeCounts_.clear();
+        std::size_t unique = 0;
+        for (std::size_t i = 0; i < edgeKeys_.size();) {
+            std::size_t end = i + 1;
+            while (end < edgeKeys_.size() && edgeKeys_[end] == edgeKeys_[i]) {
+                ++end;
+            }
+            edgeKeys_[unique++] = edgeKeys_[i];
+            edgeCounts_.push_back(static_cast<uint32_t>(end - i));
+            i = end;
+        }
+        edgeKeys_.resize(unique);
+
+        // Vertex kinds: a position used by two different vertices is a seam,
+        // open edges make a border and edges shared by 3+ triangles lock.
+        std::vector<uint32_t> firstVertex(n, kUnused);
+        std::fill(kinds_.begin(), kinds_.end(), VertexKind::Manifold);
+        for (std::size_t t = 0; t < alive_.size(); ++t) {
+            if (!alive_[t]) {
+                continue;
+            }
+            for (int k = 0; k < 3; ++k) {
+                uint32_t v = corners_[t * 3 + k];
+                uint32_t r = rep_[v];
+                if (firstVertex[r] == kUnused) {
+                    firstVertex[r] = v;
+                } else if (firstVertex[r] != v) {
+                    kinds_[r] = VertexKind::Seam;
+                }
+            }
+        }
+        for (std::size_t e = 0; e < edgeKeys_.size(); ++e) {
+            uint32_t a = static_cast<uint32_t>(edgeKeys_[e] >> 32);
+            uint32_t b = static_cast<uint32_t>(edgeKeys_[e] & 0xFFFFFFFFu);
+            if (edgeCounts_[e] > 2) {
+                kinds_[a] = VertexKind::Locked;
+                kinds_[b] = VertexKind::Locked;
+            } else if (edgeCounts_[e] == 1) {
+                for (uint32_t v : {a, b}) {
+                    if (kinds_[v] != VertexKind::Locked) {
+                        kinds_[v] = VertexKind::Border;
+                    }
+                }
+            }
+        }
+        for (std::size_t r = 0; r < n; ++r) {
+            if (lockedRep_[r]) {
+                kinds_[r] = VertexKind::Locked;
+            }
+        }
+
+        adjacencyOffsets_.assign(n + 1, 0);
+        for (std::size_t t = 0; t < alive_.size(); ++t) {
+            if (alive_[t]) {
+                for (int k = 0; k < 3; ++k) {
+                    ++adjacencyOffsets_[RepOf(static_cast<uint32_t>(t), k) + 1];
+                }
+            }
+        }
+        for (std::size_t r = 0; r < n; ++r) {
+            adjacencyOffsets_[r + 1] += adjacencyOffsets_[r];
+        }
+        adjacency_.resize(adjacencyOffsets_[n]);
+        std::vector<uint32_t> fill(adjacencyOffsets_.begin(), adjacencyOffsets_.end() - 1);
+        for (std::size_t t = 0; t < alive_.size(); ++t) {
+            if (alive_[t]) {
+                for (int k = 0; k < 3; ++k) {
+                    adjacency_[fill[RepOf(static_cast<uint32_t>(t), k)]++] = static_cast<uint32_t>(t);
+                }
+            }
+        }
+    }
+
+    uint32_t EdgeCount(uint32_t a, uint32_t b) const {
+        uint64_t key = EdgeKey(a, b);
+        auto it = std::lower_bound(edgeKeys_.begin(), edgeKeys_.end(), key);
+        if (it == edgeKeys_.end() || *it != key) {
+            return 0;
+        }
+        return edgeCounts_[static_cast<std::size_t>(it - edgeKeys_.begin())];
+    }
+
+    // True when the triangle across edge k uses different vertices for it.
+    bool IsSeamEdge(uint32_t t, int k) const {
+        uint32_t va = corners_[t * 3 + k];
+        uint32_t vb = corners_[t * 3 + (k + 1) % 3];
+        uint32_t a = rep_[va];
+        uint32_t b = rep_[vb];
+        for (uint32_t i = adjacencyOffsets_[a]; i < adjacencyOffsets_[a + 1]; ++i) {
+            uint32_t other = adjacency_[i];
+            if (other == t) {
+                continue;
+            }
+            for (int j = 0; j < 3; ++j) {
+                if (RepOf(other, j) == b) {
+                    for (int m = 0; m < 3; ++m) {
+                        uint32_t v = corners_[other * 3 + m];
+                        if ((rep_[v] == a && v != va) || (rep_[v] == b && v != vb)) {
+                            return true;
+                        }
+                    }
+                }
+            }
+        }
+        return false;
+    }
+
+    void CollectCandidates() {
+        candidates_.clear();
+        std::vector<Candidate> options;
+        for (uint32_t r = 0; r < positions_.size(); ++r) {
+            if (rep_[r] != r || kinds_[r] == VertexKind::Locked || adjacencyOffsets_[r] == adjacencyOffsets_[r + 1]) {
+                continue;
+            }
+
+            options.clear();
+            for (uint32_t i = adjacencyOffsets_[r]; i < adjacencyOffsets_[r + 1]; ++i) {
+                uint32_t t = adjacency_[i];
+                for (int k = 0; k < 3; ++k) {
+                    uint32_t q = RepOf(t, k);
+                    if (q == r) {
+                        continue;
+                    }
+                    if (kinds_[r] == VertexKind::Border && EdgeCount(r, q) != 1) {
+                        continue;
+                    }
+                    options.push_back({quadrics_[r].Evaluate(positions_[q]), r, q});
+                }
+            }
+            std::sort(options.begin(), options.end(), [](const Candidate& a, const Candidate& b) {
+                return a.cost < b.cost;
+            });
+            for (const Candidate& option : options) {
+                if (BuildWedgeMap(option.from, option.to)) {
+                    candidates_.push_back(option);
+                    break;
+                }
+            }
+        }
+        std::sort(candidates_.begin(), candidates_.end(), [](const Candidate& a, const Candidate& b) {
+            return a.cost < b.cost;
+        });
+    }
+
+    // Every vertex at `from` must map to the vertex at `to` it shares a
+    // triangle with; otherwise the collapse would tear an attribute seam.
+    bool BuildWedgeMap(uint32_t from, uint32_t to) {
+        wedgeMap_.clear();
+        for (uint32_t i = adjacencyOffsets_[from]; i < adjacencyOffsets_[from + 1]; ++i) {
+            uint32_t t = adjacency_[i];
+            uint32_t vFrom = kUnused;
+            uint32_t vTo = kUnused;
+            for (int k = 0; k < 3; ++k) {
+                uint32_t v = corners_[t * 3 + k];
+                if (rep_[v] == from) {
+                    vFrom = v;
+                } else if (rep_[v] == to) {
+                    vTo = v;
+                }
+            }
+            if (vTo == kUnused) {
+                continue;
+            }
+            auto it = std::find_if(wedgeMap_.begin(), wedgeMap_.end(), [&](const auto& entry) {
+                return entry.first == vFrom;
+            });
+            if (it == wedgeMap_.end()) {
+                wedgeMap_.emplace_back(vFrom, vTo);
+            } else if (it->second != vTo) {
+                return false;
+            }
+        }
+
+        for (uint32_t i = adjacencyOffsets_[from]; i < adjacencyOffsets_[from + 1]; ++i) {
+            uint32_t t = adjacency_[i];
+            for (int k = 0; k < 3; ++k) {
+                uint32_t v = corners_[t * 3 + k];
+                if (rep_[v] != from) {
+                    continue;
+                }
+                bool mapped = std::any_of(wedgeMap_.begin(), wedgeMap_.end(), [&](const auto& entry) {
+                    return entry.first == v;
+                });
+                if (!mapped) {
+                    return false;
+                }
+            }
+        }
+        return !wedgeMap_.empty();
+    }
+
+    // Neighbours common to both ends must be exactly the apexes of the
+    // triangles on the edge, or the collapse folds the surface onto itself.
+    bool PassesLinkCondition(uint32_t from, uint32_t to) {
+        ++linkTime_;
+        for (uint32_t i = adjacencyOffsets_[from]; i < adjacencyOffsets_[from + 1]; ++i) {
+            uint32_t t = adjacency_[i];
+            for (int k = 0; k < 3; ++k) {
+                linkStamp_[RepOf(t, k)] = linkTime_;
+            }
+        }
+
+        uint32_t shared = 0;
+        ++linkTime_;
+        for (uint32_t i = adjacencyOffsets_[to]; i < adjacencyOffsets_[to + 1]; ++i) {
+            uint32_t t = adjacency_[i];
+            for (int k = 0; k < 3; ++k) {
+                uint32_t r = RepOf(t, k);
+                if (r != from && r != to && linkStamp_[r] == linkTime_ - 1) {
+                    linkStamp_[r] = linkTime_;
+                    ++shared;
+                }
+            }
+        }
+        return shared <= EdgeCount(from, to);
+    }
+
+    bool Flips(uint32_t from, uint32_t to) const {
+        const glm::vec3& target = positions_[to];
+        for (uint32_t i = adjacencyOffsets_[from]; i < adjacencyOffsets_[from + 1]; ++i) {
+            uint32_t t = adjacency_[i];
+            glm::vec3 p[3];
+            glm::vec3 moved[3];
+            bool hasTarget = false;
+            for (int k = 0; k < 3; ++k) {
+                uint32_t r = RepOf(t, k);
+                hasTarget = hasTarget || r == to;
+                p[k] = positions_[r];
+                moved[k] = r == from ? target : p[k];
+            }
+            if (hasTarget) {
+                continue;
+            }
+            glm::vec3 before = glm::cross(p[1] - p[0], p[2] - p[0]);
+            glm::vec3 after = glm::cross(moved[1] - moved[0], moved[2] - moved[0]);
+            if (glm::dot(before, after) <= 0.0f) {
+                return true;
+            }
+        }
+        return false;
+    }
+
+    void Collapse(uint32_t from, uint32_t to) {
+        for (uint32_t i = adjacencyOffsets_[from]; i < adjacencyOffsets_[from + 1]; ++i) {
+            uint32_t t = adjacency_[i];
+            bool hasTarget = false;
+            for (int k = 0; k < 3; ++k) {
+                uint32_t r = RepOf(t, k);
+                touched_[r] = 1;
+                hasTarget = hasTarget || r == to;
+            }
+            if (hasTarget) {
+                alive_[t] = 0;
+                --liveTriangles_;
+                continue;
+            }
+            for (int k = 0; k < 3; ++k) {
+                uint32_t& v = corners_[t * 3 + k];
+                if (rep_[v] == from) {
+                    auto it = std::find_if(wedgeMap_.begin(), wedgeMap_.end(), [&](const auto& entry) {
+                        return entry.first == v;
+                    });
+                    v = it->second;
+                }
+            }
+        }
+        quadrics_[to].Add(quadrics_[from]);
+        touched_[from] = 1;
+        touched_[to] = 1;
+    }
+};
+
+void LockSharedChunkBorders(const ObjMesh& mesh, std::vector<uint8_t>& locked) {
+    constexpr uint32_t kShared = kUnused - 1;
+    locked.assign(mesh.vertices.size(), 0);
+    if (mesh.chunks.size() < 2) {
+        return;
+    }
+
+    std::vector<uint32_t> chunkOf(mesh.vertices.size(), kUnused);
+    for (uint32_t c = 0; c < mesh.chunks.size(); ++c) {
+        const MeshChunk& chunk = mesh.chunks[c];
+        for (uint32_t i = chunk.startIndex; i < chunk.startIndex + chunk.indexCount; ++i) {
+            uint32_t& owner = chunkOf[mesh.indices[i]];
+            owner = owner == kUnused || owner == c ? c : kShared;
+        }
+    }
+
+    std::vector<uint32_t> order(mesh.vertices.size());
+    for (uint32_t i = 0; i < order.size(); ++i) {
+        order[i] = i;
+    }
+    std::sort(order.begin(), order.end(), [&](uint32_t a, uint32_t b) {
+        return PositionLess(mesh.vertices[a].position, mesh.vertices[b].position);
+    });
+    for (std::size_t i = 0; i < order.size();) {
+        std::size_t end = i + 1;
+        while (end < order.size() && mesh.vertices[order[end]].position == mesh.vertices[order[i]].position) {
+            ++end;
+        }
+        uint32_t owner = kUnused;
+        bool shared = false;
+        for (std::size_t j = i; j < end; ++j) {
+            uint32_t c = chunkOf[order[j]];
+            if (c == kUnused) {
+                continue;
+            }
+            shared = shared || c == kShared || (owner != kUnused && owner != c);
+            owner = c;
+        }
+        if (shared) {
+            for (std::size_t j = i; j < end; ++j) {
+                locked[order[j]] = 1;
+            }
+        }
+        i = end;
+    }
+}
+
+} // namespace
+
+float SimplifyIndices(std::span<const VertexPNT> vertices,
+                      std::span<const uint32_t> indices,
+                      const SimplifyOptions& options,
+                      std::vector<uint32_t>& outIndices) {
+    Simplifier simplifier(vertices, indices, options);
+    return simplifier.Run(outIndices);
+}
+
+void GenerateMeshLods(ObjMesh& mesh, const MeshLodOptions& options, MeshLodReport* report) {
+    const BoundingSphere bounds = ComputeBoundingSphere(mesh.vertices);
+    const float errorBudget = options.maxRelativeError * bounds.radius;
+
+    std::vector<uint8_t> locked;
+    LockSharedChunkBorders(mesh, locked);
+
+    if (report) {
+        report->triangles.assign(1, 0);
+        report->errors.assign(1, 0.0f);
+    }
+
+    std::vector<uint32_t> previous;
+    std::vector<uint32_t> simplified;
+    for (MeshChunk& chunk : mesh.chunks) {
+        chunk.lods.clear();
+        if (report) {
+            report->triangles[0] += chunk.indexCount / 3;
+        }
+
+        previous.assign(mesh.indices.begin() + chunk.startIndex,
+                        mesh.indices.begin() + chunk.startIndex + chunk.indexCount);
+        float previousError = 0.0f;
+        for (unsigned level = 1; level <= options.maxLevels; ++level) {
+            SimplifyOptions simplifyOptions;
+            simplifyOptions.targetIndexCount =
+                static_cast<std::size_t>(static_cast<float>(previous.size() / 3) * options.reduction) * 3;
+            simplifyOptions.maxError = errorBudget - previousError;
+            simplifyOptions.lockedVertices = locked;
+            float error = SimplifyIndices(mesh.vertices, previous, simplifyOptions, simplified);
+
+            // Stop once a level no longer pays for its index memory.
+            if (simplified.empty() || simplified.size() * 10 > previous.size() * 9) {
+                break;
+            }
+            if (options.optimizeVertexCache) {
+                OptimizeVertexCache(simplified, mesh.vertices.size());
+            }
+
+            MeshLod lod;
+            lod.startIndex = static_cast<uint32_t>(mesh.indices.size());
+            lod.indexCount = static_cast<uint32_t>(simplified.size());
+            // Errors of successive levels add up at worst.
+            lod.error = previousError + error;
+            mesh.indices.insert(mesh.indices.end(), simplified.begin(), simplified.end());
+            chunk.lods.push_back(lod);
+
+            if (report) {
+                if (report->triangles.size() <= level) {
+                    report->triangles.push_back(0);
+                    report->errors.push_back(0.0f);
+                }
+                report->triangles[level] += lod.indexCount / 3;
+                report->errors[level] = std::max(report->errors[level], lod.error);
+            }
+
+            previousError = lod.error;
+            previous.swap(simplified);
+        }
+    }
+}
+
+LodSelector LodSelector::ForPerspective(float fovY, int viewportHeight, float maxPixelError) {
+    LodSelector selector;
+    selector.projectionScale = static_cast<float>(viewportHeight) / (2.0f * std::tan(fovY * 0.5f));
+    selector.maxPixelError = maxPixelError;
+    return selector;
+}
+
+float LodSelector::MaxObjectError(const glm::mat4& modelMatrix,
+                                  const BoundingSphere& bounds,
+                                  const glm::vec3& cameraPos) const {
+    const float scale = std::max({glm::length(glm::vec3(modelMatrix[0])), glm::length(glm::vec3(modelMatrix[1])),
+                                  glm::length(glm::vec3(modelMatrix[2]))});
+    if (scale <= 0.0f || projectionScale <= 0.0f) {
+        return 0.0f;
+    }
+    const glm::vec3 center = glm::vec3(modelMatrix * glm::vec4(bounds.center, 1.0f));
+    const float distance = glm::length(cameraPos - center) - bounds.radius * scale;
+    if (distance <= 0.0f) {
+        return 0.0f;
+    }
+    // error * scale * projectionScale / distance pixels on screen.
+    return maxPixelError * distance / (projectionScale * scale);
+}
+
+std::size_t SelectLod(std::span<const MeshLod> lods, float maxObjectError) {
+    std::size_t level = 0;
+    while (level < lods.size() && lods[level].error <= maxObjectError) {
+        ++level;
+    }
+    return level;
+}
@@ -0,0 +1,67 @@
+#pragma once
+
+#include "Bounds.hpp"
+#include "ObjLoader.hpp"
+
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <span>
+#include <vector>
+
+#include <glm/glm.hpp>
+
+struct SimplifyOptions {
+    std::size_t targetIndexCount = 0;
+    // Stop before any collapse whose quadric error exceeds this (object-space distance).
+    float maxError = std::numeric_limits<float>::max();
+    // Optional per-vertex flags (indexed like the vertex array). A position with
+    // any locked vertex never moves; used to keep borders shared with other
+    // chunks crack-free.
+    std::span<const uint8_t> lockedVertices;
+};
+
+// Quadric edge collapse of one index range. Collapses are half-edge (a vertex
+// moves onto a neighbour), so the result indexes the same vertex array and
+// can share the original vertex buffer. Attribute seams (one position with
+// several vertices) only collapse along the seam and open borders only along
+// the border. Returns the largest collapse error.
+float SimplifyIndices(std::span<const VertexPNT> vertices,
+                      std::span<const uint32_t> indices,
+                      const SimplifyOptions& options,
+                      std::vector<uint32_t>& outIndices);
+
+struct MeshLodOptions {
+    unsigned maxLevels = 4;       // coarser levels per chunk, in addition to the full-detail range
+    float reduction = 0.5f;       // target index count of each level relative to the previous one
+    float maxRelativeError = 0.05f; // error budget as a fraction of the mesh bounding radius
+    bool optimizeVertexCache = true;
+};
+
+struct MeshLodReport {
+    // Per level (0 is the source mesh): triangles summed over chunks and the
+    // largest chunk error.
+    std::vector<std::size_t> triangles;
+    std::vector<float> errors;
+};
+
+// Builds MeshChunk::lods for every chunk. LOD indices are appended to
+// mesh.indices after the full-detail ranges.
+void GenerateMeshLods(ObjMesh& mesh, const MeshLodOptions& options = {}, MeshLodReport* report = nullptr);
+
+// Converts an allowed on-screen error into the object-space error an instance
+// may show, measured at the point of its bounding sphere nearest the camera.
+struct LodSelector {
+    float projectionScale = 1.0f; // viewport height / (2 * tan(fovY / 2)), pixels per unit at distance 1
+    float maxPixelError = 1.0f;
+
+    static LodSelector ForPerspective(float fovY, int viewportHeight, float maxPixelError = 1.0f);
+
+    float MaxObjectError(const glm::mat4& modelMatrix,
+                         const BoundingSphere& bounds,
+                         const glm::vec3& cameraPos) const;
+};
+
+// Index of the coarsest level whose error fits maxObjectError; 0 is the
+// full-detail range and i > 0 is lods[i - 1].
+std::size_t SelectLod(std::span<const MeshLod> lods, float maxObjectError);
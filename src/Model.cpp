@@ -1,21 +1,265 @@
 #include "Model.hpp"
 
+#include "GlCalls.hpp"
+#include "Hash.hpp"
+#include "TangentGenerator.hpp"
 #include "TextureLoader.hpp"
+#include "ThreadPool.hpp"
 
+#include <algorithm>
+#include <chrono>
 #include <cstddef>
+#include <cstring>
+#include <limits>
 #include <unordered_map>
 
+namespace {
+
+using Clock = std::chrono::steady_clock;
+
+double MillisecondsSince(Clock::time_point start) {
+    return std::chrono::duration<double, std::milli>(Clock::now() - start).count();
+}
+
+// Occluders use the coarsest LOD whose error stays under this fraction of
+// the bounding radius, well below a texel of the occlusion buffer.
+constexpr float kOccluderMaxRelativeError = 0.01f;
+
+// Positions of the triangles to rasterize for occlusion, compacted to the
+// vertices they use.
+std::shared_ptr<const OccluderMesh> BuildOccluderMesh(const VertexPNT* vertices,
+                                                      std::size_t vertexCount,
+                                                      const uint32_t* indices,
+                                                      std::size_t indexCount,
+                                                      const std::vector<MeshChunk>& chunks,
+                                                      float maxError) {
+    auto occluder = std::make_shared<OccluderMesh>();
+    std::vector<uint32_t> remap(vertexCount, std::numeric_limits<uint32_t>::max());
+    auto addRange = [&](uint32_t start, uint32_t count) {
+        for (const uint32_t* index = indices + start; index != indices + start + count; ++index) {
+            uint32_t& mapped = remap[*index];
+            if (mapped == std::numeric_limits<uint32_t>::max()) {
+                mapped = static_cast<uint32_t>(occluder->positions.size());
+                occluder->positions.push_back(vertices[*index].position);
+            }
+            occluder->indices.push_back(mapped);
+        }
+    };
+    for (const MeshChunk& chunk : chunks) {
+        uint32_t start = chunk.startIndex;
+        uint32_t count = chunk.indexCount;
+        for (const MeshLod& lod : chunk.lods) {
+            if (lod.error <= maxError) {
+                start = lod.startIndex;
+                count = lod.indexCount;
+            }
+        }
+        addRange(start, count);
+    }
+    if (chunks.empty()) {
+        addRange(0, static_cast<uint32_t>(indexCount));
+    }
+    return occluder;
+}
+
+// BVH over the triangles drawn at full detail. LODs are appended after the
+// chunks, so those are a prefix of the index buffer.
+std::shared_ptr<const MeshBvh> BuildMeshBvh(const VertexPNT* vertices,
+                                            std::size_t vertexCount,
+                                            const uint32_t* indices,
+                                            std::size_t indexCount,
+                                            const std::vector<MeshChunk>& chunks,
+                                            const ModelLoadOptions& options) {
+    std::size_t end = chunks.empty() ? indexCount : 0;
+    for (const MeshChunk& chunk : chunks) {
+        end = std::max<std::size_t>(end, static_cast<std::size_t>(chunk.startIndex) + chunk.indexCount);
+    }
+    std::vector<glm::vec3> positions(vertexCount);
+    for (std::size_t i = 0; i < vertexCount; ++i) {
+        positions[i] = vertices[i].position;
+    }
+
+    auto bvh = std::make_shared<MeshBvh>();
+    const unsigned threadCount =
+        options.obj.threadCount == 0 ? ThreadPool::DefaultThreadCount() : options.obj.threadCount;
+    const std::span<const uint32_t> triangles(indices, std::min(end, indexCount));
+    if (threadCount > 1) {
+        ThreadPool pool(threadCount - 1);
+        bvh->Build(positions, triangles, options.bvh, &pool);
+    } else {
+        bvh->Build(positions, triangles, options.bvh);
+    }
+    return bvh;
+}
+
+bool HasNormalMap(const std::vector<MeshChunk>& chunks) {
+    return std::any_of(chunks.begin(), chunks.end(),
+                       [](const MeshChunk& chunk) { return !chunk.material.normalTexture.empty(); });
+}
+
+// Hash of every option that changes the mesh PrepareMesh() caches; a cache
+// built with a different key is rebuilt. Normal-mapped meshes get tangents
+// whatever generateTangents says, so only forcing them on counts.
+uint64_t MeshCacheKey(const ModelLoadOptions& options) {
+    uint64_t key = 0;
+    auto add = [&key](const auto& value) { key = hash::Bytes64(&value, sizeof(value), key); };
+    add(options.obj.generateTangents);
+    add(options.optimizeMesh);
+    if (options.optimizeMesh) {
+        add(options.optimize.vertexCache);
+        add(options.optimize.overdraw);
+        add(options.optimize.vertexFetch);
+    }
+    add(options.generateLods);
+    if (options.generateLods) {
+        add(options.lod.maxLevels);
+        add(options.lod.reduction);
+        add(options.lod.maxRelativeError);
+        add(options.lod.optimizeVertexCache);
+    }
+    return key;
+}
+
+} // namespace
+
+MaterialUniforms MakeMaterialUniforms(const MeshDrawCall& draw) {
+    MaterialUniforms material;
+    material.diffuseColor = draw.diffuseColor;
+    material.shininess = draw.shininess;
+    material.hasDiffuseMap = draw.hasDiffuse ? 1 : 0;
+    material.hasNormalMap = draw.hasNormalMap ? 1 : 0;
+    material.normalScale = draw.normalScale;
+    return material;
+}
+
 Model::~Model() {
     Destroy();
 }
 
 bool Model::LoadFromObj(const std::filesystem::path& objPath, std::string* errorMessage) {
-    ObjMesh mesh;
-    if (!LoadObjMesh(objPath, mesh, errorMessage)) {
+    return LoadFromObj(objPath, ModelLoadOptions{}, errorMessage);
+}
+
+bool Model::LoadFromObj(const std::filesystem::path& objPath,
+                        const ModelLoadOptions& options,
+                        std::string* errorMessage) {
+    PreparedMesh prepared;
+    return PrepareMesh(objPath, options, prepared, errorMessage) && LoadPrepared(prepared, options, errorMessage);
+}
+
+bool Model::PrepareMesh(const std::filesystem::path& objPath,
+                        const ModelLoadOptions& options,
+                        PreparedMesh& out,
+                        std::string* errorMessage) {
+    ModelLoadStats& stats = out.stats;
+    stats = ModelLoadStats{};
+    const auto loadStart = Clock::now();
+    const uint64_t cacheKey = MeshCacheKey(options);
+
+    if (options.useMeshCache) {
+        const auto cacheStart = Clock::now();
+        if (out.cache.Open(objPath, cacheKey, &stats.cacheMessage)) {
+            out.fromCache = true;
+            out.sources = out.cache.Sources();
+            stats.meshCacheHit = true;
+            stats.cacheMs = MillisecondsSince(cacheStart);
+            if (options.buildBvh) {
+                const auto bvhStart = Clock::now();
+                out.bvh = BuildMeshBvh(out.cache.Vertices(), out.cache.VertexCount(), out.cache.Indices(),
+                                       out.cache.IndexCount(), out.cache.Chunks(), options);
+                stats.bvhMs = MillisecondsSince(bvhStart);
+            }
+            stats.totalMs = MillisecondsSince(loadStart);
+            return true;
+        }
+        stats.cacheMs = MillisecondsSince(cacheStart);
+    }
+
+    ObjMesh& mesh = out.mesh;
+    ObjLoadStats objStats;
+    if (!LoadObjMesh(objPath, mesh, options.obj, errorMessage, &objStats)) {
         return false;
     }
+    stats.parseMs = objStats.parseMs;
+    stats.tangentMs = objStats.tangentMs;
+    if (mesh.tangents.empty() && HasNormalMap(mesh.chunks)) {
+        const auto tangentStart = Clock::now();
+        GenerateTangents(mesh);
+        stats.tangentMs = MillisecondsSince(tangentStart);
+    }
+    out.sources.clear();
+    out.sources.push_back(objPath.lexically_normal());
+    out.sources.insert(out.sources.end(), mesh.materialLibraries.begin(), mesh.materialLibraries.end());
+
+    if (options.optimizeMesh) {
+        const auto optimizeStart = Clock::now();
+        OptimizeMesh(mesh, options.optimize, &stats.optimizeReport);
+        stats.optimizeMs = MillisecondsSince(optimizeStart);
+        stats.optimized = true;
+    }
+
+    if (options.generateLods) {
+        const auto lodStart = Clock::now();
+        GenerateMeshLods(mesh, options.lod, &stats.lodReport);
+        stats.lodMs = MillisecondsSince(lodStart);
+        stats.lodsGenerated = true;
+    }
+
+    if (options.useMeshCache && !mesh.vertices.empty() && !mesh.indices.empty()) {
+        const auto cacheStart = Clock::now();
+        std::string cacheError;
+        if (MeshCacheFile::Write(objPath, mesh, cacheKey, &cacheError)) {
+            stats.cacheMessage = "Wrote mesh cache " + MeshCacheFile::PathFor(objPath).string();
+        } else {
+            stats.cacheMessage = cacheError;
+        }
+        stats.cacheMs += MillisecondsSince(cacheStart);
+    }
+
+    if (options.buildBvh) {
+        const auto bvhStart = Clock::now();
+        out.bvh = BuildMeshBvh(mesh.vertices.data(), mesh.vertices.size(), mesh.indices.data(), mesh.indices.size(),
+                               mesh.chunks, options);
+        stats.bvhMs = MillisecondsSince(bvhStart);
+    }
+    stats.totalMs = MillisecondsSince(loadStart);
+    return true;
+}
+
+bool Model::LoadPrepared(const PreparedMesh& prepared, const ModelLoadOptions& options, std::string* errorMessage) {
+    loadStats_ = prepared.stats;
+    textureService_ = options.textureService;
 
-    if (mesh.vertices.empty() || mesh.indices.empty()) {
+    const auto uploadStart = Clock::now();
+    bool uploaded = false;
+    if (prepared.fromCache) {
+        const MeshCacheFile& cache = prepared.cache;
+        uploaded = Upload(cache.Vertices(), cache.Tangents(), cache.VertexCount(), cache.Indices(), cache.IndexCount(),
+                          cache.Chunks(), options.vertexFormat, errorMessage);
+    } else {
+        const ObjMesh& mesh = prepared.mesh;
+        const glm::vec4* tangents = mesh.tangents.empty() ? nullptr : mesh.tangents.data();
+        uploaded = Upload(mesh.vertices.data(), tangents, mesh.vertices.size(), mesh.indices.data(),
+                          mesh.indices.size(), mesh.chunks, options.vertexFormat, errorMessage);
+    }
+    loadStats_.uploadMs = MillisecondsSince(uploadStart);
+    loadStats_.totalMs += loadStats_.uploadMs;
+    if (uploaded) {
+        sources_ = prepared.sources;
+        bvh_ = prepared.bvh;
+    }
+    return uploaded;
+}
+
+bool Model::Upload(const VertexPNT* vertices,
+                   const glm::vec4* tangents,
+                   std::size_t vertexCount,
+                   const uint32_t* indices,
+                   std::size_t indexCount,
+                   const std::vector<MeshChunk>& chunks,
+                   VertexFormat vertexFormat,
+                   std::string* errorMessage) {
+    if (vertexCount == 0 || indexCount == 0) {
         if (errorMessage) {
             *errorMessage = "OBJ file does not contain any drawable geometry.";
         }
@@ -24,47 +268,48 @@ bool Model::LoadFromObj(const std::filesystem::path& objPath, std::string* error
 
     Destroy();
 
+    bounds_ = ComputeBoundingSphere(std::span<const VertexPNT>(vertices, vertexCount));
+    box_ = ComputeBoundingBox(std::span<const VertexPNT>(vertices, vertexCount));
+    occluder_ = BuildOccluderMesh(vertices, vertexCount, indices, indexCount, chunks,
+                                  kOccluderMaxRelativeError * bounds_.radius);
+
     glGenVertexArrays(1, &vao_);
     glBindVertexArray(vao_);
 
-    glGenBuffers(1, &vbo_);
-    glBindBuffer(GL_ARRAY_BUFFER, vbo_);
-    glBufferData(GL_ARRAY_BUFFER,
-                 mesh.vertices.size() * sizeof(VertexPNT),
-                 mesh.vertices.data(),
-                 GL_STATIC_DRAW);
+    UploadVertices(vertices, vertexCount, vertexFormat);
+    if (tangents) {
+        UploadTangents(tangents, vertexCount, vertexFormat);
+    }
 
     glGenBuffers(1, &ebo_);
     glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, ebo_);
     glBufferData(GL_ELEMENT_ARRAY_BUFFER,
-                 mesh.indices.size() * sizeof(uint32_t),
-                 mesh.indices.data(),
+                 indexCount * sizeof(uint32_t),
+                 indices,
                  GL_STATIC_DRAW);
 
-    constexpr GLsizei stride = sizeof(VertexPNT);
-    glEnableVertexAttribArray(0);
-    glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, stride, reinterpret_cast<const void*>(offsetof(VertexPNT, position)));
-    glEnableVertexAttribArray(1);
-    glVertexAttribPointer(1, 3, GL_FLOAT, GL_FALSE, stride, reinterpret_cast<const void*>(offsetof(VertexPNT, normal)));
-    glEnableVertexAttribArray(2);
-    glVertexAttribPointer(2, 2, GL_FLOAT, GL_FALSE, stride, reinterpret_cast<const void*>(offsetof(VertexPNT, texCoord)));
-
     glBindVertexArray(0);
 
     draws_.clear();
     textures_.clear();
     std::unordered_map<std::string, GLuint> textureCache;
 
-    auto acquireTexture = [&](const std::filesystem::path& texPath, std::string& lastError) -> GLuint {
+    auto acquireTexture = [&](const std::filesystem::path& texPath,
+                              gfx::TextureColorSpace colorSpace,
+                              std::string& lastError) -> GLuint {
+        if (textureService_) {
+            return textureService_->Request(texPath, colorSpace);
+        }
+
         auto canonical = texPath.lexically_normal();
-        std::string key = canonical.string();
+        std::string key = canonical.string() + (colorSpace == gfx::TextureColorSpace::Linear ? "|linear" : "");
         auto cacheIt = textureCache.find(key);
         if (cacheIt != textureCache.end()) {
             return cacheIt->second;
         }
 
         GLuint texture = 0;
-        if (!gfx::LoadTexture2D(canonical, texture, &lastError)) {
+        if (!gfx::LoadTexture2D(canonical, texture, &lastError, colorSpace)) {
             return 0;
         }
 
@@ -74,7 +319,7 @@ bool Model::LoadFromObj(const std::filesystem::path& objPath, std::string* error
     };
 
     std::string textureError;
-    for (const auto& chunk : mesh.chunks) {
+    for (const auto& chunk : chunks) {
         if (chunk.indexCount == 0) {
             continue;
         }
@@ -83,9 +328,11 @@ bool Model::LoadFromObj(const std::filesystem::path& objPath, std::string* error
         draw.indexCount = chunk.indexCount;
         draw.diffuseColor = chunk.material.diffuseColor;
         draw.shininess = chunk.material.shininess;
+        draw.lods = chunk.lods;
+        draw.box = chunk.box.Empty() ? box_ : chunk.box; // meshes built without LoadObjMesh
 
         if (!chunk.material.diffuseTexture.empty()) {
-            GLuint tex = acquireTexture(chunk.material.diffuseTexture, textureError);
+            GLuint tex = acquireTexture(chunk.material.diffuseTexture, gfx::TextureColorSpace::Srgb, textureError);
             if (tex != 0) {
                 draw.diffuseTexture = tex;
                 draw.hasDiffuse = true;
@@ -94,43 +341,226 @@ bool Model::LoadFromObj(const std::filesystem::path& objPath, std::string* error
             }
         }
 
+        // Normal maps need the tangent frame; without it the vertex normal is used.
+        if (!chunk.material.normalTexture.empty() && tangents) {
+            GLuint tex = acquireTexture(chunk.material.normalTexture, gfx::TextureColorSpace::Linear, textureError);
+            if (tex != 0) {
+                draw.normalTexture = tex;
+                draw.hasNormalMap = true;
+                draw.normalScale = chunk.material.normalScale;
+            } else if (errorMessage && !textureError.empty()) {
+                *errorMessage = "Failed to load texture " + chunk.material.normalTexture.string() + ": " + textureError;
+            }
+        }
+
+        draw.features.Set(ShaderFeature::DiffuseMap, draw.hasDiffuse).Set(ShaderFeature::NormalMap, draw.hasNormalMap);
         draws_.push_back(draw);
     }
 
     if (draws_.empty()) {
         MeshDrawCall fallback;
         fallback.startIndex = 0;
-        fallback.indexCount = static_cast<uint32_t>(mesh.indices.size());
+        fallback.indexCount = static_cast<uint32_t>(indexCount);
+        fallback.box = box_;
         draws_.push_back(fallback);
     }
 
-    indexCount_ = mesh.indices.size();
+    // Group draws by shader variant so each program is bound once per frame.
+    std::stable_sort(draws_.begin(), draws_.end(), [](const MeshDrawCall& a, const MeshDrawCall& b) {
+        return a.features.Bits() < b.features.Bits();
+    });
+
+    const GLsizeiptr alignment = UniformBufferOffsetAlignment();
+    materialStride_ = (static_cast<GLsizeiptr>(sizeof(MaterialUniforms)) + alignment - 1) / alignment * alignment;
+    std::vector<uint8_t> materials(static_cast<std::size_t>(materialStride_) * draws_.size());
+    for (std::size_t i = 0; i < draws_.size(); ++i) {
+        const MaterialUniforms material = MakeMaterialUniforms(draws_[i]);
+        std::memcpy(materials.data() + i * static_cast<std::size_t>(materialStride_), &material, sizeof(material));
+    }
+    materialBuffer_.Create(static_cast<GLsizeiptr>(materials.size()), materials.data(), GL_STATIC_DRAW);
+
+    indexCount_ = indexCount;
+    ++revision_;
     return true;
 }
 
-void Model::Draw(const ShaderProgram& shader) const {
+void Model::UploadVertices(const VertexPNT* vertices, std::size_t vertexCount, VertexFormat vertexFormat) {
+    vertexFormat_ = vertexFormat;
+    quantization_ = QuantizationParams{};
+
+    glGenBuffers(1, &vbo_);
+    glBindBuffer(GL_ARRAY_BUFFER, vbo_);
+
+    if (vertexFormat == VertexFormat::Packed) {
+        std::span<const VertexPNT> source(vertices, vertexCount);
+        quantization_ = ComputeQuantizationParams(source);
+        std::vector<VertexPacked> packed;
+        QuantizeVertices(source, quantization_, packed, &loadStats_.quantizationError);
+        loadStats_.quantized = true;
+
+        glBufferData(GL_ARRAY_BUFFER, packed.size() * sizeof(VertexPacked), packed.data(), GL_STATIC_DRAW);
+    } else {
+        glBufferData(GL_ARRAY_BUFFER,
+                     vertexCount * sizeof(VertexPNT),
+                     vertices,
+                     GL_STATIC_DRAW);
+    }
+    vertexCount_ = vertexCount;
+    BindVertexAttributes(vertexFormat);
+}
+
+void Model::BindVertexAttributes(VertexFormat vertexFormat) {
+    if (vertexFormat == VertexFormat::Packed) {
+        constexpr GLsizei stride = sizeof(VertexPacked);
+        glEnableVertexAttribArray(0);
+        glVertexAttribPointer(0, 3, GL_UNSIGNED_SHORT, GL_TRUE, stride, reinterpret_cast<const void*>(offsetof(VertexPacked, position)));
+        glEnableVertexAttribArray(1);
+        glVertexAttribPointer(1, 2, GL_SHORT, GL_TRUE, stride, reinterpret_cast<const void*>(offsetof(VertexPacked, normal)));
+        glEnableVertexAttribArray(2);
+        glVertexAttribPointer(2, 2, GL_HALF_FLOAT, GL_FALSE, stride, reinterpret_cast<const void*>(offsetof(VertexPacked, texCoord)));
+        return;
+    }
+
+    constexpr GLsizei stride = sizeof(VertexPNT);
+    glEnableVertexAttribArray(0);
+    glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, stride, reinterpret_cast<const void*>(offsetof(VertexPNT, position)));
+    glEnableVertexAttribArray(1);
+    glVertexAttribPointer(1, 3, GL_FLOAT, GL_FALSE, stride, reinterpret_cast<const void*>(offsetof(VertexPNT, normal)));
+    glEnableVertexAttribArray(2);
+    glVertexAttribPointer(2, 2, GL_FLOAT, GL_FALSE, stride, reinterpret_cast<const void*>(offsetof(VertexPNT, texCoord)));
+}
+
+void Model::UploadTangents(const glm::vec4* tangents, std::size_t vertexCount, VertexFormat vertexFormat) {
+    glGenBuffers(1, &tangentVbo_);
+    glBindBuffer(GL_ARRAY_BUFFER, tangentVbo_);
+
+    if (vertexFormat == VertexFormat::Packed) {
+        std::vector<uint32_t> packed(vertexCount);
+        for (std::size_t i = 0; i < vertexCount; ++i) {
+            packed[i] = PackTangent(tangents[i]);
+        }
+        glBufferData(GL_ARRAY_BUFFER, packed.size() * sizeof(uint32_t), packed.data(), GL_STATIC_DRAW);
+    } else {
+        glBufferData(GL_ARRAY_BUFFER, vertexCount * sizeof(glm::vec4), tangents, GL_STATIC_DRAW);
+    }
+    BindTangentAttribute(vertexFormat);
+}
+
+void Model::BindTangentAttribute(VertexFormat vertexFormat) {
+    glEnableVertexAttribArray(3);
+    if (vertexFormat == VertexFormat::Packed) {
+        glVertexAttribPointer(3, 4, GL_INT_2_10_10_10_REV, GL_TRUE, TangentStride(vertexFormat), nullptr);
+        return;
+    }
+    glVertexAttribPointer(3, 4, GL_FLOAT, GL_FALSE, TangentStride(vertexFormat), nullptr);
+}
+
+ModelGeometry Model::Geometry() const {
+    ModelGeometry geometry;
+    geometry.vertexBuffer = vbo_;
+    geometry.tangentBuffer = tangentVbo_;
+    geometry.indexBuffer = ebo_;
+    geometry.vertexCount = vertexCount_;
+    geometry.indexCount = indexCount_;
+    geometry.vertexFormat = vertexFormat_;
+    geometry.quantization = quantization_;
+    return geometry;
+}
+
+void Model::RequestShaderVariants(ShaderVariants& shaders) const {
+    for (const MeshDrawCall& draw : draws_) {
+        shaders.Request(draw.features);
+    }
+}
+
+void Model::Draw(const ShaderVariants& shaders, const glm::mat4& modelMatrix, float maxObjectError) const {
+    Draw(shaders, MakeInstanceTransform(modelMatrix), maxObjectError);
+}
+
+void Model::Draw(const ShaderVariants& shaders, const InstanceTransform& transform, float maxObjectError) const {
     if (vao_ == 0 || indexCount_ == 0) {
         return;
     }
+    gl::BindVertexArray(vao_);
+    DrawChunks(shaders, &transform, 0, maxObjectError);
+}
 
-    glBindVertexArray(vao_);
-    for (const auto& draw : draws_) {
-        shader.SetVec3("uMaterial.diffuseColor", draw.diffuseColor);
-        shader.SetFloat("uMaterial.shininess", draw.shininess);
-        shader.SetInt("uMaterial.hasDiffuseMap", draw.hasDiffuse ? 1 : 0);
+void Model::DrawInstanced(const ShaderVariants& shaders, const InstanceBuffer& instances, float maxObjectError) const {
+    if (vao_ == 0 || indexCount_ == 0 || instances.Count() == 0) {
+        return;
+    }
+    gl::BindVertexArray(vao_);
+    if (instanceAttributes_ != instances.Handle() || instanceAttributesOffset_ != instances.Offset()) {
+        instances.BindAttributes();
+        instanceAttributes_ = instances.Handle();
+        instanceAttributesOffset_ = instances.Offset();
+    }
+    DrawChunks(shaders, nullptr, instances.Count(), maxObjectError);
+}
+
+void Model::DrawChunks(const ShaderVariants& shaders,
+                       const InstanceTransform* transform,
+                       GLsizei instanceCount,
+                       float maxObjectError) const {
+    // Textures are only rebound when they change between draws.
+    GLuint boundTextures[2] = {0, 0};
+    GLuint activeUnit = 0;
+    auto bindTexture = [&](TextureUnit textureUnit, GLuint texture) {
+        const GLuint unit = static_cast<GLuint>(textureUnit);
+        if (boundTextures[unit] == texture) {
+            return;
+        }
+        if (activeUnit != unit) {
+            gl::ActiveTexture(GL_TEXTURE0 + unit);
+            activeUnit = unit;
+        }
+        gl::BindTexture(GL_TEXTURE_2D, texture);
+        boundTextures[unit] = texture;
+    };
+
+    // Uniforms are per program, so the object's are set on every switch.
+    const ShaderProgram* boundShader = nullptr;
+    for (std::size_t i = 0; i < draws_.size(); ++i) {
+        const MeshDrawCall& draw = draws_[i];
+        const ShaderProgram& shader = shaders.Get(draw.features);
+        if (&shader != boundShader) {
+            shader.Use();
+            if (transform) {
+                shader.SetMat4("uModel", transform->model);
+                shader.SetMat3("uNormalMatrix", transform->normal);
+            }
+            shader.SetVec3("uPositionOffset", quantization_.positionOffset);
+            shader.SetVec3("uPositionScale", quantization_.positionScale);
+            shader.SetInt("uOctahedralNormals", vertexFormat_ == VertexFormat::Packed ? 1 : 0);
+            boundShader = &shader;
+        }
+        materialBuffer_.BindRange(UniformBlock::Material, static_cast<GLintptr>(i) * materialStride_,
+                                  sizeof(MaterialUniforms));
         if (draw.hasDiffuse) {
-            glActiveTexture(GL_TEXTURE0);
-            glBindTexture(GL_TEXTURE_2D, draw.diffuseTexture);
+            bindTexture(TextureUnit::Diffuse, draw.diffuseTexture);
+        }
+        if (draw.hasNormalMap) {
+            bindTexture(TextureUnit::Normal, draw.normalTexture);
         }
 
-        const void* offsetPtr = reinterpret_cast<const void*>(static_cast<uintptr_t>(draw.startIndex) * sizeof(uint32_t));
-        glDrawElements(GL_TRIANGLES, draw.indexCount, GL_UNSIGNED_INT, offsetPtr);
+        uint32_t startIndex = draw.startIndex;
+        uint32_t indexCount = draw.indexCount;
+        if (std::size_t level = SelectLod(draw.lods, maxObjectError); level > 0) {
+            startIndex = draw.lods[level - 1].startIndex;
+            indexCount = draw.lods[level - 1].indexCount;
+        }
 
-        if (draw.hasDiffuse) {
-            glBindTexture(GL_TEXTURE_2D, 0);
+        const void* offsetPtr = reinterpret_cast<const void*>(static_cast<uintptr_t>(startIndex) * sizeof(uint32_t));
+        if (transform) {
+            gl::DrawElements(GL_TRIANGLES, indexCount, GL_UNSIGNED_INT, offsetPtr);
+        } else {
+            gl::DrawElementsInstanced(GL_TRIANGLES, indexCount, GL_UNSIGNED_INT, offsetPtr, instanceCount);
         }
     }
-    glBindVertexArray(0);
+    if (activeUnit != 0) {
+        gl::ActiveTexture(GL_TEXTURE0);
+    }
+    gl::BindVertexArray(0);
 }
 
 void Model::Destroy() {
@@ -139,6 +569,8 @@ void Model::Destroy() {
     }
     textures_.clear();
     draws_.clear();
+    sources_.clear();
+    materialBuffer_.Destroy();
     indexCount_ = 0;
 
     if (ebo_ != 0) {
@@ -149,9 +581,18 @@ void Model::Destroy() {
         glDeleteBuffers(1, &vbo_);
         vbo_ = 0;
     }
+    if (tangentVbo_ != 0) {
+        glDeleteBuffers(1, &tangentVbo_);
+        tangentVbo_ = 0;
+    }
     if (vao_ != 0) {
         glDeleteVertexArrays(1, &vao_);
         vao_ = 0;
     }
+    instanceAttributes_ = 0;
+    instanceAttributesOffset_ = 0;
+    vertexCount_ = 0;
+    occluder_.reset();
+    bvh_.reset();
 }
 
@@ -1,10 +1,77 @@
 #pragma once
 
+#include "Bounds.hpp"
+#include "InstanceBuffer.hpp"
+#include "MeshBvh.hpp"
+#include "MeshCache.hpp"
+#include "MeshOptimizer.hpp"
+#include "MeshSimplifier.hpp"
 #include "ObjLoader.hpp"
+#include "OcclusionCuller.hpp"
 #include "ShaderProgram.hpp"
+#include "ShaderVariants.hpp"
+#include "TextureService.hpp"
+#include "UniformBuffers.hpp"
+#include "VertexQuantization.hpp"
 
+#include <memory>
+#include <string>
 #include <vector>
 
+struct ModelLoadOptions {
+    ObjLoadOptions obj;
+    // Reuse (and refresh) the binary mesh cache stored next to the OBJ.
+    bool useMeshCache = true;
+    // Reorder triangles/vertices for GPU cache locality after parsing. The
+    // cache stores the optimised mesh, so this is only paid on a cache miss.
+    bool optimizeMesh = false;
+    MeshOptimizeOptions optimize;
+    // Append simplified index ranges per chunk for distance-based LOD.
+    bool generateLods = false;
+    MeshLodOptions lod;
+    // Keep a BVH over the full-detail triangles for ray picking. Built on
+    // every load, cached or not, using options.obj.threadCount threads.
+    bool buildBvh = false;
+    BvhBuildOptions bvh;
+    // GPU vertex layout; Packed halves vertex memory at a small precision cost.
+    VertexFormat vertexFormat = VertexFormat::Float32;
+    // When set, textures decode in the background and draws use a placeholder
+    // until they arrive. The service owns those textures and must outlive the model.
+    gfx::TextureService* textureService = nullptr;
+};
+
+struct ModelLoadStats {
+    bool meshCacheHit = false;
+    double parseMs = 0.0;
+    double tangentMs = 0.0;
+    double optimizeMs = 0.0;
+    bool optimized = false;
+    MeshOptimizeReport optimizeReport;
+    double lodMs = 0.0;
+    bool lodsGenerated = false;
+    MeshLodReport lodReport;
+    double cacheMs = 0.0;
+    double bvhMs = 0.0;
+    double uploadMs = 0.0;
+    bool quantized = false;
+    QuantizationError quantizationError;
+    double totalMs = 0.0;
+    std::string cacheMessage;
+};
+
+// CPU half of a model load: the mapped mesh cache on a hit, the parsed and
+// processed OBJ otherwise. Building it touches no GL state, so it can run
+// on a worker thread.
+struct PreparedMesh {
+    bool fromCache = false;
+    MeshCacheFile cache;
+    ObjMesh mesh;
+    // The OBJ followed by its MTL files.
+    std::vector<std::filesystem::path> sources;
+    std::shared_ptr<const MeshBvh> bvh; // when ModelLoadOptions::buildBvh
+    ModelLoadStats stats;
+};
+
 struct MeshDrawCall {
     uint32_t startIndex = 0;
     uint32_t indexCount = 0;
@@ -12,6 +79,27 @@ struct MeshDrawCall {
     float shininess = 32.0f;
     GLuint diffuseTexture = 0;
     bool hasDiffuse = false;
+    GLuint normalTexture = 0;
+    bool hasNormalMap = false;
+    float normalScale = 1.0f;
+    ShaderFeatures features; // which ShaderVariants program draws it
+    std::vector<MeshLod> lods;
+    BoundingBox box; // object space
+};
+
+// The MaterialBlock contents for a draw.
+MaterialUniforms MakeMaterialUniforms(const MeshDrawCall& draw);
+
+// A loaded model's GPU buffers, for renderers that merge the geometry of
+// several models (see BatchRenderer).
+struct ModelGeometry {
+    GLuint vertexBuffer = 0;  // VertexPNT or VertexPacked, per vertexFormat
+    GLuint tangentBuffer = 0; // vec4 or packed 2_10_10_10; 0 without tangents
+    GLuint indexBuffer = 0;   // uint32 indices
+    std::size_t vertexCount = 0;
+    std::size_t indexCount = 0;
+    VertexFormat vertexFormat = VertexFormat::Float32;
+    QuantizationParams quantization;
 };
 
 class Model {
@@ -23,15 +111,107 @@ public:
     Model& operator=(const Model&) = delete;
 
     bool LoadFromObj(const std::filesystem::path& objPath, std::string* errorMessage = nullptr);
-    void Draw(const ShaderProgram& shader) const;
+    bool LoadFromObj(const std::filesystem::path& objPath,
+                     const ModelLoadOptions& options,
+                     std::string* errorMessage = nullptr);
+    // LoadFromObj() in two steps: PrepareMesh() parses, optimizes and
+    // caches without GL; LoadPrepared() uploads on the GL thread, replacing
+    // whatever the model held.
+    static bool PrepareMesh(const std::filesystem::path& objPath,
+                            const ModelLoadOptions& options,
+                            PreparedMesh& out,
+                            std::string* errorMessage = nullptr);
+    bool LoadPrepared(const PreparedMesh& prepared,
+                      const ModelLoadOptions& options,
+                      std::string* errorMessage = nullptr);
+    // Queues the shader variants this model's materials need.
+    void RequestShaderVariants(ShaderVariants& shaders) const;
+    // Each draw uses its material's variant (the generic program until that
+    // is ready) and the coarsest LOD whose error is within maxObjectError
+    // (see LodSelector); 0 allows no error. Materials come from the
+    // MaterialBlock uniform buffer; the caller provides FrameBlock.
+    void Draw(const ShaderVariants& shaders, const glm::mat4& modelMatrix, float maxObjectError = 0.0f) const;
+    // With the normal matrix already known, e.g. from a SceneGraph.
+    void Draw(const ShaderVariants& shaders, const InstanceTransform& transform, float maxObjectError = 0.0f) const;
+    // One glDrawElementsInstanced per chunk over every transform in
+    // `instances`, with `shaders` built with the INSTANCED define. All
+    // instances share one LOD, so pass the error allowed for the nearest.
+    void DrawInstanced(const ShaderVariants& shaders,
+                       const InstanceBuffer& instances,
+                       float maxObjectError = 0.0f) const;
     void Destroy();
 
+    // Points attributes 0-2 (or 3, the tangent) of the bound vertex array at
+    // the buffer bound to GL_ARRAY_BUFFER, laid out as vertexFormat.
+    static void BindVertexAttributes(VertexFormat vertexFormat);
+    static void BindTangentAttribute(VertexFormat vertexFormat);
+    static constexpr GLsizei VertexStride(VertexFormat vertexFormat) {
+        return vertexFormat == VertexFormat::Packed ? sizeof(VertexPacked) : sizeof(VertexPNT);
+    }
+    static constexpr GLsizei TangentStride(VertexFormat vertexFormat) {
+        return vertexFormat == VertexFormat::Packed ? sizeof(uint32_t) : sizeof(glm::vec4);
+    }
+
+    ModelGeometry Geometry() const;
+    // Sorted by shader variant; MaterialUniforms are built from these.
+    const std::vector<MeshDrawCall>& DrawCalls() const { return draws_; }
+    // Bumped by every successful load, so copies of the geometry can tell
+    // they are stale.
+    uint32_t Revision() const { return revision_; }
+
+    const ModelLoadStats& LoadStats() const { return loadStats_; }
+    const BoundingSphere& Bounds() const { return bounds_; }
+    const BoundingBox& Box() const { return box_; }
+    // Triangles for OcclusionCuller; replaced, not modified, on reload, so
+    // an occlusion pass may keep using the old one.
+    const std::shared_ptr<const OccluderMesh>& OcclusionMesh() const { return occluder_; }
+    // Object-space BVH over the full-detail triangles when loaded with
+    // buildBvh, else null. Hit triangle t is indices 3t..3t+2 of the index buffer.
+    const std::shared_ptr<const MeshBvh>& Bvh() const { return bvh_; }
+    // Files the loaded mesh was built from: the OBJ, then its MTL files.
+    const std::vector<std::filesystem::path>& Sources() const { return sources_; }
+
 private:
     GLuint vao_ = 0;
     GLuint vbo_ = 0;
+    GLuint tangentVbo_ = 0;
     GLuint ebo_ = 0;
     std::vector<MeshDrawCall> draws_;
+    // MaterialUniforms for every draw, materialStride_ bytes apart, written
+    // once at load and selected per draw with glBindBufferRange.
+    UniformBuffer materialBuffer_;
+    GLsizeiptr materialStride_ = 0;
     std::vector<GLuint> textures_;
     std::size_t indexCount_ = 0;
+    std::size_t vertexCount_ = 0;
+    uint32_t revision_ = 0;
+    VertexFormat vertexFormat_ = VertexFormat::Float32;
+    QuantizationParams quantization_;
+    BoundingSphere bounds_;
+    BoundingBox box_;
+    std::shared_ptr<const OccluderMesh> occluder_;
+    std::shared_ptr<const MeshBvh> bvh_;
+    gfx::TextureService* textureService_ = nullptr;
+    ModelLoadStats loadStats_;
+    std::vector<std::filesystem::path> sources_;
+    // Instance buffer (and offset into it) vao_'s attributes point at.
+    mutable GLuint instanceAttributes_ = 0;
+    mutable GLintptr instanceAttributesOffset_ = 0;
+
+    // Shared by Draw() and DrawInstanced(); transform is null for the latter.
+    void DrawChunks(const ShaderVariants& shaders,
+                    const InstanceTransform* transform,
+                    GLsizei instanceCount,
+                    float maxObjectError) const;
+    bool Upload(const VertexPNT* vertices,
+                const glm::vec4* tangents,
+                std::size_t vertexCount,
+                const uint32_t* indices,
+                std::size_t indexCount,
+                const std::vector<MeshChunk>& chunks,
+                VertexFormat vertexFormat,
+                std::string* errorMessage);
+    void UploadVertices(const VertexPNT* vertices, std::size_t vertexCount, VertexFormat vertexFormat);
+    void UploadTangents(const glm::vec4* tangents, std::size_t vertexCount, VertexFormat vertexFormat);
 };
 
@@ -1,93 +1,173 @@
 #include "ObjLoader.hpp"
 
+#include "MappedFile.hpp"
+#include "TangentGenerator.hpp"
+#include "ThreadPool.hpp"
+#include "VertexDedupTable.hpp"
+
 #include <algorithm>
-#include <fstream>
-#include <sstream>
+#include <charconv>
+#include <cmath>
+#include <chrono>
+#include <cstring>
+#include <span>
+#include <string_view>
 #include <unordered_map>
 
 #include <glm/geometric.hpp>
 
 namespace {
 
-struct VertexKey {
+int ResolveIndex(int idx, std::size_t count) {
+    if (idx > 0) {
+        int resolved = idx - 1;
+        return (resolved >= 0 && static_cast<std::size_t>(resolved) < count) ? resolved : -1;
+    }
+    if (idx < 0) {
+        int resolved = static_cast<int>(count) + idx;
+        return (resolved >= 0 && static_cast<std::size_t>(resolved) < count) ? resolved : -1;
+    }
+    return -1;
+}
+
+struct FaceCorner {
     int position = 0;
     int texCoord = 0;
     int normal = 0;
+};
 
-    bool operator==(const VertexKey& other) const {
-        return position == other.position &&
-               texCoord == other.texCoord &&
-               normal == other.normal;
+bool IsSpace(char c) {
+    return c == ' ' || c == '\t' || c == '\r' || c == '\v' || c == '\f';
+}
+
+// Walks one line of a mapped file without copying it. Number parsing is
+// sticky on failure, mirroring how chained stream extraction behaves.
+class LineTokenizer {
+public:
+    LineTokenizer(const char* begin, const char* end) : cursor_(begin), end_(end) {}
+
+    std::string_view Next() {
+        SkipSpace();
+        const char* start = cursor_;
+        while (cursor_ < end_ && !IsSpace(*cursor_)) {
+            ++cursor_;
+        }
+        return {start, static_cast<std::size_t>(cursor_ - start)};
     }
-};
 
-struct VertexKeyHasher {
-    std::size_t operator()(const VertexKey& key) const {
-        std::size_t seed = static_cast<std::size_t>(key.position);
-        seed ^= static_cast<std::size_t>(key.texCoord) + 0x9e3779b9 + (seed << 6) + (seed >> 2);
-        seed ^= static_cast<std::size_t>(key.normal) + 0x9e3779b9 + (seed << 6) + (seed >> 2);
-        return seed;
+    template <typename T>
+    LineTokenizer& operator>>(T& value) {
+        if (failed_) {
+            return *this;
+        }
+        SkipSpace();
+        const char* start = cursor_;
+        if (start < end_ && *start == '+') {
+            ++start;
+        }
+        auto [ptr, ec] = std::from_chars(start, end_, value);
+        if (ec != std::errc()) {
+            // Like istringstream: a failed extraction stores zero.
+            value = T{};
+            failed_ = true;
+            return *this;
+        }
+        cursor_ = ptr;
+        return *this;
+    }
+
+private:
+    const char* cursor_;
+    const char* end_;
+    bool failed_ = false;
+
+    void SkipSpace() {
+        while (cursor_ < end_ && IsSpace(*cursor_)) {
+            ++cursor_;
+        }
     }
 };
 
-int ResolveIndex(int idx, std::size_t count) {
-    if (idx > 0) {
-        int resolved = idx - 1;
-        return (resolved >= 0 && static_cast<std::size_t>(resolved) < count) ? resolved : -1;
+// Calls onLine(begin, end) for every line in [data, data + size).
+template <typename Fn>
+void ForEachLine(const char* data, std::size_t size, Fn&& onLine) {
+    const char* cursor = data;
+    const char* fileEnd = data + size;
+    while (cursor < fileEnd) {
+        const void* newline = std::memchr(cursor, '\n', static_cast<std::size_t>(fileEnd - cursor));
+        const char* lineEnd = newline ? static_cast<const char*>(newline) : fileEnd;
+        onLine(cursor, lineEnd);
+        cursor = newline ? lineEnd + 1 : fileEnd;
     }
-    if (idx < 0) {
-        int resolved = static_cast<int>(count) + idx;
-        return (resolved >= 0 && static_cast<std::size_t>(resolved) < count) ? resolved : -1;
+}
+
+int ParseIndex(std::string_view text) {
+    const char* begin = text.data();
+    const char* end = begin + text.size();
+    if (begin < end && *begin == '+') {
+        ++begin;
     }
-    return -1;
+    int value = 0;
+    auto [ptr, ec] = std::from_chars(begin, end, value);
+    (void)ptr;
+    return ec == std::errc() ? value : 0;
 }
 
-bool ParseFaceToken(const std::string& token, int& v, int& t, int& n) {
-    v = t = n = 0;
+// Splits "v", "v/t", "v//n" or "v/t/n". Malformed parts parse as 0, which
+// ResolveIndex later rejects.
+FaceCorner ParseFaceCorner(std::string_view token) {
+    FaceCorner corner;
     std::size_t firstSlash = token.find('/');
-    if (firstSlash == std::string::npos) {
-        v = std::stoi(token);
-        return true;
+    if (firstSlash == std::string_view::npos) {
+        corner.position = ParseIndex(token);
+        return corner;
     }
 
+    corner.position = ParseIndex(token.substr(0, firstSlash));
     std::size_t secondSlash = token.find('/', firstSlash + 1);
-    v = std::stoi(token.substr(0, firstSlash));
-
-    if (secondSlash == std::string::npos) {
-        if (firstSlash + 1 < token.size()) {
-            t = std::stoi(token.substr(firstSlash + 1));
-        }
+    if (secondSlash == std::string_view::npos) {
+        corner.texCoord = ParseIndex(token.substr(firstSlash + 1));
     } else {
-        if (secondSlash > firstSlash + 1) {
-            t = std::stoi(token.substr(firstSlash + 1, secondSlash - firstSlash - 1));
-        }
-        if (secondSlash + 1 < token.size()) {
-            n = std::stoi(token.substr(secondSlash + 1));
-        }
+        corner.texCoord = ParseIndex(token.substr(firstSlash + 1, secondSlash - firstSlash - 1));
+        corner.normal = ParseIndex(token.substr(secondSlash + 1));
     }
-    return true;
+    return corner;
 }
 
-std::string Trim(const std::string& str) {
-    const char* whitespace = " \t\r\n";
-    std::size_t start = str.find_first_not_of(whitespace);
-    if (start == std::string::npos) {
-        return {};
+bool IsNumber(std::string_view text) {
+    float value = 0.0f;
+    auto [ptr, ec] = std::from_chars(text.data(), text.data() + text.size(), value);
+    return ec == std::errc() && ptr == text.data() + text.size();
+}
+
+// Returns the file name of a map statement, skipping the options that may
+// precede it ("-bm 0.2", "-o 0 0 0", "-clamp on"). Only -bm is kept.
+std::string_view ParseTextureStatement(LineTokenizer& line, float* bumpMultiplier = nullptr) {
+    std::string_view token = line.Next();
+    while (token.size() > 1 && token[0] == '-') {
+        const std::string_view option = token;
+        token = line.Next();
+        if (option == "-bm" && bumpMultiplier) {
+            std::from_chars(token.data(), token.data() + token.size(), *bumpMultiplier);
+        }
+        // Every option takes one argument; -o/-s/-t/-mm may take more numbers.
+        token = line.Next();
+        while (IsNumber(token)) {
+            token = line.Next();
+        }
     }
-    std::size_t end = str.find_last_not_of(whitespace);
-    return str.substr(start, end - start + 1);
+    return token;
 }
 
 void ParseMtlFile(const std::filesystem::path& filePath,
                   std::unordered_map<std::string, MaterialDefinition>& materials) {
-    std::ifstream file(filePath);
-    if (!file) {
+    MappedFile file;
+    if (!file.Open(filePath)) {
         return;
     }
 
     MaterialDefinition current;
     std::string currentName;
-    std::string line;
 
     auto commitCurrent = [&]() {
         if (!currentName.empty()) {
@@ -95,32 +175,37 @@ void ParseMtlFile(const std::filesystem::path& filePath,
         }
     };
 
-    while (std::getline(file, line)) {
-        line = Trim(line);
-        if (line.empty() || line[0] == '#') {
-            continue;
+    ForEachLine(file.Data(), file.Size(), [&](const char* lineBegin, const char* lineEnd) {
+        LineTokenizer line(lineBegin, lineEnd);
+        std::string_view token = line.Next();
+        if (token.empty() || token[0] == '#') {
+            return;
         }
 
-        std::istringstream iss(line);
-        std::string token;
-        iss >> token;
-
         if (token == "newmtl") {
             commitCurrent();
             current = MaterialDefinition{};
             current.diffuseColor = glm::vec3(0.8f);
             current.shininess = 32.0f;
-            iss >> currentName;
+            std::string_view name = line.Next();
+            if (!name.empty()) {
+                currentName.assign(name);
+            }
         } else if (token == "Kd") {
-            iss >> current.diffuseColor.r >> current.diffuseColor.g >> current.diffuseColor.b;
+            line >> current.diffuseColor.r >> current.diffuseColor.g >> current.diffuseColor.b;
         } else if (token == "Ns") {
-            iss >> current.shininess;
+            line >> current.shininess;
         } else if (token == "map_Kd") {
-            std::string texName;
-            iss >> texName;
+            std::string_view texName = ParseTextureStatement(line);
             current.diffuseTexture = (filePath.parent_path() / texName).lexically_normal();
+        } else if (token == "map_Bump" || token == "map_bump" || token == "bump" || token == "norm") {
+            // Treated as a tangent-space normal map; -bm scales its slope.
+            std::string_view texName = ParseTextureStatement(line, &current.normalScale);
+            if (!texName.empty()) {
+                current.normalTexture = (filePath.parent_path() / texName).lexically_normal();
+            }
         }
-    }
+    });
 
     commitCurrent();
 }
@@ -135,148 +220,408 @@ MaterialDefinition ResolveMaterial(const std::string& name,
     return fallback;
 }
 
-} // namespace
+struct RecordCounts {
+    std::size_t positions = 0;
+    std::size_t texCoords = 0;
+    std::size_t normals = 0;
+    std::size_t faces = 0;
+    std::size_t corners = 0;
+};
 
-bool LoadObjMesh(const std::filesystem::path& objPath,
-                 ObjMesh& outMesh,
-                 std::string* errorMessage) {
-    std::ifstream file(objPath);
-    if (!file) {
-        if (errorMessage) {
-            *errorMessage = "Unable to open OBJ file: " + objPath.string();
+// Cheap pre-pass that only looks at the first characters of each line.
+// Corner counts are estimated as three per face.
+RecordCounts CountRecords(const char* data, std::size_t size) {
+    RecordCounts counts;
+    ForEachLine(data, size, [&](const char* lineBegin, const char* lineEnd) {
+        while (lineBegin < lineEnd && IsSpace(*lineBegin)) {
+            ++lineBegin;
         }
-        return false;
+        if (lineEnd - lineBegin < 2) {
+            return;
+        }
+        if (lineBegin[0] == 'f' && IsSpace(lineBegin[1])) {
+            ++counts.faces;
+        } else if (lineBegin[0] == 'v') {
+            if (IsSpace(lineBegin[1])) {
+                ++counts.positions;
+            } else if (lineBegin[1] == 't' && lineEnd - lineBegin > 2 && IsSpace(lineBegin[2])) {
+                ++counts.texCoords;
+            } else if (lineBegin[1] == 'n' && lineEnd - lineBegin > 2 && IsSpace(lineBegin[2])) {
+                ++counts.normals;
+            }
+        }
+    });
+    counts.corners = counts.faces * 3;
+    return counts;
+}
+
+// Turns face records into deduplicated vertices, triangle indices and
+// material chunks. Both the serial and the chunked parser feed it in file
+// order, which is what keeps their output identical.
+class MeshAssembler {
+public:
+    MeshAssembler(const std::filesystem::path& objPath,
+                  const std::vector<glm::vec3>& positions,
+                  const std::vector<glm::vec2>& texcoords,
+                  const std::vector<glm::vec3>& normals)
+        : objPath_(objPath), positions_(positions), texcoords_(texcoords), normals_(normals) {
+        defaultMaterial_.name = "default";
+        defaultMaterial_.diffuseColor = glm::vec3(0.8f);
+        defaultMaterial_.shininess = 32.0f;
+
+        currentChunk_.material = defaultMaterial_;
+        currentChunk_.startIndex = 0;
+        currentChunk_.indexCount = 0;
     }
 
-    std::vector<glm::vec3> positions;
-    std::vector<glm::vec2> texcoords;
-    std::vector<glm::vec3> normals;
-    std::unordered_map<std::string, MaterialDefinition> materialLibrary;
-
-    ObjMesh mesh;
-    mesh.vertices.clear();
-    mesh.indices.clear();
-    mesh.chunks.clear();
-
-    MaterialDefinition defaultMaterial;
-    defaultMaterial.name = "default";
-    defaultMaterial.diffuseColor = glm::vec3(0.8f);
-    defaultMaterial.shininess = 32.0f;
-
-    MeshChunk currentChunk;
-    currentChunk.material = defaultMaterial;
-    currentChunk.startIndex = 0;
-    currentChunk.indexCount = 0;
-    std::string currentMaterialName;
-
-    std::unordered_map<VertexKey, uint32_t, VertexKeyHasher> vertexCache;
-
-    std::string line;
-    while (std::getline(file, line)) {
-        line = Trim(line);
-        if (line.empty() || line[0] == '#') {
-            continue;
+    void Reserve(const RecordCounts& counts) {
+        // Most corners share a position with a neighbouring face; allow some
+        // headroom for UV/normal seams. The table grows if this undershoots.
+        std::size_t expectedVertices = std::min(counts.corners, counts.positions + counts.positions / 4);
+        vertexCache_.Reserve(expectedVertices);
+        mesh_.vertices.reserve(expectedVertices);
+        mesh_.indices.reserve(counts.corners > 2 * counts.faces ? 3 * (counts.corners - 2 * counts.faces) : 0);
+    }
+
+    void AddMaterialLibrary(std::string_view mtlFile) {
+        std::filesystem::path mtlPath = (objPath_.parent_path() / mtlFile).lexically_normal();
+        ParseMtlFile(mtlPath, materialLibrary_);
+        if (std::find(mesh_.materialLibraries.begin(), mesh_.materialLibraries.end(), mtlPath) ==
+            mesh_.materialLibraries.end()) {
+            mesh_.materialLibraries.push_back(std::move(mtlPath));
+        }
+    }
+
+    void UseMaterial(std::string_view name) {
+        materialName_.assign(name);
+        if (materialName_ == currentMaterialName_) {
+            return;
+        }
+        if (currentChunk_.indexCount > 0) {
+            mesh_.chunks.push_back(currentChunk_);
+            currentChunk_.startIndex = static_cast<uint32_t>(mesh_.indices.size());
+            currentChunk_.indexCount = 0;
+        } else {
+            currentChunk_.startIndex = static_cast<uint32_t>(mesh_.indices.size());
+        }
+        currentMaterialName_ = materialName_;
+        currentChunk_.material = ResolveMaterial(materialName_, materialLibrary_, defaultMaterial_);
+    }
+
+    // The counts are how many v/vt/vn records preceded the face in the file;
+    // relative and out-of-range indices resolve against them.
+    void AddFace(std::span<const FaceCorner> corners,
+                 std::size_t positionCount,
+                 std::size_t texCoordCount,
+                 std::size_t normalCount) {
+        if (corners.size() < 3) {
+            return;
+        }
+
+        auto emitVertex = [&](const FaceCorner& corner) -> int {
+            int posIndex = ResolveIndex(corner.position, positionCount);
+            if (posIndex < 0) {
+                return -1;
+            }
+            int texIndex = ResolveIndex(corner.texCoord, texCoordCount);
+            int normIndex = ResolveIndex(corner.normal, normalCount);
+
+            VertexKey key{posIndex, texIndex, normIndex};
+            uint32_t newIndex = static_cast<uint32_t>(mesh_.vertices.size());
+            uint32_t index = vertexCache_.FindOrInsert(key, newIndex);
+            if (index != newIndex) {
+                return static_cast<int>(index);
+            }
+
+            VertexPNT vertex{};
+            vertex.position = positions_[posIndex];
+            if (texIndex >= 0) {
+                vertex.texCoord = texcoords_[texIndex];
+            }
+            if (normIndex >= 0) {
+                vertex.normal = normals_[normIndex];
+            }
+
+            mesh_.vertices.push_back(vertex);
+            return static_cast<int>(newIndex);
+        };
+
+        // Triangulate polygon via fan method
+        int first = emitVertex(corners[0]);
+        int prev = emitVertex(corners[1]);
+        for (std::size_t i = 2; i < corners.size(); ++i) {
+            int current = emitVertex(corners[i]);
+            if (first < 0 || prev < 0 || current < 0) {
+                continue;
+            }
+            mesh_.indices.push_back(static_cast<uint32_t>(first));
+            mesh_.indices.push_back(static_cast<uint32_t>(prev));
+            mesh_.indices.push_back(static_cast<uint32_t>(current));
+            currentChunk_.indexCount += 3;
+            prev = current;
+        }
+    }
+
+    ObjMesh Finish() {
+        if (currentChunk_.indexCount > 0) {
+            mesh_.chunks.push_back(currentChunk_);
         }
+        return std::move(mesh_);
+    }
 
-        std::istringstream iss(line);
-        std::string token;
-        iss >> token;
+private:
+    const std::filesystem::path& objPath_;
+    const std::vector<glm::vec3>& positions_;
+    const std::vector<glm::vec2>& texcoords_;
+    const std::vector<glm::vec3>& normals_;
+    std::unordered_map<std::string, MaterialDefinition> materialLibrary_;
+    VertexDedupTable vertexCache_;
+
+    ObjMesh mesh_;
+    MaterialDefinition defaultMaterial_;
+    MeshChunk currentChunk_;
+    std::string currentMaterialName_;
+    std::string materialName_;
+};
+
+void ParseSerial(const MappedFile& file,
+                 MeshAssembler& assembler,
+                 std::vector<glm::vec3>& positions,
+                 std::vector<glm::vec2>& texcoords,
+                 std::vector<glm::vec3>& normals) {
+    RecordCounts counts = CountRecords(file.Data(), file.Size());
+    positions.reserve(counts.positions);
+    texcoords.reserve(counts.texCoords);
+    normals.reserve(counts.normals);
+    assembler.Reserve(counts);
+
+    // Reused across lines so face parsing does not allocate once warmed up.
+    std::vector<FaceCorner> faceCorners;
+
+    ForEachLine(file.Data(), file.Size(), [&](const char* lineBegin, const char* lineEnd) {
+        LineTokenizer line(lineBegin, lineEnd);
+        std::string_view token = line.Next();
+        if (token.empty() || token[0] == '#') {
+            return;
+        }
 
         if (token == "v") {
             glm::vec3 pos{};
-            iss >> pos.x >> pos.y >> pos.z;
+            line >> pos.x >> pos.y >> pos.z;
             positions.push_back(pos);
         } else if (token == "vt") {
             glm::vec2 uv{};
-            iss >> uv.x >> uv.y;
+            line >> uv.x >> uv.y;
             texcoords.push_back(uv);
         } else if (token == "vn") {
             glm::vec3 normal{};
-            iss >> normal.x >> normal.y >> normal.z;
+            line >> normal.x >> normal.y >> normal.z;
             normals.push_back(normal);
         } else if (token == "mtllib") {
-            std::string mtlFile;
-            while (iss >> mtlFile) {
-                ParseMtlFile((objPath.parent_path() / mtlFile).lexically_normal(), materialLibrary);
+            for (std::string_view mtlFile = line.Next(); !mtlFile.empty(); mtlFile = line.Next()) {
+                assembler.AddMaterialLibrary(mtlFile);
             }
         } else if (token == "usemtl") {
-            std::string materialName;
-            iss >> materialName;
-            if (materialName != currentMaterialName) {
-                if (currentChunk.indexCount > 0) {
-                    mesh.chunks.push_back(currentChunk);
-                    currentChunk.startIndex = static_cast<uint32_t>(mesh.indices.size());
-                    currentChunk.indexCount = 0;
-                } else {
-                    currentChunk.startIndex = static_cast<uint32_t>(mesh.indices.size());
-                }
-                currentMaterialName = materialName;
-                currentChunk.material = ResolveMaterial(materialName, materialLibrary, defaultMaterial);
-            }
+            assembler.UseMaterial(line.Next());
         } else if (token == "f") {
-            std::vector<std::string> faceTokens;
-            std::string part;
-            while (iss >> part) {
-                faceTokens.push_back(part);
-            }
-            if (faceTokens.size() < 3) {
-                continue;
+            faceCorners.clear();
+            for (std::string_view part = line.Next(); !part.empty(); part = line.Next()) {
+                faceCorners.push_back(ParseFaceCorner(part));
             }
+            assembler.AddFace(faceCorners, positions.size(), texcoords.size(), normals.size());
+        }
+    });
+}
 
-            auto emitVertex = [&](const std::string& partToken) -> int {
-                int vi = 0, ti = 0, ni = 0;
-                if (!ParseFaceToken(partToken, vi, ti, ni)) {
-                    return -1;
-                }
-                int posIndex = ResolveIndex(vi, positions.size());
-                if (posIndex < 0) {
-                    return -1;
-                }
-                int texIndex = ResolveIndex(ti, texcoords.size());
-                int normIndex = ResolveIndex(ni, normals.size());
+// Records parsed from one line-aligned slice of the file. Directive
+// arguments point into the mapping, which outlives the merge.
+struct ParsedChunk {
+    struct Face {
+        uint32_t firstCorner = 0;
+        uint32_t cornerCount = 0;
+        uint32_t positionCount = 0;
+        uint32_t texCoordCount = 0;
+        uint32_t normalCount = 0;
+    };
 
-                VertexKey key{posIndex, texIndex, normIndex};
-                auto it = vertexCache.find(key);
-                if (it != vertexCache.end()) {
-                    return static_cast<int>(it->second);
-                }
+    struct Directive {
+        enum class Kind { MaterialLibrary, UseMaterial };
+        Kind kind = Kind::UseMaterial;
+        std::size_t faceIndex = 0; // applies before this face
+        std::string_view argument;
+    };
 
-                VertexPNT vertex{};
-                vertex.position = positions[posIndex];
-                if (texIndex >= 0) {
-                    vertex.texCoord = texcoords[texIndex];
-                }
-                if (normIndex >= 0) {
-                    vertex.normal = normals[normIndex];
-                }
+    std::vector<glm::vec3> positions;
+    std::vector<glm::vec2> texcoords;
+    std::vector<glm::vec3> normals;
+    std::vector<FaceCorner> corners;
+    std::vector<Face> faces;
+    std::vector<Directive> directives;
+};
+
+void ParseChunk(const char* begin, const char* end, ParsedChunk& chunk) {
+    ForEachLine(begin, static_cast<std::size_t>(end - begin), [&](const char* lineBegin, const char* lineEnd) {
+        LineTokenizer line(lineBegin, lineEnd);
+        std::string_view token = line.Next();
+        if (token.empty() || token[0] == '#') {
+            return;
+        }
 
-                uint32_t newIndex = static_cast<uint32_t>(mesh.vertices.size());
-                mesh.vertices.push_back(vertex);
-                vertexCache.emplace(key, newIndex);
-                return static_cast<int>(newIndex);
-            };
-
-            // Triangulate polygon via fan method
-            int first = emitVertex(faceTokens[0]);
-            int prev = emitVertex(faceTokens[1]);
-            for (std::size_t i = 2; i < faceTokens.size(); ++i) {
-                int current = emitVertex(faceTokens[i]);
-                if (first < 0 || prev < 0 || current < 0) {
-                    continue;
+        if (token == "v") {
+            glm::vec3 pos{};
+            line >> pos.x >> pos.y >> pos.z;
+            chunk.positions.push_back(pos);
+        } else if (token == "vt") {
+            glm::vec2 uv{};
+            line >> uv.x >> uv.y;
+            chunk.texcoords.push_back(uv);
+        } else if (token == "vn") {
+            glm::vec3 normal{};
+            line >> normal.x >> normal.y >> normal.z;
+            chunk.normals.push_back(normal);
+        } else if (token == "mtllib") {
+            for (std::string_view mtlFile = line.Next(); !mtlFile.empty(); mtlFile = line.Next()) {
+                chunk.directives.push_back({ParsedChunk::Directive::Kind::MaterialLibrary, chunk.faces.size(), mtlFile});
+            }
+        } else if (token == "usemtl") {
+            chunk.directives.push_back({ParsedChunk::Directive::Kind::UseMaterial, chunk.faces.size(), line.Next()});
+        } else if (token == "f") {
+            ParsedChunk::Face face;
+            face.firstCorner = static_cast<uint32_t>(chunk.corners.size());
+            for (std::string_view part = line.Next(); !part.empty(); part = line.Next()) {
+                chunk.corners.push_back(ParseFaceCorner(part));
+            }
+            face.cornerCount = static_cast<uint32_t>(chunk.corners.size()) - face.firstCorner;
+            face.positionCount = static_cast<uint32_t>(chunk.positions.size());
+            face.texCoordCount = static_cast<uint32_t>(chunk.texcoords.size());
+            face.normalCount = static_cast<uint32_t>(chunk.normals.size());
+            chunk.faces.push_back(face);
+        }
+    });
+}
+
+void ParseParallel(const MappedFile& file,
+                   unsigned threadCount,
+                   MeshAssembler& assembler,
+                   std::vector<glm::vec3>& positions,
+                   std::vector<glm::vec2>& texcoords,
+                   std::vector<glm::vec3>& normals) {
+    const char* data = file.Data();
+    const std::size_t size = file.Size();
+
+    // Split at line starts; several slices per thread keeps the pool busy
+    // when some regions of the file are denser than others.
+    const std::size_t sliceCount = std::max<std::size_t>(1, std::min<std::size_t>(threadCount * 4, size / (64 * 1024)));
+    std::vector<std::size_t> boundaries{0};
+    for (std::size_t i = 1; i < sliceCount; ++i) {
+        std::size_t offset = std::max(size * i / sliceCount, boundaries.back());
+        const void* newline = std::memchr(data + offset, '\n', size - offset);
+        offset = newline ? static_cast<std::size_t>(static_cast<const char*>(newline) - data) + 1 : size;
+        if (offset > boundaries.back() && offset < size) {
+            boundaries.push_back(offset);
+        }
+    }
+    boundaries.push_back(size);
+
+    std::vector<ParsedChunk> chunks(boundaries.size() - 1);
+    ThreadPool pool(threadCount - 1);
+    pool.ParallelFor(chunks.size(), [&](std::size_t i) {
+        ParseChunk(data + boundaries[i], data + boundaries[i + 1], chunks[i]);
+    });
+
+    // Gather attribute arrays in file order.
+    std::vector<std::size_t> positionBase(chunks.size());
+    std::vector<std::size_t> texCoordBase(chunks.size());
+    std::vector<std::size_t> normalBase(chunks.size());
+    RecordCounts counts;
+    for (std::size_t i = 0; i < chunks.size(); ++i) {
+        positionBase[i] = counts.positions;
+        texCoordBase[i] = counts.texCoords;
+        normalBase[i] = counts.normals;
+        counts.positions += chunks[i].positions.size();
+        counts.texCoords += chunks[i].texcoords.size();
+        counts.normals += chunks[i].normals.size();
+        counts.faces += chunks[i].faces.size();
+        counts.corners += chunks[i].corners.size();
+    }
+    positions.resize(counts.positions);
+    texcoords.resize(counts.texCoords);
+    normals.resize(counts.normals);
+    assembler.Reserve(counts);
+    pool.ParallelFor(chunks.size(), [&](std::size_t i) {
+        std::copy(chunks[i].positions.begin(), chunks[i].positions.end(), positions.begin() + positionBase[i]);
+        std::copy(chunks[i].texcoords.begin(), chunks[i].texcoords.end(), texcoords.begin() + texCoordBase[i]);
+        std::copy(chunks[i].normals.begin(), chunks[i].normals.end(), normals.begin() + normalBase[i]);
+        chunks[i].positions = {};
+        chunks[i].texcoords = {};
+        chunks[i].normals = {};
+    });
+
+    // Replay faces and directives in file order. Vertex numbering depends on
+    // first use, so this stays on one thread.
+    for (std::size_t i = 0; i < chunks.size(); ++i) {
+        const ParsedChunk& chunk = chunks[i];
+        std::size_t nextDirective = 0;
+        auto applyDirectivesUpTo = [&](std::size_t faceIndex) {
+            while (nextDirective < chunk.directives.size() && chunk.directives[nextDirective].faceIndex <= faceIndex) {
+                const auto& directive = chunk.directives[nextDirective++];
+                if (directive.kind == ParsedChunk::Directive::Kind::MaterialLibrary) {
+                    assembler.AddMaterialLibrary(directive.argument);
+                } else {
+                    assembler.UseMaterial(directive.argument);
                 }
-                mesh.indices.push_back(static_cast<uint32_t>(first));
-                mesh.indices.push_back(static_cast<uint32_t>(prev));
-                mesh.indices.push_back(static_cast<uint32_t>(current));
-                currentChunk.indexCount += 3;
-                prev = current;
             }
+        };
+
+        for (std::size_t f = 0; f < chunk.faces.size(); ++f) {
+            applyDirectivesUpTo(f);
+            const auto& face = chunk.faces[f];
+            assembler.AddFace(std::span<const FaceCorner>(chunk.corners.data() + face.firstCorner, face.cornerCount),
+                              positionBase[i] + face.positionCount,
+                              texCoordBase[i] + face.texCoordCount,
+                              normalBase[i] + face.normalCount);
         }
+        applyDirectivesUpTo(chunk.faces.size());
     }
+}
+
+} // namespace
+
+bool LoadObjMesh(const std::filesystem::path& objPath,
+                 ObjMesh& outMesh,
+                 std::string* errorMessage) {
+    return LoadObjMesh(objPath, outMesh, ObjLoadOptions{}, errorMessage);
+}
+
+bool LoadObjMesh(const std::filesystem::path& objPath,
+                 ObjMesh& outMesh,
+                 const ObjLoadOptions& options,
+                 std::string* errorMessage,
+                 ObjLoadStats* stats) {
+    using Clock = std::chrono::steady_clock;
+    const auto parseStart = Clock::now();
+    MappedFile file;
+    if (!file.Open(objPath)) {
+        if (errorMessage) {
+            *errorMessage = "Unable to open OBJ file: " + objPath.string();
+        }
+        return false;
+    }
+
+    std::vector<glm::vec3> positions;
+    std::vector<glm::vec2> texcoords;
+    std::vector<glm::vec3> normals;
+    MeshAssembler assembler(objPath, positions, texcoords, normals);
 
-    if (currentChunk.indexCount > 0) {
-        mesh.chunks.push_back(currentChunk);
+    unsigned threadCount = options.threadCount == 0 ? ThreadPool::DefaultThreadCount() : options.threadCount;
+    if (threadCount <= 1) {
+        ParseSerial(file, assembler, positions, texcoords, normals);
+    } else {
+        ParseParallel(file, threadCount, assembler, positions, texcoords, normals);
     }
 
+    ObjMesh mesh = assembler.Finish();
+
     // Compute normals if none were provided
     bool hasNormals = false;
     for (const auto& v : mesh.vertices) {
@@ -319,7 +664,62 @@ bool LoadObjMesh(const std::filesystem::path& objPath,
         }
     }
 
+    const auto tangentStart = Clock::now();
+    if (options.generateTangents) {
+        GenerateTangents(mesh);
+    }
+    ComputeChunkBounds(mesh);
+    if (stats) {
+        stats->parseMs = std::chrono::duration<double, std::milli>(tangentStart - parseStart).count();
+        stats->tangentMs = std::chrono::duration<double, std::milli>(Clock::now() - tangentStart).count();
+    }
+
     outMesh = std::move(mesh);
     return true;
 }
 
+BoundingBox ComputeBoundingBox(std::span<const VertexPNT> vertices) {
+    BoundingBox box;
+    for (const auto& v : vertices) {
+        box.Expand(v.position);
+    }
+    return box;
+}
+
+BoundingSphere ComputeBoundingSphere(std::span<const VertexPNT> vertices) {
+    BoundingSphere sphere;
+    if (vertices.empty()) {
+        return sphere;
+    }
+    sphere.center = ComputeBoundingBox(vertices).Center();
+
+    float radiusSq = 0.0f;
+    for (const auto& v : vertices) {
+        glm::vec3 d = v.position - sphere.center;
+        radiusSq = std::max(radiusSq, glm::dot(d, d));
+    }
+    sphere.radius = std::sqrt(radiusSq);
+    return sphere;
+}
+
+void ComputeChunkBounds(ObjMesh& mesh) {
+    for (MeshChunk& chunk : mesh.chunks) {
+        const uint32_t* first = mesh.indices.data() + chunk.startIndex;
+        const uint32_t* last = first + chunk.indexCount;
+        chunk.box = BoundingBox{};
+        for (const uint32_t* index = first; index != last; ++index) {
+            chunk.box.Expand(mesh.vertices[*index].position);
+        }
+        chunk.sphere = BoundingSphere{};
+        if (chunk.box.Empty()) {
+            continue;
+        }
+        chunk.sphere.center = chunk.box.Center();
+        float radiusSq = 0.0f;
+        for (const uint32_t* index = first; index != last; ++index) {
+            const glm::vec3 d = mesh.vertices[*index].position - chunk.sphere.center;
+            radiusSq = std::max(radiusSq, glm::dot(d, d));
+        }
+        chunk.sphere.radius = std::sqrt(radiusSq);
+    }
+}
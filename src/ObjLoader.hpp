@@ -1,7 +1,10 @@
 #pragma once
 
+#include "Bounds.hpp"
+
 #include <filesystem>
 #include <glm/glm.hpp>
+#include <span>
 #include <string>
 #include <vector>
 
@@ -16,21 +19,69 @@ struct MaterialDefinition {
     glm::vec3 diffuseColor{0.8f};
     float shininess = 32.0f;
     std::filesystem::path diffuseTexture;
+    // Tangent-space normal map (map_Bump/bump/norm) and its -bm multiplier.
+    std::filesystem::path normalTexture;
+    float normalScale = 1.0f;
+};
+
+// Coarser index range for a chunk, indexing the same vertices.
+struct MeshLod {
+    uint32_t startIndex = 0;
+    uint32_t indexCount = 0;
+    float error = 0.0f; // object-space deviation from the full-detail range
 };
 
 struct MeshChunk {
     uint32_t startIndex = 0;
     uint32_t indexCount = 0;
     MaterialDefinition material;
+    // Filled by GenerateMeshLods, ordered by increasing error.
+    std::vector<MeshLod> lods;
+    // Object space, over the vertices the chunk indexes; LODs use a subset
+    // of them, so these cover every level.
+    BoundingBox box;
+    BoundingSphere sphere;
 };
 
 struct ObjMesh {
     std::vector<VertexPNT> vertices;
+    // Per-vertex tangent (xyz) and bitangent sign (w), parallel to vertices;
+    // empty unless tangents were generated.
+    std::vector<glm::vec4> tangents;
     std::vector<uint32_t> indices;
     std::vector<MeshChunk> chunks;
+    // MTL files referenced through mtllib, in the order they were read.
+    std::vector<std::filesystem::path> materialLibraries;
+};
+
+struct ObjLoadOptions {
+    // Threads used to parse the file. 1 parses serially, 0 uses every
+    // hardware thread. The resulting mesh is identical either way.
+    unsigned threadCount = 1;
+    // Generate MikkTSpace-style tangents for normal mapping. Vertices whose
+    // triangles disagree on UV handedness are split. Model turns this on by
+    // itself when a material has a normal map.
+    bool generateTangents = false;
+};
+
+struct ObjLoadStats {
+    double parseMs = 0.0;
+    double tangentMs = 0.0;
 };
 
+// Also fills every chunk's box and sphere.
 bool LoadObjMesh(const std::filesystem::path& objPath,
                  ObjMesh& outMesh,
                  std::string* errorMessage = nullptr);
 
+bool LoadObjMesh(const std::filesystem::path& objPath,
+                 ObjMesh& outMesh,
+                 const ObjLoadOptions& options,
+                 std::string* errorMessage = nullptr,
+                 ObjLoadStats* stats = nullptr);
+
+BoundingBox ComputeBoundingBox(std::span<const VertexPNT> vertices);
+// Sphere around the AABB centre; not minimal, but cheap and stable.
+BoundingSphere ComputeBoundingSphere(std::span<const VertexPNT> vertices);
+// Recomputes the box and sphere of every chunk from the vertices it indexes.
+void ComputeChunkBounds(ObjMesh& mesh);
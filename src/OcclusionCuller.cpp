@@ -0,0 +1,290 @@
+#include "OcclusionCuller.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <limits>
+#include <numeric>
+#include <utility>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define OCCLUSION_CULLER_SSE2 1
+#include <emmintrin.h>
+#endif
+
+namespace {
+
+double MillisecondsSince(std::chrono::steady_clock::time_point start) {
+    return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+}
+
+// Converts a window coordinate to a pixel index; clamping first keeps
+// far-off vertices from overflowing the int.
+int PixelIndex(float coordinate, int size) {
+    return static_cast<int>(std::floor(std::clamp(coordinate, -1.0f, static_cast<float>(size))));
+}
+
+// Signed distance to the OpenGL near plane (z = -w) in clip space.
+float NearDistance(const glm::vec4& clip) {
+    return clip.z + clip.w;
+}
+
+// Clips a triangle against the near plane; returns 0, 3 or 4 vertices of a
+// convex polygon.
+int ClipNear(const glm::vec4 (&triangle)[3], glm::vec4 (&polygon)[4]) {
+    int count = 0;
+    for (int i = 0; i < 3; ++i) {
+        const glm::vec4& current = triangle[i];
+        const glm::vec4& next = triangle[(i + 1) % 3];
+        const float currentDistance = NearDistance(current);
+        const float nextDistance = NearDistance(next);
+        if (currentDistance >= 0.0f) {
+            polygon[count++] = current;
+        }
+        if ((currentDistance >= 0.0f) != (nextDistance >= 0.0f)) {
+            const float t = currentDistance / (currentDistance - nextDistance);
+            polygon[count++] = current + (next - current) * t;
+        }
+    }
+    return count;
+}
+
+} // namespace
+
+std::vector<uint32_t> SelectOccluders(std::span<const BoundingSphere> worldSpheres,
+                                      const glm::vec3& cameraPos,
+                                      std::size_t maxCount) {
+    std::vector<float> coverage(worldSpheres.size());
+    for (std::size_t i = 0; i < worldSpheres.size(); ++i) {
+        const float distance = std::max(glm::length(worldSpheres[i].center - cameraPos), 1e-3f);
+        coverage[i] = worldSpheres[i].radius / distance;
+    }
+    std::vector<uint32_t> order(worldSpheres.size());
+    std::iota(order.begin(), order.end(), 0u);
+    const std::size_t count = std::min(maxCount, order.size());
+    // Ties go to the lower index so the choice is deterministic.
+    std::partial_sort(order.begin(), order.begin() + static_cast<std::ptrdiff_t>(count), order.end(),
+                      [&](uint32_t a, uint32_t b) {
+                          return coverage[a] != coverage[b] ? coverage[a] > coverage[b] : a < b;
+                      });
+    order.resize(count);
+    return order;
+}
+
+OcclusionCuller::OcclusionCuller(int width, int height) : pool_(1) {
+    width_ = (std::max(width, 4) + 3) / 4 * 4;
+    height_ = std::max(height, 1);
+    glm::ivec2 size(width_, height_);
+    while (true) {
+        levelSizes_.push_back(size);
+        levels_.emplace_back(static_cast<std::size_t>(size.x) * size.y, 1.0f);
+        if (size.x == 1 && size.y == 1) {
+            break;
+        }
+        size = glm::max((size + 1) / 2, glm::ivec2(1));
+    }
+}
+
+OcclusionCuller::~OcclusionCuller() {
+    if (pending_.valid()) {
+        pending_.wait();
+    }
+}
+
+void OcclusionCuller::Cull(const OcclusionScene& scene, std::vector<uint32_t>& visible) {
+    stats_ = OcclusionStats{};
+    const auto rasterStart = std::chrono::steady_clock::now();
+    Rasterize(scene);
+    BuildPyramid();
+    stats_.rasterMs = MillisecondsSince(rasterStart);
+
+    const auto testStart = std::chrono::steady_clock::now();
+    visible.clear();
+    for (uint32_t i = 0; i < scene.boxes.size(); ++i) {
+        if (TestBox(scene.boxes[i], scene.viewProjection)) {
+            visible.push_back(i);
+        }
+    }
+    stats_.testMs = MillisecondsSince(testStart);
+    stats_.occluders = static_cast<uint32_t>(scene.occluders.size());
+    stats_.tested = static_cast<uint32_t>(scene.boxes.size());
+    stats_.visible = static_cast<uint32_t>(visible.size());
+}
+
+void OcclusionCuller::CullAsync(OcclusionScene scene) {
+    asyncScene_ = std::move(scene);
+    pending_ = pool_.Submit([this]() { Cull(asyncScene_, asyncVisible_); });
+}
+
+const std::vector<uint32_t>& OcclusionCuller::Wait() {
+    if (pending_.valid()) {
+        pending_.get();
+    }
+    return asyncVisible_;
+}
+
+void OcclusionCuller::Rasterize(const OcclusionScene& scene) {
+    std::fill(levels_[0].begin(), levels_[0].end(), 1.0f);
+    std::vector<glm::vec4> clip;
+    for (const Occluder& occluder : scene.occluders) {
+        if (!occluder.mesh) {
+            continue;
+        }
+        const OccluderMesh& mesh = *occluder.mesh;
+        const glm::mat4 transform = scene.viewProjection * occluder.transform;
+        clip.resize(mesh.positions.size());
+        for (std::size_t i = 0; i < mesh.positions.size(); ++i) {
+            clip[i] = transform * glm::vec4(mesh.positions[i], 1.0f);
+        }
+        for (std::size_t i = 0; i + 2 < mesh.indices.size(); i += 3) {
+            const glm::vec4 triangle[3] = {clip[mesh.indices[i]], clip[mesh.indices[i + 1]], clip[mesh.indices[i + 2]]};
+            glm::vec4 polygon[4];
+            const int count = ClipNear(triangle, polygon);
+            for (int v = 2; v < count; ++v) {
+                RasterizeTriangle(polygon[0], polygon[v - 1], polygon[v]);
+            }
+        }
+    }
+}
+
+void OcclusionCuller::RasterizeTriangle(const glm::vec4& a, const glm::vec4& b, const glm::vec4& c) {
+    // Window coordinates with y up and depth in [0, 1].
+    auto toWindow = [&](const glm::vec4& clip) {
+        const glm::vec3 ndc = glm::vec3(clip) / clip.w;
+        return glm::vec3((ndc.x * 0.5f + 0.5f) * static_cast<float>(width_),
+                         (ndc.y * 0.5f + 0.5f) * static_cast<float>(height_), ndc.z * 0.5f + 0.5f);
+    };
+    glm::vec3 v0 = toWindow(a);
+    glm::vec3 v1 = toWindow(b);
+    glm::vec3 v2 = toWindow(c);
+
+    float area = (v1.x - v0.x) * (v2.y - v0.y) - (v2.x - v0.x) * (v1.y - v0.y);
+    if (!(std::abs(area) > 1e-8f)) {
+        return;
+    }
+    // Both windings are drawn, so open meshes still occlude.
+    if (area < 0.0f) {
+        std::swap(v1, v2);
+        area = -area;
+    }
+
+    const int minX = std::max(PixelIndex(std::min({v0.x, v1.x, v2.x}), width_), 0) & ~3;
+    const int maxX = std::min(PixelIndex(std::max({v0.x, v1.x, v2.x}), width_), width_ - 1);
+    const int minY = std::max(PixelIndex(std::min({v0.y, v1.y, v2.y}), height_), 0);
+    const int maxY = std::min(PixelIndex(std::max({v0.y, v1.y, v2.y}), height_), height_ - 1);
+    if (minX > maxX || minY > maxY || std::min({v0.z, v1.z, v2.z}) > 1.0f) {
+        return;
+    }
+    ++stats_.triangles;
+
+    // Edge functions e = A*x + B*y + C, non-negative inside, and the depth
+    // plane z = Az*x + Bz*y + Cz, evaluated at pixel centres.
+    const glm::vec3 edgeA(v1.y - v2.y, v2.y - v0.y, v0.y - v1.y);
+    const glm::vec3 edgeB(v2.x - v1.x, v0.x - v2.x, v1.x - v0.x);
+    const glm::vec3 edgeC(v1.x * v2.y - v2.x * v1.y, v2.x * v0.y - v0.x * v2.y, v0.x * v1.y - v1.x * v0.y);
+    const float depthA = ((v1.z - v0.z) * (v2.y - v0.y) - (v2.z - v0.z) * (v1.y - v0.y)) / area;
+    const float depthB = ((v1.x - v0.x) * (v2.z - v0.z) - (v2.x - v0.x) * (v1.z - v0.z)) / area;
+    const float depthC = v0.z - depthA * v0.x - depthB * v0.y;
+
+    std::vector<float>& depth = levels_[0];
+    for (int y = minY; y <= maxY; ++y) {
+        const float py = static_cast<float>(y) + 0.5f;
+        const glm::vec3 rowEdges = edgeB * py + edgeC;
+        const float rowDepth = depthB * py + depthC;
+        float* row = depth.data() + static_cast<std::size_t>(y) * width_;
+        int x = minX;
+#if OCCLUSION_CULLER_SSE2
+        const __m128 zero = _mm_setzero_ps();
+        const __m128 laneOffsets = _mm_setr_ps(0.5f, 1.5f, 2.5f, 3.5f);
+        for (; x <= maxX; x += 4) {
+            const __m128 px = _mm_add_ps(_mm_set1_ps(static_cast<float>(x)), laneOffsets);
+            const __m128 e0 = _mm_add_ps(_mm_mul_ps(_mm_set1_ps(edgeA.x), px), _mm_set1_ps(rowEdges.x));
+            const __m128 e1 = _mm_add_ps(_mm_mul_ps(_mm_set1_ps(edgeA.y), px), _mm_set1_ps(rowEdges.y));
+            const __m128 e2 = _mm_add_ps(_mm_mul_ps(_mm_set1_ps(edgeA.z), px), _mm_set1_ps(rowEdges.z));
+            const __m128 inside =
+                _mm_and_ps(_mm_and_ps(_mm_cmpge_ps(e0, zero), _mm_cmpge_ps(e1, zero)), _mm_cmpge_ps(e2, zero));
+            if (_mm_movemask_ps(inside) == 0) {
+                continue;
+            }
+            const __m128 z = _mm_add_ps(_mm_mul_ps(_mm_set1_ps(depthA), px), _mm_set1_ps(rowDepth));
+            const __m128 stored = _mm_loadu_ps(row + x);
+            const __m128 nearer = _mm_min_ps(stored, z);
+            _mm_storeu_ps(row + x, _mm_or_ps(_mm_and_ps(inside, nearer), _mm_andnot_ps(inside, stored)));
+        }
+#endif
+        for (; x <= maxX; ++x) {
+            const float px = static_cast<float>(x) + 0.5f;
+            if (edgeA.x * px + rowEdges.x >= 0.0f && edgeA.y * px + rowEdges.y >= 0.0f &&
+                edgeA.z * px + rowEdges.z >= 0.0f) {
+                row[x] = std::min(row[x], depthA * px + rowDepth);
+            }
+        }
+    }
+}
+
+void OcclusionCuller::BuildPyramid() {
+    for (std::size_t level = 1; level < levels_.size(); ++level) {
+        const std::vector<float>& source = levels_[level - 1];
+        const glm::ivec2 sourceSize = levelSizes_[level - 1];
+        const glm::ivec2 size = levelSizes_[level];
+        std::vector<float>& target = levels_[level];
+        for (int y = 0; y < size.y; ++y) {
+            const int y0 = y * 2;
+            const int y1 = std::min(y0 + 1, sourceSize.y - 1);
+            for (int x = 0; x < size.x; ++x) {
+                const int x0 = x * 2;
+                const int x1 = std::min(x0 + 1, sourceSize.x - 1);
+                target[static_cast<std::size_t>(y) * size.x + x] =
+                    std::max({source[static_cast<std::size_t>(y0) * sourceSize.x + x0],
+                              source[static_cast<std::size_t>(y0) * sourceSize.x + x1],
+                              source[static_cast<std::size_t>(y1) * sourceSize.x + x0],
+                              source[static_cast<std::size_t>(y1) * sourceSize.x + x1]});
+            }
+        }
+    }
+}
+
+bool OcclusionCuller::TestBox(const BoundingBox& box, const glm::mat4& viewProjection) const {
+    glm::vec2 minWindow(std::numeric_limits<float>::max());
+    glm::vec2 maxWindow(std::numeric_limits<float>::lowest());
+    float nearestDepth = std::numeric_limits<float>::max();
+    for (int corner = 0; corner < 8; ++corner) {
+        const glm::vec3 point((corner & 1) ? box.max.x : box.min.x, (corner & 2) ? box.max.y : box.min.y,
+                              (corner & 4) ? box.max.z : box.min.z);
+        const glm::vec4 clip = viewProjection * glm::vec4(point, 1.0f);
+        if (NearDistance(clip) <= 0.0f) {
+            return true;
+        }
+        const glm::vec3 ndc = glm::vec3(clip) / clip.w;
+        const glm::vec2 window((ndc.x * 0.5f + 0.5f) * static_cast<float>(width_),
+                               (ndc.y * 0.5f + 0.5f) * static_cast<float>(height_));
+        minWindow = glm::min(minWindow, window);
+        maxWindow = glm::max(maxWindow, window);
+        nearestDepth = std::min(nearestDepth, ndc.z * 0.5f + 0.5f);
+    }
+    if (maxWindow.x < 0.0f || maxWindow.y < 0.0f || minWindow.x > static_cast<float>(width_) ||
+        minWindow.y > static_cast<float>(height_)) {
+        return false; // outside the view
+    }
+
+    // Occluders cover a pixel when they cover its centre, so they can reach
+    // half a pixel past their true edge; growing the rectangle by a pixel
+    // keeps boxes peeking past an edge visible.
+    const int x0 = std::clamp(PixelIndex(minWindow.x, width_) - 1, 0, width_ - 1);
+    const int x1 = std::clamp(PixelIndex(maxWindow.x, width_) + 1, 0, width_ - 1);
+    const int y0 = std::clamp(PixelIndex(minWindow.y, height_) - 1, 0, height_ - 1);
+    const int y1 = std::clamp(PixelIndex(maxWindow.y, height_) + 1, 0, height_ - 1);
+    std::size_t level = 0;
+    while (level + 1 < levels_.size() && ((x1 >> level) - (x0 >> level) > 1 || (y1 >> level) - (y0 >> level) > 1)) {
+        ++level;
+    }
+    const std::vector<float>& depth = levels_[level];
+    const int levelWidth = levelSizes_[level].x;
+    float farthest = 0.0f;
+    for (int y = y0 >> level; y <= y1 >> level; ++y) {
+        for (int x = x0 >> level; x <= x1 >> level; ++x) {
+            farthest = std::max(farthest, depth[static_cast<std::size_t>(y) * levelWidth + x]);
+        }
+    }
+    return nearestDepth <= farthest;
+}
@@ -0,0 +1,103 @@
+#pragma once
+
+#include "Bounds.hpp"
+#include "ThreadPool.hpp"
+
+#include <cstddef>
+#include <cstdint>
+#include <future>
+#include <memory>
+#include <span>
+#include <vector>
+
+#include <glm/glm.hpp>
+
+// Object-space triangles rasterized into the occlusion buffer; usually a
+// coarse LOD of a model (see Model::OcclusionMesh()).
+struct OccluderMesh {
+    std::vector<glm::vec3> positions;
+    std::vector<uint32_t> indices;
+};
+
+struct Occluder {
+    std::shared_ptr<const OccluderMesh> mesh;
+    glm::mat4 transform{1.0f};
+};
+
+// Everything one occlusion pass reads. It is copied into the job, so the
+// caller may change or reload models while the pass runs.
+struct OcclusionScene {
+    glm::mat4 viewProjection{1.0f};
+    std::vector<Occluder> occluders;
+    std::vector<BoundingBox> boxes; // world space
+};
+
+struct OcclusionStats {
+    uint32_t occluders = 0;
+    uint32_t triangles = 0; // occluder triangles rasterized, after near clipping
+    uint32_t tested = 0;
+    uint32_t visible = 0;
+    double rasterMs = 0.0; // rasterization and pyramid build
+    double testMs = 0.0;
+
+    uint32_t Culled() const { return tested - visible; }
+};
+
+// Indices of the `maxCount` spheres that cover the most of the screen
+// (largest radius over distance), the best candidates for occluders.
+std::vector<uint32_t> SelectOccluders(std::span<const BoundingSphere> worldSpheres,
+                                      const glm::vec3& cameraPos,
+                                      std::size_t maxCount);
+
+// Software occlusion culling. Occluders are rasterized into a small depth
+// buffer (4 pixels per step with SSE2, chosen at compile time), which is
+// reduced into a pyramid keeping the farthest depth of each 2x2 block. A box
+// is hidden when its nearest point lies behind the farthest depth stored
+// over its screen rectangle, read from the level where that rectangle spans
+// at most 2x2 texels. Boxes crossing the near plane are always visible.
+//
+// The result only depends on the scene, so identical scenes give identical
+// visibility. CullAsync() runs the same pass on a worker thread, letting the
+// GL thread prepare the frame while the GPU finishes the previous one.
+class OcclusionCuller {
+public:
+    // The buffer width is rounded up to a multiple of 4.
+    explicit OcclusionCuller(int width = 256, int height = 128);
+    ~OcclusionCuller();
+
+    OcclusionCuller(const OcclusionCuller&) = delete;
+    OcclusionCuller& operator=(const OcclusionCuller&) = delete;
+
+    // Replaces `visible` with the indices of the scene's boxes that are not
+    // occluded, in increasing order.
+    void Cull(const OcclusionScene& scene, std::vector<uint32_t>& visible);
+
+    // Starts Cull() on the worker; Wait() returns its visible list. Nothing
+    // else may be called in between.
+    void CullAsync(OcclusionScene scene);
+    bool Pending() const { return pending_.valid(); }
+    const std::vector<uint32_t>& Wait();
+
+    const OcclusionStats& Stats() const { return stats_; }
+    int Width() const { return width_; }
+    int Height() const { return height_; }
+    // Level 0 of the pyramid: depth in [0, 1] (1 = far), bottom row first.
+    const std::vector<float>& Depth() const { return levels_[0]; }
+
+private:
+    int width_ = 0;
+    int height_ = 0;
+    std::vector<std::vector<float>> levels_;
+    std::vector<glm::ivec2> levelSizes_;
+    OcclusionStats stats_;
+
+    ThreadPool pool_;
+    std::future<void> pending_;
+    OcclusionScene asyncScene_;
+    std::vector<uint32_t> asyncVisible_;
+
+    void Rasterize(const OcclusionScene& scene);
+    void RasterizeTriangle(const glm::vec4& a, const glm::vec4& b, const glm::vec4& c);
+    void BuildPyramid();
+    bool TestBox(const BoundingBox& box, const glm::mat4& viewProjection) const;
+};
@@ -0,0 +1,101 @@
+#include "OffscreenTarget.hpp"
+
+#include "GlCalls.hpp"
+
+#include <algorithm>
+
+namespace {
+
+GLuint CreateRenderbuffer(GLenum format, int width, int height, int samples) {
+    GLuint renderbuffer = 0;
+    glGenRenderbuffers(1, &renderbuffer);
+    glBindRenderbuffer(GL_RENDERBUFFER, renderbuffer);
+    if (samples > 1) {
+        glRenderbufferStorageMultisample(GL_RENDERBUFFER, samples, format, width, height);
+    } else {
+        glRenderbufferStorage(GL_RENDERBUFFER, format, width, height);
+    }
+    glBindRenderbuffer(GL_RENDERBUFFER, 0);
+    return renderbuffer;
+}
+
+} // namespace
+
+OffscreenTarget::~OffscreenTarget() {
+    Destroy();
+}
+
+bool OffscreenTarget::Create(int width, int height, int samples, std::string* error) {
+    Destroy();
+    GLint maxSamples = 1;
+    glGetIntegerv(GL_MAX_SAMPLES, &maxSamples);
+    width_ = width;
+    height_ = height;
+    samples_ = std::clamp(samples, 1, std::max(maxSamples, 1));
+
+    glGenFramebuffers(1, &framebuffer_);
+    glBindFramebuffer(GL_FRAMEBUFFER, framebuffer_);
+    colorBuffer_ = CreateRenderbuffer(GL_RGBA8, width, height, samples_);
+    depthBuffer_ = CreateRenderbuffer(GL_DEPTH_COMPONENT24, width, height, samples_);
+    glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_RENDERBUFFER, colorBuffer_);
+    glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, GL_RENDERBUFFER, depthBuffer_);
+    bool complete = glCheckFramebufferStatus(GL_FRAMEBUFFER) == GL_FRAMEBUFFER_COMPLETE;
+
+    if (complete && samples_ > 1) {
+        glGenFramebuffers(1, &resolveFramebuffer_);
+        glBindFramebuffer(GL_FRAMEBUFFER, resolveFramebuffer_);
+        resolveBuffer_ = CreateRenderbuffer(GL_RGBA8, width, height, 1);
+        glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_RENDERBUFFER, resolveBuffer_);
+        complete = glCheckFramebufferStatus(GL_FRAMEBUFFER) == GL_FRAMEBUFFER_COMPLETE;
+    }
+    glBindFramebuffer(GL_FRAMEBUFFER, 0);
+
+    if (!complete) {
+        Destroy();
+        if (error) {
+            *error = "Offscreen framebuffer of " + std::to_string(width) + "x" + std::to_string(height) + " with " +
+                     std::to_string(samples) + " samples is incomplete.";
+        }
+        return false;
+    }
+    return true;
+}
+
+void OffscreenTarget::Bind() const {
+    gl::BindFramebuffer(GL_FRAMEBUFFER, framebuffer_);
+    gl::Viewport(0, 0, width_, height_);
+}
+
+void OffscreenTarget::ReadPixels(gfx::ImageRGBA8& out) const {
+    GLuint source = framebuffer_;
+    if (resolveFramebuffer_ != 0) {
+        glBindFramebuffer(GL_READ_FRAMEBUFFER, framebuffer_);
+        glBindFramebuffer(GL_DRAW_FRAMEBUFFER, resolveFramebuffer_);
+        glBlitFramebuffer(0, 0, width_, height_, 0, 0, width_, height_, GL_COLOR_BUFFER_BIT, GL_NEAREST);
+        source = resolveFramebuffer_;
+    }
+    out.width = static_cast<uint32_t>(width_);
+    out.height = static_cast<uint32_t>(height_);
+    out.pixels.resize(static_cast<std::size_t>(width_) * height_ * 4);
+    glBindFramebuffer(GL_READ_FRAMEBUFFER, source);
+    glPixelStorei(GL_PACK_ALIGNMENT, 1);
+    glReadPixels(0, 0, width_, height_, GL_RGBA, GL_UNSIGNED_BYTE, out.pixels.data());
+    glBindFramebuffer(GL_FRAMEBUFFER, framebuffer_);
+}
+
+void OffscreenTarget::Destroy() {
+    for (GLuint* framebuffer : {&framebuffer_, &resolveFramebuffer_}) {
+        if (*framebuffer != 0) {
+            glDeleteFramebuffers(1, framebuffer);
+            *framebuffer = 0;
+        }
+    }
+    for (GLuint* renderbuffer : {&colorBuffer_, &depthBuffer_, &resolveBuffer_}) {
+        if (*renderbuffer != 0) {
+            glDeleteRenderbuffers(1, renderbuffer);
+            *renderbuffer = 0;
+        }
+    }
+    width_ = 0;
+    height_ = 0;
+}
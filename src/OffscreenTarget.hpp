@@ -0,0 +1,41 @@
+#pragma once
+
+#include "TextureLoader.hpp"
+
+#include <GL/glew.h>
+
+#include <string>
+
+// A framebuffer object with colour and depth renderbuffers, for rendering
+// without a window. With samples > 1 the draws are multisampled and
+// ReadPixels() resolves them first.
+class OffscreenTarget {
+public:
+    OffscreenTarget() = default;
+    ~OffscreenTarget();
+
+    OffscreenTarget(const OffscreenTarget&) = delete;
+    OffscreenTarget& operator=(const OffscreenTarget&) = delete;
+
+    bool Create(int width, int height, int samples = 1, std::string* error = nullptr);
+    // Directs draws here and sets the viewport to cover the target.
+    void Bind() const;
+    // The finished frame, bottom row first like ImageRGBA8. Waits for the GPU.
+    void ReadPixels(gfx::ImageRGBA8& out) const;
+    void Destroy();
+
+    int Width() const { return width_; }
+    int Height() const { return height_; }
+    int Samples() const { return samples_; }
+
+private:
+    GLuint framebuffer_ = 0;
+    GLuint colorBuffer_ = 0;
+    GLuint depthBuffer_ = 0;
+    // Single-sampled copy read back when the target is multisampled.
+    GLuint resolveFramebuffer_ = 0;
+    GLuint resolveBuffer_ = 0;
+    int width_ = 0;
+    int height_ = 0;
+    int samples_ = 1;
+};
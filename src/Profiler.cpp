@@ -0,0 +1,214 @@
+#include "Profiler.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <fstream>
+
+namespace {
+
+constexpr uint64_t kNoFrame = UINT64_MAX;
+
+// Nearest-rank percentile of sorted values.
+double Percentile(const std::vector<float>& sorted, double fraction) {
+    const std::size_t rank = static_cast<std::size_t>(std::ceil(fraction * static_cast<double>(sorted.size())));
+    return sorted[std::clamp<std::size_t>(rank, 1, sorted.size()) - 1];
+}
+
+} // namespace
+
+Profiler::Profiler(std::size_t historyFrames)
+    : history_(std::max<std::size_t>(historyFrames, 1)), epoch_(std::chrono::steady_clock::now()) {
+    current_.fill(-1.0f);
+    frameZone_ = Zone("Frame", false);
+}
+
+void Profiler::CreateGpuTimers(std::size_t framesInFlight, std::size_t gpuZonesPerFrame) {
+    gpuTimer_.Create(std::max<std::size_t>(framesInFlight, 1) * std::max<std::size_t>(gpuZonesPerFrame, 1));
+}
+
+void Profiler::DestroyGpuTimers() {
+    gpuTimer_.Destroy();
+    gpuOpen_ = false;
+    pendingGpuEvents_.clear();
+}
+
+void Profiler::BeginFrame() {
+    frameStart_ = std::chrono::steady_clock::now();
+    current_.fill(-1.0f);
+}
+
+void Profiler::EndFrame() {
+    EndCpuZone(frameZone_, frameStart_);
+    FrameRecord& record = history_[frame_ % history_.size()];
+    record.frame = frame_;
+    record.ms = current_;
+    CollectGpu();
+    ++frame_;
+}
+
+std::size_t Profiler::Zone(const char* name, bool gpu) {
+    for (std::size_t i = 0; i < zones_.size(); ++i) {
+        if (zones_[i].gpu == gpu && (zones_[i].name == name || std::strcmp(zones_[i].name, name) == 0)) {
+            return i;
+        }
+    }
+    if (zones_.size() == kMaxZones) {
+        return kMaxZones;
+    }
+    zones_.push_back(ZoneInfo{name, gpu});
+    return zones_.size() - 1;
+}
+
+void Profiler::EndCpuZone(std::size_t zone, std::chrono::steady_clock::time_point start) {
+    if (zone >= kMaxZones) {
+        return;
+    }
+    const auto end = std::chrono::steady_clock::now();
+    const float ms = std::chrono::duration<float, std::milli>(end - start).count();
+    current_[zone] = std::max(current_[zone], 0.0f) + ms;
+    if (tracing_) {
+        const double startUs = MicrosecondsSinceEpoch(start);
+        AddTraceEvent(zones_[zone].name, false, startUs, MicrosecondsSinceEpoch(end) - startUs);
+    }
+}
+
+void Profiler::BeginGpuZone(std::size_t zone) {
+    if (zone >= kMaxZones || gpuOpen_) {
+        return;
+    }
+    const uint64_t tag = frame_ * kMaxZones + zone;
+    if (!gpuTimer_.Begin(tag, false)) {
+        return;
+    }
+    gpuOpen_ = true;
+    if (tracing_ && trace_.size() < maxTraceEvents_) {
+        pendingGpuEvents_.emplace_back(tag, trace_.size());
+        AddTraceEvent(zones_[zone].name, true, MicrosecondsSinceEpoch(std::chrono::steady_clock::now()), -1.0);
+    }
+}
+
+void Profiler::EndGpuZone() {
+    if (gpuOpen_) {
+        gpuTimer_.End();
+        gpuOpen_ = false;
+    }
+}
+
+void Profiler::StartTrace(std::size_t maxEvents) {
+    tracing_ = true;
+    maxTraceEvents_ = maxEvents;
+    trace_.reserve(std::min<std::size_t>(maxEvents, 1u << 16));
+}
+
+bool Profiler::WriteChromeTrace(const std::filesystem::path& path, std::string* error) const {
+    std::ofstream file(path);
+    if (!file) {
+        if (error) {
+            *error = "Unable to create " + path.string();
+        }
+        return false;
+    }
+    file.setf(std::ios::fixed);
+    file.precision(3);
+    file << "{\"displayTimeUnit\": \"ms\", \"traceEvents\": [\n"
+         << "  {\"name\": \"thread_name\", \"ph\": \"M\", \"pid\": 1, \"tid\": 1, \"args\": {\"name\": \"CPU\"}},\n"
+         << "  {\"name\": \"thread_name\", \"ph\": \"M\", \"pid\": 1, \"tid\": 2, \"args\": {\"name\": \"GPU\"}}";
+    for (const TraceEvent& event : trace_) {
+        if (event.durationUs < 0.0) {
+            continue;
+        }
+        file << ",\n  {\"name\": \"" << event.name << "\", \"cat\": \"" << (event.gpu ? "gpu" : "cpu")
+             << "\", \"ph\": \"X\", \"pid\": 1, \"tid\": " << (event.gpu ? 2 : 1) << ", \"ts\": " << event.startUs
+             << ", \"dur\": " << event.durationUs << "}";
+    }
+    file << "\n]}\n";
+    if (!file) {
+        if (error) {
+            *error = "Failed to write " + path.string();
+        }
+        return false;
+    }
+    return true;
+}
+
+ZoneStats Profiler::Stats(std::size_t zone) const {
+    ZoneStats stats;
+    if (zone >= zones_.size()) {
+        return stats;
+    }
+    std::vector<float> samples;
+    samples.reserve(history_.size());
+    uint64_t newest = 0;
+    for (const FrameRecord& record : history_) {
+        if (record.frame == kNoFrame || record.ms[zone] < 0.0f) {
+            continue;
+        }
+        samples.push_back(record.ms[zone]);
+        if (record.frame >= newest) {
+            newest = record.frame;
+            stats.last = record.ms[zone];
+        }
+    }
+    if (samples.empty()) {
+        return stats;
+    }
+    std::sort(samples.begin(), samples.end());
+    double sum = 0.0;
+    for (float sample : samples) {
+        sum += sample;
+    }
+    stats.samples = samples.size();
+    stats.mean = sum / static_cast<double>(samples.size());
+    stats.p50 = Percentile(samples, 0.50);
+    stats.p95 = Percentile(samples, 0.95);
+    stats.p99 = Percentile(samples, 0.99);
+    stats.max = samples.back();
+    return stats;
+}
+
+void Profiler::History(std::size_t zone, std::vector<float>& out) const {
+    out.assign(history_.size(), -1.0f);
+    if (zone >= zones_.size()) {
+        return;
+    }
+    for (std::size_t i = 0; i < history_.size(); ++i) {
+        // Frame numbers of the ring, oldest first, ending with the last
+        // finished frame.
+        const uint64_t frame = frame_ - history_.size() + i;
+        const FrameRecord& record = history_[frame % history_.size()];
+        if (frame_ >= history_.size() - i && record.frame == frame) {
+            out[i] = record.ms[zone];
+        }
+    }
+}
+
+double Profiler::MicrosecondsSinceEpoch(std::chrono::steady_clock::time_point time) const {
+    return std::chrono::duration<double, std::micro>(time - epoch_).count();
+}
+
+void Profiler::AddTraceEvent(const char* name, bool gpu, double startUs, double durationUs) {
+    if (trace_.size() < maxTraceEvents_) {
+        trace_.push_back(TraceEvent{name, gpu, startUs, durationUs});
+    }
+}
+
+void Profiler::CollectGpu() {
+    gpuResults_.clear();
+    gpuTimer_.Collect(gpuResults_);
+    for (const GpuTiming& timing : gpuResults_) {
+        const uint64_t frame = timing.tag / kMaxZones;
+        const std::size_t zone = static_cast<std::size_t>(timing.tag % kMaxZones);
+        FrameRecord& record = history_[frame % history_.size()];
+        if (record.frame == frame) {
+            record.ms[zone] = std::max(record.ms[zone], 0.0f) + static_cast<float>(timing.ms);
+        }
+        while (!pendingGpuEvents_.empty() && pendingGpuEvents_.front().first < timing.tag) {
+            pendingGpuEvents_.pop_front();
+        }
+        if (!pendingGpuEvents_.empty() && pendingGpuEvents_.front().first == timing.tag) {
+            trace_[pendingGpuEvents_.front().second].durationUs = timing.ms * 1000.0;
+            pendingGpuEvents_.pop_front();
+        }
+    }
+}
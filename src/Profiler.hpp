@@ -0,0 +1,157 @@
+#pragma once
+
+#include "GpuTimer.hpp"
+
+#include <array>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <filesystem>
+#include <string>
+#include <vector>
+
+// Percentiles over the frames a Profiler still remembers.
+struct ZoneStats {
+    double last = 0.0; // ms in the newest frame with a sample
+    double mean = 0.0;
+    double p50 = 0.0;
+    double p95 = 0.0;
+    double p99 = 0.0;
+    double max = 0.0;
+    std::size_t samples = 0;
+};
+
+// Per-frame CPU and GPU zone times for the overlay, the console and Chrome
+// traces. CPU zones are timed with steady_clock and may nest; a zone
+// entered several times in a frame adds up. GPU zones are GL_TIME_ELAPSED
+// spans read back a few frames later, so they must not nest and never
+// stall the CPU: when every query is still in flight the span is dropped.
+// Only touched on the GL thread.
+class Profiler {
+public:
+    static constexpr std::size_t kMaxZones = 16;
+
+    explicit Profiler(std::size_t historyFrames = 240);
+
+    Profiler(const Profiler&) = delete;
+    Profiler& operator=(const Profiler&) = delete;
+
+    // Needs a current context. Without it GPU zones are ignored.
+    void CreateGpuTimers(std::size_t framesInFlight = 3, std::size_t gpuZonesPerFrame = 4);
+    void DestroyGpuTimers();
+
+    void BeginFrame();
+    // Also records the "Frame" zone and picks up finished GPU spans.
+    void EndFrame();
+
+    // Zones are identified by name; the pointer is kept, so pass literals.
+    // Returns kMaxZones once the table is full.
+    std::size_t Zone(const char* name, bool gpu);
+    void EndCpuZone(std::size_t zone, std::chrono::steady_clock::time_point start);
+    void BeginGpuZone(std::size_t zone);
+    void EndGpuZone();
+
+    // Keeps every zone span from now on for WriteChromeTrace(), up to
+    // maxEvents.
+    void StartTrace(std::size_t maxEvents = 1u << 20);
+    // Chrome's trace event format (chrome://tracing, ui.perfetto.dev). GPU
+    // spans sit on their own track at the time they were submitted.
+    bool WriteChromeTrace(const std::filesystem::path& path, std::string* error = nullptr) const;
+
+    std::size_t ZoneCount() const { return zones_.size(); }
+    const char* ZoneName(std::size_t zone) const { return zones_[zone].name; }
+    bool IsGpuZone(std::size_t zone) const { return zones_[zone].gpu; }
+    ZoneStats Stats(std::size_t zone) const;
+    // Oldest first; negative where the zone has no sample for that frame.
+    void History(std::size_t zone, std::vector<float>& out) const;
+    std::size_t HistoryFrames() const { return history_.size(); }
+
+private:
+    struct ZoneInfo {
+        const char* name = nullptr;
+        bool gpu = false;
+    };
+
+    struct FrameRecord {
+        uint64_t frame = UINT64_MAX;
+        std::array<float, kMaxZones> ms{};
+    };
+
+    struct TraceEvent {
+        const char* name = nullptr;
+        bool gpu = false;
+        double startUs = 0.0;
+        double durationUs = -1.0; // GPU spans until their query is read
+    };
+
+    std::vector<ZoneInfo> zones_;
+    std::vector<FrameRecord> history_; // ring indexed by frame number
+    std::array<float, kMaxZones> current_{};
+    uint64_t frame_ = 0;
+    std::size_t frameZone_ = 0;
+    std::chrono::steady_clock::time_point frameStart_;
+    std::chrono::steady_clock::time_point epoch_;
+
+    GpuTimer gpuTimer_;
+    std::vector<GpuTiming> gpuResults_;
+    bool gpuOpen_ = false;
+
+    bool tracing_ = false;
+    std::size_t maxTraceEvents_ = 0;
+    std::vector<TraceEvent> trace_;
+    // GPU events waiting for their query, oldest first, by GpuTimer tag.
+    std::deque<std::pair<uint64_t, std::size_t>> pendingGpuEvents_;
+
+    double MicrosecondsSinceEpoch(std::chrono::steady_clock::time_point time) const;
+    void AddTraceEvent(const char* name, bool gpu, double startUs, double durationUs);
+    void CollectGpu();
+};
+
+// Times the enclosing scope as a CPU zone, or up to End().
+class ProfileZone {
+public:
+    ProfileZone(Profiler& profiler, const char* name)
+        : profiler_(profiler), zone_(profiler.Zone(name, false)), start_(std::chrono::steady_clock::now()) {}
+    ~ProfileZone() { End(); }
+
+    ProfileZone(const ProfileZone&) = delete;
+    ProfileZone& operator=(const ProfileZone&) = delete;
+
+    void End() {
+        if (open_) {
+            profiler_.EndCpuZone(zone_, start_);
+            open_ = false;
+        }
+    }
+
+private:
+    Profiler& profiler_;
+    std::size_t zone_;
+    std::chrono::steady_clock::time_point start_;
+    bool open_ = true;
+};
+
+// Times the GL commands issued in the enclosing scope as a GPU zone, or up
+// to End().
+class GpuProfileZone {
+public:
+    GpuProfileZone(Profiler& profiler, const char* name) : profiler_(profiler) {
+        profiler_.BeginGpuZone(profiler.Zone(name, true));
+    }
+    ~GpuProfileZone() { End(); }
+
+    GpuProfileZone(const GpuProfileZone&) = delete;
+    GpuProfileZone& operator=(const GpuProfileZone&) = delete;
+
+    void End() {
+        if (open_) {
+            profiler_.EndGpuZone();
+            open_ = false;
+        }
+    }
+
+private:
+    Profiler& profiler_;
+    bool open_ = true;
+};
@@ -0,0 +1,227 @@
+#include "ProfilerOverlay.hpp"
+
+#include "GlCalls.hpp"
+#include "Profiler.hpp"
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <cstddef>
+#include <cstdio>
+
+namespace {
+
+constexpr uint32_t Rgba(uint32_t r, uint32_t g, uint32_t b, uint32_t a = 255) {
+    return r | (g << 8) | (b << 16) | (a << 24);
+}
+
+struct PaletteEntry {
+    uint32_t color;
+    const char* name;
+};
+
+// Zone colours by zone index; zone 0 is the whole frame.
+constexpr std::array<PaletteEntry, 12> kPalette{{
+    {Rgba(90, 90, 100), "grey"},
+    {Rgba(240, 150, 40), "orange"},
+    {Rgba(70, 150, 240), "blue"},
+    {Rgba(120, 210, 80), "green"},
+    {Rgba(230, 70, 90), "red"},
+    {Rgba(170, 110, 230), "purple"},
+    {Rgba(60, 210, 200), "cyan"},
+    {Rgba(240, 220, 70), "yellow"},
+    {Rgba(240, 130, 200), "pink"},
+    {Rgba(170, 120, 70), "brown"},
+    {Rgba(200, 200, 200), "white"},
+    {Rgba(130, 160, 60), "olive"},
+}};
+
+const PaletteEntry& ZonePalette(std::size_t zone) {
+    return zone == 0 ? kPalette[0] : kPalette[1 + (zone - 1) % (kPalette.size() - 1)];
+}
+
+constexpr uint32_t kBackground = Rgba(0, 0, 0, 170);
+constexpr uint32_t kText = Rgba(230, 230, 230);
+constexpr uint32_t kTargetLine = Rgba(255, 255, 255, 110);
+
+// 3x5 digits, top row in the high bits, for the numbers next to each zone.
+constexpr std::array<uint16_t, 11> kDigits{{
+    0b111'101'101'101'111, // 0
+    0b010'110'010'010'111, // 1
+    0b111'001'111'100'111, // 2
+    0b111'001'111'001'111, // 3
+    0b101'101'111'001'001, // 4
+    0b111'100'111'001'111, // 5
+    0b111'100'111'101'111, // 6
+    0b111'001'001'001'001, // 7
+    0b111'101'111'101'111, // 8
+    0b111'101'111'001'111, // 9
+    0b000'000'000'000'010, // .
+}};
+
+constexpr float kMargin = 8.0f;
+constexpr float kGraphHeight = 100.0f;
+constexpr float kGraphMs = 100.0f / 3.0f; // the graph's full height, 30 Hz
+constexpr float kRowHeight = 14.0f;
+constexpr float kFontPixel = 2.0f;
+constexpr float kColumnWidth = 56.0f;
+
+} // namespace
+
+ProfilerOverlay::~ProfilerOverlay() {
+    Destroy();
+}
+
+bool ProfilerOverlay::Create(const std::filesystem::path& shaderDirectory, std::string* error) {
+    Destroy();
+    if (!program_.LoadFromFiles(shaderDirectory / "overlay.vert", shaderDirectory / "overlay.frag", error)) {
+        return false;
+    }
+    glGenVertexArrays(1, &vao_);
+    glGenBuffers(1, &vbo_);
+    glBindVertexArray(vao_);
+    glBindBuffer(GL_ARRAY_BUFFER, vbo_);
+    glEnableVertexAttribArray(0);
+    glVertexAttribPointer(0, 2, GL_FLOAT, GL_FALSE, sizeof(Vertex), reinterpret_cast<const void*>(offsetof(Vertex, x)));
+    glEnableVertexAttribArray(1);
+    glVertexAttribPointer(1, 4, GL_UNSIGNED_BYTE, GL_TRUE, sizeof(Vertex),
+                          reinterpret_cast<const void*>(offsetof(Vertex, color)));
+    glBindVertexArray(0);
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
+    return true;
+}
+
+void ProfilerOverlay::Draw(const Profiler& profiler, int width, int height) {
+    if (vao_ == 0 || width <= 0 || height <= 0) {
+        return;
+    }
+    scaleX_ = 2.0f / static_cast<float>(width);
+    scaleY_ = 2.0f / static_cast<float>(height);
+    vertices_.clear();
+
+    const std::size_t frames = profiler.HistoryFrames();
+    const float graphWidth = static_cast<float>(frames);
+    const std::size_t zoneCount = profiler.ZoneCount();
+    const float rowsTop = kMargin * 2.0f + kGraphHeight;
+    AddRect(kMargin * 0.5f, kMargin * 0.5f, graphWidth * 2.0f + kMargin * 2.0f,
+            rowsTop + kRowHeight * static_cast<float>(zoneCount) + kMargin * 0.5f, kBackground);
+
+    // Left graph: the frame's CPU time behind the stacked CPU zones. Right
+    // graph: the stacked GPU zones.
+    for (int gpu = 0; gpu < 2; ++gpu) {
+        const float left = kMargin + static_cast<float>(gpu) * (graphWidth + kMargin);
+        const float bottom = kMargin + kGraphHeight;
+        stacked_.assign(frames, 0.0f);
+        for (std::size_t zone = 0; zone < zoneCount; ++zone) {
+            if (profiler.IsGpuZone(zone) != (gpu == 1)) {
+                continue;
+            }
+            profiler.History(zone, history_);
+            for (std::size_t i = 0; i < frames; ++i) {
+                if (history_[i] <= 0.0f) {
+                    continue;
+                }
+                // The frame zone is the backdrop, not a layer of the stack.
+                const float base = zone == 0 ? 0.0f : stacked_[i];
+                const float top = std::min(base + history_[i], kGraphMs);
+                if (top > base) {
+                    const float y0 = bottom - base / kGraphMs * kGraphHeight;
+                    const float y1 = bottom - top / kGraphMs * kGraphHeight;
+                    AddRect(left + static_cast<float>(i), y1, 1.0f, y0 - y1, ZonePalette(zone).color);
+                }
+                if (zone != 0) {
+                    stacked_[i] += history_[i];
+                }
+            }
+        }
+        AddRect(left, bottom - kGraphHeight * 0.5f, graphWidth, 1.0f, kTargetLine);
+        AddRect(left, kMargin, graphWidth, 1.0f, kTargetLine);
+    }
+
+    // One row per zone: colour, then last, p50, p95 and p99 in ms.
+    for (std::size_t zone = 0; zone < zoneCount; ++zone) {
+        const float y = rowsTop + kRowHeight * static_cast<float>(zone);
+        AddRect(kMargin, y, 10.0f, 10.0f, ZonePalette(zone).color);
+        const ZoneStats stats = profiler.Stats(zone);
+        const double values[] = {stats.last, stats.p50, stats.p95, stats.p99};
+        for (std::size_t column = 0; column < std::size(values); ++column) {
+            float x = kMargin + 18.0f + kColumnWidth * static_cast<float>(column);
+            AddNumber(x, y, values[column], kFontPixel, kText);
+        }
+    }
+
+    const GLsizeiptr size = static_cast<GLsizeiptr>(vertices_.size() * sizeof(Vertex));
+    gl::BindBuffer(GL_ARRAY_BUFFER, vbo_);
+    if (size > capacity_) {
+        capacity_ = std::max(size, capacity_ * 2);
+    }
+    gl::BufferData(GL_ARRAY_BUFFER, capacity_, nullptr, GL_STREAM_DRAW);
+    gl::BufferSubData(GL_ARRAY_BUFFER, 0, size, vertices_.data());
+    gl::BindBuffer(GL_ARRAY_BUFFER, 0);
+
+    gl::Disable(GL_DEPTH_TEST);
+    gl::Disable(GL_CULL_FACE);
+    gl::Enable(GL_BLEND);
+    // Keeps the framebuffer opaque for screenshots.
+    gl::BlendFuncSeparate(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA, GL_ZERO, GL_ONE);
+    program_.Use();
+    gl::BindVertexArray(vao_);
+    gl::DrawArrays(GL_TRIANGLES, 0, static_cast<GLsizei>(vertices_.size()));
+    gl::BindVertexArray(0);
+    gl::Disable(GL_BLEND);
+    gl::Enable(GL_CULL_FACE);
+    gl::Enable(GL_DEPTH_TEST);
+}
+
+void ProfilerOverlay::Destroy() {
+    if (vbo_ != 0) {
+        glDeleteBuffers(1, &vbo_);
+        vbo_ = 0;
+    }
+    if (vao_ != 0) {
+        glDeleteVertexArrays(1, &vao_);
+        vao_ = 0;
+    }
+    capacity_ = 0;
+}
+
+std::string ProfilerOverlay::Legend(const Profiler& profiler) {
+    std::string legend = "Profiler overlay (ms: last, p50, p95, p99):";
+    for (std::size_t zone = 0; zone < profiler.ZoneCount(); ++zone) {
+        legend += std::string("\n  ") + ZonePalette(zone).name + " " + (profiler.IsGpuZone(zone) ? "GPU " : "CPU ") +
+                  profiler.ZoneName(zone);
+    }
+    return legend;
+}
+
+void ProfilerOverlay::AddRect(float x, float y, float width, float height, uint32_t color) {
+    const float x0 = x * scaleX_ - 1.0f;
+    const float x1 = (x + width) * scaleX_ - 1.0f;
+    const float y0 = 1.0f - y * scaleY_;
+    const float y1 = 1.0f - (y + height) * scaleY_;
+    vertices_.push_back(Vertex{x0, y0, color});
+    vertices_.push_back(Vertex{x0, y1, color});
+    vertices_.push_back(Vertex{x1, y1, color});
+    vertices_.push_back(Vertex{x0, y0, color});
+    vertices_.push_back(Vertex{x1, y1, color});
+    vertices_.push_back(Vertex{x1, y0, color});
+}
+
+void ProfilerOverlay::AddNumber(float& x, float y, double value, float pixelScale, uint32_t color) {
+    char text[16];
+    std::snprintf(text, sizeof(text), value < 100.0 ? "%.2f" : "%.0f", std::min(value, 99999.0));
+    for (const char* c = text; *c != '\0'; ++c) {
+        const std::size_t glyph = *c == '.' ? 10 : static_cast<std::size_t>(*c - '0');
+        if (glyph < kDigits.size()) {
+            for (int row = 0; row < 5; ++row) {
+                for (int column = 0; column < 3; ++column) {
+                    if (kDigits[glyph] & (1u << (14 - row * 3 - column))) {
+                        AddRect(x + static_cast<float>(column) * pixelScale, y + static_cast<float>(row) * pixelScale,
+                                pixelScale, pixelScale, color);
+                    }
+                }
+            }
+        }
+        x += 4.0f * pixelScale;
+    }
+}
@@ -0,0 +1,56 @@
+#pragma once
+
+#include "ShaderProgram.hpp"
+
+#include <GL/glew.h>
+
+#include <cstdint>
+#include <filesystem>
+#include <string>
+#include <vector>
+
+class Profiler;
+
+// Draws a Profiler's recent frames in the top-left corner: stacked CPU and
+// GPU zone times per frame against 60 and 30 Hz lines, and one row per zone
+// with its colour and last/p50/p95/p99 milliseconds. Zone names are not
+// drawn; Legend() lists them by colour.
+class ProfilerOverlay {
+public:
+    ProfilerOverlay() = default;
+    ~ProfilerOverlay();
+
+    ProfilerOverlay(const ProfilerOverlay&) = delete;
+    ProfilerOverlay& operator=(const ProfilerOverlay&) = delete;
+
+    // Loads overlay.vert/.frag from shaderDirectory.
+    bool Create(const std::filesystem::path& shaderDirectory, std::string* error = nullptr);
+    // Draws over the bound framebuffer of the given size; leaves depth
+    // testing and face culling enabled.
+    void Draw(const Profiler& profiler, int width, int height);
+    void Destroy();
+
+    // "zone: colour" lines matching the rows Draw() shows.
+    static std::string Legend(const Profiler& profiler);
+
+private:
+    struct Vertex {
+        float x = 0.0f;
+        float y = 0.0f;
+        uint32_t color = 0; // RGBA8
+    };
+
+    ShaderProgram program_;
+    GLuint vao_ = 0;
+    GLuint vbo_ = 0;
+    GLsizeiptr capacity_ = 0; // bytes
+    std::vector<Vertex> vertices_;
+    std::vector<float> history_;
+    std::vector<float> stacked_;
+    float scaleX_ = 0.0f; // pixels to NDC
+    float scaleY_ = 0.0f;
+
+    void AddRect(float x, float y, float width, float height, uint32_t color);
+    // Advances x past the text; pixel scale is the size of a font pixel.
+    void AddNumber(float& x, float y, double value, float pixelScale, uint32_t color);
+};
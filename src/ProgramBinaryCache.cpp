@@ -0,0 +1,152 @@
+#include "ProgramBinaryCache.hpp"
+
+#include "Hash.hpp"
+#include "MappedFile.hpp"
+
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <system_error>
+#include <vector>
+
+namespace {
+
+constexpr char kMagic[8] = {'U', 'F', 'O', 'P', 'R', 'O', 'G', '\0'};
+
+struct BinaryHeader {
+    char magic[8];
+    uint32_t version;
+    uint32_t binaryFormat;
+    uint64_t key;
+    uint64_t dataSize;
+};
+
+uint64_t HashString(std::string_view text, uint64_t seed) {
+    return hash::Bytes64(text.data(), text.size(), seed);
+}
+
+std::string_view DriverString(GLenum name) {
+    const auto* text = reinterpret_cast<const char*>(glGetString(name));
+    return text ? std::string_view(text) : std::string_view();
+}
+
+bool Fail(std::string* error, const std::string& message) {
+    if (error) {
+        *error = message;
+    }
+    return false;
+}
+
+} // namespace
+
+ProgramBinaryCache::ProgramBinaryCache(std::filesystem::path directory) : directory_(std::move(directory)) {
+    GLint formatCount = 0;
+    glGetIntegerv(GL_NUM_PROGRAM_BINARY_FORMATS, &formatCount);
+    enabled_ = formatCount > 0;
+
+    driverHash_ = HashString(DriverString(GL_VENDOR), kVersion);
+    driverHash_ = HashString(DriverString(GL_RENDERER), driverHash_);
+    driverHash_ = HashString(DriverString(GL_VERSION), driverHash_);
+}
+
+uint64_t ProgramBinaryCache::KeyFor(std::string_view vertexSource, std::string_view fragmentSource) const {
+    // Hash the lengths too so moving text between the stages changes the key.
+    const uint64_t lengths[2] = {vertexSource.size(), fragmentSource.size()};
+    uint64_t key = hash::Bytes64(lengths, sizeof(lengths), driverHash_);
+    key = HashString(vertexSource, key);
+    return HashString(fragmentSource, key);
+}
+
+std::filesystem::path ProgramBinaryCache::PathFor(uint64_t key) const {
+    char name[32];
+    std::snprintf(name, sizeof(name), "%016llx.progbin", static_cast<unsigned long long>(key));
+    return directory_ / name;
+}
+
+bool ProgramBinaryCache::Load(uint64_t key, GLuint program) {
+    if (!enabled_) {
+        ++stats_.misses;
+        return false;
+    }
+
+    MappedFile file;
+    BinaryHeader header{};
+    if (!file.Open(PathFor(key)) || file.Size() < sizeof(header)) {
+        ++stats_.misses;
+        return false;
+    }
+    std::memcpy(&header, file.Data(), sizeof(header));
+    const bool valid = std::memcmp(header.magic, kMagic, sizeof(kMagic)) == 0 && header.version == kVersion &&
+                       header.key == key && header.dataSize == file.Size() - sizeof(header);
+    if (valid) {
+        glProgramBinary(program, header.binaryFormat, file.Data() + sizeof(header),
+                        static_cast<GLsizei>(header.dataSize));
+        GLint linkStatus = GL_FALSE;
+        glGetProgramiv(program, GL_LINK_STATUS, &linkStatus);
+        if (linkStatus == GL_TRUE) {
+            ++stats_.hits;
+            return true;
+        }
+    }
+    ++stats_.rejected;
+    ++stats_.misses;
+    return false;
+}
+
+bool ProgramBinaryCache::Store(uint64_t key, GLuint program, std::string* error) {
+    if (!enabled_) {
+        return Fail(error, "Driver exposes no program binary formats");
+    }
+
+    GLint length = 0;
+    glGetProgramiv(program, GL_PROGRAM_BINARY_LENGTH, &length);
+    if (length <= 0) {
+        return Fail(error, "Driver returned an empty program binary");
+    }
+    std::vector<char> data(static_cast<std::size_t>(length));
+    GLenum binaryFormat = 0;
+    GLsizei written = 0;
+    glGetProgramBinary(program, length, &written, &binaryFormat, data.data());
+    if (written <= 0) {
+        return Fail(error, "Driver returned an empty program binary");
+    }
+
+    std::error_code ec;
+    std::filesystem::create_directories(directory_, ec);
+    if (ec) {
+        return Fail(error, "Unable to create program cache directory: " + directory_.string());
+    }
+
+    BinaryHeader header{};
+    std::memcpy(header.magic, kMagic, sizeof(kMagic));
+    header.version = kVersion;
+    header.binaryFormat = binaryFormat;
+    header.key = key;
+    header.dataSize = static_cast<uint64_t>(written);
+
+    // Write to a temporary file and rename so readers never see a partial binary.
+    const std::filesystem::path path = PathFor(key);
+    std::filesystem::path tempPath = path;
+    tempPath += ".tmp";
+    {
+        std::ofstream out(tempPath, std::ios::binary | std::ios::trunc);
+        if (!out) {
+            return Fail(error, "Unable to create program binary: " + tempPath.string());
+        }
+        out.write(reinterpret_cast<const char*>(&header), sizeof(header));
+        out.write(data.data(), written);
+        if (!out) {
+            out.close();
+            std::filesystem::remove(tempPath, ec);
+            return Fail(error, "Unable to write program binary: " + tempPath.string());
+        }
+    }
+
+    std::filesystem::rename(tempPath, path, ec);
+    if (ec) {
+        std::filesystem::remove(tempPath, ec);
+        return Fail(error, "Unable to replace program binary: " + path.string());
+    }
+    ++stats_.stores;
+    return true;
+}
@@ -0,0 +1,52 @@
+#pragma once
+
+#include <GL/glew.h>
+#include <cstdint>
+#include <filesystem>
+#include <string>
+#include <string_view>
+
+struct ProgramBinaryCacheStats {
+    uint32_t hits = 0;
+    uint32_t misses = 0;   // includes rejected binaries
+    uint32_t rejected = 0; // a file existed but the driver refused it
+    uint32_t stores = 0;
+
+    double HitRate() const {
+        const uint32_t lookups = hits + misses;
+        return lookups > 0 ? static_cast<double>(hits) / lookups : 0.0;
+    }
+};
+
+// Linked program binaries (glGetProgramBinary) stored one file per program
+// under `directory`. Files are named by a hash of the final shader sources
+// (defines included) and the driver's vendor/renderer/version strings, so a
+// driver update simply misses. Drivers may still refuse a binary; Load()
+// then reports a miss and the caller links from source and stores again.
+class ProgramBinaryCache {
+public:
+    static constexpr uint32_t kVersion = 1;
+
+    // Reads the driver strings, so construct it with the GL context current.
+    explicit ProgramBinaryCache(std::filesystem::path directory);
+
+    // False when the driver exposes no binary formats; lookups then miss.
+    bool Enabled() const { return enabled_; }
+    const std::filesystem::path& Directory() const { return directory_; }
+    const ProgramBinaryCacheStats& Stats() const { return stats_; }
+
+    uint64_t KeyFor(std::string_view vertexSource, std::string_view fragmentSource) const;
+    std::filesystem::path PathFor(uint64_t key) const;
+
+    // Restores `program` (a fresh glCreateProgram name) from the cache.
+    bool Load(uint64_t key, GLuint program);
+
+    // `program` must have been linked with GL_PROGRAM_BINARY_RETRIEVABLE_HINT.
+    bool Store(uint64_t key, GLuint program, std::string* error = nullptr);
+
+private:
+    std::filesystem::path directory_;
+    uint64_t driverHash_ = 0;
+    bool enabled_ = false;
+    ProgramBinaryCacheStats stats_;
+};
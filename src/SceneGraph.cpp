@@ -0,0 +1,136 @@
+#include "SceneGraph.hpp"
+
+#include <algorithm>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define SCENE_GRAPH_SSE2 1
+#include <emmintrin.h>
+#endif
+
+namespace {
+
+glm::mat4 LocalMatrix(const glm::vec3& translation, const glm::quat& rotation, const glm::vec3& scale) {
+    const glm::mat3 r = glm::mat3_cast(rotation);
+    glm::mat4 local;
+    local[0] = glm::vec4(r[0] * scale.x, 0.0f);
+    local[1] = glm::vec4(r[1] * scale.y, 0.0f);
+    local[2] = glm::vec4(r[2] * scale.z, 0.0f);
+    local[3] = glm::vec4(translation, 1.0f);
+    return local;
+}
+
+// a * b, one column of the result per four multiply-adds of a's columns.
+void Multiply(const glm::mat4& a, const glm::mat4& b, glm::mat4& out) {
+#if SCENE_GRAPH_SSE2
+    const __m128 a0 = _mm_loadu_ps(&a[0][0]);
+    const __m128 a1 = _mm_loadu_ps(&a[1][0]);
+    const __m128 a2 = _mm_loadu_ps(&a[2][0]);
+    const __m128 a3 = _mm_loadu_ps(&a[3][0]);
+    for (int column = 0; column < 4; ++column) {
+        const __m128 b0 = _mm_set1_ps(b[column][0]);
+        const __m128 b1 = _mm_set1_ps(b[column][1]);
+        const __m128 b2 = _mm_set1_ps(b[column][2]);
+        const __m128 b3 = _mm_set1_ps(b[column][3]);
+        const __m128 sum = _mm_add_ps(_mm_add_ps(_mm_mul_ps(a0, b0), _mm_mul_ps(a1, b1)),
+                                      _mm_add_ps(_mm_mul_ps(a2, b2), _mm_mul_ps(a3, b3)));
+        _mm_storeu_ps(&out[column][0], sum);
+    }
+#else
+    out = a * b;
+#endif
+}
+
+} // namespace
+
+void SceneGraph::Clear() {
+    parent_.clear();
+    translation_.clear();
+    rotation_.clear();
+    scale_.clear();
+    world_.clear();
+    normal_.clear();
+    dirty_.clear();
+    uniformScale_.clear();
+    firstDirty_ = 0;
+    stats_ = SceneGraphStats{};
+}
+
+void SceneGraph::Reserve(std::size_t count) {
+    parent_.reserve(count);
+    translation_.reserve(count);
+    rotation_.reserve(count);
+    scale_.reserve(count);
+    world_.reserve(count);
+    normal_.reserve(count);
+    dirty_.reserve(count);
+    uniformScale_.reserve(count);
+}
+
+SceneNode SceneGraph::Add(SceneNode parent) {
+    const SceneNode node = static_cast<SceneNode>(parent_.size());
+    parent_.push_back(parent < node ? parent : kNoParent);
+    translation_.emplace_back(0.0f);
+    rotation_.emplace_back(1.0f, 0.0f, 0.0f, 0.0f);
+    scale_.emplace_back(1.0f);
+    world_.emplace_back(1.0f);
+    normal_.emplace_back(1.0f);
+    dirty_.push_back(1);
+    uniformScale_.push_back(1);
+    firstDirty_ = std::min<std::size_t>(firstDirty_, node);
+    stats_.nodes = static_cast<uint32_t>(parent_.size());
+    return node;
+}
+
+void SceneGraph::SetTranslation(SceneNode node, const glm::vec3& translation) {
+    translation_[node] = translation;
+    MarkDirty(node);
+}
+
+void SceneGraph::SetRotation(SceneNode node, const glm::quat& rotation) {
+    rotation_[node] = rotation;
+    MarkDirty(node);
+}
+
+void SceneGraph::SetScale(SceneNode node, const glm::vec3& scale) {
+    scale_[node] = scale;
+    MarkDirty(node);
+}
+
+void SceneGraph::Update() {
+    stats_.updated = 0;
+    stats_.inverseNormals = 0;
+    const std::size_t count = parent_.size();
+    // Parents come first, so by the time a node is reached its parent's
+    // world matrix and dirty flag are final.
+    for (std::size_t i = firstDirty_; i < count; ++i) {
+        const SceneNode parent = parent_[i];
+        if (parent != kNoParent) {
+            dirty_[i] |= dirty_[parent];
+        }
+        if (!dirty_[i]) {
+            continue;
+        }
+        const glm::vec3& scale = scale_[i];
+        const glm::mat4 local = LocalMatrix(translation_[i], rotation_[i], scale);
+        bool uniform = scale.x == scale.y && scale.y == scale.z;
+        if (parent == kNoParent) {
+            world_[i] = local;
+        } else {
+            Multiply(world_[parent], local, world_[i]);
+            uniform = uniform && uniformScale_[parent];
+        }
+        uniformScale_[i] = uniform ? 1 : 0;
+        normal_[i] = NormalMatrix(world_[i], uniform);
+        ++stats_.updated;
+        stats_.inverseNormals += uniform ? 0 : 1;
+    }
+    if (firstDirty_ < count) {
+        std::fill(dirty_.begin() + static_cast<std::ptrdiff_t>(firstDirty_), dirty_.end(), 0);
+    }
+    firstDirty_ = count;
+}
+
+void SceneGraph::MarkDirty(SceneNode node) {
+    dirty_[node] = 1;
+    firstDirty_ = std::min<std::size_t>(firstDirty_, node);
+}
@@ -0,0 +1,73 @@
+#pragma once
+
+#include "InstanceTransform.hpp"
+
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <vector>
+
+#include <glm/glm.hpp>
+#include <glm/gtc/quaternion.hpp>
+
+// Index of a node in a SceneGraph. A parent always has a smaller one.
+using SceneNode = uint32_t;
+constexpr SceneNode kNoParent = std::numeric_limits<SceneNode>::max();
+
+struct SceneGraphStats {
+    uint32_t nodes = 0;
+    uint32_t updated = 0;        // world matrices recomputed by the last Update()
+    uint32_t inverseNormals = 0; // of those, normal matrices that needed an inverse
+};
+
+// Transform hierarchy kept as parallel arrays, one entry per node, in the
+// order nodes were added, so every parent comes before its children. Local
+// transforms are translation, rotation and scale; setting one marks the
+// node dirty. Update() then makes a single pass from the first dirty node
+// on, recomputing world = parentWorld * local (4x4 multiply with SSE2 where
+// available) for dirty nodes and everything below them, and leaves clean
+// subtrees alone.
+//
+// Normal matrices come along: a node whose scale and ancestors' scales are
+// all uniform gets its world matrix over the squared scale, the others the
+// full inverse-transpose.
+class SceneGraph {
+public:
+    void Clear();
+    void Reserve(std::size_t count);
+    // `parent` must already exist. New nodes start at the identity.
+    SceneNode Add(SceneNode parent = kNoParent);
+
+    void SetTranslation(SceneNode node, const glm::vec3& translation);
+    void SetRotation(SceneNode node, const glm::quat& rotation);
+    void SetScale(SceneNode node, const glm::vec3& scale);
+    void SetScale(SceneNode node, float scale) { SetScale(node, glm::vec3(scale)); }
+
+    void Update();
+
+    std::size_t Size() const { return parent_.size(); }
+    SceneNode Parent(SceneNode node) const { return parent_[node]; }
+    const glm::vec3& Translation(SceneNode node) const { return translation_[node]; }
+    const glm::quat& Rotation(SceneNode node) const { return rotation_[node]; }
+    const glm::vec3& Scale(SceneNode node) const { return scale_[node]; }
+    // As of the last Update().
+    const glm::mat4& World(SceneNode node) const { return world_[node]; }
+    const glm::mat3& Normal(SceneNode node) const { return normal_[node]; }
+    InstanceTransform Transform(SceneNode node) const { return InstanceTransform{world_[node], normal_[node]}; }
+
+    const SceneGraphStats& Stats() const { return stats_; }
+
+private:
+    std::vector<SceneNode> parent_;
+    std::vector<glm::vec3> translation_;
+    std::vector<glm::quat> rotation_;
+    std::vector<glm::vec3> scale_;
+    std::vector<glm::mat4> world_;
+    std::vector<glm::mat3> normal_;
+    std::vector<uint8_t> dirty_;        // local transform changed, or during Update() any ancestor's
+    std::vector<uint8_t> uniformScale_; // world matrix has no non-uniform scale
+    std::size_t firstDirty_ = 0;        // Size() when nothing is dirty
+    SceneGraphStats stats_;
+
+    void MarkDirty(SceneNode node);
+};
@@ -1,22 +1,80 @@
 #include "ShaderProgram.hpp"
 
+#include "GlCalls.hpp"
+#include "ProgramBinaryCache.hpp"
+#include "UniformBuffers.hpp"
+
+#include <bit>
+#include <chrono>
 #include <fstream>
 #include <sstream>
+#include <utility>
 #include <vector>
 
+namespace {
+
+using Clock = std::chrono::steady_clock;
+
+double MillisecondsSince(Clock::time_point start) {
+    return std::chrono::duration<double, std::milli>(Clock::now() - start).count();
+}
+
+// Defines go after #version, which must stay the first directive. A #line
+// keeps compiler messages pointing at the lines of the file on disk.
+std::string InjectDefines(const std::string& source, const std::vector<std::string>& defines) {
+    if (defines.empty()) {
+        return source;
+    }
+    std::size_t insertAt = 0;
+    std::size_t nextLine = 1;
+    const std::size_t version = source.find("#version");
+    if (version != std::string::npos) {
+        const std::size_t lineEnd = source.find('\n', version);
+        insertAt = lineEnd == std::string::npos ? source.size() : lineEnd + 1;
+        for (std::size_t i = 0; i < insertAt; ++i) {
+            nextLine += source[i] == '\n' ? 1 : 0;
+        }
+    }
+
+    std::string block;
+    if (insertAt == source.size() && (source.empty() || source.back() != '\n')) {
+        block += '\n';
+    }
+    for (const std::string& define : defines) {
+        block += "#define " + define + "\n";
+    }
+    block += "#line " + std::to_string(nextLine) + "\n";
+
+    std::string result = source;
+    result.insert(insertAt, block);
+    return result;
+}
+
+} // namespace
+
 ShaderProgram::~ShaderProgram() {
+    DiscardPending();
     Destroy();
 }
 
-ShaderProgram::ShaderProgram(ShaderProgram&& other) noexcept {
-    program_ = other.program_;
+ShaderProgram::ShaderProgram(ShaderProgram&& other) noexcept
+    : program_(other.program_),
+      loadStats_(std::move(other.loadStats_)),
+      uniforms_(std::move(other.uniforms_)),
+      uniformBlocks_(std::move(other.uniformBlocks_)),
+      pending_(std::exchange(other.pending_, PendingLoad{})) {
     other.program_ = 0;
 }
 
 ShaderProgram& ShaderProgram::operator=(ShaderProgram&& other) noexcept {
     if (this != &other) {
+        DiscardPending();
         Destroy();
         program_ = other.program_;
+        loadStats_ = std::move(other.loadStats_);
+        uniforms_ = std::move(other.uniforms_);
+        uniformBlocks_ = std::move(other.uniformBlocks_);
+        pending_ = std::exchange(other.pending_, PendingLoad{});
         other.program_ = 0;
     }
     return *this;
@@ -25,95 +83,299 @@ ShaderProgram& ShaderProgram::operator=(ShaderProgram&& other) noexcept {
 bool ShaderProgram::LoadFromFiles(const std::filesystem::path& vertexPath,
                                   const std::filesystem::path& fragmentPath,
                                   std::string* error) {
+    return LoadFromFiles(vertexPath, fragmentPath, ShaderLoadOptions{}, error);
+}
+
+bool ShaderProgram::LoadFromFiles(const std::filesystem::path& vertexPath,
+                                  const std::filesystem::path& fragmentPath,
+                                  const ShaderLoadOptions& options,
+                                  std::string* error) {
+    return BeginLoad(vertexPath, fragmentPath, options, error) && FinishLoad(error);
+}
+
+bool ShaderProgram::ParallelCompileSupported() {
+    return GLEW_KHR_parallel_shader_compile;
+}
+
+bool ShaderProgram::BeginLoad(const std::filesystem::path& vertexPath,
+                              const std::filesystem::path& fragmentPath,
+                              const ShaderLoadOptions& options,
+                              std::string* error) {
+    const auto loadStart = Clock::now();
+    DiscardPending();
+
     std::string vertexSource;
     std::string fragmentSource;
     if (!ReadFile(vertexPath, vertexSource, error) || !ReadFile(fragmentPath, fragmentSource, error)) {
         return false;
     }
+    vertexSource = InjectDefines(vertexSource, options.defines);
+    fragmentSource = InjectDefines(fragmentSource, options.defines);
 
-    std::string compileError;
-    GLuint vertexShader = CompileShader(GL_VERTEX_SHADER, vertexSource, compileError);
-    if (!vertexShader) {
-        if (error) {
-            *error = "Vertex shader error: " + compileError;
+    PendingLoad& pending = pending_;
+    pending.cache = options.binaryCache;
+    pending.cacheKey = pending.cache ? pending.cache->KeyFor(vertexSource, fragmentSource) : 0;
+    if (pending.cache) {
+        const auto binaryStart = Clock::now();
+        pending.program = glCreateProgram();
+        pending.stats.binaryCacheHit = pending.cache->Load(pending.cacheKey, pending.program);
+        pending.stats.binaryMs = MillisecondsSince(binaryStart);
+        if (pending.stats.binaryCacheHit) {
+            pending.stats.totalMs = MillisecondsSince(loadStart);
+            return true;
         }
-        return false;
+        // A rejected binary leaves the program unusable; start over.
+        glDeleteProgram(pending.program);
+        pending.program = 0;
     }
 
-    GLuint fragmentShader = CompileShader(GL_FRAGMENT_SHADER, fragmentSource, compileError);
-    if (!fragmentShader) {
-        glDeleteShader(vertexShader);
-        if (error) {
-            *error = "Fragment shader error: " + compileError;
-        }
-        return false;
+    // Only issue the work here. The statuses are read in FinishLoad(), so a
+    // driver with parallel compilation can run it on its own threads.
+    const auto compileStart = Clock::now();
+    pending.vertexShader = StartCompile(GL_VERTEX_SHADER, vertexSource);
+    pending.fragmentShader = StartCompile(GL_FRAGMENT_SHADER, fragmentSource);
+    pending.stats.compileMs = MillisecondsSince(compileStart);
+
+    const auto linkStart = Clock::now();
+    pending.program = glCreateProgram();
+    if (pending.cache && pending.cache->Enabled()) {
+        glProgramParameteri(pending.program, GL_PROGRAM_BINARY_RETRIEVABLE_HINT, GL_TRUE);
     }
+    glAttachShader(pending.program, pending.vertexShader);
+    glAttachShader(pending.program, pending.fragmentShader);
+    glLinkProgram(pending.program);
+    pending.stats.linkMs = MillisecondsSince(linkStart);
+    pending.stats.totalMs = MillisecondsSince(loadStart);
+    return true;
+}
 
-    GLuint program = glCreateProgram();
-    glAttachShader(program, vertexShader);
-    glAttachShader(program, fragmentShader);
-    glLinkProgram(program);
+bool ShaderProgram::IsLoadComplete() const {
+    if (pending_.program == 0 || !ParallelCompileSupported()) {
+        return true;
+    }
+    GLint complete = GL_TRUE;
+    glGetProgramiv(pending_.program, GL_COMPLETION_STATUS_KHR, &complete);
+    return complete == GL_TRUE;
+}
 
-    GLint linkStatus = GL_FALSE;
-    glGetProgramiv(program, GL_LINK_STATUS, &linkStatus);
-    if (linkStatus != GL_TRUE) {
-        GLint logLength = 0;
-        glGetProgramiv(program, GL_INFO_LOG_LENGTH, &logLength);
-        std::vector<GLchar> log(logLength + 1);
-        glGetProgramInfoLog(program, logLength, nullptr, log.data());
+bool ShaderProgram::FinishLoad(std::string* error) {
+    if (pending_.program == 0) {
         if (error) {
-            *error = "Program link error: " + std::string(log.data());
+            *error = "No shader load in progress";
         }
-        glDeleteShader(vertexShader);
-        glDeleteShader(fragmentShader);
-        glDeleteProgram(program);
         return false;
     }
 
-    glDetachShader(program, vertexShader);
-    glDetachShader(program, fragmentShader);
-    glDeleteShader(vertexShader);
-    glDeleteShader(fragmentShader);
+    const auto finishStart = Clock::now();
+    PendingLoad& pending = pending_;
+    if (pending.vertexShader != 0) {
+        std::string compileError;
+        if (!CheckCompile(pending.vertexShader, compileError)) {
+            if (error) {
+                *error = "Vertex shader error: " + compileError;
+            }
+            DiscardPending();
+            return false;
+        }
+        if (!CheckCompile(pending.fragmentShader, compileError)) {
+            if (error) {
+                *error = "Fragment shader error: " + compileError;
+            }
+            DiscardPending();
+            return false;
+        }
+
+        GLint linkStatus = GL_FALSE;
+        glGetProgramiv(pending.program, GL_LINK_STATUS, &linkStatus);
+        if (linkStatus != GL_TRUE) {
+            GLint logLength = 0;
+            glGetProgramiv(pending.program, GL_INFO_LOG_LENGTH, &logLength);
+            std::vector<GLchar> log(logLength + 1);
+            glGetProgramInfoLog(pending.program, logLength, nullptr, log.data());
+            if (error) {
+                *error = "Program link error: " + std::string(log.data());
+            }
+            DiscardPending();
+            return false;
+        }
+
+        glDetachShader(pending.program, pending.vertexShader);
+        glDetachShader(pending.program, pending.fragmentShader);
+        glDeleteShader(pending.vertexShader);
+        glDeleteShader(pending.fragmentShader);
+        pending.vertexShader = 0;
+        pending.fragmentShader = 0;
+        // Waiting for the driver counts as link time.
+        pending.stats.linkMs += MillisecondsSince(finishStart);
 
+        if (pending.cache && pending.cache->Enabled()) {
+            const auto storeStart = Clock::now();
+            pending.cache->Store(pending.cacheKey, pending.program, &pending.stats.cacheMessage);
+            pending.stats.binaryMs += MillisecondsSince(storeStart);
+        }
+    }
+
+    const GLuint program = pending.program;
+    ShaderLoadStats stats = std::move(pending.stats);
+    pending = PendingLoad{};
     Destroy();
     program_ = program;
+    Reflect();
+    stats.totalMs += MillisecondsSince(finishStart);
+    loadStats_ = std::move(stats);
     return true;
 }
 
+void ShaderProgram::DiscardPending() {
+    if (pending_.vertexShader != 0) {
+        glDeleteShader(pending_.vertexShader);
+    }
+    if (pending_.fragmentShader != 0) {
+        glDeleteShader(pending_.fragmentShader);
+    }
+    if (pending_.program != 0) {
+        glDeleteProgram(pending_.program);
+    }
+    pending_ = PendingLoad{};
+}
+
 void ShaderProgram::Use() const {
-    glUseProgram(program_);
+    gl::UseProgram(program_);
 }
 
-void ShaderProgram::SetMat4(const std::string& name, const glm::mat4& value) const {
-    glUniformMatrix4fv(GetUniformLocation(name), 1, GL_FALSE, &value[0][0]);
+void ShaderProgram::SetMat4(UniformName name, const glm::mat4& value) const {
+    if (GLint location = GetUniformLocation(name); location >= 0) {
+        gl::UniformMatrix4fv(location, 1, GL_FALSE, &value[0][0]);
+    }
 }
 
-void ShaderProgram::SetMat3(const std::string& name, const glm::mat3& value) const {
-    glUniformMatrix3fv(GetUniformLocation(name), 1, GL_FALSE, &value[0][0]);
+void ShaderProgram::SetMat3(UniformName name, const glm::mat3& value) const {
+    if (GLint location = GetUniformLocation(name); location >= 0) {
+        gl::UniformMatrix3fv(location, 1, GL_FALSE, &value[0][0]);
+    }
 }
 
-void ShaderProgram::SetVec3(const std::string& name, const glm::vec3& value) const {
-    glUniform3fv(GetUniformLocation(name), 1, &value[0]);
+void ShaderProgram::SetVec3(UniformName name, const glm::vec3& value) const {
+    if (GLint location = GetUniformLocation(name); location >= 0) {
+        gl::Uniform3fv(location, 1, &value[0]);
+    }
+}
+
+void ShaderProgram::SetFloat(UniformName name, float value) const {
+    if (GLint location = GetUniformLocation(name); location >= 0) {
+        gl::Uniform1f(location, value);
+    }
+}
+
+void ShaderProgram::SetInt(UniformName name, int value) const {
+    if (GLint location = GetUniformLocation(name); location >= 0) {
+        gl::Uniform1i(location, value);
+    }
+}
+
+GLint ShaderProgram::GetUniformLocation(UniformName name) const {
+    if (uniforms_.empty()) {
+        return -1;
+    }
+    const std::size_t mask = uniforms_.size() - 1;
+    for (std::size_t i = name.Hash() & mask;; i = (i + 1) & mask) {
+        const UniformSlot& slot = uniforms_[i];
+        if (slot.name.empty()) {
+            return -1;
+        }
+        if (slot.hash == name.Hash() && slot.name == name.Name()) {
+            return slot.location;
+        }
+    }
 }
 
-void ShaderProgram::SetFloat(const std::string& name, float value) const {
-    glUniform1f(GetUniformLocation(name), value);
+bool ShaderProgram::HasUniformBlock(std::string_view name) const {
+    for (const std::string& block : uniformBlocks_) {
+        if (block == name) {
+            return true;
+        }
+    }
+    return false;
 }
 
-void ShaderProgram::SetInt(const std::string& name, int value) const {
-    glUniform1i(GetUniformLocation(name), value);
+// Runs once after linking: records every active uniform's location and
+// binds shared uniform blocks and samplers to their fixed slots.
+void ShaderProgram::Reflect() {
+    uniforms_.clear();
+    uniformBlocks_.clear();
+
+    GLint uniformCount = 0;
+    GLint maxNameLength = 0;
+    glGetProgramiv(program_, GL_ACTIVE_UNIFORMS, &uniformCount);
+    glGetProgramiv(program_, GL_ACTIVE_UNIFORM_MAX_LENGTH, &maxNameLength);
+
+    // At most half full, and room for the "name[0]" -> "name" aliases.
+    uniforms_.resize(std::bit_ceil(static_cast<std::size_t>(uniformCount) * 4 + 1));
+    std::vector<GLchar> nameBuffer(static_cast<std::size_t>(maxNameLength) + 1);
+    for (GLint i = 0; i < uniformCount; ++i) {
+        GLsizei length = 0;
+        GLint size = 0;
+        GLenum type = 0;
+        glGetActiveUniform(program_, static_cast<GLuint>(i), static_cast<GLsizei>(nameBuffer.size()), &length, &size,
+                           &type, nameBuffer.data());
+        std::string name(nameBuffer.data(), static_cast<std::size_t>(length));
+        GLint location = glGetUniformLocation(program_, name.c_str());
+        if (location < 0) {
+            continue; // block member
+        }
+        GLuint unit = 0;
+        if ((type == GL_SAMPLER_2D || type == GL_SAMPLER_BUFFER) && TextureUnitFor(name, unit)) {
+            glProgramUniform1i(program_, location, static_cast<GLint>(unit));
+        }
+        // Arrays report "name[0]"; accept the bare name as well.
+        if (name.size() > 3 && name.compare(name.size() - 3, 3, "[0]") == 0) {
+            InsertUniform(name.substr(0, name.size() - 3), location);
+        }
+        InsertUniform(std::move(name), location);
+    }
+
+    GLint blockCount = 0;
+    GLint maxBlockNameLength = 0;
+    glGetProgramiv(program_, GL_ACTIVE_UNIFORM_BLOCKS, &blockCount);
+    glGetProgramiv(program_, GL_ACTIVE_UNIFORM_BLOCK_MAX_NAME_LENGTH, &maxBlockNameLength);
+    nameBuffer.assign(static_cast<std::size_t>(maxBlockNameLength) + 1, '\0');
+    for (GLint i = 0; i < blockCount; ++i) {
+        GLsizei length = 0;
+        glGetActiveUniformBlockName(program_, static_cast<GLuint>(i), static_cast<GLsizei>(nameBuffer.size()), &length,
+                                    nameBuffer.data());
+        std::string name(nameBuffer.data(), static_cast<std::size_t>(length));
+        GLuint binding = 0;
+        if (UniformBlockBindingFor(name, binding)) {
+            glUniformBlockBinding(program_, static_cast<GLuint>(i), binding);
+        }
+        uniformBlocks_.push_back(std::move(name));
+    }
 }
 
-GLint ShaderProgram::GetUniformLocation(const std::string& name) const {
-    return glGetUniformLocation(program_, name.c_str());
+void ShaderProgram::InsertUniform(std::string name, GLint location) {
+    const uint32_t hash = hash::Name32(name);
+    const std::size_t mask = uniforms_.size() - 1;
+    for (std::size_t i = hash & mask;; i = (i + 1) & mask) {
+        UniformSlot& slot = uniforms_[i];
+        if (slot.name.empty()) {
+            slot = UniformSlot{hash, location, std::move(name)};
+            return;
+        }
+        if (slot.hash == hash && slot.name == name) {
+            return;
+        }
+    }
 }
 
-GLuint ShaderProgram::CompileShader(GLenum type, const std::string& source, std::string& error) {
+GLuint ShaderProgram::StartCompile(GLenum type, const std::string& source) {
     GLuint shader = glCreateShader(type);
     const GLchar* data = source.c_str();
     glShaderSource(shader, 1, &data, nullptr);
     glCompileShader(shader);
+    return shader;
+}
 
+bool ShaderProgram::CheckCompile(GLuint shader, std::string& error) {
     GLint compileStatus = GL_FALSE;
     glGetShaderiv(shader, GL_COMPILE_STATUS, &compileStatus);
     if (compileStatus != GL_TRUE) {
@@ -122,10 +384,9 @@ GLuint ShaderProgram::CompileShader(GLenum type, const std::string& source, std:
         std::vector<GLchar> log(logLength + 1);
         glGetShaderInfoLog(shader, logLength, nullptr, log.data());
         error = log.data();
-        glDeleteShader(shader);
-        return 0;
+        return false;
     }
-    return shader;
+    return true;
 }
 
 bool ShaderProgram::ReadFile(const std::filesystem::path& path, std::string& out, std::string* error) {
@@ -147,5 +408,7 @@ void ShaderProgram::Destroy() {
         glDeleteProgram(program_);
         program_ = 0;
     }
+    uniforms_.clear();
+    uniformBlocks_.clear();
 }
 
@@ -1,11 +1,54 @@
 #pragma once
 
+#include "Hash.hpp"
+
+#include <cstddef>
+#include <cstdint>
 #include <filesystem>
 #include <glm/glm.hpp>
 #include <string>
+#include <string_view>
+#include <vector>
 
 #include <GL/glew.h>
 
+class ProgramBinaryCache;
+
+struct ShaderLoadOptions {
+    // Each entry becomes "#define <entry>" right after the #version line,
+    // e.g. "USE_FOG" or "LIGHT_COUNT 4".
+    std::vector<std::string> defines;
+    // Reuse linked program binaries across runs; only used during the load.
+    ProgramBinaryCache* binaryCache = nullptr;
+};
+
+// Times spent on the calling thread. With parallel compilation the driver
+// works in the background, so these stay small until FinishLoad() waits.
+struct ShaderLoadStats {
+    bool binaryCacheHit = false;
+    double compileMs = 0.0; // both stages; 0 on a cache hit
+    double linkMs = 0.0;    // includes waiting for the driver in FinishLoad()
+    double binaryMs = 0.0;  // glProgramBinary on a hit, glGetProgramBinary + write on a miss
+    double totalMs = 0.0;
+    std::string cacheMessage; // why a fresh binary could not be stored
+};
+
+// Uniform name with its hash. String literals are hashed at compile time, so
+// SetMat4("uModel", ...) costs a table probe instead of glGetUniformLocation.
+class UniformName {
+public:
+    template <std::size_t N>
+    consteval UniformName(const char (&name)[N]) : name_(name, N - 1), hash_(hash::Name32(name_)) {}
+    explicit UniformName(std::string_view name) : name_(name), hash_(hash::Name32(name)) {}
+
+    std::string_view Name() const { return name_; }
+    uint32_t Hash() const { return hash_; }
+
+private:
+    std::string_view name_;
+    uint32_t hash_;
+};
+
 class ShaderProgram {
 public:
     ShaderProgram() = default;
@@ -20,21 +63,71 @@ public:
     bool LoadFromFiles(const std::filesystem::path& vertexPath,
                        const std::filesystem::path& fragmentPath,
                        std::string* error = nullptr);
+    bool LoadFromFiles(const std::filesystem::path& vertexPath,
+                       const std::filesystem::path& fragmentPath,
+                       const ShaderLoadOptions& options,
+                       std::string* error = nullptr);
+
+    // LoadFromFiles() in two steps. BeginLoad() only issues the compile and
+    // link; FinishLoad() reads their status and swaps the new program in.
+    // With GL_KHR_parallel_shader_compile the driver compiles in between,
+    // and IsLoadComplete() says when FinishLoad() will not block.
+    bool BeginLoad(const std::filesystem::path& vertexPath,
+                   const std::filesystem::path& fragmentPath,
+                   const ShaderLoadOptions& options,
+                   std::string* error = nullptr);
+    bool IsLoadComplete() const;
+    bool FinishLoad(std::string* error = nullptr);
+    bool IsLoadPending() const { return pending_.program != 0; }
+
+    static bool ParallelCompileSupported();
 
     void Use() const;
+    const ShaderLoadStats& LoadStats() const { return loadStats_; }
     GLuint GetHandle() const { return program_; }
 
-    void SetMat4(const std::string& name, const glm::mat4& value) const;
-    void SetMat3(const std::string& name, const glm::mat3& value) const;
-    void SetVec3(const std::string& name, const glm::vec3& value) const;
-    void SetFloat(const std::string& name, float value) const;
-    void SetInt(const std::string& name, int value) const;
+    // Uniforms the program does not use (e.g. optimised out) are skipped
+    // without a GL call.
+    void SetMat4(UniformName name, const glm::mat4& value) const;
+    void SetMat3(UniformName name, const glm::mat3& value) const;
+    void SetVec3(UniformName name, const glm::vec3& value) const;
+    void SetFloat(UniformName name, float value) const;
+    void SetInt(UniformName name, int value) const;
+
+    // -1 when the uniform is not active. Uniforms inside blocks have none.
+    GLint GetUniformLocation(UniformName name) const;
+    bool HasUniformBlock(std::string_view name) const;
 
 private:
+    struct UniformSlot {
+        uint32_t hash = 0;
+        GLint location = -1;
+        std::string name; // empty marks a free slot
+    };
+
+    // A load between BeginLoad() and FinishLoad(). vertexShader is 0 when
+    // the program came from the binary cache.
+    struct PendingLoad {
+        GLuint program = 0;
+        GLuint vertexShader = 0;
+        GLuint fragmentShader = 0;
+        ProgramBinaryCache* cache = nullptr;
+        uint64_t cacheKey = 0;
+        ShaderLoadStats stats;
+    };
+
     GLuint program_ = 0;
+    ShaderLoadStats loadStats_;
+    // Open-addressing table filled by Reflect(); power-of-two sized.
+    std::vector<UniformSlot> uniforms_;
+    std::vector<std::string> uniformBlocks_;
+    PendingLoad pending_;
 
-    GLint GetUniformLocation(const std::string& name) const;
-    GLuint CompileShader(GLenum type, const std::string& source, std::string& error);
+    void Reflect();
+    void InsertUniform(std::string name, GLint location);
+    void DiscardPending();
+    static GLuint StartCompile(GLenum type, const std::string& source);
+    static bool CheckCompile(GLuint shader, std::string& error);
     static bool ReadFile(const std::filesystem::path& path, std::string& out, std::string* error);
     void Destroy();
 };
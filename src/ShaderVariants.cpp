@@ -0,0 +1,241 @@
+#include "ShaderVariants.hpp"
+
+#include <iterator>
+
+namespace {
+
+constexpr const char* kFeatureDefines[] = {
+    "HAS_DIFFUSE_MAP",
+    "HAS_NORMAL_MAP",
+};
+static_assert(std::size(kFeatureDefines) == static_cast<std::size_t>(ShaderFeature::Count));
+
+std::string VariantLabel(ShaderFeatures features) {
+    return "Shader variant " + std::to_string(features.Bits());
+}
+
+const std::string kGenericLabel = "Generic shader";
+
+} // namespace
+
+std::vector<std::string> ShaderFeatures::Defines() const {
+    std::vector<std::string> defines{"MATERIAL_VARIANT"};
+    for (uint32_t i = 0; i < static_cast<uint32_t>(ShaderFeature::Count); ++i) {
+        if (Has(static_cast<ShaderFeature>(i))) {
+            defines.emplace_back(kFeatureDefines[i]);
+        }
+    }
+    return defines;
+}
+
+bool ShaderVariants::Load(const std::filesystem::path& vertexPath,
+                          const std::filesystem::path& fragmentPath,
+                          const ShaderLoadOptions& options,
+                          std::string* error) {
+    Destroy();
+    if (!generic_.LoadFromFiles(vertexPath, fragmentPath, options, error)) {
+        return false;
+    }
+    vertexPath_ = vertexPath;
+    fragmentPath_ = fragmentPath;
+    options_ = options;
+
+    parallel_ = ShaderProgram::ParallelCompileSupported();
+    if (parallel_) {
+        // Let the driver use as many compiler threads as it likes.
+        glMaxShaderCompilerThreadsKHR(0xFFFFFFFFu);
+    }
+    return true;
+}
+
+void ShaderVariants::Request(ShaderFeatures features) {
+    Variant& variant = variants_[features.Bits()];
+    if (variant.state != VariantState::Unused) {
+        return;
+    }
+    if (PendingCount() == 0) {
+        firstRequest_ = Clock::now();
+    }
+    variant.state = VariantState::Queued;
+    if (parallel_) {
+        Begin(features);
+    }
+}
+
+std::size_t ShaderVariants::Pump(std::size_t maxCompiles) {
+    std::size_t finished = 0;
+    std::size_t compiles = 0;
+
+    if (generic_.IsLoadPending() && generic_.IsLoadComplete()) {
+        FinishReload(generic_, kGenericLabel);
+        ++finished;
+    } else if (genericReloadQueued_ && compiles < maxCompiles) {
+        genericReloadQueued_ = false;
+        BeginReload(generic_, options_, kGenericLabel);
+        FinishReload(generic_, kGenericLabel);
+        ++compiles;
+        ++finished;
+    }
+
+    for (uint32_t bits = 0; bits < ShaderFeatures::kCombinations; ++bits) {
+        Variant& variant = variants_[bits];
+        if (variant.state == VariantState::Ready) {
+            if (variant.program.IsLoadPending() && variant.program.IsLoadComplete()) {
+                FinishReload(variant.program, VariantLabel(ShaderFeatures(bits)));
+                ++finished;
+            } else if (variant.reloadQueued && compiles < maxCompiles) {
+                variant.reloadQueued = false;
+                BeginReload(variant.program, OptionsFor(ShaderFeatures(bits)), VariantLabel(ShaderFeatures(bits)));
+                FinishReload(variant.program, VariantLabel(ShaderFeatures(bits)));
+                ++compiles;
+                ++finished;
+            }
+        } else if (variant.state == VariantState::Compiling && variant.program.IsLoadComplete()) {
+            Complete(ShaderFeatures(bits));
+            ++finished;
+        } else if (variant.state == VariantState::Queued && compiles < maxCompiles) {
+            // Deferred path: build synchronously, but only a few per frame.
+            Begin(ShaderFeatures(bits));
+            if (variant.state == VariantState::Compiling) {
+                Complete(ShaderFeatures(bits));
+            }
+            ++compiles;
+            ++finished;
+        }
+    }
+    return finished;
+}
+
+void ShaderVariants::Finish() {
+    for (uint32_t bits = 0; bits < ShaderFeatures::kCombinations; ++bits) {
+        Variant& variant = variants_[bits];
+        if (variant.state == VariantState::Queued) {
+            Begin(ShaderFeatures(bits));
+        }
+        if (variant.state == VariantState::Compiling) {
+            Complete(ShaderFeatures(bits));
+        }
+    }
+}
+
+void ShaderVariants::Reload() {
+    if (parallel_) {
+        BeginReload(generic_, options_, kGenericLabel);
+    } else {
+        genericReloadQueued_ = true;
+    }
+
+    for (uint32_t bits = 0; bits < ShaderFeatures::kCombinations; ++bits) {
+        Variant& variant = variants_[bits];
+        switch (variant.state) {
+        case VariantState::Ready:
+            if (parallel_) {
+                BeginReload(variant.program, OptionsFor(ShaderFeatures(bits)), VariantLabel(ShaderFeatures(bits)));
+            } else {
+                variant.reloadQueued = true;
+            }
+            break;
+        case VariantState::Failed:
+            // The edit may have fixed it.
+            variant.state = VariantState::Unused;
+            Request(ShaderFeatures(bits));
+            break;
+        case VariantState::Compiling:
+            // Restart from the new source; BeginLoad() drops the old work.
+            Begin(ShaderFeatures(bits));
+            break;
+        case VariantState::Unused:
+        case VariantState::Queued:
+            break;
+        }
+    }
+}
+
+std::size_t ShaderVariants::ReloadPendingCount() const {
+    std::size_t count = generic_.IsLoadPending() || genericReloadQueued_ ? 1 : 0;
+    for (const Variant& variant : variants_) {
+        if (variant.state == VariantState::Ready && (variant.program.IsLoadPending() || variant.reloadQueued)) {
+            ++count;
+        }
+    }
+    return count;
+}
+
+const ShaderProgram& ShaderVariants::Get(ShaderFeatures features) const {
+    const Variant& variant = variants_[features.Bits()];
+    return variant.state == VariantState::Ready ? variant.program : generic_;
+}
+
+std::size_t ShaderVariants::PendingCount() const {
+    std::size_t count = 0;
+    for (const Variant& variant : variants_) {
+        count += variant.state == VariantState::Queued || variant.state == VariantState::Compiling ? 1 : 0;
+    }
+    return count;
+}
+
+ShaderLoadOptions ShaderVariants::OptionsFor(ShaderFeatures features) const {
+    ShaderLoadOptions options = options_;
+    for (std::string& define : features.Defines()) {
+        options.defines.push_back(std::move(define));
+    }
+    return options;
+}
+
+void ShaderVariants::Begin(ShaderFeatures features) {
+    Variant& variant = variants_[features.Bits()];
+    std::string error;
+    if (!variant.program.BeginLoad(vertexPath_, fragmentPath_, OptionsFor(features), &error)) {
+        variant.state = VariantState::Failed;
+        ++stats_.failed;
+        errors_.push_back(VariantLabel(features) + ": " + error);
+        return;
+    }
+    variant.state = VariantState::Compiling;
+}
+
+void ShaderVariants::Complete(ShaderFeatures features) {
+    Variant& variant = variants_[features.Bits()];
+    std::string error;
+    if (variant.program.FinishLoad(&error)) {
+        variant.state = VariantState::Ready;
+        ++stats_.ready;
+        const ShaderLoadStats& loadStats = variant.program.LoadStats();
+        stats_.threadMs += loadStats.totalMs;
+        stats_.binaryCacheHits += loadStats.binaryCacheHit ? 1 : 0;
+    } else {
+        // Draws keep using the generic program.
+        variant.state = VariantState::Failed;
+        ++stats_.failed;
+        errors_.push_back(VariantLabel(features) + ": " + error);
+    }
+    if (PendingCount() == 0) {
+        stats_.latencyMs = std::chrono::duration<double, std::milli>(Clock::now() - firstRequest_).count();
+    }
+}
+
+void ShaderVariants::BeginReload(ShaderProgram& program, const ShaderLoadOptions& options, const std::string& label) {
+    std::string error;
+    if (!program.BeginLoad(vertexPath_, fragmentPath_, options, &error)) {
+        errors_.push_back(label + ": " + error);
+    }
+}
+
+void ShaderVariants::FinishReload(ShaderProgram& program, const std::string& label) {
+    std::string error;
+    if (program.IsLoadPending() && !program.FinishLoad(&error)) {
+        errors_.push_back(label + ": " + error);
+    }
+}
+
+void ShaderVariants::Destroy() {
+    for (Variant& variant : variants_) {
+        variant.program = ShaderProgram();
+        variant.state = VariantState::Unused;
+        variant.reloadQueued = false;
+    }
+    generic_ = ShaderProgram();
+    genericReloadQueued_ = false;
+    stats_ = ShaderVariantStats{};
+    errors_.clear();
+}
@@ -0,0 +1,132 @@
+#pragma once
+
+#include "ShaderProgram.hpp"
+
+#include <array>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <filesystem>
+#include <string>
+#include <vector>
+
+// Material features a shader can be specialized for. Each one becomes a
+// define in the variant's source.
+enum class ShaderFeature : uint32_t {
+    DiffuseMap, // HAS_DIFFUSE_MAP
+    NormalMap,  // HAS_NORMAL_MAP
+    Count,
+};
+
+// Bitset of ShaderFeature naming one variant.
+class ShaderFeatures {
+public:
+    static constexpr uint32_t kCombinations = 1u << static_cast<uint32_t>(ShaderFeature::Count);
+
+    constexpr ShaderFeatures() = default;
+    constexpr explicit ShaderFeatures(uint32_t bits) : bits_(bits & (kCombinations - 1)) {}
+
+    constexpr ShaderFeatures& Set(ShaderFeature feature, bool enabled = true) {
+        const uint32_t bit = 1u << static_cast<uint32_t>(feature);
+        bits_ = enabled ? bits_ | bit : bits_ & ~bit;
+        return *this;
+    }
+    constexpr bool Has(ShaderFeature feature) const { return (bits_ >> static_cast<uint32_t>(feature)) & 1u; }
+    constexpr uint32_t Bits() const { return bits_; }
+
+    friend constexpr bool operator==(ShaderFeatures, ShaderFeatures) = default;
+
+    // MATERIAL_VARIANT plus one define per enabled feature.
+    std::vector<std::string> Defines() const;
+
+private:
+    uint32_t bits_ = 0;
+};
+
+struct ShaderVariantStats {
+    uint32_t ready = 0;
+    uint32_t failed = 0;
+    uint32_t binaryCacheHits = 0;
+    double threadMs = 0.0;  // GL-thread time spent in BeginLoad/FinishLoad
+    double latencyMs = 0.0; // first Request() until the last variant finished
+};
+
+// Specialized builds of one vertex/fragment pair, one per ShaderFeatures.
+// The generic program (no MATERIAL_VARIANT, branches on the material at
+// runtime) loads synchronously and stands in for every variant that is not
+// ready, so draws never wait for a compile. With
+// GL_KHR_parallel_shader_compile requested variants compile on driver
+// threads; otherwise Pump() builds a few of them per call.
+class ShaderVariants {
+public:
+    ShaderVariants() = default;
+
+    ShaderVariants(const ShaderVariants&) = delete;
+    ShaderVariants& operator=(const ShaderVariants&) = delete;
+
+    // The options' defines apply to every variant.
+    bool Load(const std::filesystem::path& vertexPath,
+              const std::filesystem::path& fragmentPath,
+              const ShaderLoadOptions& options,
+              std::string* error = nullptr);
+
+    void Request(ShaderFeatures features);
+
+    // Finishes variants the driver is done with or, without parallel
+    // compilation, builds up to maxCompiles queued ones. Call once per frame;
+    // returns how many variants were finished.
+    std::size_t Pump(std::size_t maxCompiles = 1);
+
+    // Blocks until every requested variant is ready (or failed).
+    void Finish();
+
+    // Rebuilds the generic program and every variant from the files on disk.
+    // The old programs keep drawing until Pump() swaps in the replacements;
+    // one that fails to build is dropped (see Errors()) and the old stays.
+    void Reload();
+    std::size_t ReloadPendingCount() const;
+
+    const std::filesystem::path& VertexPath() const { return vertexPath_; }
+    const std::filesystem::path& FragmentPath() const { return fragmentPath_; }
+
+    // The specialized program if it is ready, the generic one otherwise.
+    const ShaderProgram& Get(ShaderFeatures features) const;
+    const ShaderProgram& Generic() const { return generic_; }
+
+    bool Parallel() const { return parallel_; }
+    std::size_t PendingCount() const;
+    const ShaderVariantStats& Stats() const { return stats_; }
+    // One message per failed build or reload, oldest first.
+    const std::vector<std::string>& Errors() const { return errors_; }
+
+    void Destroy();
+
+private:
+    using Clock = std::chrono::steady_clock;
+
+    enum class VariantState : uint8_t { Unused, Queued, Compiling, Ready, Failed };
+
+    struct Variant {
+        ShaderProgram program;
+        VariantState state = VariantState::Unused;
+        bool reloadQueued = false; // deferred path: rebuild on a later Pump()
+    };
+
+    std::filesystem::path vertexPath_;
+    std::filesystem::path fragmentPath_;
+    ShaderLoadOptions options_;
+    ShaderProgram generic_;
+    bool genericReloadQueued_ = false;
+    std::array<Variant, ShaderFeatures::kCombinations> variants_;
+    bool parallel_ = false;
+    Clock::time_point firstRequest_;
+    ShaderVariantStats stats_;
+    std::vector<std::string> errors_;
+
+    ShaderLoadOptions OptionsFor(ShaderFeatures features) const;
+    void Begin(ShaderFeatures features);
+    void Complete(ShaderFeatures features);
+    // Reloads of programs that are already in use; failures keep the old one.
+    void BeginReload(ShaderProgram& program, const ShaderLoadOptions& options, const std::string& label);
+    void FinishReload(ShaderProgram& program, const std::string& label);
+};
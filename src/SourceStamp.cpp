@@ -0,0 +1,59 @@
+#include "SourceStamp.hpp"
+
+#include "Hash.hpp"
+#include "MappedFile.hpp"
+
+#include <system_error>
+
+bool StatSource(const std::filesystem::path& path, SourceStamp& stamp) {
+    std::error_code ec;
+    auto size = std::filesystem::file_size(path, ec);
+    if (ec) {
+        return false;
+    }
+    auto mtime = std::filesystem::last_write_time(path, ec);
+    if (ec) {
+        return false;
+    }
+    stamp.size = static_cast<uint64_t>(size);
+    stamp.mtime = static_cast<int64_t>(mtime.time_since_epoch().count());
+    return true;
+}
+
+bool HashSource(const std::filesystem::path& path, uint64_t& outHash) {
+    MappedFile file;
+    if (!file.Open(path)) {
+        return false;
+    }
+    outHash = hash::Bytes64(file.Data(), file.Size());
+    return true;
+}
+
+bool StampSource(const std::filesystem::path& path, SourceStamp& stamp) {
+    return StatSource(path, stamp) && HashSource(path, stamp.contentHash);
+}
+
+bool SourceUnchanged(const std::filesystem::path& path, const SourceStamp& cached, SourceStamp* current) {
+    SourceStamp stamp;
+    if (cached.mtime == kMissingSourceMtime) {
+        if (StatSource(path, stamp)) {
+            return false;
+        }
+        stamp = cached;
+    } else {
+        if (!StatSource(path, stamp) || stamp.size != cached.size) {
+            return false;
+        }
+        if (stamp.mtime != cached.mtime) {
+            uint64_t contentHash = 0;
+            if (!HashSource(path, contentHash) || contentHash != cached.contentHash) {
+                return false;
+            }
+        }
+        stamp.contentHash = cached.contentHash;
+    }
+    if (current) {
+        *current = stamp;
+    }
+    return true;
+}
@@ -0,0 +1,30 @@
+#pragma once
+
+#include <cstdint>
+#include <filesystem>
+#include <limits>
+
+// mtime of a source that did not exist when the cache was built; the cache
+// goes stale once the file appears.
+constexpr int64_t kMissingSourceMtime = std::numeric_limits<int64_t>::min();
+
+// Identity of a source file a cache was built from.
+struct SourceStamp {
+    uint64_t size = 0;
+    int64_t mtime = 0;
+    uint64_t contentHash = 0;
+};
+
+// Fills size and mtime only.
+bool StatSource(const std::filesystem::path& path, SourceStamp& stamp);
+
+bool HashSource(const std::filesystem::path& path, uint64_t& outHash);
+
+// Size, mtime and content hash.
+bool StampSource(const std::filesystem::path& path, SourceStamp& stamp);
+
+// Compares by size and mtime first and by content hash when only the mtime
+// changed (e.g. after a fresh checkout). On success `current` gets the
+// file's stamp, so a caller can store the new mtime and skip the hash next
+// time.
+bool SourceUnchanged(const std::filesystem::path& path, const SourceStamp& cached, SourceStamp* current = nullptr);
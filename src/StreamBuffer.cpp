@@ -0,0 +1,189 @@
+#include "StreamBuffer.hpp"
+
+#include "GlCalls.hpp"
+
+#include <algorithm>
+#include <chrono>
+
+namespace {
+
+// Keeps every region aligned for any uniform block offset alignment.
+constexpr GLsizeiptr kRegionAlignment = 256;
+
+GLintptr AlignUp(GLintptr value, GLsizeiptr alignment) {
+    return alignment > 1 ? (value + alignment - 1) / alignment * alignment : value;
+}
+
+} // namespace
+
+StreamBuffer::~StreamBuffer() {
+    Destroy();
+}
+
+bool StreamBuffer::Create(GLsizeiptr bytesPerFrame, int frames, std::string* error) {
+    Destroy();
+    if (bytesPerFrame <= 0 || frames < 1) {
+        if (error) {
+            *error = "A stream buffer needs at least one frame of a positive size.";
+        }
+        return false;
+    }
+    regionSize_ = AlignUp(bytesPerFrame, kRegionAlignment);
+    const GLsizeiptr totalSize = regionSize_ * frames;
+    persistent_ = GLEW_VERSION_4_4 || GLEW_ARB_buffer_storage;
+
+    glGenBuffers(1, &buffer_);
+    glBindBuffer(GL_COPY_WRITE_BUFFER, buffer_);
+    if (persistent_) {
+        const GLbitfield flags = GL_MAP_WRITE_BIT | GL_MAP_PERSISTENT_BIT | GL_MAP_COHERENT_BIT;
+        glBufferStorage(GL_COPY_WRITE_BUFFER, totalSize, nullptr, flags);
+        persistentData_ = static_cast<char*>(glMapBufferRange(GL_COPY_WRITE_BUFFER, 0, totalSize, flags));
+    } else {
+        glBufferData(GL_COPY_WRITE_BUFFER, totalSize, nullptr, GL_STREAM_DRAW);
+    }
+    glBindBuffer(GL_COPY_WRITE_BUFFER, 0);
+    if (persistent_ && !persistentData_) {
+        Destroy();
+        if (error) {
+            *error = "Failed to map a " + std::to_string(totalSize) + " byte persistent stream buffer.";
+        }
+        return false;
+    }
+    fences_.assign(static_cast<std::size_t>(frames), nullptr);
+    // The first BeginFrame() moves on to region 0.
+    region_ = fences_.size() - 1;
+    return true;
+}
+
+void StreamBuffer::Destroy() {
+    if (buffer_ != 0) {
+        if (persistentData_ || mappedData_) {
+            glBindBuffer(GL_COPY_WRITE_BUFFER, buffer_);
+            glUnmapBuffer(GL_COPY_WRITE_BUFFER);
+            glBindBuffer(GL_COPY_WRITE_BUFFER, 0);
+        }
+        glDeleteBuffers(1, &buffer_);
+        buffer_ = 0;
+    }
+    for (GLsync& fence : fences_) {
+        if (fence) {
+            glDeleteSync(fence);
+        }
+    }
+    fences_.clear();
+    persistentData_ = nullptr;
+    mappedData_ = nullptr;
+    regionSize_ = 0;
+    head_ = 0;
+    inFrame_ = false;
+}
+
+void StreamBuffer::BeginFrame() {
+    if (buffer_ == 0) {
+        return;
+    }
+    if (inFrame_) {
+        EndFrame();
+    }
+    region_ = (region_ + 1) % fences_.size();
+    head_ = RegionStart();
+    inFrame_ = true;
+
+    GLsync& fence = fences_[region_];
+    if (!fence) {
+        return;
+    }
+    if (gl::ClientWaitSync(fence, 0, 0) == GL_TIMEOUT_EXPIRED) {
+        if (persistent_) {
+            // The GPU is more than a ring behind; nothing to do but wait.
+            const auto start = std::chrono::steady_clock::now();
+            GLbitfield flags = GL_SYNC_FLUSH_COMMANDS_BIT;
+            while (gl::ClientWaitSync(fence, flags, 1'000'000'000) == GL_TIMEOUT_EXPIRED) {
+                flags = 0;
+            }
+            ++stats_.fenceWaits;
+            stats_.fenceWaitMs += std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+        } else {
+            // Fresh storage for the whole ring; the driver frees the old
+            // one once the GPU is done with it, so no region is in use.
+            gl::BindBuffer(GL_COPY_WRITE_BUFFER, buffer_);
+            gl::BufferData(GL_COPY_WRITE_BUFFER, regionSize_ * static_cast<GLsizeiptr>(fences_.size()), nullptr,
+                           GL_STREAM_DRAW);
+            gl::BindBuffer(GL_COPY_WRITE_BUFFER, 0);
+            ++stats_.orphans;
+            for (GLsync& other : fences_) {
+                if (other && &other != &fence) {
+                    gl::DeleteSync(other);
+                    other = nullptr;
+                }
+            }
+        }
+    }
+    gl::DeleteSync(fence);
+    fence = nullptr;
+}
+
+StreamAllocation StreamBuffer::Allocate(GLsizeiptr size, GLsizeiptr alignment) {
+    if (!inFrame_ || size <= 0) {
+        return {};
+    }
+    const GLintptr offset = AlignUp(head_, alignment);
+    if (offset + size > RegionStart() + regionSize_) {
+        ++stats_.overflows;
+        return {};
+    }
+    StreamAllocation allocation;
+    if (persistent_) {
+        allocation.data = persistentData_ + offset;
+    } else {
+        if (!mappedData_ && !MapRest()) {
+            return {};
+        }
+        allocation.data = mappedData_ + (offset - mappedOffset_);
+    }
+    allocation.offset = offset;
+    allocation.size = size;
+    head_ = offset + size;
+    return allocation;
+}
+
+void StreamBuffer::Commit() {
+    if (!mappedData_) {
+        return;
+    }
+    gl::BindBuffer(GL_COPY_WRITE_BUFFER, buffer_);
+    gl::FlushMappedBufferRange(GL_COPY_WRITE_BUFFER, 0, head_ - mappedOffset_);
+    gl::UnmapBuffer(GL_COPY_WRITE_BUFFER);
+    gl::BindBuffer(GL_COPY_WRITE_BUFFER, 0);
+    mappedData_ = nullptr;
+}
+
+void StreamBuffer::EndFrame() {
+    if (!inFrame_) {
+        return;
+    }
+    Commit();
+    fences_[region_] = gl::FenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+    stats_.frameBytes = head_ - RegionStart();
+    stats_.peakFrameBytes = std::max(stats_.peakFrameBytes, stats_.frameBytes);
+    inFrame_ = false;
+}
+
+void StreamBuffer::BindRange(GLenum target, GLuint index, const StreamAllocation& allocation) const {
+    gl::BindBufferRange(target, index, buffer_, allocation.offset, allocation.size);
+}
+
+bool StreamBuffer::MapRest() {
+    // Unsynchronized is safe: the fences keep the GPU off this region.
+    const GLsizeiptr length = RegionStart() + regionSize_ - head_;
+    if (length <= 0) {
+        return false;
+    }
+    gl::BindBuffer(GL_COPY_WRITE_BUFFER, buffer_);
+    mappedData_ = static_cast<char*>(gl::MapBufferRange(GL_COPY_WRITE_BUFFER, head_, length,
+                                                        GL_MAP_WRITE_BIT | GL_MAP_INVALIDATE_RANGE_BIT |
+                                                            GL_MAP_UNSYNCHRONIZED_BIT | GL_MAP_FLUSH_EXPLICIT_BIT));
+    gl::BindBuffer(GL_COPY_WRITE_BUFFER, 0);
+    mappedOffset_ = head_;
+    return mappedData_ != nullptr;
+}
@@ -0,0 +1,83 @@
+#pragma once
+
+#include <GL/glew.h>
+
+#include <cstddef>
+#include <string>
+#include <vector>
+
+// A range of a StreamBuffer to write this frame's data into.
+struct StreamAllocation {
+    void* data = nullptr;
+    GLintptr offset = 0; // in the buffer, for glBindBufferRange and attribute pointers
+    GLsizeiptr size = 0;
+
+    explicit operator bool() const { return data != nullptr; }
+};
+
+struct StreamBufferStats {
+    GLsizeiptr frameBytes = 0;     // allocated in the last finished frame
+    GLsizeiptr peakFrameBytes = 0;
+    std::size_t overflows = 0;     // Allocate() calls that did not fit
+    std::size_t fenceWaits = 0;    // frames that found their region still in use
+    double fenceWaitMs = 0.0;
+    std::size_t orphans = 0;       // fallback only: storage replaced instead
+};
+
+// Ring of per-frame regions for data the CPU rewrites every frame (uniform
+// blocks, instance attributes). Each frame sub-allocates from its own
+// region; EndFrame() fences it, and BeginFrame() only reuses a region the
+// GPU has finished with, so writes go straight into mapped memory without
+// glBufferSubData copies or driver synchronization.
+//
+// With GL 4.4 or ARB_buffer_storage the buffer stays persistently and
+// coherently mapped. Otherwise each frame's writes are mapped unsynchronized
+// and flushed by Commit(); a region still in use makes the driver orphan the
+// storage instead of waiting.
+class StreamBuffer {
+public:
+    StreamBuffer() = default;
+    ~StreamBuffer();
+
+    StreamBuffer(const StreamBuffer&) = delete;
+    StreamBuffer& operator=(const StreamBuffer&) = delete;
+
+    bool Create(GLsizeiptr bytesPerFrame, int frames = 3, std::string* error = nullptr);
+    void Destroy();
+
+    void BeginFrame();
+    // `alignment` need not be a power of two. Returns an empty allocation
+    // when the frame's region is full.
+    StreamAllocation Allocate(GLsizeiptr size, GLsizeiptr alignment = 16);
+    // Makes the writes so far visible to the GPU; call before drawing from
+    // them. Free with persistent mapping.
+    void Commit();
+    void EndFrame();
+
+    // glBindBufferRange for an allocation, e.g. to a uniform block binding.
+    void BindRange(GLenum target, GLuint index, const StreamAllocation& allocation) const;
+
+    GLuint Handle() const { return buffer_; }
+    bool Persistent() const { return persistent_; }
+    GLsizeiptr BytesPerFrame() const { return regionSize_; }
+    const StreamBufferStats& Stats() const { return stats_; }
+
+private:
+    GLuint buffer_ = 0;
+    bool persistent_ = false;
+    GLsizeiptr regionSize_ = 0;
+    std::vector<GLsync> fences_; // one per region, null once retired
+    std::size_t region_ = 0;
+    GLintptr head_ = 0;          // next free byte in the buffer
+    bool inFrame_ = false;
+
+    char* persistentData_ = nullptr;
+    // Fallback: the currently mapped range, starting at mappedOffset_.
+    char* mappedData_ = nullptr;
+    GLintptr mappedOffset_ = 0;
+
+    StreamBufferStats stats_;
+
+    GLintptr RegionStart() const { return static_cast<GLintptr>(region_) * regionSize_; }
+    bool MapRest();
+};
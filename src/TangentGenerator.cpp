@@ -0,0 +1,304 @@
+#include "TangentGenerator.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define TANGENT_GENERATOR_SSE2 1
+#include <emmintrin.h>
+#endif
+
+namespace {
+
+constexpr float kPi = 3.14159265358979f;
+constexpr float kEpsilon = 1e-20f;
+constexpr uint32_t kNoClone = std::numeric_limits<uint32_t>::max();
+
+// Four float lanes. The scalar build performs the same IEEE operations in
+// the same order, so both produce identical tangents.
+#if TANGENT_GENERATOR_SSE2
+struct Float4 {
+    __m128 v;
+
+    static Float4 Load(const float* p) { return {_mm_loadu_ps(p)}; }
+    static Float4 Splat(float a) { return {_mm_set1_ps(a)}; }
+    void Store(float* p) const { _mm_storeu_ps(p, v); }
+
+    friend Float4 operator+(Float4 a, Float4 b) { return {_mm_add_ps(a.v, b.v)}; }
+    friend Float4 operator-(Float4 a, Float4 b) { return {_mm_sub_ps(a.v, b.v)}; }
+    friend Float4 operator*(Float4 a, Float4 b) { return {_mm_mul_ps(a.v, b.v)}; }
+    friend Float4 operator/(Float4 a, Float4 b) { return {_mm_div_ps(a.v, b.v)}; }
+    friend Float4 Sqrt(Float4 a) { return {_mm_sqrt_ps(a.v)}; }
+    friend Float4 Max(Float4 a, Float4 b) { return {_mm_max_ps(a.v, b.v)}; }
+    friend Float4 Min(Float4 a, Float4 b) { return {_mm_min_ps(a.v, b.v)}; }
+    friend Float4 Abs(Float4 a) { return {_mm_andnot_ps(_mm_set1_ps(-0.0f), a.v)}; }
+    // Lane-wise a < b ? x : y.
+    friend Float4 SelectLess(Float4 a, Float4 b, Float4 x, Float4 y) {
+        const __m128 mask = _mm_cmplt_ps(a.v, b.v);
+        return {_mm_or_ps(_mm_and_ps(mask, x.v), _mm_andnot_ps(mask, y.v))};
+    }
+};
+#else
+struct Float4 {
+    float v[4];
+
+    static Float4 Load(const float* p) { return {{p[0], p[1], p[2], p[3]}}; }
+    static Float4 Splat(float a) { return {{a, a, a, a}}; }
+    void Store(float* p) const { std::copy(v, v + 4, p); }
+
+    template <typename Op>
+    static Float4 Map(Float4 a, Float4 b, Op op) {
+        return {{op(a.v[0], b.v[0]), op(a.v[1], b.v[1]), op(a.v[2], b.v[2]), op(a.v[3], b.v[3])}};
+    }
+
+    friend Float4 operator+(Float4 a, Float4 b) { return Map(a, b, [](float x, float y) { return x + y; }); }
+    friend Float4 operator-(Float4 a, Float4 b) { return Map(a, b, [](float x, float y) { return x - y; }); }
+    friend Float4 operator*(Float4 a, Float4 b) { return Map(a, b, [](float x, float y) { return x * y; }); }
+    friend Float4 operator/(Float4 a, Float4 b) { return Map(a, b, [](float x, float y) { return x / y; }); }
+    friend Float4 Sqrt(Float4 a) { return Map(a, a, [](float x, float) { return std::sqrt(x); }); }
+    friend Float4 Max(Float4 a, Float4 b) { return Map(a, b, [](float x, float y) { return x > y ? x : y; }); }
+    friend Float4 Min(Float4 a, Float4 b) { return Map(a, b, [](float x, float y) { return x < y ? x : y; }); }
+    friend Float4 Abs(Float4 a) { return Map(a, a, [](float x, float) { return std::fabs(x); }); }
+    friend Float4 SelectLess(Float4 a, Float4 b, Float4 x, Float4 y) {
+        Float4 r;
+        for (int i = 0; i < 4; ++i) {
+            r.v[i] = a.v[i] < b.v[i] ? x.v[i] : y.v[i];
+        }
+        return r;
+    }
+};
+#endif
+
+struct Vec3x4 {
+    Float4 x, y, z;
+};
+
+Vec3x4 operator+(const Vec3x4& a, const Vec3x4& b) { return {a.x + b.x, a.y + b.y, a.z + b.z}; }
+Vec3x4 operator-(const Vec3x4& a, const Vec3x4& b) { return {a.x - b.x, a.y - b.y, a.z - b.z}; }
+Vec3x4 operator*(const Vec3x4& a, Float4 s) { return {a.x * s, a.y * s, a.z * s}; }
+
+Float4 Dot(const Vec3x4& a, const Vec3x4& b) {
+    return a.x * b.x + a.y * b.y + a.z * b.z;
+}
+
+Vec3x4 Cross(const Vec3x4& a, const Vec3x4& b) {
+    return {a.y * b.z - a.z * b.y, a.z * b.x - a.x * b.z, a.x * b.y - a.y * b.x};
+}
+
+// v with its component along unit n removed, normalised; zero when nothing
+// is left.
+Vec3x4 OrthonormalizeAgainst(const Vec3x4& v, const Vec3x4& n) {
+    const Vec3x4 projected = v - n * Dot(n, v);
+    const Float4 length = Sqrt(Dot(projected, projected));
+    const Float4 zero = Float4::Splat(0.0f);
+    const Float4 inverse = SelectLess(length, Float4::Splat(kEpsilon), zero,
+                                      Float4::Splat(1.0f) / Max(length, Float4::Splat(kEpsilon)));
+    return projected * inverse;
+}
+
+// Angle between unit-less edges a and b; acos from Abramowitz & Stegun
+// 4.4.45 (|error| < 7e-5 rad), plenty for weights.
+Float4 AngleBetween(const Vec3x4& a, const Vec3x4& b) {
+    const Float4 lengths = Sqrt(Dot(a, a) * Dot(b, b));
+    const Float4 cosine = Dot(a, b) / Max(lengths, Float4::Splat(kEpsilon));
+    const Float4 x = Min(Abs(cosine), Float4::Splat(1.0f));
+    const Float4 poly =
+        ((Float4::Splat(-0.0187293f) * x + Float4::Splat(0.0742610f)) * x - Float4::Splat(0.2121144f)) * x +
+        Float4::Splat(1.5707288f);
+    const Float4 angle = Sqrt(Float4::Splat(1.0f) - x) * poly;
+    return SelectLess(cosine, Float4::Splat(0.0f), Float4::Splat(kPi) - angle, angle);
+}
+
+// Per-triangle results: each corner's angle-weighted tangent, already in the
+// plane of that corner's normal.
+struct FaceTangents {
+    glm::vec3 corner[3];
+    float weight[3];
+    float sign; // UV handedness; 0 for triangles without a usable UV mapping
+};
+
+void ComputeFaceTangents(const ObjMesh& mesh, std::vector<FaceTangents>& faces) {
+    const std::size_t faceCount = mesh.indices.size() / 3;
+    faces.resize(faceCount);
+
+    for (std::size_t first = 0; first < faceCount; first += 4) {
+        // Gather four triangles into lanes; a short tail repeats the last one.
+        alignas(16) float position[3][3][4];
+        alignas(16) float normal[3][3][4];
+        alignas(16) float uv[3][2][4];
+        for (std::size_t lane = 0; lane < 4; ++lane) {
+            const std::size_t face = std::min(first + lane, faceCount - 1);
+            for (std::size_t c = 0; c < 3; ++c) {
+                const VertexPNT& vertex = mesh.vertices[mesh.indices[face * 3 + c]];
+                for (int k = 0; k < 3; ++k) {
+                    position[c][k][lane] = vertex.position[k];
+                    normal[c][k][lane] = vertex.normal[k];
+                }
+                uv[c][0][lane] = vertex.texCoord.x;
+                uv[c][1][lane] = vertex.texCoord.y;
+            }
+        }
+        auto load = [](const float (&v)[3][4]) {
+            return Vec3x4{Float4::Load(v[0]), Float4::Load(v[1]), Float4::Load(v[2])};
+        };
+        const Vec3x4 p0 = load(position[0]);
+        const Vec3x4 p1 = load(position[1]);
+        const Vec3x4 p2 = load(position[2]);
+
+        const Vec3x4 e1 = p1 - p0;
+        const Vec3x4 e2 = p2 - p0;
+        const Float4 s1 = Float4::Load(uv[1][0]) - Float4::Load(uv[0][0]);
+        const Float4 t1 = Float4::Load(uv[1][1]) - Float4::Load(uv[0][1]);
+        const Float4 s2 = Float4::Load(uv[2][0]) - Float4::Load(uv[0][0]);
+        const Float4 t2 = Float4::Load(uv[2][1]) - Float4::Load(uv[0][1]);
+
+        // dP/du and dP/dv scaled by the UV determinant.
+        const Float4 det = s1 * t2 - s2 * t1;
+        const Vec3x4 scaledTangent = e1 * t2 - e2 * t1;
+        const Vec3x4 scaledBitangent = e2 * s1 - e1 * s2;
+
+        const Float4 zero = Float4::Splat(0.0f);
+        const Float4 one = Float4::Splat(1.0f);
+        const Float4 minusOne = Float4::Splat(-1.0f);
+        const Float4 detSign = SelectLess(det, zero, minusOne, one);
+        // det^2 cancels, so the scaled vectors give the true handedness.
+        const Float4 handedness = Dot(Cross(Cross(e1, e2), scaledTangent), scaledBitangent);
+        const Float4 usable = SelectLess(Abs(det), Float4::Splat(kEpsilon), zero, one);
+        const Float4 sign = SelectLess(handedness, zero, minusOne, one) * usable;
+        const Vec3x4 tangent = scaledTangent * (detSign * usable);
+
+        const Float4 angle0 = AngleBetween(e1, e2);
+        const Float4 angle1 = AngleBetween(p2 - p1, p0 - p1);
+        const Float4 angle2 = Max(Float4::Splat(kPi) - angle0 - angle1, zero);
+        const Float4 angles[3] = {angle0, angle1, angle2};
+
+        alignas(16) float out[3][4][4];
+        for (std::size_t c = 0; c < 3; ++c) {
+            const Vec3x4 projected = OrthonormalizeAgainst(tangent, load(normal[c]));
+            const Float4 weight = angles[c] * Abs(sign);
+            (projected.x * weight).Store(out[c][0]);
+            (projected.y * weight).Store(out[c][1]);
+            (projected.z * weight).Store(out[c][2]);
+            weight.Store(out[c][3]);
+        }
+        alignas(16) float signs[4];
+        sign.Store(signs);
+
+        for (std::size_t lane = 0; lane < 4 && first + lane < faceCount; ++lane) {
+            FaceTangents& face = faces[first + lane];
+            for (std::size_t c = 0; c < 3; ++c) {
+                face.corner[c] = glm::vec3(out[c][0][lane], out[c][1][lane], out[c][2][lane]);
+                face.weight[c] = out[c][3][lane];
+            }
+            face.sign = signs[lane];
+        }
+    }
+}
+
+// Orthonormalises accumulated tangents against their vertex normals, four
+// at a time. Vertices without any contribution get an arbitrary
+// perpendicular so the frame stays valid.
+void FinalizeTangents(const std::vector<VertexPNT>& vertices,
+                      const std::vector<glm::vec3>& sums,
+                      const std::vector<float>& signs,
+                      std::vector<glm::vec4>& tangents) {
+    const std::size_t count = vertices.size();
+    tangents.resize(count);
+    for (std::size_t first = 0; first < count; first += 4) {
+        alignas(16) float normal[3][4];
+        alignas(16) float sum[3][4];
+        for (std::size_t lane = 0; lane < 4; ++lane) {
+            const std::size_t v = std::min(first + lane, count - 1);
+            for (int k = 0; k < 3; ++k) {
+                normal[k][lane] = vertices[v].normal[k];
+                sum[k][lane] = sums[v][k];
+            }
+        }
+        const Vec3x4 n{Float4::Load(normal[0]), Float4::Load(normal[1]), Float4::Load(normal[2])};
+        const Vec3x4 s{Float4::Load(sum[0]), Float4::Load(sum[1]), Float4::Load(sum[2])};
+
+        const Float4 zero = Float4::Splat(0.0f);
+        const Float4 one = Float4::Splat(1.0f);
+        const Float4 useX = SelectLess(Abs(n.x), Float4::Splat(0.9f), one, zero);
+        const Vec3x4 axis{useX, one - useX, zero};
+        const Vec3x4 fallback = OrthonormalizeAgainst(axis, n);
+        const Vec3x4 tangent = OrthonormalizeAgainst(s, n);
+        const Float4 empty = SelectLess(Dot(tangent, tangent), Float4::Splat(0.5f), one, zero);
+        const Vec3x4 result = tangent * (one - empty) + fallback * empty;
+
+        alignas(16) float out[3][4];
+        result.x.Store(out[0]);
+        result.y.Store(out[1]);
+        result.z.Store(out[2]);
+        for (std::size_t lane = 0; lane < 4 && first + lane < count; ++lane) {
+            tangents[first + lane] = glm::vec4(out[0][lane], out[1][lane], out[2][lane], signs[first + lane]);
+        }
+    }
+}
+
+} // namespace
+
+void GenerateTangents(ObjMesh& mesh) {
+    mesh.tangents.clear();
+    if (mesh.vertices.empty()) {
+        return;
+    }
+
+    std::vector<FaceTangents> faces;
+    ComputeFaceTangents(mesh, faces);
+
+    // Accumulate right- and left-handed contributions separately.
+    const std::size_t originalCount = mesh.vertices.size();
+    std::vector<glm::vec3> sums[2] = {std::vector<glm::vec3>(originalCount, glm::vec3(0.0f)),
+                                      std::vector<glm::vec3>(originalCount, glm::vec3(0.0f))};
+    std::vector<float> weights[2] = {std::vector<float>(originalCount, 0.0f),
+                                     std::vector<float>(originalCount, 0.0f)};
+    for (std::size_t f = 0; f < faces.size(); ++f) {
+        const FaceTangents& face = faces[f];
+        if (face.sign == 0.0f) {
+            continue;
+        }
+        const int side = face.sign > 0.0f ? 0 : 1;
+        for (std::size_t c = 0; c < 3; ++c) {
+            const uint32_t v = mesh.indices[f * 3 + c];
+            sums[side][v] += face.corner[c];
+            weights[side][v] += face.weight[c];
+        }
+    }
+
+    // Each vertex keeps its dominant handedness; the other one, if any,
+    // moves to a copy of the vertex.
+    std::vector<glm::vec3> finalSums(originalCount);
+    std::vector<float> finalSigns(originalCount);
+    std::vector<uint8_t> primarySide(originalCount);
+    std::vector<uint32_t> clones(originalCount, kNoClone);
+    for (std::size_t v = 0; v < originalCount; ++v) {
+        const int side = weights[0][v] >= weights[1][v] ? 0 : 1;
+        primarySide[v] = static_cast<uint8_t>(side);
+        finalSums[v] = sums[side][v];
+        finalSigns[v] = side == 0 ? 1.0f : -1.0f;
+        if (weights[1 - side][v] > 0.0f) {
+            clones[v] = static_cast<uint32_t>(mesh.vertices.size());
+            mesh.vertices.push_back(mesh.vertices[v]);
+            finalSums.push_back(sums[1 - side][v]);
+            finalSigns.push_back(-finalSigns[v]);
+        }
+    }
+    for (std::size_t f = 0; f < faces.size(); ++f) {
+        if (faces[f].sign == 0.0f) {
+            continue;
+        }
+        const uint8_t side = faces[f].sign > 0.0f ? 0 : 1;
+        for (std::size_t c = 0; c < 3; ++c) {
+            uint32_t& index = mesh.indices[f * 3 + c];
+            if (index < originalCount && side != primarySide[index]) {
+                index = clones[index];
+            }
+        }
+    }
+
+    FinalizeTangents(mesh.vertices, finalSums, finalSigns, mesh.tangents);
+}
@@ -0,0 +1,13 @@
+#pragma once
+
+#include "ObjLoader.hpp"
+
+// Fills mesh.tangents the way MikkTSpace does: each triangle's UV-aligned
+// tangent is projected onto the plane of every corner's normal and
+// accumulated weighted by the corner angle. Vertices shared by triangles of
+// opposite UV handedness (mirrored UVs) are split, so mesh.vertices may
+// grow; only index values change, chunk ranges stay valid.
+//
+// The per-triangle and per-vertex math runs four lanes at a time (SSE2 when
+// available, identical results otherwise).
+void GenerateTangents(ObjMesh& mesh);
@@ -1,10 +1,17 @@
 #include "TextureLoader.hpp"
 
+#include "CompressedTexture.hpp"
+#include "MappedFile.hpp"
+
 #include <png.h>
 
+#include <algorithm>
+#include <cctype>
 #include <cstdio>
+#include <cstring>
 #include <memory>
 #include <setjmp.h>
+#include <utility>
 #include <vector>
 
 namespace gfx {
@@ -18,11 +25,79 @@ struct FileCloser {
     }
 };
 
+bool Fail(std::string* error, std::string message) {
+    if (error) {
+        *error = std::move(message);
+    }
+    return false;
+}
+
+#pragma pack(push, 1)
+struct TgaHeader {
+    uint8_t idLength;
+    uint8_t colorMapType;
+    uint8_t imageType;
+    uint16_t colorMapFirst;
+    uint16_t colorMapLength;
+    uint8_t colorMapEntryBits;
+    uint16_t xOrigin;
+    uint16_t yOrigin;
+    uint16_t width;
+    uint16_t height;
+    uint8_t pixelBits;
+    uint8_t descriptor;
+};
+#pragma pack(pop)
+static_assert(sizeof(TgaHeader) == 18);
+
+constexpr uint8_t kTgaTrueColor = 2;
+constexpr uint8_t kTgaGrey = 3;
+constexpr uint8_t kTgaRleFlag = 8;
+constexpr uint8_t kTgaRightToLeft = 0x10;
+constexpr uint8_t kTgaTopToBottom = 0x20;
+
+// Expands RLE packets into `out` (pixelCount * bytesPerPixel bytes). Packets
+// may run across scanlines.
+bool DecodeTgaRle(const uint8_t* data,
+                  std::size_t size,
+                  std::size_t pixelCount,
+                  std::size_t bytesPerPixel,
+                  uint8_t* out) {
+    const uint8_t* end = data + size;
+    std::size_t written = 0;
+    while (written < pixelCount) {
+        if (data >= end) {
+            return false;
+        }
+        const uint8_t packet = *data++;
+        const std::size_t count = std::min<std::size_t>((packet & 0x7F) + 1u, pixelCount - written);
+        if (packet & 0x80) {
+            if (static_cast<std::size_t>(end - data) < bytesPerPixel) {
+                return false;
+            }
+            uint8_t* dst = out + written * bytesPerPixel;
+            for (std::size_t i = 0; i < count; ++i) {
+                std::memcpy(dst + i * bytesPerPixel, data, bytesPerPixel);
+            }
+            data += bytesPerPixel;
+        } else {
+            const std::size_t bytes = count * bytesPerPixel;
+            if (static_cast<std::size_t>(end - data) < bytes) {
+                return false;
+            }
+            std::memcpy(out + written * bytesPerPixel, data, bytes);
+            data += bytes;
+        }
+        written += count;
+    }
+    return true;
+}
+
 } // namespace
 
-bool LoadTexture2D(const std::filesystem::path& path,
-                   GLuint& outTexture,
-                   std::string* error) {
+bool DecodePng(const std::filesystem::path& path,
+               ImageRGBA8& outImage,
+               std::string* error) {
     std::unique_ptr<FILE, FileCloser> file(std::fopen(path.string().c_str(), "rb"));
     if (!file) {
         if (error) {
@@ -112,10 +187,157 @@ bool LoadTexture2D(const std::filesystem::path& path,
     png_read_image(pngPtr, rowPointers.data());
     png_destroy_read_struct(&pngPtr, &infoPtr, nullptr);
 
-    glGenTextures(1, &outTexture);
-    glBindTexture(GL_TEXTURE_2D, outTexture);
-    glTexImage2D(GL_TEXTURE_2D, 0, GL_SRGB8_ALPHA8, static_cast<GLsizei>(width),
-                 static_cast<GLsizei>(height), 0, GL_RGBA, GL_UNSIGNED_BYTE, imageData.data());
+    outImage.width = width;
+    outImage.height = height;
+    outImage.pixels = std::move(imageData);
+    return true;
+}
+
+bool EncodePng(const std::filesystem::path& path,
+               const ImageRGBA8& image,
+               std::string* error) {
+    if (image.pixels.size() < static_cast<std::size_t>(image.width) * image.height * 4) {
+        return Fail(error, "Image is smaller than its dimensions: " + path.string());
+    }
+    std::unique_ptr<FILE, FileCloser> file(std::fopen(path.string().c_str(), "wb"));
+    if (!file) {
+        return Fail(error, "Unable to create image file: " + path.string());
+    }
+
+    png_structp pngPtr = png_create_write_struct(PNG_LIBPNG_VER_STRING, nullptr, nullptr, nullptr);
+    if (!pngPtr) {
+        return Fail(error, "Unable to allocate png write struct.");
+    }
+    png_infop infoPtr = png_create_info_struct(pngPtr);
+    if (!infoPtr) {
+        png_destroy_write_struct(&pngPtr, nullptr);
+        return Fail(error, "Unable to allocate png info struct.");
+    }
+
+    std::vector<png_bytep> rowPointers(image.height);
+    if (setjmp(png_jmpbuf(pngPtr))) {
+        png_destroy_write_struct(&pngPtr, &infoPtr);
+        return Fail(error, "Error while writing PNG file: " + path.string());
+    }
+
+    png_init_io(pngPtr, file.get());
+    png_set_IHDR(pngPtr, infoPtr, image.width, image.height, 8, PNG_COLOR_TYPE_RGB_ALPHA, PNG_INTERLACE_NONE,
+                 PNG_COMPRESSION_TYPE_DEFAULT, PNG_FILTER_TYPE_DEFAULT);
+    png_write_info(pngPtr, infoPtr);
+    const std::size_t rowBytes = static_cast<std::size_t>(image.width) * 4;
+    for (uint32_t y = 0; y < image.height; ++y) {
+        // PNG stores the top row first.
+        rowPointers[image.height - 1 - y] = const_cast<png_bytep>(image.pixels.data() + y * rowBytes);
+    }
+    png_write_image(pngPtr, rowPointers.data());
+    png_write_end(pngPtr, nullptr);
+    png_destroy_write_struct(&pngPtr, &infoPtr);
+    return true;
+}
+
+bool DecodeTga(const std::filesystem::path& path,
+               ImageRGBA8& outImage,
+               std::string* error) {
+    MappedFile file;
+    if (!file.Open(path)) {
+        return Fail(error, "Unable to open texture file: " + path.string());
+    }
+
+    TgaHeader header{};
+    if (file.Size() < sizeof(header)) {
+        return Fail(error, "File is not a valid TGA: " + path.string());
+    }
+    std::memcpy(&header, file.Data(), sizeof(header));
+
+    const uint8_t baseType = header.imageType & ~kTgaRleFlag;
+    const bool rle = (header.imageType & kTgaRleFlag) != 0;
+    const bool grey = baseType == kTgaGrey;
+    const bool supportedDepth = grey ? header.pixelBits == 8 : (header.pixelBits == 24 || header.pixelBits == 32);
+    if ((baseType != kTgaTrueColor && baseType != kTgaGrey) || !supportedDepth) {
+        return Fail(error, "Unsupported TGA type " + std::to_string(header.imageType) + " (" +
+                               std::to_string(header.pixelBits) + " bpp): " + path.string());
+    }
+
+    const uint32_t width = header.width;
+    const uint32_t height = header.height;
+    const std::size_t bytesPerPixel = header.pixelBits / 8u;
+    const std::size_t pixelCount = static_cast<std::size_t>(width) * height;
+
+    std::size_t dataOffset = sizeof(header) + header.idLength;
+    if (header.colorMapType != 0) {
+        dataOffset += static_cast<std::size_t>(header.colorMapLength) * ((header.colorMapEntryBits + 7u) / 8u);
+    }
+    if (dataOffset > file.Size()) {
+        return Fail(error, "TGA file is truncated: " + path.string());
+    }
+    const uint8_t* data = reinterpret_cast<const uint8_t*>(file.Data()) + dataOffset;
+    const std::size_t dataSize = file.Size() - dataOffset;
+
+    std::vector<uint8_t> unpacked;
+    const uint8_t* source = data;
+    if (rle) {
+        unpacked.resize(pixelCount * bytesPerPixel);
+        if (!DecodeTgaRle(data, dataSize, pixelCount, bytesPerPixel, unpacked.data())) {
+            return Fail(error, "TGA file is truncated: " + path.string());
+        }
+        source = unpacked.data();
+    } else if (dataSize < pixelCount * bytesPerPixel) {
+        return Fail(error, "TGA file is truncated: " + path.string());
+    }
+
+    // Stored as BGR(A); 32-bit files without alpha bits in the descriptor
+    // leave the fourth byte undefined.
+    const bool topToBottom = (header.descriptor & kTgaTopToBottom) != 0;
+    const bool rightToLeft = (header.descriptor & kTgaRightToLeft) != 0;
+    const bool hasAlpha = header.pixelBits == 32 && (header.descriptor & 0x0F) != 0;
+    std::vector<uint8_t> pixels(pixelCount * 4);
+    for (uint32_t y = 0; y < height; ++y) {
+        const uint8_t* src = source + static_cast<std::size_t>(y) * width * bytesPerPixel;
+        const uint32_t dstRow = topToBottom ? height - 1 - y : y;
+        uint8_t* dst = pixels.data() + static_cast<std::size_t>(dstRow) * width * 4;
+        for (uint32_t x = 0; x < width; ++x, src += bytesPerPixel) {
+            uint8_t* texel = dst + static_cast<std::size_t>(rightToLeft ? width - 1 - x : x) * 4;
+            if (grey) {
+                texel[0] = texel[1] = texel[2] = src[0];
+                texel[3] = 255;
+            } else {
+                texel[0] = src[2];
+                texel[1] = src[1];
+                texel[2] = src[0];
+                texel[3] = hasAlpha ? src[3] : 255;
+            }
+        }
+    }
+
+    outImage.width = width;
+    outImage.height = height;
+    outImage.pixels = std::move(pixels);
+    return true;
+}
+
+bool DecodeImage(const std::filesystem::path& path,
+                 ImageRGBA8& outImage,
+                 std::string* error) {
+    std::string extension = path.extension().string();
+    for (char& c : extension) {
+        c = static_cast<char>(std::tolower(static_cast<unsigned char>(c)));
+    }
+    if (extension == ".tga") {
+        return DecodeTga(path, outImage, error);
+    }
+    return DecodePng(path, outImage, error);
+}
+
+void UploadTexture2D(GLuint texture,
+                     uint32_t width,
+                     uint32_t height,
+                     const void* pixels,
+                     TextureColorSpace colorSpace) {
+    const GLint internalFormat = colorSpace == TextureColorSpace::Srgb ? GL_SRGB8_ALPHA8 : GL_RGBA8;
+    glBindTexture(GL_TEXTURE_2D, texture);
+    glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
+    glTexImage2D(GL_TEXTURE_2D, 0, internalFormat, static_cast<GLsizei>(width),
+                 static_cast<GLsizei>(height), 0, GL_RGBA, GL_UNSIGNED_BYTE, pixels);
     glGenerateMipmap(GL_TEXTURE_2D);
 
     glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_LINEAR);
@@ -124,6 +346,37 @@ bool LoadTexture2D(const std::filesystem::path& path,
     glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_REPEAT);
 
     glBindTexture(GL_TEXTURE_2D, 0);
+}
+
+GLuint CreateSolidTexture2D(uint8_t r, uint8_t g, uint8_t b, uint8_t a, TextureColorSpace colorSpace) {
+    const uint8_t pixel[4] = {r, g, b, a};
+    GLuint texture = 0;
+    glGenTextures(1, &texture);
+    UploadTexture2D(texture, 1, 1, pixel, colorSpace);
+    return texture;
+}
+
+bool LoadTexture2D(const std::filesystem::path& path,
+                   GLuint& outTexture,
+                   std::string* error,
+                   TextureColorSpace colorSpace) {
+    // Prefer an up-to-date block-compressed copy written by TextureCompressor.
+    CompressedTexture compressed;
+    if (CompressedTextureFile::Read(path, compressed) &&
+        compressed.srgb == (colorSpace == TextureColorSpace::Srgb) &&
+        CompressedFormatSupport::Query().Supports(compressed.format, compressed.srgb)) {
+        glGenTextures(1, &outTexture);
+        UploadCompressedTexture2D(outTexture, compressed, compressed.data.data());
+        return true;
+    }
+
+    ImageRGBA8 image;
+    if (!DecodeImage(path, image, error)) {
+        return false;
+    }
+
+    glGenTextures(1, &outTexture);
+    UploadTexture2D(outTexture, image.width, image.height, image.pixels.data(), colorSpace);
     return true;
 }
 
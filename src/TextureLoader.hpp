@@ -1,15 +1,70 @@
 #pragma once
 
 #include <GL/glew.h>
+#include <cstdint>
 #include <filesystem>
 #include <string>
+#include <vector>
 
 namespace gfx {
 
-// Loads a PNG texture into GPU memory using libpng.
+// Tightly packed RGBA8 pixels, bottom row first (OpenGL convention).
+struct ImageRGBA8 {
+    uint32_t width = 0;
+    uint32_t height = 0;
+    std::vector<uint8_t> pixels;
+};
+
+// Colour textures are sampled as sRGB; normal maps and other data as-is.
+enum class TextureColorSpace {
+    Srgb,
+    Linear,
+};
+
+// Decodes a PNG with libpng. Touches no GL state, so it may run on any thread.
+bool DecodePng(const std::filesystem::path& path,
+               ImageRGBA8& outImage,
+               std::string* error = nullptr);
+
+// Decodes an uncompressed or RLE TGA (8-bit grey, 24/32-bit colour). Touches
+// no GL state.
+bool DecodeTga(const std::filesystem::path& path,
+               ImageRGBA8& outImage,
+               std::string* error = nullptr);
+
+// Picks the decoder from the file extension (.tga, otherwise PNG).
+bool DecodeImage(const std::filesystem::path& path,
+                 ImageRGBA8& outImage,
+                 std::string* error = nullptr);
+
+// Writes an RGBA8 PNG (bottom row first, like the decoders' output) with
+// libpng. Touches no GL state.
+bool EncodePng(const std::filesystem::path& path,
+               const ImageRGBA8& image,
+               std::string* error = nullptr);
+
+// (Re)defines `texture` with mipmaps from tightly packed RGBA8 pixels. When a
+// pixel unpack buffer is bound, `pixels` is an offset into it instead.
+void UploadTexture2D(GLuint texture,
+                     uint32_t width,
+                     uint32_t height,
+                     const void* pixels,
+                     TextureColorSpace colorSpace = TextureColorSpace::Srgb);
+
+// 1x1 texture of the given colour, used while real textures load.
+GLuint CreateSolidTexture2D(uint8_t r,
+                            uint8_t g,
+                            uint8_t b,
+                            uint8_t a = 255,
+                            TextureColorSpace colorSpace = TextureColorSpace::Srgb);
+
+// Loads a PNG or TGA texture into GPU memory, or its block-compressed ".ctex"
+// copy (see CompressedTextureFile) when one is current, supported and in the
+// requested colour space.
 bool LoadTexture2D(const std::filesystem::path& path,
                    GLuint& outTexture,
-                   std::string* error = nullptr);
+                   std::string* error = nullptr,
+                   TextureColorSpace colorSpace = TextureColorSpace::Srgb);
 
 } // namespace gfx
 
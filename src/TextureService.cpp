@@ -0,0 +1,185 @@
+#include "TextureService.hpp"
+
+#include <cstring>
+#include <utility>
+
+namespace gfx {
+namespace {
+
+double MillisecondsBetween(std::chrono::steady_clock::time_point start, std::chrono::steady_clock::time_point end) {
+    return std::chrono::duration<double, std::milli>(end - start).count();
+}
+
+} // namespace
+
+TextureService::TextureService(unsigned threadCount)
+    : pool_(threadCount), formatSupport_(CompressedFormatSupport::Query()) {
+}
+
+TextureService::~TextureService() {
+    Destroy();
+}
+
+GLuint TextureService::Request(const std::filesystem::path& path, TextureColorSpace colorSpace) {
+    const bool srgb = colorSpace == TextureColorSpace::Srgb;
+    const std::filesystem::path canonical = path.lexically_normal();
+    const std::string key = canonical.string() + (srgb ? "" : "|linear");
+    auto it = textures_.find(key);
+    if (it != textures_.end()) {
+        return it->second;
+    }
+
+    GLuint texture = srgb ? CreateSolidTexture2D(255, 255, 255)
+                          : CreateSolidTexture2D(128, 128, 255, 255, TextureColorSpace::Linear);
+    textures_.emplace(key, texture);
+    sources_.emplace(canonical, std::vector<TextureUse>{}).first->second.push_back({texture, colorSpace});
+    Enqueue(texture, canonical, colorSpace);
+    return texture;
+}
+
+std::size_t TextureService::Reload(const std::filesystem::path& path) {
+    auto it = sources_.find(path.lexically_normal());
+    if (it == sources_.end()) {
+        return 0;
+    }
+    for (const TextureUse& use : it->second) {
+        // An older decode of the same texture must not land after this one.
+        for (PendingTexture& pending : pending_) {
+            if (pending.texture == use.texture) {
+                pending.superseded = true;
+            }
+        }
+        Enqueue(use.texture, it->first, use.colorSpace);
+    }
+    return it->second.size();
+}
+
+std::vector<std::filesystem::path> TextureService::Sources() const {
+    std::vector<std::filesystem::path> paths;
+    paths.reserve(sources_.size());
+    for (const auto& [path, uses] : sources_) {
+        paths.push_back(path);
+    }
+    return paths;
+}
+
+void TextureService::Enqueue(GLuint texture, const std::filesystem::path& canonical, TextureColorSpace colorSpace) {
+    const bool srgb = colorSpace == TextureColorSpace::Srgb;
+    PendingTexture pending;
+    pending.texture = texture;
+    pending.path = canonical;
+    pending.colorSpace = colorSpace;
+    pending.requested = Clock::now();
+    pending.result = pool_.Submit([canonical, srgb, support = formatSupport_]() {
+        DecodeResult result;
+        const auto start = Clock::now();
+        result.isCompressed = CompressedTextureFile::Read(canonical, result.compressed) &&
+                              result.compressed.srgb == srgb &&
+                              support.Supports(result.compressed.format, result.compressed.srgb);
+        result.ok = result.isCompressed || DecodeImage(canonical, result.image, &result.error);
+        result.decodeMs = MillisecondsBetween(start, Clock::now());
+        return result;
+    });
+    pending_.push_back(std::move(pending));
+}
+
+std::size_t TextureService::Pump(std::size_t maxUploads) {
+    std::size_t uploads = 0;
+    for (std::size_t i = 0; i < pending_.size() && uploads < maxUploads;) {
+        if (pending_[i].result.wait_for(std::chrono::seconds(0)) != std::future_status::ready) {
+            ++i;
+            continue;
+        }
+        Complete(pending_[i]);
+        pending_.erase(pending_.begin() + static_cast<std::ptrdiff_t>(i));
+        ++uploads;
+    }
+    return uploads;
+}
+
+void TextureService::Finish() {
+    for (auto& pending : pending_) {
+        pending.result.wait();
+        Complete(pending);
+    }
+    pending_.clear();
+}
+
+void TextureService::Complete(PendingTexture& pending) {
+    DecodeResult result = pending.result.get();
+    if (pending.superseded) {
+        return;
+    }
+
+    TextureLoadTiming timing;
+    timing.path = pending.path;
+    timing.decodeMs = result.decodeMs;
+    if (!result.ok) {
+        // Keep the placeholder so draws stay valid.
+        timing.failed = true;
+        timing.error = std::move(result.error);
+        timing.latencyMs = MillisecondsBetween(pending.requested, Clock::now());
+        timings_.push_back(std::move(timing));
+        return;
+    }
+
+    const auto uploadStart = Clock::now();
+    const ImageRGBA8& image = result.image;
+    const std::vector<uint8_t>& bytes = result.isCompressed ? result.compressed.data : image.pixels;
+    const GLsizeiptr size = static_cast<GLsizeiptr>(bytes.size());
+    auto upload = [&](const uint8_t* data) {
+        if (result.isCompressed) {
+            UploadCompressedTexture2D(pending.texture, result.compressed, data);
+        } else {
+            UploadTexture2D(pending.texture, image.width, image.height, data, pending.colorSpace);
+        }
+    };
+
+    // Stage through a pixel unpack buffer so glTexImage2D can return before
+    // the driver has copied the pixels. Orphaning the store each time avoids
+    // waiting on the previous upload.
+    if (uploadBuffer_ == 0) {
+        glGenBuffers(1, &uploadBuffer_);
+    }
+    glBindBuffer(GL_PIXEL_UNPACK_BUFFER, uploadBuffer_);
+    glBufferData(GL_PIXEL_UNPACK_BUFFER, size, nullptr, GL_STREAM_DRAW);
+    void* mapped = glMapBufferRange(GL_PIXEL_UNPACK_BUFFER, 0, size,
+                                    GL_MAP_WRITE_BIT | GL_MAP_INVALIDATE_BUFFER_BIT | GL_MAP_UNSYNCHRONIZED_BIT);
+    if (mapped) {
+        std::memcpy(mapped, bytes.data(), bytes.size());
+        glUnmapBuffer(GL_PIXEL_UNPACK_BUFFER);
+        upload(nullptr);
+        glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+    } else {
+        glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+        upload(bytes.data());
+    }
+
+    const auto uploadEnd = Clock::now();
+    timing.compressed = result.isCompressed;
+    timing.width = result.isCompressed ? result.compressed.mips[0].width : image.width;
+    timing.height = result.isCompressed ? result.compressed.mips[0].height : image.height;
+    timing.uploadMs = MillisecondsBetween(uploadStart, uploadEnd);
+    timing.latencyMs = MillisecondsBetween(pending.requested, uploadEnd);
+    timings_.push_back(std::move(timing));
+}
+
+void TextureService::Destroy() {
+    for (auto& pending : pending_) {
+        pending.result.wait();
+    }
+    pending_.clear();
+
+    for (const auto& [key, texture] : textures_) {
+        glDeleteTextures(1, &texture);
+    }
+    textures_.clear();
+    sources_.clear();
+
+    if (uploadBuffer_ != 0) {
+        glDeleteBuffers(1, &uploadBuffer_);
+        uploadBuffer_ = 0;
+    }
+}
+
+} // namespace gfx
@@ -0,0 +1,108 @@
+#pragma once
+
+#include "CompressedTexture.hpp"
+#include "TextureLoader.hpp"
+#include "ThreadPool.hpp"
+
+#include <GL/glew.h>
+#include <chrono>
+#include <cstddef>
+#include <filesystem>
+#include <future>
+#include <map>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace gfx {
+
+struct TextureLoadTiming {
+    std::filesystem::path path;
+    uint32_t width = 0;
+    uint32_t height = 0;
+    bool compressed = false; // loaded from a block-compressed .ctex copy
+    double decodeMs = 0.0;  // worker thread, PNG decode or .ctex read
+    double uploadMs = 0.0;  // GL thread, PBO copy + glTexImage2D + mipmaps
+    double latencyMs = 0.0; // Request() until the real texture is bound
+    bool failed = false;
+    std::string error;
+};
+
+// Decodes textures on worker threads and uploads them on the GL thread.
+// Like LoadTexture2D, a current block-compressed copy is preferred.
+// Request() hands out the final texture name at once, filled with a 1x1
+// placeholder (white, or a flat normal for linear data); Pump() later
+// redefines it with the decoded image, so callers never need to swap names.
+// Owns every texture it creates; must be used from the GL thread and
+// destroyed while the context is current.
+class TextureService {
+public:
+    // threadCount == 0 uses every hardware thread. Queries compressed format
+    // support, so construct it with the GL context current.
+    explicit TextureService(unsigned threadCount = 0);
+    ~TextureService();
+
+    TextureService(const TextureService&) = delete;
+    TextureService& operator=(const TextureService&) = delete;
+
+    GLuint Request(const std::filesystem::path& path, TextureColorSpace colorSpace = TextureColorSpace::Srgb);
+
+    // Decodes `path` again for every texture made from it and redefines
+    // them in place once Pump() uploads the result; until then the old image
+    // stays bound. Returns how many textures were queued.
+    std::size_t Reload(const std::filesystem::path& path);
+
+    // Every source file requested so far.
+    std::vector<std::filesystem::path> Sources() const;
+
+    // Uploads up to maxUploads finished images and returns how many were
+    // uploaded. Call once per frame.
+    std::size_t Pump(std::size_t maxUploads = static_cast<std::size_t>(-1));
+
+    // Blocks until every requested texture has been uploaded (or failed).
+    void Finish();
+
+    std::size_t PendingCount() const { return pending_.size(); }
+    const std::vector<TextureLoadTiming>& Timings() const { return timings_; }
+
+    void Destroy();
+
+private:
+    using Clock = std::chrono::steady_clock;
+
+    struct DecodeResult {
+        ImageRGBA8 image;
+        bool isCompressed = false;
+        CompressedTexture compressed;
+        double decodeMs = 0.0;
+        bool ok = false;
+        std::string error;
+    };
+
+    struct PendingTexture {
+        GLuint texture = 0;
+        std::filesystem::path path;
+        TextureColorSpace colorSpace = TextureColorSpace::Srgb;
+        Clock::time_point requested;
+        std::future<DecodeResult> result;
+        bool superseded = false; // a later Reload() replaces this decode
+    };
+
+    struct TextureUse {
+        GLuint texture = 0;
+        TextureColorSpace colorSpace = TextureColorSpace::Srgb;
+    };
+
+    ThreadPool pool_;
+    CompressedFormatSupport formatSupport_;
+    std::unordered_map<std::string, GLuint> textures_;
+    std::map<std::filesystem::path, std::vector<TextureUse>> sources_;
+    std::vector<PendingTexture> pending_;
+    std::vector<TextureLoadTiming> timings_;
+    GLuint uploadBuffer_ = 0;
+
+    void Enqueue(GLuint texture, const std::filesystem::path& canonical, TextureColorSpace colorSpace);
+    void Complete(PendingTexture& pending);
+};
+
+} // namespace gfx
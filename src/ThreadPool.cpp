@@ -0,0 +1,104 @@
+#include "ThreadPool.hpp"
+
+#include <algorithm>
+#include <atomic>
+
+ThreadPool::ThreadPool(unsigned threadCount) {
+    if (threadCount == 0) {
+        threadCount = DefaultThreadCount();
+    }
+    workers_.reserve(threadCount);
+    for (unsigned i = 0; i < threadCount; ++i) {
+        workers_.emplace_back([this]() { WorkerLoop(); });
+    }
+}
+
+ThreadPool::~ThreadPool() {
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        stopping_ = true;
+    }
+    wake_.notify_all();
+    for (auto& worker : workers_) {
+        worker.join();
+    }
+}
+
+unsigned ThreadPool::DefaultThreadCount() {
+    return std::max(1u, std::thread::hardware_concurrency());
+}
+
+void ThreadPool::Enqueue(std::function<void()> task) {
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        tasks_.push_back(std::move(task));
+    }
+    wake_.notify_one();
+}
+
+void ThreadPool::WorkerLoop() {
+    for (;;) {
+        std::function<void()> task;
+        {
+            std::unique_lock<std::mutex> lock(mutex_);
+            wake_.wait(lock, [this]() { return stopping_ || !tasks_.empty(); });
+            if (tasks_.empty()) {
+                return;
+            }
+            task = std::move(tasks_.front());
+            tasks_.pop_front();
+        }
+        task();
+    }
+}
+
+void ThreadPool::ParallelFor(std::size_t count, const std::function<void(std::size_t)>& body) {
+    if (count == 0) {
+        return;
+    }
+    if (count == 1 || workers_.empty()) {
+        for (std::size_t i = 0; i < count; ++i) {
+            body(i);
+        }
+        return;
+    }
+
+    // Helpers that start after all indices are taken exit without touching
+    // body, so the caller only has to wait for helpers that are mid-item.
+    struct SharedState {
+        std::atomic<std::size_t> next{0};
+        std::atomic<unsigned> active{0};
+        std::mutex mutex;
+        std::condition_variable done;
+        std::size_t count = 0;
+        const std::function<void(std::size_t)>* body = nullptr;
+    };
+    auto state = std::make_shared<SharedState>();
+    state->count = count;
+    state->body = &body;
+
+    auto drain = [](SharedState& shared) {
+        for (std::size_t i = shared.next.fetch_add(1); i < shared.count; i = shared.next.fetch_add(1)) {
+            (*shared.body)(i);
+        }
+    };
+
+    std::size_t helperCount = std::min<std::size_t>(workers_.size(), count - 1);
+    for (std::size_t h = 0; h < helperCount; ++h) {
+        Enqueue([state, drain]() {
+            state->active.fetch_add(1);
+            if (state->next.load() < state->count) {
+                drain(*state);
+            }
+            if (state->active.fetch_sub(1) == 1) {
+                std::lock_guard<std::mutex> lock(state->mutex);
+                state->done.notify_all();
+            }
+        });
+    }
+
+    drain(*state);
+
+    std::unique_lock<std::mutex> lock(state->mutex);
+    state->done.wait(lock, [&]() { return state->active.load() == 0; });
+}
@@ -0,0 +1,77 @@
+#include "UniformBuffers.hpp"
+
+#include "GlCalls.hpp"
+
+bool UniformBlockBindingFor(std::string_view blockName, GLuint& binding) {
+    if (blockName == "FrameBlock") {
+        binding = static_cast<GLuint>(UniformBlock::Frame);
+        return true;
+    }
+    if (blockName == "MaterialBlock") {
+        binding = static_cast<GLuint>(UniformBlock::Material);
+        return true;
+    }
+    return false;
+}
+
+bool TextureUnitFor(std::string_view samplerName, GLuint& unit) {
+    if (samplerName == "uDiffuseMap") {
+        unit = static_cast<GLuint>(TextureUnit::Diffuse);
+        return true;
+    }
+    if (samplerName == "uNormalMap") {
+        unit = static_cast<GLuint>(TextureUnit::Normal);
+        return true;
+    }
+    if (samplerName == "uObjects") {
+        unit = static_cast<GLuint>(TextureUnit::Objects);
+        return true;
+    }
+    if (samplerName == "uMaterials") {
+        unit = static_cast<GLuint>(TextureUnit::Materials);
+        return true;
+    }
+    return false;
+}
+
+GLsizeiptr UniformBufferOffsetAlignment() {
+    GLint alignment = 0;
+    glGetIntegerv(GL_UNIFORM_BUFFER_OFFSET_ALIGNMENT, &alignment);
+    return alignment > 0 ? alignment : 256;
+}
+
+UniformBuffer::~UniformBuffer() {
+    Destroy();
+}
+
+void UniformBuffer::Create(GLsizeiptr size, const void* data, GLenum usage) {
+    if (buffer_ == 0) {
+        glGenBuffers(1, &buffer_);
+    }
+    glBindBuffer(GL_UNIFORM_BUFFER, buffer_);
+    glBufferData(GL_UNIFORM_BUFFER, size, data, usage);
+    glBindBuffer(GL_UNIFORM_BUFFER, 0);
+    size_ = size;
+}
+
+void UniformBuffer::Update(const void* data, GLsizeiptr size, GLintptr offset) {
+    // glNamedBufferSubData would save the bind but needs GL 4.5.
+    gl::BindBuffer(GL_UNIFORM_BUFFER, buffer_);
+    gl::BufferSubData(GL_UNIFORM_BUFFER, offset, size, data);
+}
+
+void UniformBuffer::BindBase(UniformBlock block) const {
+    gl::BindBufferBase(GL_UNIFORM_BUFFER, static_cast<GLuint>(block), buffer_);
+}
+
+void UniformBuffer::BindRange(UniformBlock block, GLintptr offset, GLsizeiptr size) const {
+    gl::BindBufferRange(GL_UNIFORM_BUFFER, static_cast<GLuint>(block), buffer_, offset, size);
+}
+
+void UniformBuffer::Destroy() {
+    if (buffer_ != 0) {
+        glDeleteBuffers(1, &buffer_);
+        buffer_ = 0;
+        size_ = 0;
+    }
+}
@@ -0,0 +1,80 @@
+#pragma once
+
+#include <GL/glew.h>
+#include <cstddef>
+#include <cstdint>
+#include <glm/glm.hpp>
+#include <string_view>
+
+// Binding points shared by every program. GLSL 4.10 has no binding layout
+// qualifier for blocks, so ShaderProgram assigns these by block name after
+// linking.
+enum class UniformBlock : GLuint {
+    Frame = 0,    // "FrameBlock": camera and light, updated once per frame
+    Material = 1, // "MaterialBlock": one range per draw, written at load
+};
+
+// Binding for a block name, or false when the block is not a shared one.
+bool UniformBlockBindingFor(std::string_view blockName, GLuint& binding);
+
+// Texture units of the samplers every program uses, assigned by name after
+// linking for the same reason.
+enum class TextureUnit : GLuint {
+    Diffuse = 0,   // "uDiffuseMap"
+    Normal = 1,    // "uNormalMap"
+    Objects = 2,   // "uObjects", BatchRenderer's per-object transforms
+    Materials = 3, // "uMaterials", BatchRenderer's MaterialUniforms
+};
+
+bool TextureUnitFor(std::string_view samplerName, GLuint& unit);
+
+// std140 mirror of FrameBlock in object.vert/object.frag.
+struct FrameUniforms {
+    glm::mat4 view{1.0f};
+    glm::mat4 projection{1.0f};
+    glm::vec4 cameraPos{0.0f}; // xyz
+    glm::vec4 lightDir{0.0f};  // xyz
+    glm::vec4 lightColor{0.0f};
+    glm::vec4 ambientColor{0.0f};
+};
+static_assert(sizeof(FrameUniforms) == 192, "FrameUniforms must match the std140 FrameBlock");
+
+// std140 mirror of MaterialBlock in object.frag.
+struct MaterialUniforms {
+    glm::vec3 diffuseColor{0.8f};
+    float shininess = 32.0f;
+    int32_t hasDiffuseMap = 0;
+    int32_t hasNormalMap = 0;
+    float normalScale = 1.0f;
+    float padding = 0.0f;
+};
+static_assert(sizeof(MaterialUniforms) == 32, "MaterialUniforms must match the std140 MaterialBlock");
+static_assert(offsetof(MaterialUniforms, hasDiffuseMap) == 16, "std140 puts the ints after the vec3 + float");
+
+// GL_UNIFORM_BUFFER_OFFSET_ALIGNMENT, needed to pack several blocks into one
+// buffer for glBindBufferRange.
+GLsizeiptr UniformBufferOffsetAlignment();
+
+// Owns one uniform buffer object.
+class UniformBuffer {
+public:
+    UniformBuffer() = default;
+    ~UniformBuffer();
+
+    UniformBuffer(const UniformBuffer&) = delete;
+    UniformBuffer& operator=(const UniformBuffer&) = delete;
+
+    // (Re)allocates `size` bytes, optionally filled from `data`.
+    void Create(GLsizeiptr size, const void* data = nullptr, GLenum usage = GL_DYNAMIC_DRAW);
+    void Update(const void* data, GLsizeiptr size, GLintptr offset = 0);
+    void BindBase(UniformBlock block) const;
+    void BindRange(UniformBlock block, GLintptr offset, GLsizeiptr size) const;
+    void Destroy();
+
+    GLuint Handle() const { return buffer_; }
+    GLsizeiptr Size() const { return size_; }
+
+private:
+    GLuint buffer_ = 0;
+    GLsizeiptr size_ = 0;
+};
@@ -0,0 +1,64 @@
+#include "VertexDedupTable.hpp"
+
+namespace {
+
+// Linear probing with a well-mixed hash stays at a couple of probes per
+// lookup up to ~70% load; past that clusters grow quickly.
+bool ExceedsMaxLoad(std::size_t count, std::size_t capacity) {
+    return count * 10 > capacity * 7;
+}
+
+std::size_t CapacityFor(std::size_t count) {
+    std::size_t capacity = 16;
+    while (ExceedsMaxLoad(count, capacity)) {
+        capacity *= 2;
+    }
+    return capacity;
+}
+
+} // namespace
+
+void VertexDedupTable::Reserve(std::size_t expectedCount) {
+    std::size_t capacity = CapacityFor(expectedCount);
+    if (capacity > slots_.size()) {
+        Rehash(capacity);
+    }
+}
+
+uint32_t VertexDedupTable::FindOrInsert(const VertexKey& key, uint32_t candidateIndex) {
+    if (ExceedsMaxLoad(size_ + 1, slots_.size())) {
+        Rehash(CapacityFor(size_ + 1));
+    }
+
+    std::size_t slot = static_cast<std::size_t>(Hash(key)) & mask_;
+    for (;;) {
+        Slot& entry = slots_[slot];
+        if (entry.value == kEmpty) {
+            entry.key = key;
+            entry.value = candidateIndex;
+            ++size_;
+            return candidateIndex;
+        }
+        if (entry.key == key) {
+            return entry.value;
+        }
+        slot = (slot + 1) & mask_;
+    }
+}
+
+void VertexDedupTable::Rehash(std::size_t newCapacity) {
+    std::vector<Slot> old = std::move(slots_);
+    slots_.assign(newCapacity, Slot{});
+    mask_ = newCapacity - 1;
+
+    for (const Slot& entry : old) {
+        if (entry.value == kEmpty) {
+            continue;
+        }
+        std::size_t slot = static_cast<std::size_t>(Hash(entry.key)) & mask_;
+        while (slots_[slot].value != kEmpty) {
+            slot = (slot + 1) & mask_;
+        }
+        slots_[slot] = entry;
+    }
+}
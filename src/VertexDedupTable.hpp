@@ -0,0 +1,63 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+// Resolved (position, texcoord, normal) indices of one OBJ face corner; -1
+// marks a missing attribute.
+struct VertexKey {
+    int position = 0;
+    int texCoord = 0;
+    int normal = 0;
+
+    bool operator==(const VertexKey& other) const {
+        return position == other.position &&
+               texCoord == other.texCoord &&
+               normal == other.normal;
+    }
+};
+
+// Flat open-addressing map from VertexKey to output vertex index. Slots are
+// 16 bytes and probed linearly, so a lookup usually touches one cache line
+// and inserting never allocates once the table has been reserved.
+class VertexDedupTable {
+public:
+    static constexpr uint32_t kEmpty = 0xFFFFFFFFu;
+
+    // Sizes the table for about expectedCount unique keys without rehashing.
+    void Reserve(std::size_t expectedCount);
+
+    // Returns the index stored for key, or stores candidateIndex and returns it.
+    uint32_t FindOrInsert(const VertexKey& key, uint32_t candidateIndex);
+
+    std::size_t Size() const { return size_; }
+    std::size_t Capacity() const { return slots_.size(); }
+    std::size_t MemoryBytes() const { return slots_.capacity() * sizeof(Slot); }
+
+    static uint64_t Hash(const VertexKey& key) {
+        // Multiply each component by a distinct odd constant, then run the
+        // murmur3 finalizer so sequential indices spread over all bits.
+        uint64_t h = static_cast<uint64_t>(static_cast<uint32_t>(key.position)) * 0x9E3779B97F4A7C15ULL;
+        h ^= static_cast<uint64_t>(static_cast<uint32_t>(key.texCoord)) * 0xC2B2AE3D27D4EB4FULL;
+        h ^= static_cast<uint64_t>(static_cast<uint32_t>(key.normal)) * 0x165667B19E3779F9ULL;
+        h ^= h >> 33;
+        h *= 0xFF51AFD7ED558CCDULL;
+        h ^= h >> 33;
+        h *= 0xC4CEB9FE1A85EC53ULL;
+        h ^= h >> 33;
+        return h;
+    }
+
+private:
+    struct Slot {
+        VertexKey key;
+        uint32_t value = kEmpty;
+    };
+
+    std::vector<Slot> slots_;
+    std::size_t mask_ = 0;
+    std::size_t size_ = 0;
+
+    void Rehash(std::size_t newCapacity);
+};
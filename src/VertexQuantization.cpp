@@ -0,0 +1,150 @@
+#include "VertexQuantization.hpp"
+
+#include <algorithm>
+#include <cmath>
+
+#include <glm/geometric.hpp>
+#include <glm/gtc/packing.hpp>
+
+namespace {
+
+float SignNotZero(float value) {
+    return value >= 0.0f ? 1.0f : -1.0f;
+}
+
+uint16_t QuantizeUnorm16(float value) {
+    return static_cast<uint16_t>(std::lround(std::clamp(value, 0.0f, 1.0f) * 65535.0f));
+}
+
+float DequantizeUnorm16(uint16_t value) {
+    return static_cast<float>(value) / 65535.0f;
+}
+
+// GL snorm16 -> float conversion: max(q / 32767, -1).
+float DequantizeSnorm16(int16_t value) {
+    return std::max(static_cast<float>(value) / 32767.0f, -1.0f);
+}
+
+// Rounding each octahedral coordinate independently is not always the
+// closest representable normal; try the four neighbouring grid points.
+void EncodeNormalSnorm16(const glm::vec3& normal, int16_t out[2]) {
+    glm::vec2 encoded = OctahedralEncode(normal) * 32767.0f;
+    float floorX = std::floor(encoded.x);
+    float floorY = std::floor(encoded.y);
+
+    float bestDot = -2.0f;
+    for (int dy = 0; dy <= 1; ++dy) {
+        for (int dx = 0; dx <= 1; ++dx) {
+            int16_t qx = static_cast<int16_t>(std::clamp(floorX + static_cast<float>(dx), -32767.0f, 32767.0f));
+            int16_t qy = static_cast<int16_t>(std::clamp(floorY + static_cast<float>(dy), -32767.0f, 32767.0f));
+            glm::vec3 decoded = OctahedralDecode(glm::vec2(DequantizeSnorm16(qx), DequantizeSnorm16(qy)));
+            float d = glm::dot(decoded, normal);
+            if (d > bestDot) {
+                bestDot = d;
+                out[0] = qx;
+                out[1] = qy;
+            }
+        }
+    }
+}
+
+} // namespace
+
+uint32_t PackTangent(const glm::vec4& tangent) {
+    auto snorm10 = [](float value) {
+        return static_cast<uint32_t>(std::lround(std::clamp(value, -1.0f, 1.0f) * 511.0f)) & 0x3FFu;
+    };
+    const uint32_t sign = tangent.w < 0.0f ? 0x3u : 0x1u; // -1 or +1 as 2-bit two's complement
+    return snorm10(tangent.x) | (snorm10(tangent.y) << 10) | (snorm10(tangent.z) << 20) | (sign << 30);
+}
+
+glm::vec2 OctahedralEncode(const glm::vec3& normal) {
+    float l1 = std::abs(normal.x) + std::abs(normal.y) + std::abs(normal.z);
+    if (l1 <= 0.0f) {
+        return glm::vec2(0.0f);
+    }
+    glm::vec2 p(normal.x / l1, normal.y / l1);
+    if (normal.z < 0.0f) {
+        p = glm::vec2((1.0f - std::abs(p.y)) * SignNotZero(p.x), (1.0f - std::abs(p.x)) * SignNotZero(p.y));
+    }
+    return p;
+}
+
+glm::vec3 OctahedralDecode(const glm::vec2& encoded) {
+    glm::vec3 n(encoded.x, encoded.y, 1.0f - std::abs(encoded.x) - std::abs(encoded.y));
+    if (n.z < 0.0f) {
+        float x = n.x;
+        n.x = (1.0f - std::abs(n.y)) * SignNotZero(x);
+        n.y = (1.0f - std::abs(x)) * SignNotZero(n.y);
+    }
+    return glm::normalize(n);
+}
+
+QuantizationParams ComputeQuantizationParams(std::span<const VertexPNT> vertices) {
+    QuantizationParams params;
+    if (vertices.empty()) {
+        return params;
+    }
+
+    glm::vec3 minPos = vertices[0].position;
+    glm::vec3 maxPos = vertices[0].position;
+    for (const auto& v : vertices) {
+        minPos = glm::min(minPos, v.position);
+        maxPos = glm::max(maxPos, v.position);
+    }
+    params.positionOffset = minPos;
+    params.positionScale = maxPos - minPos;
+    return params;
+}
+
+void QuantizeVertices(std::span<const VertexPNT> vertices,
+                      const QuantizationParams& params,
+                      std::vector<VertexPacked>& outVertices,
+                      QuantizationError* error) {
+    outVertices.resize(vertices.size());
+    QuantizationError maxError;
+
+    for (std::size_t i = 0; i < vertices.size(); ++i) {
+        const VertexPNT& src = vertices[i];
+        VertexPacked& dst = outVertices[i];
+
+        for (int axis = 0; axis < 3; ++axis) {
+            float extent = params.positionScale[axis];
+            float normalized = extent > 0.0f ? (src.position[axis] - params.positionOffset[axis]) / extent : 0.0f;
+            dst.position[axis] = QuantizeUnorm16(normalized);
+        }
+        dst.position[3] = 0;
+
+        EncodeNormalSnorm16(src.normal, dst.normal);
+
+        dst.texCoord[0] = glm::packHalf1x16(src.texCoord.x);
+        dst.texCoord[1] = glm::packHalf1x16(src.texCoord.y);
+
+        if (error) {
+            glm::vec3 position;
+            for (int axis = 0; axis < 3; ++axis) {
+                position[axis] = params.positionOffset[axis] +
+                                 DequantizeUnorm16(dst.position[axis]) * params.positionScale[axis];
+            }
+            maxError.maxPositionError = std::max(maxError.maxPositionError, glm::length(position - src.position));
+
+            float normalLength = glm::length(src.normal);
+            if (normalLength > 0.0f) {
+                glm::vec3 normal = OctahedralDecode(
+                    glm::vec2(DequantizeSnorm16(dst.normal[0]), DequantizeSnorm16(dst.normal[1])));
+                glm::vec3 reference = src.normal / normalLength;
+                // atan2 keeps precision for the tiny angles a float acos would round to zero.
+                float angle = std::atan2(glm::length(glm::cross(normal, reference)), glm::dot(normal, reference));
+                maxError.maxNormalErrorDegrees = std::max(maxError.maxNormalErrorDegrees, glm::degrees(angle));
+            }
+
+            glm::vec2 uv(glm::unpackHalf1x16(dst.texCoord[0]), glm::unpackHalf1x16(dst.texCoord[1]));
+            glm::vec2 uvError = glm::abs(uv - src.texCoord);
+            maxError.maxTexCoordError = std::max({maxError.maxTexCoordError, uvError.x, uvError.y});
+        }
+    }
+
+    if (error) {
+        *error = maxError;
+    }
+}
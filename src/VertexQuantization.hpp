@@ -0,0 +1,50 @@
+#pragma once
+
+#include "ObjLoader.hpp"
+
+#include <cstdint>
+#include <span>
+#include <vector>
+
+#include <glm/glm.hpp>
+
+enum class VertexFormat {
+    Float32, // VertexPNT as parsed, 32 bytes
+    Packed,  // VertexPacked, 16 bytes
+};
+
+// 16-byte vertex: positions as unorm16 within the mesh bounds, octahedral
+// snorm16 normals and half-float UVs. Dequantised in object.vert.
+struct VertexPacked {
+    uint16_t position[4]; // xyz + padding to keep the normal 4-byte aligned
+    int16_t normal[2];
+    uint16_t texCoord[2];
+};
+static_assert(sizeof(VertexPacked) == 16, "VertexPacked must stay 16 bytes");
+
+// position = positionOffset + unorm * positionScale (per axis).
+struct QuantizationParams {
+    glm::vec3 positionOffset{0.0f};
+    glm::vec3 positionScale{1.0f};
+};
+
+struct QuantizationError {
+    float maxPositionError = 0.0f;      // object-space units
+    float maxNormalErrorDegrees = 0.0f;
+    float maxTexCoordError = 0.0f;
+};
+
+QuantizationParams ComputeQuantizationParams(std::span<const VertexPNT> vertices);
+
+void QuantizeVertices(std::span<const VertexPNT> vertices,
+                      const QuantizationParams& params,
+                      std::vector<VertexPacked>& outVertices,
+                      QuantizationError* error = nullptr);
+
+// Tangent xyz as snorm10 and the bitangent sign in the 2-bit w, laid out
+// for a normalized GL_INT_2_10_10_10_REV attribute.
+uint32_t PackTangent(const glm::vec4& tangent);
+
+// Octahedral mapping of a unit vector to [-1, 1]^2 and back.
+glm::vec2 OctahedralEncode(const glm::vec3& normal);
+glm::vec3 OctahedralDecode(const glm::vec2& encoded);
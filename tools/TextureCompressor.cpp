@@ -0,0 +1,94 @@
+// Block-compresses PNG/TGA textures into the .ctex files the viewer prefers
+// over the source image at load time. Output goes next to each source
+// ("a.png.ctex"). Normal maps should use --format=bc5.
+//
+// Usage: TextureCompressor [--format=bc1|bc3|bc5|bc7] [--linear] [--threads=N] <image>...
+
+#include "CompressedTexture.hpp"
+#include "ThreadPool.hpp"
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace {
+
+bool ParseFormat(std::string_view name, gfx::BlockFormat& format) {
+    if (name == "bc1") {
+        format = gfx::BlockFormat::BC1;
+    } else if (name == "bc3") {
+        format = gfx::BlockFormat::BC3;
+    } else if (name == "bc5") {
+        format = gfx::BlockFormat::BC5;
+    } else if (name == "bc7") {
+        format = gfx::BlockFormat::BC7;
+    } else {
+        return false;
+    }
+    return true;
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+    gfx::BlockFormat format = gfx::BlockFormat::BC7;
+    bool srgb = true;
+    unsigned threads = 0;
+    std::vector<std::string> files;
+
+    for (int i = 1; i < argc; ++i) {
+        const std::string_view arg = argv[i];
+        if (arg.rfind("--format=", 0) == 0) {
+            if (!ParseFormat(arg.substr(9), format)) {
+                std::fprintf(stderr, "Unknown format: %s\n", argv[i]);
+                return EXIT_FAILURE;
+            }
+        } else if (arg == "--linear") {
+            srgb = false;
+        } else if (arg.rfind("--threads=", 0) == 0) {
+            threads = static_cast<unsigned>(std::atoi(argv[i] + 10));
+        } else {
+            files.emplace_back(arg);
+        }
+    }
+    if (files.empty()) {
+        std::fprintf(stderr, "Usage: %s [--format=bc1|bc3|bc5|bc7] [--linear] [--threads=N] <image>...\n",
+                     argv[0]);
+        return EXIT_FAILURE;
+    }
+    // BC5 stores two data channels; sRGB decoding does not apply.
+    if (format == gfx::BlockFormat::BC5) {
+        srgb = false;
+    }
+
+    ThreadPool pool(threads);
+    int failures = 0;
+    for (const std::string& file : files) {
+        std::string error;
+        gfx::ImageRGBA8 image;
+        if (!gfx::DecodeImage(file, image, &error)) {
+            std::fprintf(stderr, "%s\n", error.c_str());
+            ++failures;
+            continue;
+        }
+
+        const auto start = std::chrono::steady_clock::now();
+        gfx::CompressedTexture compressed;
+        gfx::CompressTexture(image, format, srgb, compressed, &pool);
+        const double ms =
+            std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+
+        if (!gfx::CompressedTextureFile::Write(file, compressed, &error)) {
+            std::fprintf(stderr, "%s\n", error.c_str());
+            ++failures;
+            continue;
+        }
+        std::printf("%s: %ux%u BC%u%s, %zu mips, %.1f ms, %zu -> %zu bytes\n", file.c_str(), image.width,
+                    image.height, static_cast<unsigned>(format), srgb ? " sRGB" : "", compressed.mips.size(), ms,
+                    image.pixels.size(), compressed.data.size());
+    }
+    return failures == 0 ? EXIT_SUCCESS : EXIT_FAILURE;
+}